@@ -3,27 +3,20 @@
 #include <glib.h>
 #include <gio/gio.h>
 #include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "archive_cache.h"
+#include "archive_index.h"
+#include "metrics.h"
 
 #ifdef HAVE_LIBARCHIVE
 #include <archive.h>
 #include <archive_entry.h>
 #endif
 
-/* Internal helper: get cache path for an archive entry */
-static char *
-get_cache_path(const char *archive_path, const char *entry_name)
-{
-    char *sum = g_compute_checksum_for_string(G_CHECKSUM_MD5, archive_path, -1);
-    char *cache_dir = g_build_filename(g_get_user_cache_dir(), "brighteyes", "archives", sum, NULL);
-    g_free(sum);
-    
-    char *full_path = g_build_filename(cache_dir, entry_name, NULL);
-    g_free(cache_dir);
-    
-    return full_path;
-}
-
 /* Internal helper: is filename an image we care about */
 static gboolean
 is_image_name(const char *name)
@@ -42,6 +35,30 @@ is_image_name(const char *name)
     return ok;
 }
 
+gboolean
+archive_split_path(const char *path, char **archive_path, char **entry_name)
+{
+    if (!path || !g_str_has_prefix(path, "archive://")) return FALSE;
+    const char *rest = path + strlen("archive://");
+    const char *sep = strstr(rest, "::");
+    if (!sep) return FALSE;
+    *archive_path = g_strndup(rest, sep - rest);
+    *entry_name = g_strdup(sep + 2);
+    return TRUE;
+}
+
+gboolean
+archive_is_video_path(const char *path)
+{
+    const char *exts[] = { ".mp4", ".mkv", ".webm", ".avi", ".mov", NULL };
+    const char *ext = path ? strrchr(path, '.') : NULL;
+    if (!ext) return FALSE;
+    for (int i = 0; exts[i]; i++) {
+        if (g_ascii_strcasecmp(ext, exts[i]) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
 #ifdef HAVE_LIBARCHIVE
 
 static int
@@ -60,33 +77,17 @@ compare_image_entries(gconstpointer a, gconstpointer b)
 gboolean
 archive_list_image_entries(const char *archive_path, GPtrArray *out_entries, GError **error)
 {
-    struct archive *a = NULL;
-    struct archive_entry *entry = NULL;
-
-    a = archive_read_new();
-    if (!a) {
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create archive reader");
-        return FALSE;
-    }
-
-    archive_read_support_format_all(a);
-    archive_read_support_filter_all(a);
-
-    if (archive_read_open_filename(a, archive_path, 10240) != ARCHIVE_OK) {
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open archive: %s", archive_error_string(a));
-        archive_read_free(a);
-        return FALSE;
-    }
+    ArchiveIndex *index = archive_index_get(archive_path, error);
+    if (!index) return FALSE;
 
-    while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
-        const char *name = archive_entry_pathname(entry);
-        if (is_image_name(name)) {
-            g_ptr_array_add(out_entries, g_strdup(name));
+    guint n = archive_index_get_n_entries(index);
+    for (guint i = 0; i < n; i++) {
+        const ArchiveIndexEntry *e = archive_index_get_entry(index, i);
+        if (is_image_name(e->name)) {
+            g_ptr_array_add(out_entries, g_strdup(e->name));
         }
-        archive_read_data_skip(a);
     }
-
-    archive_read_free(a);
+    archive_index_unref(index);
 
     /* Sort entries naturally (e.g. 1.jpg, 2.jpg, 10.jpg) */
     g_ptr_array_sort(out_entries, compare_image_entries);
@@ -94,27 +95,143 @@ archive_list_image_entries(const char *archive_path, GPtrArray *out_entries, GEr
     return TRUE;
 }
 
-GBytes *
-archive_read_entry_bytes(const char *archive_path, const char *entry_name, GError **error)
+/* Internal helper: positional read of exactly len bytes */
+static gboolean
+read_at(int fd, void *buf, gsize len, guint64 offset)
 {
-    /* Check Cache first */
-    char *cache_path = get_cache_path(archive_path, entry_name);
-    if (g_file_test(cache_path, G_FILE_TEST_EXISTS)) {
-        char *content = NULL;
-        gsize len = 0;
-        if (g_file_get_contents(cache_path, &content, &len, NULL)) {
-            g_free(cache_path);
-            return g_bytes_new_take(content, len);
+    guint8 *p = buf;
+    while (len > 0) {
+        ssize_t r = pread(fd, p, len, (off_t)offset);
+        if (r <= 0) return FALSE;
+        p += r;
+        len -= (gsize)r;
+        offset += (guint64)r;
+    }
+    return TRUE;
+}
+
+typedef struct {
+    int fd;
+    guint64 pos;
+    guint8 buf[65536];
+} ZipStreamSource;
+
+static la_ssize_t
+zip_stream_read(struct archive *a, void *client_data, const void **buffer)
+{
+    ZipStreamSource *src = client_data;
+    ssize_t r = pread(src->fd, src->buf, sizeof(src->buf), (off_t)src->pos);
+    if (r < 0) {
+        archive_set_error(a, errno, "%s", g_strerror(errno));
+        return -1;
+    }
+    src->pos += (guint64)r;
+    *buffer = src->buf;
+    return r;
+}
+
+/* Read a ZIP entry straight from its local header using the index offset.
+ * Stored entries are copied with a single pread; compressed ones are decoded
+ * by libarchive's streaming ZIP reader starting at the entry. At most limit
+ * bytes are returned. */
+static GBytes *
+read_zip_entry_direct(const char *archive_path, const ArchiveIndexEntry *e, gsize limit, GError **error)
+{
+    int fd = g_open(archive_path, O_RDONLY, 0);
+    if (fd < 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to open archive: %s", g_strerror(errno));
+        return NULL;
+    }
+
+    GStatBuf st;
+    guint8 header[30];
+    if (fstat(fd, &st) != 0 || !read_at(fd, header, sizeof(header), (guint64)e->offset) ||
+        header[0] != 'P' || header[1] != 'K' || header[2] != 0x03 || header[3] != 0x04) {
+        close(fd);
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid local header for '%s'", e->name);
+        return NULL;
+    }
+
+    guint64 data_off = (guint64)e->offset + sizeof(header) +
+                       (guint64)(header[26] | (header[27] << 8)) + (guint64)(header[28] | (header[29] << 8));
+
+    if (e->method == 0 && e->compressed_size == e->size) {
+        if (data_off + e->size > (guint64)st.st_size) {
+            close(fd);
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Entry '%s' is truncated", e->name);
+            return NULL;
         }
+        gsize len = (gsize)MIN(e->size, (guint64)limit);
+        guint8 *data = g_malloc(len ? len : 1);
+        if (!read_at(fd, data, len, data_off)) {
+            g_free(data);
+            close(fd);
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading entry '%s'", e->name);
+            return NULL;
+        }
+        close(fd);
+        return g_bytes_new_take(data, len);
     }
 
-    struct archive *a = NULL;
+    ZipStreamSource *src = g_new(ZipStreamSource, 1);
+    src->fd = fd;
+    src->pos = (guint64)e->offset;
+
+    struct archive *a = archive_read_new();
     struct archive_entry *entry = NULL;
+    archive_read_support_format_zip_streamable(a);
+
     GBytes *res = NULL;
+    if (archive_read_open(a, src, NULL, zip_stream_read, NULL) == ARCHIVE_OK &&
+        archive_read_next_header(a, &entry) == ARCHIVE_OK) {
+        /* Sizes come from the central directory; don't trust them for huge allocations */
+        GByteArray *buf = g_byte_array_sized_new((guint)MIN(MIN(e->size, (guint64)st.st_size * 4 + 4096), (guint64)limit));
+        ssize_t r = 0;
+        char tmp[65536];
+        while (buf->len < limit && (r = archive_read_data(a, tmp, sizeof(tmp))) > 0) {
+            g_byte_array_append(buf, (const guint8 *)tmp, MIN((gsize)r, limit - buf->len));
+        }
+        if (r < 0) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading entry: %s", archive_error_string(a));
+            g_byte_array_free(buf, TRUE);
+        } else {
+            res = g_byte_array_free_to_bytes(buf);
+        }
+    } else {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to read entry '%s': %s", e->name, archive_error_string(a));
+    }
+
+    archive_read_free(a);
+    g_free(src);
+    close(fd);
+    return res;
+}
+
+/* Internal helper: read up to limit bytes of the entry whose header was just
+ * read. Some entries may not report size; read into growable buffer */
+static GBytes *
+read_current_entry(struct archive *a, gsize limit, GError **error)
+{
+    GByteArray *buf = g_byte_array_new();
+    ssize_t r = 0;
+    char tmp[8192];
+    while (buf->len < limit && (r = archive_read_data(a, tmp, sizeof(tmp))) > 0) {
+        g_byte_array_append(buf, (const guint8*)tmp, MIN((gsize)r, limit - buf->len));
+    }
+    if (r < 0) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading entry: %s", archive_error_string(a));
+        g_byte_array_free(buf, TRUE);
+        return NULL;
+    }
+    return g_byte_array_free_to_bytes(buf);
+}
 
-    a = archive_read_new();
+/* Internal helper: open a reader accepting every supported format */
+static struct archive *
+open_reader(const char *archive_path, GError **error)
+{
+    struct archive *a = archive_read_new();
     if (!a) {
-        g_free(cache_path);
         g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create archive reader");
         return NULL;
     }
@@ -123,87 +240,306 @@ archive_read_entry_bytes(const char *archive_path, const char *entry_name, GErro
     archive_read_support_filter_all(a);
 
     if (archive_read_open_filename(a, archive_path, 10240) != ARCHIVE_OK) {
-        g_free(cache_path);
         g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open archive: %s", archive_error_string(a));
         archive_read_free(a);
         return NULL;
     }
+    return a;
+}
+
+/* Internal helper: find an entry by scanning the archive from the start */
+static GBytes *
+read_entry_linear(const char *archive_path, const char *entry_name, gsize limit, GError **error)
+{
+    struct archive_entry *entry = NULL;
+    GBytes *res = NULL;
+
+    struct archive *a = open_reader(archive_path, error);
+    if (!a) return NULL;
 
     while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
         const char *name = archive_entry_pathname(entry);
         if (g_strcmp0(name, entry_name) == 0) {
-            /* Some entries may not report size; read into growable buffer */
-            GByteArray *buf = g_byte_array_new();
-            ssize_t r;
-            char tmp[8192];
-            while ((r = archive_read_data(a, tmp, sizeof(tmp))) > 0) {
-                g_byte_array_append(buf, (const guint8*)tmp, r);
-            }
-            if (r < 0) {
-                g_free(cache_path);
-                g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading entry: %s", archive_error_string(a));
-                g_byte_array_free(buf, TRUE);
-                archive_read_free(a);
-                return NULL;
-            }
-            /* Transfer to GBytes */
-            gsize buf_len = buf->len;
-            guint8 *data = g_byte_array_free(buf, FALSE);
-            res = g_bytes_new_take(data, buf_len);
-            
-            /* Save to cache */
-            char *dir = g_path_get_dirname(cache_path);
-            g_mkdir_with_parents(dir, 0700);
-            g_free(dir);
-            g_file_set_contents(cache_path, (const char *)data, (gssize)buf_len, NULL);
-
+            res = read_current_entry(a, limit, error);
             archive_read_free(a);
-            g_free(cache_path);
             return res;
         }
         archive_read_data_skip(a);
     }
 
     archive_read_free(a);
-    g_free(cache_path);
     g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Entry '%s' not found in archive", entry_name);
     return NULL;
 }
 
-gboolean
-archive_get_entry_size(const char *archive_path, const char *entry_name, guint64 *size, GError **error)
+/* --- Reader sessions ---
+ *
+ * Non-seekable archives (solid RAR in particular) can only be read front to
+ * back, so reaching page N means decompressing everything before it. A
+ * session keeps a reader open together with the ordinal of the next header
+ * it will return; a read at or after that ordinal continues from there
+ * instead of reopening the file. Each archive keeps at most a couple of
+ * sessions (the viewer and the thumbnail loaders usually read in different
+ * places) and idle ones are closed by a periodic sweep. */
+
+#define MAX_SESSIONS_PER_ARCHIVE 2
+#define SESSION_IDLE_TIMEOUT_US (30 * G_USEC_PER_SEC)
+#define SESSION_SWEEP_INTERVAL_S 10
+
+typedef struct {
+    char *archive_path;
+    ArchiveIndex *index;   /* Index the session was opened against */
+    struct archive *a;
+    guint next_ordinal;    /* Ordinal of the header the next call returns */
+    gint64 last_used;
+    gboolean busy;
+    gboolean stale;        /* Archive changed while the session was in use */
+} ArchiveSession;
+
+G_LOCK_DEFINE_STATIC(sessions);
+static GList *sessions = NULL;
+static guint session_sweep_id = 0;
+
+static void
+archive_session_free(ArchiveSession *session)
+{
+    if (session->a) archive_read_free(session->a);
+    archive_index_unref(session->index);
+    g_free(session->archive_path);
+    g_free(session);
+}
+
+static gboolean
+session_sweep_cb(gpointer user_data)
+{
+    GList *expired = NULL;
+    gint64 now = g_get_monotonic_time();
+
+    G_LOCK(sessions);
+    for (GList *l = sessions; l; ) {
+        GList *next = l->next;
+        ArchiveSession *session = l->data;
+        if (!session->busy && now - session->last_used > SESSION_IDLE_TIMEOUT_US) {
+            sessions = g_list_delete_link(sessions, l);
+            expired = g_list_prepend(expired, session);
+        }
+        l = next;
+    }
+    gboolean keep = sessions != NULL;
+    if (!keep) session_sweep_id = 0;
+    G_UNLOCK(sessions);
+
+    g_list_free_full(expired, (GDestroyNotify)archive_session_free);
+    return keep ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+/* Take a session that can reach target_ordinal without rewinding, or NULL if
+ * the caller should open a new one. Evicts surplus idle sessions. */
+static ArchiveSession *
+session_acquire(const char *archive_path, ArchiveIndex *index, guint target_ordinal)
+{
+    ArchiveSession *best = NULL;
+    ArchiveSession *oldest_idle = NULL;
+    GList *dropped = NULL;
+    guint count = 0;
+
+    G_LOCK(sessions);
+    for (GList *l = sessions; l; ) {
+        GList *next = l->next;
+        ArchiveSession *session = l->data;
+        if (g_strcmp0(session->archive_path, archive_path) == 0) {
+            if (session->index != index && !session->busy) {
+                /* Opened against an older version of the file */
+                sessions = g_list_delete_link(sessions, l);
+                dropped = g_list_prepend(dropped, session);
+            } else {
+                count++;
+                if (!session->busy) {
+                    if (session->next_ordinal <= target_ordinal &&
+                        (!best || session->next_ordinal > best->next_ordinal))
+                        best = session;
+                    if (!oldest_idle || session->last_used < oldest_idle->last_used)
+                        oldest_idle = session;
+                }
+            }
+        }
+        l = next;
+    }
+
+    if (best) {
+        best->busy = TRUE;
+    } else if (count >= MAX_SESSIONS_PER_ARCHIVE && oldest_idle) {
+        sessions = g_list_remove(sessions, oldest_idle);
+        dropped = g_list_prepend(dropped, oldest_idle);
+    }
+    G_UNLOCK(sessions);
+
+    g_list_free_full(dropped, (GDestroyNotify)archive_session_free);
+    return best;
+}
+
+static void
+session_release(ArchiveSession *session, gboolean reusable)
+{
+    G_LOCK(sessions);
+    gboolean tracked = g_list_find(sessions, session) != NULL;
+    if (reusable && !session->stale) {
+        session->busy = FALSE;
+        session->last_used = g_get_monotonic_time();
+        if (!tracked) sessions = g_list_prepend(sessions, session);
+        if (session_sweep_id == 0)
+            session_sweep_id = g_timeout_add_seconds(SESSION_SWEEP_INTERVAL_S, session_sweep_cb, NULL);
+        session = NULL;
+    } else if (tracked) {
+        sessions = g_list_remove(sessions, session);
+    }
+    G_UNLOCK(sessions);
+
+    if (session) archive_session_free(session);
+}
+
+/* Close sessions for an archive that is about to change on disk. Sessions in
+ * use are marked stale and freed by their reader. */
+static void
+archive_sessions_close(const char *archive_path)
+{
+    GList *dropped = NULL;
+
+    G_LOCK(sessions);
+    for (GList *l = sessions; l; ) {
+        GList *next = l->next;
+        ArchiveSession *session = l->data;
+        if (g_strcmp0(session->archive_path, archive_path) == 0) {
+            if (session->busy) {
+                session->stale = TRUE;
+            } else {
+                sessions = g_list_delete_link(sessions, l);
+                dropped = g_list_prepend(dropped, session);
+            }
+        }
+        l = next;
+    }
+    G_UNLOCK(sessions);
+
+    g_list_free_full(dropped, (GDestroyNotify)archive_session_free);
+}
+
+static GBytes *
+read_entry_from_session(const char *archive_path, ArchiveIndex *index, const ArchiveIndexEntry *e,
+                        gsize limit, GError **error)
 {
-    struct archive *a = NULL;
+    ArchiveSession *session = session_acquire(archive_path, index, e->ordinal);
+    if (!session) {
+        struct archive *a = open_reader(archive_path, error);
+        if (!a) return NULL;
+        session = g_new0(ArchiveSession, 1);
+        session->archive_path = g_strdup(archive_path);
+        session->index = archive_index_ref(index);
+        session->a = a;
+        session->busy = TRUE;
+    }
+
     struct archive_entry *entry = NULL;
+    while (session->next_ordinal < e->ordinal) {
+        if (archive_read_next_header(session->a, &entry) != ARCHIVE_OK) break;
+        archive_read_data_skip(session->a);
+        session->next_ordinal++;
+    }
 
-    a = archive_read_new();
-    if (!a) {
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create archive reader");
-        return FALSE;
+    GBytes *res = NULL;
+    if (session->next_ordinal == e->ordinal &&
+        archive_read_next_header(session->a, &entry) == ARCHIVE_OK) {
+        session->next_ordinal++;
+        if (g_strcmp0(archive_entry_pathname(entry), e->name) == 0) {
+            /* A short read is fine: the next header skips the rest */
+            res = read_current_entry(session->a, limit, error);
+        } else {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Archive index out of date for '%s'", e->name);
+        }
+    } else {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Entry '%s' not found in archive", e->name);
     }
 
-    archive_read_support_format_all(a);
-    archive_read_support_filter_all(a);
+    session_release(session, res != NULL);
+    return res;
+}
 
-    if (archive_read_open_filename(a, archive_path, 10240) != ARCHIVE_OK) {
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open archive: %s", archive_error_string(a));
-        archive_read_free(a);
-        return FALSE;
+/* Shared by the whole-entry and prefix reads. Only whole entries are cached. */
+static GBytes *
+read_entry(const char *archive_path, const char *entry_name, gsize limit, GError **error)
+{
+    GBytes *res = NULL;
+    ArchiveIndex *index = archive_index_get(archive_path, NULL);
+    const ArchiveIndexEntry *e = index ? archive_index_lookup(index, entry_name) : NULL;
+    gboolean seekable = index && archive_index_is_seekable(index);
+
+    /* Stored ZIP entries are a single pread away; caching them would only
+     * duplicate the archive on disk. Everything else goes through the cache. */
+    gboolean cacheable = !(seekable && e && e->offset >= 0 && e->method == 0);
+    if (cacheable) {
+        res = archive_cache_lookup(archive_path, entry_name);
+        if (res) {
+            archive_index_unref(index);
+            if (g_bytes_get_size(res) > limit) {
+                GBytes *prefix = g_bytes_new_from_bytes(res, 0, limit);
+                g_bytes_unref(res);
+                return prefix;
+            }
+            return res;
+        }
     }
 
-    while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
-        const char *name = archive_entry_pathname(entry);
-        if (g_strcmp0(name, entry_name) == 0) {
-            *size = (guint64)archive_entry_size(entry);
-            archive_read_free(a);
-            return TRUE;
+    if (e) {
+        GError *fast_error = NULL;
+        if (seekable && e->offset >= 0)
+            res = read_zip_entry_direct(archive_path, e, limit, &fast_error);
+        else if (!seekable)
+            res = read_entry_from_session(archive_path, index, e, limit, &fast_error);
+        if (!res && fast_error) {
+            g_debug("Fast read of '%s' failed, rescanning: %s", entry_name, fast_error->message);
+            g_clear_error(&fast_error);
+            cacheable = TRUE;
         }
-        archive_read_data_skip(a);
     }
+    if (index) archive_index_unref(index);
 
-    archive_read_free(a);
-    g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Entry '%s' not found in archive", entry_name);
-    return FALSE;
+    if (!res) res = read_entry_linear(archive_path, entry_name, limit, error);
+    if (!res) return NULL;
+
+    if (cacheable && limit == G_MAXSIZE) archive_cache_store(archive_path, entry_name, res);
+    return res;
+}
+
+GBytes *
+archive_read_entry_bytes(const char *archive_path, const char *entry_name, GError **error)
+{
+    gint64 start = metrics_start();
+    GBytes *bytes = read_entry(archive_path, entry_name, G_MAXSIZE, error);
+    if (bytes) metrics_record(METRICS_ARCHIVE_READ, start);
+    return bytes;
+}
+
+GBytes *
+archive_read_entry_prefix(const char *archive_path, const char *entry_name, gsize max_len, GError **error)
+{
+    return read_entry(archive_path, entry_name, max_len, error);
+}
+
+gboolean
+archive_get_entry_size(const char *archive_path, const char *entry_name, guint64 *size, GError **error)
+{
+    ArchiveIndex *index = archive_index_get(archive_path, error);
+    if (!index) return FALSE;
+
+    const ArchiveIndexEntry *e = archive_index_lookup(index, entry_name);
+    if (!e) {
+        archive_index_unref(index);
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Entry '%s' not found in archive", entry_name);
+        return FALSE;
+    }
+    *size = e->size;
+    archive_index_unref(index);
+    return TRUE;
 }
 
 typedef struct {
@@ -253,14 +589,45 @@ archive_read_entry_bytes_finish(GAsyncResult *res, GError **error)
 }
 
 gboolean
-archive_delete_entry(const char *archive_path, const char *entry_name, GError **error)
+archive_supports_deletion(const char *archive_path)
+{
+    return g_str_has_suffix(archive_path, ".cbz") || g_str_has_suffix(archive_path, ".zip") ||
+           g_str_has_suffix(archive_path, ".CBZ") || g_str_has_suffix(archive_path, ".ZIP");
+}
+
+/* Copy the data of the current entry of in to out. */
+static gboolean
+copy_entry_data(struct archive *in, struct archive *out, GError **error)
+{
+    const void *buff;
+    size_t size;
+    int64_t offset;
+    int r;
+    while ((r = archive_read_data_block(in, &buff, &size, &offset)) == ARCHIVE_OK) {
+        if (archive_write_data_block(out, buff, size, offset) != ARCHIVE_OK) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to write data: %s", archive_error_string(out));
+            return FALSE;
+        }
+    }
+    if (r != ARCHIVE_EOF) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading data: %s", archive_error_string(in));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+archive_delete_entries(const char *archive_path, const char * const *entry_names, GError **error)
 {
-    if (!g_str_has_suffix(archive_path, ".cbz") && !g_str_has_suffix(archive_path, ".zip") &&
-        !g_str_has_suffix(archive_path, ".CBZ") && !g_str_has_suffix(archive_path, ".ZIP")) {
+    if (!archive_supports_deletion(archive_path)) {
         g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Modification only supported for Zip/CBZ archives");
         return FALSE;
     }
 
+    GHashTable *doomed = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; entry_names && entry_names[i]; i++)
+        g_hash_table_add(doomed, (gpointer)entry_names[i]);
+
     struct archive *in = archive_read_new();
     struct archive *out = archive_write_new();
     struct archive_entry *entry;
@@ -274,158 +641,381 @@ archive_delete_entry(const char *archive_path, const char *entry_name, GError **
         g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open archive: %s", archive_error_string(in));
         archive_read_free(in);
         archive_write_free(out);
+        g_hash_table_unref(doomed);
         return FALSE;
     }
 
-    char *tmp_path = g_strdup_printf("%s.tmp", archive_path);
-    if (archive_write_open_filename(out, tmp_path) != ARCHIVE_OK) {
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create temp archive: %s", archive_error_string(out));
+    /* Write next to the original so the final rename is atomic */
+    char *tmp_path = g_strdup_printf("%s.XXXXXX", archive_path);
+    int fd = g_mkstemp_full(tmp_path, O_WRONLY, 0600);
+    GStatBuf st;
+    if (fd >= 0 && g_stat(archive_path, &st) == 0) fchmod(fd, st.st_mode & 07777);
+
+    if (fd < 0 || archive_write_open_fd(out, fd) != ARCHIVE_OK) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create temp archive: %s",
+                    fd < 0 ? g_strerror(errno) : archive_error_string(out));
         archive_read_free(in);
         archive_write_free(out);
+        if (fd >= 0) {
+            close(fd);
+            g_unlink(tmp_path);
+        }
         g_free(tmp_path);
+        g_hash_table_unref(doomed);
         return FALSE;
     }
 
     int ret;
-    gboolean found = FALSE;
+    guint removed = 0;
+    gboolean ok = TRUE;
     while ((ret = archive_read_next_header(in, &entry)) == ARCHIVE_OK) {
         const char *current_name = archive_entry_pathname(entry);
         
-        if (g_strcmp0(current_name, entry_name) == 0) {
-            found = TRUE;
+        if (current_name && g_hash_table_contains(doomed, current_name)) {
+            removed++;
             /* Skip this entry */
             archive_read_data_skip(in);
             continue;
         }
 
-        /* Copy header */
         if (archive_write_header(out, entry) != ARCHIVE_OK) {
-             g_warning("Failed to write header: %s", archive_error_string(out));
-             /* Continue? Most likely fatal */
-             break;
-        }
-        
-        /* Copy data */
-        const void *buff;
-        size_t size;
-        int64_t offset;
-        int r;
-        while ((r = archive_read_data_block(in, &buff, &size, &offset)) == ARCHIVE_OK) {
-            if (archive_write_data_block(out, buff, size, offset) != ARCHIVE_OK) {
-                g_warning("Failed to write data: %s", archive_error_string(out));
-                break;
-            }
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to write header: %s", archive_error_string(out));
+            ok = FALSE;
+            break;
         }
-        if (r != ARCHIVE_EOF && r != ARCHIVE_OK) {
-             g_warning("Error reading data: %s", archive_error_string(in));
+        if (!copy_entry_data(in, out, error)) {
+            ok = FALSE;
+            break;
         }
     }
+    if (ok && ret != ARCHIVE_EOF) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading archive: %s", archive_error_string(in));
+        ok = FALSE;
+    }
 
     archive_read_close(in);
     archive_read_free(in);
-    archive_write_close(out);
+    if (archive_write_close(out) != ARCHIVE_OK && ok) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to finish temp archive: %s", archive_error_string(out));
+        ok = FALSE;
+    }
     archive_write_free(out);
+    if (ok && fsync(fd) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to flush temp archive: %s", g_strerror(errno));
+        ok = FALSE;
+    }
+    close(fd);
+    g_hash_table_unref(doomed);
 
-    if (found) {
-        GFile *src = g_file_new_for_path(tmp_path);
-        GFile *dest = g_file_new_for_path(archive_path);
-        if (g_file_move(src, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, error)) {
-             /* Success - clear cache */
-             char *cache_path = get_cache_path(archive_path, entry_name);
-             g_unlink(cache_path);
-             g_free(cache_path);
-        } else {
-             /* Error set by g_file_move */
-             found = FALSE; /* Treat as failure */
-        }
-        g_object_unref(src);
-        g_object_unref(dest);
+    if (ok && removed == 0) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No such entries in archive");
+        ok = FALSE;
+    }
+
+    if (ok && g_rename(tmp_path, archive_path) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to replace archive: %s", g_strerror(errno));
+        ok = FALSE;
+    }
+
+    if (ok) {
+        /* Drop the now stale sessions, index and cached pages */
+        archive_sessions_close(archive_path);
+        archive_index_invalidate(archive_path);
+        archive_cache_invalidate(archive_path);
     } else {
-        /* Not found, just delete temp */
+        /* The original is untouched; just delete temp */
         g_unlink(tmp_path);
     }
     
     g_free(tmp_path);
-    return found;
+    return ok;
+}
+
+/* --- Conversion ---
+ *
+ * The source is read (and, for RAR, decompressed) on the calling thread
+ * while a writer thread compresses and writes the ZIP, connected by a queue
+ * holding at most CONVERT_QUEUE_MAX bytes of pages. Formats that are
+ * already compressed are stored rather than deflated again.
+ */
+
+#define CONVERT_QUEUE_MAX (64 * 1024 * 1024)
+
+typedef struct {
+    struct archive_entry *entry;
+    GBytes *data; /* NULL for entries without contents, e.g. directories */
+} ConvertItem;
+
+typedef struct {
+    GMutex lock;
+    GCond cond;
+    GQueue items;
+    gsize queued;     /* Bytes of data in items */
+    gboolean eof;     /* The reader has queued everything */
+    gboolean stop;    /* The writer gave up; error says why */
+    GError *error;
+    struct archive *out;
+    GCancellable *cancellable;
+} ConvertPipe;
+
+static void
+convert_item_free(ConvertItem *item)
+{
+    archive_entry_free(item->entry);
+    if (item->data) g_bytes_unref(item->data);
+    g_free(item);
+}
+
+/* Image formats that deflate cannot shrink further */
+static gboolean
+is_precompressed_name(const char *name)
+{
+    if (!name) return FALSE;
+    const char *exts[] = { ".jpg", ".jpeg", ".png", ".gif", ".webp", NULL };
+    char *lower = g_ascii_strdown(name, -1);
+    gboolean ok = FALSE;
+    for (int i = 0; exts[i]; i++) {
+        if (g_str_has_suffix(lower, exts[i])) {
+            ok = TRUE;
+            break;
+        }
+    }
+    g_free(lower);
+    return ok;
+}
+
+static gboolean
+write_convert_item(struct archive *out, ConvertItem *item, GError **error)
+{
+    const char *name = archive_entry_pathname(item->entry);
+
+    /* Format options are only accepted before the archive is opened; the
+     * ZIP writer's own setters work per entry and apply to the next header */
+    int r = item->data && is_precompressed_name(name)
+        ? archive_write_zip_set_compression_store(out)
+        : archive_write_zip_set_compression_deflate(out);
+    if (r != ARCHIVE_OK) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to set compression for %s: %s", name, archive_error_string(out));
+        return FALSE;
+    }
+
+    if (archive_write_header(out, item->entry) != ARCHIVE_OK) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to write header for %s: %s", name, archive_error_string(out));
+        return FALSE;
+    }
+    if (item->data) {
+        gsize len;
+        const void *data = g_bytes_get_data(item->data, &len);
+        if (archive_write_data(out, data, len) != (la_ssize_t)len) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to write %s: %s", name, archive_error_string(out));
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gpointer
+convert_writer_thread(gpointer user_data)
+{
+    ConvertPipe *pipe = user_data;
+
+    for (;;) {
+        g_mutex_lock(&pipe->lock);
+        while (g_queue_is_empty(&pipe->items) && !pipe->eof && !pipe->stop)
+            g_cond_wait(&pipe->cond, &pipe->lock);
+        ConvertItem *item = pipe->stop ? NULL : g_queue_pop_head(&pipe->items);
+        if (item && item->data) pipe->queued -= g_bytes_get_size(item->data);
+        g_cond_broadcast(&pipe->cond);
+        g_mutex_unlock(&pipe->lock);
+
+        if (!item) break; /* Finished and drained, or told to stop */
+
+        GError *error = NULL;
+        gboolean ok = !g_cancellable_set_error_if_cancelled(pipe->cancellable, &error) &&
+                      write_convert_item(pipe->out, item, &error);
+        convert_item_free(item);
+
+        if (!ok) {
+            g_mutex_lock(&pipe->lock);
+            pipe->stop = TRUE;
+            pipe->error = error;
+            g_cond_broadcast(&pipe->cond);
+            g_mutex_unlock(&pipe->lock);
+            break;
+        }
+    }
+    return NULL;
+}
+
+/* Read the contents of the current entry of in. */
+static GBytes *
+read_convert_data(struct archive *in, struct archive_entry *entry, GError **error)
+{
+    gsize hint = archive_entry_size_is_set(entry) ? (gsize)MIN(archive_entry_size(entry), G_MAXUINT) : 0;
+    GByteArray *buf = g_byte_array_sized_new((guint)hint);
+    const void *block;
+    size_t size;
+    int64_t offset;
+    int r;
+
+    while ((r = archive_read_data_block(in, &block, &size, &offset)) == ARCHIVE_OK) {
+        /* Sparse entries: fill the holes */
+        if (offset > (int64_t)buf->len) {
+            guint old = buf->len;
+            g_byte_array_set_size(buf, (guint)offset);
+            memset(buf->data + old, 0, buf->len - old);
+        }
+        g_byte_array_append(buf, block, (guint)size);
+    }
+    if (r != ARCHIVE_EOF) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading %s: %s",
+                    archive_entry_pathname(entry), archive_error_string(in));
+        g_byte_array_unref(buf);
+        return NULL;
+    }
+    return g_byte_array_free_to_bytes(buf);
 }
 
 gboolean
-archive_convert_to_cbz(const char *source_path, const char *dest_path, GError **error)
+archive_convert_to_cbz(const char *source_path, const char *dest_path, GCancellable *cancellable,
+                       ArchiveProgressFunc progress, gpointer user_data, GError **error)
 {
     struct archive *in = archive_read_new();
-    struct archive *out = archive_write_new();
     struct archive_entry *entry;
-    int r;
+    GStatBuf st;
+    int r = ARCHIVE_EOF;
 
     archive_read_support_format_all(in);
     archive_read_support_filter_all(in);
-    
-    archive_write_set_format_zip(out);
 
-    if (archive_read_open_filename(in, source_path, 10240) != ARCHIVE_OK) {
+    if (g_stat(source_path, &st) != 0 || archive_read_open_filename(in, source_path, 65536) != ARCHIVE_OK) {
         g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open source archive: %s", archive_error_string(in));
         archive_read_free(in);
-        archive_write_free(out);
         return FALSE;
     }
 
-    if (archive_write_open_filename(out, dest_path) != ARCHIVE_OK) {
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create destination archive: %s", archive_error_string(out));
+    /* Written under a temporary name so a failed or cancelled conversion
+       never leaves a truncated CBZ behind */
+    char *tmp_path = g_strdup_printf("%s.XXXXXX", dest_path);
+    int fd = g_mkstemp_full(tmp_path, O_WRONLY, 0600);
+    if (fd < 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to create destination archive: %s", g_strerror(errno));
         archive_read_free(in);
-        archive_write_free(out);
+        g_free(tmp_path);
         return FALSE;
     }
+    fchmod(fd, st.st_mode & 0666);
 
-    while ((r = archive_read_next_header(in, &entry)) == ARCHIVE_OK) {
-        /* We might want to ensure the entry name is clean or safe, but for conversion we typically keep it as is. */
-        
-        /* Copy header */
-        /* Note: archive_write_header might fail if the format doesn't support some metadata from the source.
-           We can clone the entry to be safe and strip unsupported fields, but libarchive usually does a best effort. */
-           
-        /* Explicitly unset the size if it is unknown? 
-           Archive entries from RAR usually have size. */
-        
-        if (archive_write_header(out, entry) != ARCHIVE_OK) {
-             g_warning("Failed to write header for %s: %s", archive_entry_pathname(entry), archive_error_string(out));
-             /* Continue or fail? Let's try to continue or break if it's fatal context. */
-             /* If we can't write header, we can't write data. */
-             break;
+    ConvertPipe pipe = { 0 };
+    g_mutex_init(&pipe.lock);
+    g_cond_init(&pipe.cond);
+    g_queue_init(&pipe.items);
+    pipe.cancellable = cancellable;
+    pipe.out = archive_write_new();
+    archive_write_set_format_zip(pipe.out);
+
+    gboolean ok = TRUE;
+    if (archive_write_open_fd(pipe.out, fd) != ARCHIVE_OK) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create destination archive: %s", archive_error_string(pipe.out));
+        ok = FALSE;
+    }
+
+    GThread *writer = ok ? g_thread_new("cbz-writer", convert_writer_thread, &pipe) : NULL;
+
+    while (ok && (r = archive_read_next_header(in, &entry)) == ARCHIVE_OK) {
+        if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+            ok = FALSE;
+            break;
         }
-        
-        /* Copy data */
-        const void *buff;
-        size_t size;
-        int64_t offset;
-        int r2;
-        while ((r2 = archive_read_data_block(in, &buff, &size, &offset)) == ARCHIVE_OK) {
-            if (archive_write_data_block(out, buff, size, offset) != ARCHIVE_OK) {
-                g_warning("Failed to write data block: %s", archive_error_string(out));
+
+        ConvertItem *item = g_new0(ConvertItem, 1);
+        if (archive_entry_filetype(entry) == AE_IFREG) {
+            item->data = read_convert_data(in, entry, error);
+            if (!item->data) {
+                g_free(item);
+                ok = FALSE;
                 break;
             }
         }
-        if (r2 != ARCHIVE_EOF && r2 != ARCHIVE_OK) {
-             g_warning("Error reading data block: %s", archive_error_string(in));
+        item->entry = archive_entry_clone(entry);
+        /* Known up front, which lets stored entries skip the data descriptor */
+        if (item->data) archive_entry_set_size(item->entry, (la_int64_t)g_bytes_get_size(item->data));
+
+        gsize len = item->data ? g_bytes_get_size(item->data) : 0;
+        g_mutex_lock(&pipe.lock);
+        while (pipe.queued > CONVERT_QUEUE_MAX && !pipe.stop)
+            g_cond_wait(&pipe.cond, &pipe.lock);
+        gboolean stopped = pipe.stop;
+        if (!stopped) {
+            g_queue_push_tail(&pipe.items, item);
+            pipe.queued += len;
+            g_cond_broadcast(&pipe.cond);
         }
+        g_mutex_unlock(&pipe.lock);
+
+        if (stopped) {
+            convert_item_free(item);
+            ok = FALSE;
+            break;
+        }
+
+        if (progress) progress((guint64)archive_filter_bytes(in, -1), (guint64)st.st_size, user_data);
     }
+    if (ok && r != ARCHIVE_EOF) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading source archive: %s", archive_error_string(in));
+        ok = FALSE;
+    }
+
+    if (writer) {
+        g_mutex_lock(&pipe.lock);
+        pipe.eof = TRUE;
+        if (!ok) pipe.stop = TRUE; /* Reader failed: writing the rest is pointless */
+        g_cond_broadcast(&pipe.cond);
+        g_mutex_unlock(&pipe.lock);
+        g_thread_join(writer);
+    }
+    g_queue_clear_full(&pipe.items, (GDestroyNotify)convert_item_free);
 
-    if (r != ARCHIVE_EOF && r != ARCHIVE_OK) {
-         g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Error reading source archive: %s", archive_error_string(in));
-         archive_read_close(in);
-         archive_read_free(in);
-         archive_write_close(out);
-         archive_write_free(out);
-         /* Clean up partially written file */
-         g_unlink(dest_path);
-         return FALSE;
+    if (pipe.error) {
+        if (ok) g_propagate_error(error, pipe.error);
+        else g_error_free(pipe.error);
+        ok = FALSE;
     }
 
     archive_read_close(in);
     archive_read_free(in);
-    archive_write_close(out);
-    archive_write_free(out);
+    if (archive_write_close(pipe.out) != ARCHIVE_OK && ok) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to finish destination archive: %s", archive_error_string(pipe.out));
+        ok = FALSE;
+    }
+    archive_write_free(pipe.out);
+    g_mutex_clear(&pipe.lock);
+    g_cond_clear(&pipe.cond);
 
-    return TRUE;
+    if (ok && fsync(fd) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to flush destination archive: %s", g_strerror(errno));
+        ok = FALSE;
+    }
+    close(fd);
+
+    /* link fails when dest_path exists, where a rename would replace it.
+     * Filesystems without hard links fall back to the rename. */
+    if (ok && link(tmp_path, dest_path) != 0) {
+        int saved_errno = errno;
+        if ((saved_errno == EPERM || saved_errno == ENOTSUP || saved_errno == ENOSYS) &&
+            !g_file_test(dest_path, G_FILE_TEST_EXISTS) && g_rename(tmp_path, dest_path) == 0) {
+            g_free(tmp_path);
+            return TRUE;
+        }
+        if (saved_errno == EEXIST)
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_EXISTS, "Destination already exists: %s", dest_path);
+        else
+            g_set_error(error, G_IO_ERROR, g_io_error_from_errno(saved_errno), "Failed to create destination archive: %s", g_strerror(saved_errno));
+        ok = FALSE;
+    }
+    g_unlink(tmp_path);
+    g_free(tmp_path);
+    return ok;
 }
 
 #else /* HAVE_LIBARCHIVE */
@@ -444,6 +1034,13 @@ archive_read_entry_bytes(const char *archive_path, const char *entry_name, GErro
     return NULL;
 }
 
+GBytes *
+archive_read_entry_prefix(const char *archive_path, const char *entry_name, gsize max_len, GError **error)
+{
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "libarchive support not compiled in");
+    return NULL;
+}
+
 gboolean
 archive_get_entry_size(const char *archive_path, const char *entry_name, guint64 *size, GError **error)
 {
@@ -452,14 +1049,21 @@ archive_get_entry_size(const char *archive_path, const char *entry_name, guint64
 }
 
 gboolean
-archive_delete_entry(const char *archive_path, const char *entry_name, GError **error)
+archive_supports_deletion(const char *archive_path)
+{
+    return FALSE;
+}
+
+gboolean
+archive_delete_entries(const char *archive_path, const char * const *entry_names, GError **error)
 {
     g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "libarchive support not compiled in");
     return FALSE;
 }
 
 gboolean
-archive_convert_to_cbz(const char *source_path, const char *dest_path, GError **error)
+archive_convert_to_cbz(const char *source_path, const char *dest_path, GCancellable *cancellable,
+                       ArchiveProgressFunc progress, gpointer user_data, GError **error)
 {
     g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "libarchive support not compiled in");
     return FALSE;
@@ -4,6 +4,14 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+/* Split an archive://<archive>::<entry> path into newly allocated parts.
+ * Returns FALSE, leaving both untouched, for plain paths. */
+gboolean archive_split_path(const char *path, char **archive_path, char **entry_name);
+
+/* TRUE for the extensions played as video rather than decoded as images.
+ * The one list of them; curator_is_supported accepts the same ones. */
+gboolean archive_is_video_path(const char *path);
+
 /* List image entries inside an archive. Returns TRUE on success and fills
  * out_entries with newly allocated strings (use g_ptr_array_unref to free).
  */
@@ -14,6 +22,11 @@ gboolean archive_list_image_entries(const char *archive_path, GPtrArray *out_ent
  * returned GBytes and must unref it. */
 GBytes *archive_read_entry_bytes(const char *archive_path, const char *entry_name, GError **error);
 
+/* Read at most max_len bytes from the start of an entry, e.g. to parse image
+ * headers. Stored ZIP entries read only the prefix; compressed entries stop
+ * decompressing once it is reached. */
+GBytes *archive_read_entry_prefix(const char *archive_path, const char *entry_name, gsize max_len, GError **error);
+
 /* Asynchronous version of archive_read_entry_bytes */
 void archive_read_entry_bytes_async(const char *archive_path, const char *entry_name, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
 GBytes *archive_read_entry_bytes_finish(GAsyncResult *res, GError **error);
@@ -21,11 +34,25 @@ GBytes *archive_read_entry_bytes_finish(GAsyncResult *res, GError **error);
 /* Get size of entry without extracting (if available). */
 gboolean archive_get_entry_size(const char *archive_path, const char *entry_name, guint64 *size, GError **error);
 
-/* Delete a single entry from the archive (Archives must be Zip/CBZ).
- * This performs a streaming rewrite of the archive. */
-gboolean archive_delete_entry(const char *archive_path, const char *entry_name, GError **error);
-
-/* Convert any supported archive format (like CBR/RAR) to a CBZ (Zip) archive. */
-gboolean archive_convert_to_cbz(const char *source_path, const char *dest_path, GError **error);
+/* TRUE when archive_delete_entries can modify archive_path. */
+gboolean archive_supports_deletion(const char *archive_path);
+
+/* Delete the NULL-terminated list of entries from the archive (Archives must
+ * be Zip/CBZ) in one streaming rewrite. The new archive is written to a
+ * temporary file next to it and renamed over the original, so a failure
+ * leaves the original untouched. Blocking; safe on worker threads. */
+gboolean archive_delete_entries(const char *archive_path, const char * const *entry_names, GError **error);
+
+/* Called after each entry with the bytes of the source consumed so far. */
+typedef void (*ArchiveProgressFunc)(guint64 done, guint64 total, gpointer user_data);
+
+/* Convert any supported archive format (like CBR/RAR) to a CBZ (Zip) archive.
+ * Reading the source and writing the ZIP run on two threads; JPEG, PNG, GIF
+ * and WebP pages are stored rather than deflated again. dest_path only
+ * appears once the conversion succeeded, and an existing one is never
+ * replaced (G_IO_ERROR_EXISTS). Blocking; progress is called on
+ * the calling thread. */
+gboolean archive_convert_to_cbz(const char *source_path, const char *dest_path, GCancellable *cancellable,
+                                ArchiveProgressFunc progress, gpointer user_data, GError **error);
 
 #endif /* BRIGHTEYES_ARCHIVE_H */
@@ -0,0 +1,412 @@
+#include "archive_cache.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Archive entry cache (storage)
+ *
+ * Bounded on-disk cache for pages extracted from archives.
+ * - Layout: entries/<md5(archive path)>/<md5(mtime:size:entry name)>, so
+ *   entry names never reach the filesystem and a modified archive misses.
+ * - Accounting: an in-memory table of cached files, kept in LRU order with
+ *   O(1) promotion. Files from earlier sessions are added by a directory
+ *   scan that runs as the writer thread's first job, outside the lock; until
+ *   it is done they simply miss.
+ * - Writes: queued to a single writer thread (FIFO, so an eviction queued
+ *   after a write always runs after it). Bytes stay readable from memory
+ *   until their file is on disk.
+ *
+ * Sections: state, writer thread, initialisation, public API.
+ */
+
+#define DEFAULT_BUDGET_MB 512
+#define KEY_LENGTH 32 /* hex MD5 */
+
+typedef struct {
+    char *path;       /* Full path of the cache file (table key) */
+    guint64 size;
+    GBytes *pending;  /* Bytes not yet written to disk */
+    GList link;       /* Node in cache_lru, data points back to the entry */
+} CacheEntry;
+
+typedef struct {
+    char *path;
+    GBytes *bytes;    /* NULL for an unlink job */
+    gboolean scan;    /* The startup scan instead; path and bytes unused */
+} CacheJob;
+
+G_LOCK_DEFINE_STATIC(cache);
+static GHashTable *cache_table = NULL;   /* path -> CacheEntry* */
+static GQueue cache_lru = G_QUEUE_INIT;  /* Least recently used first */
+static guint64 cache_bytes = 0;
+static guint64 cache_budget = 0;
+static GThreadPool *writer_pool = NULL;
+
+static gint stat_hits = 0;    /* Atomic */
+static gint stat_misses = 0;  /* Atomic */
+static guint64 stat_evictions = 0;
+
+/* --- State --- */
+
+static char *
+get_cache_root(void)
+{
+    return g_build_filename(g_get_user_cache_dir(), "brighteyes", "entries", NULL);
+}
+
+static void
+cache_entry_free(CacheEntry *entry)
+{
+    if (entry->pending) g_bytes_unref(entry->pending);
+    g_free(entry->path);
+    g_free(entry);
+}
+
+/* Key the archive by path and the entry by archive version + name. Returns
+ * NULL when the archive can't be stat'ed. */
+static char *
+get_entry_path(const char *archive_path, const char *entry_name)
+{
+    GStatBuf st;
+    if (g_stat(archive_path, &st) != 0) return NULL;
+
+    char *dir_key = g_compute_checksum_for_string(G_CHECKSUM_MD5, archive_path, -1);
+    char *raw = g_strdup_printf("%" G_GINT64_FORMAT ":%" G_GUINT64_FORMAT ":%s",
+                                (gint64)st.st_mtime, (guint64)st.st_size, entry_name);
+    char *file_key = g_compute_checksum_for_string(G_CHECKSUM_MD5, raw, -1);
+    char *root = get_cache_root();
+    char *path = g_build_filename(root, dir_key, file_key, NULL);
+
+    g_free(root);
+    g_free(file_key);
+    g_free(raw);
+    g_free(dir_key);
+    return path;
+}
+
+static void
+queue_job(char *path, GBytes *bytes)
+{
+    CacheJob *job = g_new0(CacheJob, 1);
+    job->path = path;
+    job->bytes = bytes;
+    g_thread_pool_push(writer_pool, job, NULL);
+}
+
+/* Drop an entry from the accounting and schedule its file for removal.
+ * Called with the cache lock held. */
+static void
+remove_entry_locked(CacheEntry *entry)
+{
+    g_queue_unlink(&cache_lru, &entry->link);
+    cache_bytes -= entry->size;
+    queue_job(g_strdup(entry->path), NULL);
+    g_hash_table_remove(cache_table, entry->path);
+}
+
+static void
+evict_locked(void)
+{
+    while (cache_bytes > cache_budget && cache_lru.head) {
+        CacheEntry *oldest = cache_lru.head->data;
+        remove_entry_locked(oldest);
+        stat_evictions++;
+    }
+}
+
+static CacheEntry *
+add_entry_locked(const char *path, guint64 size)
+{
+    CacheEntry *entry = g_new0(CacheEntry, 1);
+    entry->path = g_strdup(path);
+    entry->size = size;
+    entry->link.data = entry;
+    g_hash_table_insert(cache_table, entry->path, entry);
+    g_queue_push_tail_link(&cache_lru, &entry->link);
+    cache_bytes += size;
+    return entry;
+}
+
+/* --- Writer thread --- */
+
+static void scan_cache_dir(void);
+
+static void
+writer_func(gpointer data, gpointer user_data)
+{
+    CacheJob *job = data;
+
+    if (job->scan) {
+        scan_cache_dir();
+    } else if (!job->bytes) {
+        g_unlink(job->path);
+        char *dir = g_path_get_dirname(job->path);
+        g_rmdir(dir); /* Only succeeds once the archive's directory is empty */
+        g_free(dir);
+    } else {
+        char *dir = g_path_get_dirname(job->path);
+        g_mkdir_with_parents(dir, 0700);
+        g_free(dir);
+
+        gsize len = 0;
+        const char *contents = g_bytes_get_data(job->bytes, &len);
+        /* g_file_set_contents writes to a temp file and renames it into place */
+        gboolean written = g_file_set_contents(job->path, contents ? contents : "", (gssize)len, NULL);
+
+        G_LOCK(cache);
+        CacheEntry *entry = g_hash_table_lookup(cache_table, job->path);
+        if (entry && entry->pending == job->bytes) {
+            g_clear_pointer(&entry->pending, g_bytes_unref);
+            if (!written) remove_entry_locked(entry);
+        }
+        G_UNLOCK(cache);
+
+        g_bytes_unref(job->bytes);
+    }
+
+    g_free(job->path);
+    g_free(job);
+}
+
+/* Remove a directory tree left over from the previous cache layout. */
+static void
+remove_tree(const char *path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const char *name;
+        while ((name = g_dir_read_name(dir))) {
+            char *child = g_build_filename(path, name, NULL);
+            if (g_file_test(child, G_FILE_TEST_IS_DIR) && !g_file_test(child, G_FILE_TEST_IS_SYMLINK))
+                remove_tree(child);
+            else
+                g_unlink(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_rmdir(path);
+}
+
+static gpointer
+legacy_cleanup_func(gpointer data)
+{
+    char *legacy = g_build_filename(g_get_user_cache_dir(), "brighteyes", "archives", NULL);
+    remove_tree(legacy);
+    g_free(legacy);
+    return NULL;
+}
+
+/* --- Initialisation --- */
+
+typedef struct {
+    char *path;
+    guint64 size;
+    gint64 mtime;
+} ScannedFile;
+
+static int
+compare_scanned(gconstpointer a, gconstpointer b)
+{
+    const ScannedFile *fa = a;
+    const ScannedFile *fb = b;
+    return (fa->mtime > fb->mtime) - (fa->mtime < fb->mtime);
+}
+
+/* Add the files on disk to the accounting, oldest modification first and
+ * older than anything stored since startup. Leftover temp files from
+ * interrupted writes are removed; running on the writer thread before any
+ * write, they cannot be ours. Only the merge takes the lock. */
+static void
+scan_cache_dir(void)
+{
+    char *root = get_cache_root();
+    GArray *files = g_array_new(FALSE, FALSE, sizeof(ScannedFile));
+
+    GDir *top = g_dir_open(root, 0, NULL);
+    if (top) {
+        const char *dir_name;
+        while ((dir_name = g_dir_read_name(top))) {
+            char *dir_path = g_build_filename(root, dir_name, NULL);
+            GDir *sub = g_dir_open(dir_path, 0, NULL);
+            if (sub) {
+                const char *file_name;
+                while ((file_name = g_dir_read_name(sub))) {
+                    char *file_path = g_build_filename(dir_path, file_name, NULL);
+                    GStatBuf st;
+                    if (strlen(file_name) != KEY_LENGTH) {
+                        g_unlink(file_path);
+                        g_free(file_path);
+                    } else if (g_stat(file_path, &st) == 0) {
+                        ScannedFile f = { file_path, (guint64)st.st_size, (gint64)st.st_mtime };
+                        g_array_append_val(files, f);
+                    } else {
+                        g_free(file_path);
+                    }
+                }
+                g_dir_close(sub);
+            }
+            g_free(dir_path);
+        }
+        g_dir_close(top);
+    }
+
+    g_array_sort(files, compare_scanned);
+
+    G_LOCK(cache);
+    for (guint i = files->len; i-- > 0; ) {
+        ScannedFile *f = &g_array_index(files, ScannedFile, i);
+        if (!g_hash_table_contains(cache_table, f->path)) {
+            CacheEntry *entry = g_new0(CacheEntry, 1);
+            entry->path = g_strdup(f->path);
+            entry->size = f->size;
+            entry->link.data = entry;
+            g_hash_table_insert(cache_table, entry->path, entry);
+            g_queue_push_head_link(&cache_lru, &entry->link);
+            cache_bytes += f->size;
+        }
+        g_free(f->path);
+    }
+    evict_locked();
+    G_UNLOCK(cache);
+
+    g_array_free(files, TRUE);
+    g_free(root);
+}
+
+static void
+ensure_init_locked(void)
+{
+    if (cache_table) return;
+
+    guint64 budget_mb = DEFAULT_BUDGET_MB;
+    const char *env = g_getenv("BRIGHTEYES_ARCHIVE_CACHE_MB");
+    if (env && *env) {
+        guint64 v = g_ascii_strtoull(env, NULL, 10);
+        if (v > 0) budget_mb = v;
+    }
+    cache_budget = budget_mb * 1024 * 1024;
+
+    cache_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)cache_entry_free);
+    writer_pool = g_thread_pool_new(writer_func, NULL, 1, FALSE, NULL);
+
+    CacheJob *scan = g_new0(CacheJob, 1);
+    scan->scan = TRUE;
+    g_thread_pool_push(writer_pool, scan, NULL);
+
+    GThread *cleanup = g_thread_new("archive-cache-cleanup", legacy_cleanup_func, NULL);
+    g_thread_unref(cleanup);
+}
+
+/* --- Public API --- */
+
+GBytes *
+archive_cache_lookup(const char *archive_path, const char *entry_name)
+{
+    char *path = get_entry_path(archive_path, entry_name);
+    if (!path) return NULL;
+
+    G_LOCK(cache);
+    ensure_init_locked();
+    CacheEntry *entry = g_hash_table_lookup(cache_table, path);
+    GBytes *pending = NULL;
+    if (entry) {
+        g_queue_unlink(&cache_lru, &entry->link);
+        g_queue_push_tail_link(&cache_lru, &entry->link);
+        if (entry->pending) pending = g_bytes_ref(entry->pending);
+    }
+    G_UNLOCK(cache);
+
+    if (!entry) {
+        g_atomic_int_inc(&stat_misses);
+        g_free(path);
+        return NULL;
+    }
+    if (pending) {
+        g_atomic_int_inc(&stat_hits);
+        g_free(path);
+        return pending;
+    }
+
+    char *contents = NULL;
+    gsize len = 0;
+    if (!g_file_get_contents(path, &contents, &len, NULL)) {
+        /* Removed behind our back: forget it */
+        G_LOCK(cache);
+        entry = g_hash_table_lookup(cache_table, path);
+        if (entry && !entry->pending) {
+            g_queue_unlink(&cache_lru, &entry->link);
+            cache_bytes -= entry->size;
+            g_hash_table_remove(cache_table, path);
+        }
+        G_UNLOCK(cache);
+        g_atomic_int_inc(&stat_misses);
+        g_free(path);
+        return NULL;
+    }
+
+    g_atomic_int_inc(&stat_hits);
+    g_free(path);
+    return g_bytes_new_take(contents, len);
+}
+
+void
+archive_cache_store(const char *archive_path, const char *entry_name, GBytes *bytes)
+{
+    g_return_if_fail(bytes != NULL);
+
+    char *path = get_entry_path(archive_path, entry_name);
+    if (!path) return;
+
+    G_LOCK(cache);
+    ensure_init_locked();
+    if (!g_hash_table_contains(cache_table, path) && g_bytes_get_size(bytes) <= cache_budget) {
+        CacheEntry *entry = add_entry_locked(path, g_bytes_get_size(bytes));
+        entry->pending = g_bytes_ref(bytes);
+        queue_job(g_strdup(path), g_bytes_ref(bytes));
+        evict_locked();
+    }
+    G_UNLOCK(cache);
+
+    g_free(path);
+}
+
+void
+archive_cache_invalidate(const char *archive_path)
+{
+    char *dir_key = g_compute_checksum_for_string(G_CHECKSUM_MD5, archive_path, -1);
+    char *root = get_cache_root();
+    char *dir = g_build_filename(root, dir_key, NULL);
+    char *prefix = g_strconcat(dir, G_DIR_SEPARATOR_S, NULL);
+
+    G_LOCK(cache);
+    ensure_init_locked();
+    for (GList *l = cache_lru.head; l; ) {
+        GList *next = l->next;
+        CacheEntry *entry = l->data;
+        if (g_str_has_prefix(entry->path, prefix)) remove_entry_locked(entry);
+        l = next;
+    }
+    G_UNLOCK(cache);
+
+    g_free(prefix);
+    g_free(dir);
+    g_free(root);
+    g_free(dir_key);
+}
+
+void
+archive_cache_get_stats(ArchiveCacheStats *stats)
+{
+    g_return_if_fail(stats != NULL);
+
+    stats->hits = (guint)g_atomic_int_get(&stat_hits);
+    stats->misses = (guint)g_atomic_int_get(&stat_misses);
+
+    G_LOCK(cache);
+    stats->evictions = stat_evictions;
+    stats->bytes = cache_bytes;
+    stats->budget = cache_budget;
+    G_UNLOCK(cache);
+}
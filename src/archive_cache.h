@@ -0,0 +1,34 @@
+#ifndef BRIGHTEYES_ARCHIVE_CACHE_H
+#define BRIGHTEYES_ARCHIVE_CACHE_H
+
+#include <glib.h>
+
+/* Archive entry cache
+ *
+ * Disk cache of extracted archive entries under ~/.cache/brighteyes/entries.
+ * Keys include the archive's mtime and size so a modified archive never
+ * serves stale pages. The cache is bounded by a byte budget (default 512 MB,
+ * override with BRIGHTEYES_ARCHIVE_CACHE_MB) with LRU eviction, and writes
+ * are performed atomically on a background thread.
+ */
+
+typedef struct {
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+    guint64 bytes;     /* Bytes currently accounted in the cache */
+    guint64 budget;
+} ArchiveCacheStats;
+
+/* Returns the cached bytes for an entry or NULL on a miss. Thread-safe. */
+GBytes *archive_cache_lookup(const char *archive_path, const char *entry_name);
+
+/* Queue bytes for an entry to be written; returns immediately. Thread-safe. */
+void archive_cache_store(const char *archive_path, const char *entry_name, GBytes *bytes);
+
+/* Drop every cached entry belonging to an archive (all versions). */
+void archive_cache_invalidate(const char *archive_path);
+
+void archive_cache_get_stats(ArchiveCacheStats *stats);
+
+#endif /* BRIGHTEYES_ARCHIVE_CACHE_H */
@@ -0,0 +1,537 @@
+#include "archive_index.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBARCHIVE
+#include <archive.h>
+#include <archive_entry.h>
+#endif
+
+/* Archive index (model)
+ *
+ * Builds and caches the entry table of CBZ/ZIP and CBR/RAR archives.
+ * - ZIP: the central directory is parsed directly (including ZIP64 records),
+ *   so only the tail of the file is read and every entry gets the offset of
+ *   its local header for direct access.
+ * - Other formats: one libarchive pass records names, sizes and stream order.
+ *
+ * Indexes are validated against the archive's mtime + size, shared through an
+ * in-memory table of the MAX_MEMORY_INDEXES most recently used and persisted
+ * as a GVariant under the user cache dir.
+ *
+ * Sections: lifecycle, ZIP parser, libarchive scan, persistence, public API.
+ */
+
+#define INDEX_FORMAT_VERSION 2
+#define INDEX_VARIANT_TYPE "(usxtba(sttxqu))"
+#define MAX_MEMORY_INDEXES 32
+
+struct _ArchiveIndex {
+    gint ref_count;
+    char *path;
+    gint64 mtime;
+    guint64 file_size;
+    gboolean seekable;
+    GArray *entries;      /* ArchiveIndexEntry */
+    GHashTable *by_name;  /* name -> entry position + 1 */
+};
+
+G_LOCK_DEFINE_STATIC(index_table);
+static GHashTable *index_table = NULL; /* path -> ArchiveIndex* */
+static GQueue index_order = G_QUEUE_INIT; /* paths, least recently used first */
+
+/* --- Lifecycle --- */
+
+static void
+entry_clear(gpointer data)
+{
+    ArchiveIndexEntry *e = data;
+    g_free(e->name);
+}
+
+static ArchiveIndex *
+archive_index_new(const char *path, gint64 mtime, guint64 file_size)
+{
+    ArchiveIndex *index = g_new0(ArchiveIndex, 1);
+    index->ref_count = 1;
+    index->path = g_strdup(path);
+    index->mtime = mtime;
+    index->file_size = file_size;
+    index->entries = g_array_new(FALSE, TRUE, sizeof(ArchiveIndexEntry));
+    g_array_set_clear_func(index->entries, entry_clear);
+    index->by_name = g_hash_table_new(g_str_hash, g_str_equal);
+    return index;
+}
+
+static void
+archive_index_add(ArchiveIndex *index, const char *name, guint64 size, guint64 csize, gint64 offset,
+                  guint16 method, guint ordinal)
+{
+    ArchiveIndexEntry e = { 0 };
+    e.name = g_strdup(name);
+    e.size = size;
+    e.compressed_size = csize;
+    e.offset = offset;
+    e.method = method;
+    e.ordinal = ordinal;
+    g_array_append_val(index->entries, e);
+}
+
+/* Must be called once all entries are added: the name table points into the array. */
+static void
+archive_index_finish(ArchiveIndex *index)
+{
+    for (guint i = 0; i < index->entries->len; i++) {
+        ArchiveIndexEntry *e = &g_array_index(index->entries, ArchiveIndexEntry, i);
+        /* Keep the first occurrence, like a linear scan would */
+        if (!g_hash_table_contains(index->by_name, e->name))
+            g_hash_table_insert(index->by_name, e->name, GUINT_TO_POINTER(i + 1));
+    }
+}
+
+ArchiveIndex *
+archive_index_ref(ArchiveIndex *index)
+{
+    g_return_val_if_fail(index != NULL, NULL);
+    g_atomic_int_inc(&index->ref_count);
+    return index;
+}
+
+void
+archive_index_unref(ArchiveIndex *index)
+{
+    if (!index) return;
+    if (!g_atomic_int_dec_and_test(&index->ref_count)) return;
+    g_hash_table_destroy(index->by_name);
+    g_array_unref(index->entries);
+    g_free(index->path);
+    g_free(index);
+}
+
+/* --- ZIP central directory parser --- */
+
+#define ZIP_EOCD_SIG      0x06054b50
+#define ZIP64_LOCATOR_SIG 0x07064b50
+#define ZIP64_EOCD_SIG    0x06064b50
+#define ZIP_CDIR_SIG      0x02014b50
+#define ZIP_EOCD_SIZE     22
+#define ZIP64_LOCATOR_SIZE 20
+#define ZIP_CDIR_SIZE     46
+#define ZIP_MAX_COMMENT   65535
+
+static inline guint16
+rd16(const guint8 *p)
+{
+    return (guint16)(p[0] | (p[1] << 8));
+}
+
+static inline guint32
+rd32(const guint8 *p)
+{
+    return (guint32)p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+}
+
+static inline guint64
+rd64(const guint8 *p)
+{
+    return (guint64)rd32(p) | ((guint64)rd32(p + 4) << 32);
+}
+
+static gboolean
+pread_full(int fd, void *buf, gsize len, guint64 offset)
+{
+    guint8 *p = buf;
+    while (len > 0) {
+        ssize_t r = pread(fd, p, len, (off_t)offset);
+        if (r <= 0) return FALSE;
+        p += r;
+        len -= (gsize)r;
+        offset += (guint64)r;
+    }
+    return TRUE;
+}
+
+/* Returns FALSE when the file is not a (readable) ZIP; the caller then falls
+ * back to a libarchive scan. */
+static gboolean
+parse_zip_central_directory(int fd, ArchiveIndex *index)
+{
+    guint64 file_size = index->file_size;
+    if (file_size < ZIP_EOCD_SIZE) return FALSE;
+
+    gsize tail_len = (gsize)MIN(file_size, (guint64)(ZIP_EOCD_SIZE + ZIP_MAX_COMMENT + ZIP64_LOCATOR_SIZE));
+    guint64 tail_off = file_size - tail_len;
+    guint8 *tail = g_malloc(tail_len);
+    if (!pread_full(fd, tail, tail_len, tail_off)) {
+        g_free(tail);
+        return FALSE;
+    }
+
+    /* Find the end of central directory record, scanning backwards */
+    gssize eocd = -1;
+    for (gssize i = (gssize)tail_len - ZIP_EOCD_SIZE; i >= 0; i--) {
+        if (rd32(tail + i) == ZIP_EOCD_SIG) {
+            eocd = i;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        g_free(tail);
+        return FALSE;
+    }
+
+    const guint8 *e = tail + eocd;
+    guint64 n_entries = rd16(e + 10);
+    guint64 cd_size = rd32(e + 12);
+    guint64 cd_offset = rd32(e + 16);
+
+    if (n_entries == 0xFFFF || cd_size == 0xFFFFFFFF || cd_offset == 0xFFFFFFFF) {
+        /* ZIP64: the locator sits right before the classic record */
+        if (eocd < ZIP64_LOCATOR_SIZE || rd32(e - ZIP64_LOCATOR_SIZE) != ZIP64_LOCATOR_SIG) {
+            g_free(tail);
+            return FALSE;
+        }
+        guint64 z64_off = rd64(e - ZIP64_LOCATOR_SIZE + 8);
+        guint8 z64[56];
+        if (z64_off + sizeof(z64) > file_size || !pread_full(fd, z64, sizeof(z64), z64_off) ||
+            rd32(z64) != ZIP64_EOCD_SIG) {
+            g_free(tail);
+            return FALSE;
+        }
+        n_entries = rd64(z64 + 32);
+        cd_size = rd64(z64 + 40);
+        cd_offset = rd64(z64 + 48);
+    }
+    g_free(tail);
+
+    if (cd_offset > file_size || cd_size > file_size - cd_offset || cd_size > G_MAXUINT32)
+        return FALSE;
+
+    guint8 *cd = g_malloc(cd_size ? cd_size : 1);
+    if (!pread_full(fd, cd, (gsize)cd_size, cd_offset)) {
+        g_free(cd);
+        return FALSE;
+    }
+
+    gsize pos = 0;
+    gboolean ok = TRUE;
+    for (guint64 i = 0; i < n_entries; i++) {
+        if (pos + ZIP_CDIR_SIZE > cd_size || rd32(cd + pos) != ZIP_CDIR_SIG) {
+            ok = FALSE;
+            break;
+        }
+        const guint8 *r = cd + pos;
+        guint16 flags = rd16(r + 8);
+        guint16 method = rd16(r + 10);
+        guint64 csize = rd32(r + 20);
+        guint64 usize = rd32(r + 24);
+        guint16 name_len = rd16(r + 28);
+        guint16 extra_len = rd16(r + 30);
+        guint16 comment_len = rd16(r + 32);
+        guint64 local_off = rd32(r + 42);
+
+        gsize rec_len = ZIP_CDIR_SIZE + (gsize)name_len + extra_len + comment_len;
+        if (pos + rec_len > cd_size) {
+            ok = FALSE;
+            break;
+        }
+
+        /* ZIP64 extended information: only saturated fields are present, in order */
+        const guint8 *extra = r + ZIP_CDIR_SIZE + name_len;
+        gsize xp = 0;
+        while (xp + 4 <= extra_len) {
+            guint16 id = rd16(extra + xp);
+            guint16 len = rd16(extra + xp + 2);
+            if (xp + 4 + len > extra_len) break;
+            if (id == 0x0001) {
+                const guint8 *f = extra + xp + 4;
+                gsize fl = len;
+                if (usize == 0xFFFFFFFF && fl >= 8) { usize = rd64(f); f += 8; fl -= 8; }
+                if (csize == 0xFFFFFFFF && fl >= 8) { csize = rd64(f); f += 8; fl -= 8; }
+                if (local_off == 0xFFFFFFFF && fl >= 8) { local_off = rd64(f); }
+                break;
+            }
+            xp += 4 + (gsize)len;
+        }
+
+        char *name = g_strndup((const char *)(r + ZIP_CDIR_SIZE), name_len);
+        /* Directories carry no data; encrypted entries cannot be read directly */
+        if (name_len > 0 && !g_str_has_suffix(name, "/")) {
+            gint64 offset = (flags & 0x0001) || local_off >= file_size ? -1 : (gint64)local_off;
+            archive_index_add(index, name, usize, csize, offset, method, (guint)i);
+        }
+        g_free(name);
+        pos += rec_len;
+    }
+
+    g_free(cd);
+    if (!ok) {
+        g_array_set_size(index->entries, 0);
+        return FALSE;
+    }
+    index->seekable = TRUE;
+    return TRUE;
+}
+
+/* --- libarchive scan (RAR, 7z, tar, damaged ZIPs) --- */
+
+#ifdef HAVE_LIBARCHIVE
+static gboolean
+scan_with_libarchive(ArchiveIndex *index, GError **error)
+{
+    struct archive *a = archive_read_new();
+    struct archive_entry *entry = NULL;
+
+    if (!a) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create archive reader");
+        return FALSE;
+    }
+
+    archive_read_support_format_all(a);
+    archive_read_support_filter_all(a);
+
+    if (archive_read_open_filename(a, index->path, 10240) != ARCHIVE_OK) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to open archive: %s", archive_error_string(a));
+        archive_read_free(a);
+        return FALSE;
+    }
+
+    /* Ordinals count every header in the stream (directories included) so a
+     * reader positioned at header N knows how far ahead an entry is */
+    guint ordinal = 0;
+    while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
+        const char *name = archive_entry_pathname(entry);
+        if (name && archive_entry_filetype(entry) != AE_IFDIR) {
+            gint64 size = archive_entry_size_is_set(entry) ? archive_entry_size(entry) : 0;
+            archive_index_add(index, name, (guint64)MAX(size, 0), 0, -1, 0, ordinal);
+        }
+        archive_read_data_skip(a);
+        ordinal++;
+    }
+
+    archive_read_free(a);
+    index->seekable = FALSE;
+    return TRUE;
+}
+#endif
+
+/* --- Persistence --- */
+
+static char *
+get_index_cache_path(const char *archive_path)
+{
+    char *sum = g_compute_checksum_for_string(G_CHECKSUM_MD5, archive_path, -1);
+    char *path = g_build_filename(g_get_user_cache_dir(), "brighteyes", "index", sum, NULL);
+    g_free(sum);
+    return path;
+}
+
+static ArchiveIndex *
+load_from_disk(const char *archive_path, gint64 mtime, guint64 file_size)
+{
+    char *cache_path = get_index_cache_path(archive_path);
+    char *contents = NULL;
+    gsize len = 0;
+    gboolean loaded = g_file_get_contents(cache_path, &contents, &len, NULL);
+    g_free(cache_path);
+    if (!loaded) return NULL;
+
+    GVariant *v = g_variant_new_from_data(G_VARIANT_TYPE(INDEX_VARIANT_TYPE), contents, len,
+                                          FALSE, g_free, contents);
+    g_variant_ref_sink(v);
+
+    guint32 version = 0;
+    const char *path = NULL;
+    gint64 v_mtime = 0;
+    guint64 v_size = 0;
+    gboolean seekable = FALSE;
+    GVariantIter *iter = NULL;
+    g_variant_get(v, "(u&sxtba(sttxqu))", &version, &path, &v_mtime, &v_size, &seekable, &iter);
+
+    ArchiveIndex *index = NULL;
+    if (version == INDEX_FORMAT_VERSION && g_strcmp0(path, archive_path) == 0 &&
+        v_mtime == mtime && v_size == file_size) {
+        index = archive_index_new(archive_path, mtime, file_size);
+        index->seekable = seekable;
+        const char *name;
+        guint64 size, csize;
+        gint64 offset;
+        guint16 method;
+        guint32 ordinal;
+        while (g_variant_iter_next(iter, "(&sttxqu)", &name, &size, &csize, &offset, &method, &ordinal))
+            archive_index_add(index, name, size, csize, offset, method, ordinal);
+        archive_index_finish(index);
+    }
+
+    g_variant_iter_free(iter);
+    g_variant_unref(v);
+    return index;
+}
+
+static void
+save_to_disk(ArchiveIndex *index)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sttxqu)"));
+    for (guint i = 0; i < index->entries->len; i++) {
+        ArchiveIndexEntry *e = &g_array_index(index->entries, ArchiveIndexEntry, i);
+        /* GVariant strings must be valid UTF-8; such archives are simply rescanned */
+        if (!g_utf8_validate(e->name, -1, NULL)) {
+            g_variant_builder_clear(&builder);
+            return;
+        }
+        g_variant_builder_add(&builder, "(sttxqu)", e->name, e->size, e->compressed_size,
+                              e->offset, e->method, e->ordinal);
+    }
+
+    if (!g_utf8_validate(index->path, -1, NULL)) {
+        g_variant_builder_clear(&builder);
+        return;
+    }
+
+    GVariant *v = g_variant_new("(usxtba(sttxqu))", (guint32)INDEX_FORMAT_VERSION, index->path,
+                                index->mtime, index->file_size, index->seekable, &builder);
+    g_variant_ref_sink(v);
+
+    char *cache_path = get_index_cache_path(index->path);
+    char *dir = g_path_get_dirname(cache_path);
+    g_mkdir_with_parents(dir, 0700);
+    g_free(dir);
+    g_file_set_contents(cache_path, g_variant_get_data(v), (gssize)g_variant_get_size(v), NULL);
+    g_free(cache_path);
+    g_variant_unref(v);
+}
+
+/* --- Public API --- */
+
+static ArchiveIndex *
+build_index(const char *archive_path, gint64 mtime, guint64 file_size, GError **error)
+{
+    ArchiveIndex *index = archive_index_new(archive_path, mtime, file_size);
+
+    int fd = g_open(archive_path, O_RDONLY, 0);
+    if (fd < 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to open archive: %s", g_strerror(errno));
+        archive_index_unref(index);
+        return NULL;
+    }
+    gboolean parsed = parse_zip_central_directory(fd, index);
+    close(fd);
+
+    if (!parsed) {
+#ifdef HAVE_LIBARCHIVE
+        if (!scan_with_libarchive(index, error)) {
+            archive_index_unref(index);
+            return NULL;
+        }
+#else
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "libarchive support not compiled in");
+        archive_index_unref(index);
+        return NULL;
+#endif
+    }
+
+    archive_index_finish(index);
+    save_to_disk(index);
+    return index;
+}
+
+ArchiveIndex *
+archive_index_get(const char *archive_path, GError **error)
+{
+    g_return_val_if_fail(archive_path != NULL, NULL);
+
+    GStatBuf st;
+    if (g_stat(archive_path, &st) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to stat archive: %s", g_strerror(errno));
+        return NULL;
+    }
+    gint64 mtime = (gint64)st.st_mtime;
+    guint64 file_size = (guint64)st.st_size;
+
+    G_LOCK(index_table);
+    if (!index_table)
+        index_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)archive_index_unref);
+    ArchiveIndex *cached = g_hash_table_lookup(index_table, archive_path);
+    if (cached && cached->mtime == mtime && cached->file_size == file_size) {
+        /* At most MAX_MEMORY_INDEXES links, so the walk is cheap */
+        GList *link = g_queue_find_custom(&index_order, archive_path, (GCompareFunc)g_strcmp0);
+        if (link) {
+            g_queue_unlink(&index_order, link);
+            g_queue_push_tail_link(&index_order, link);
+        }
+        archive_index_ref(cached);
+        G_UNLOCK(index_table);
+        return cached;
+    }
+    G_UNLOCK(index_table);
+
+    /* Build outside the lock; two threads racing on one archive both produce
+     * identical indexes and the last one wins the table slot. */
+    ArchiveIndex *index = load_from_disk(archive_path, mtime, file_size);
+    if (!index) index = build_index(archive_path, mtime, file_size, error);
+    if (!index) return NULL;
+
+    G_LOCK(index_table);
+    if (!g_hash_table_contains(index_table, archive_path)) {
+        g_queue_push_tail(&index_order, g_strdup(archive_path));
+        while (g_queue_get_length(&index_order) > MAX_MEMORY_INDEXES) {
+            char *oldest = g_queue_pop_head(&index_order);
+            g_hash_table_remove(index_table, oldest);
+            g_free(oldest);
+        }
+    }
+    g_hash_table_replace(index_table, g_strdup(archive_path), archive_index_ref(index));
+    G_UNLOCK(index_table);
+
+    return index;
+}
+
+gboolean
+archive_index_is_seekable(ArchiveIndex *index)
+{
+    return index->seekable;
+}
+
+guint
+archive_index_get_n_entries(ArchiveIndex *index)
+{
+    return index->entries->len;
+}
+
+const ArchiveIndexEntry *
+archive_index_get_entry(ArchiveIndex *index, guint i)
+{
+    g_return_val_if_fail(i < index->entries->len, NULL);
+    return &g_array_index(index->entries, ArchiveIndexEntry, i);
+}
+
+const ArchiveIndexEntry *
+archive_index_lookup(ArchiveIndex *index, const char *name)
+{
+    guint pos = GPOINTER_TO_UINT(g_hash_table_lookup(index->by_name, name));
+    if (pos == 0) return NULL;
+    return &g_array_index(index->entries, ArchiveIndexEntry, pos - 1);
+}
+
+void
+archive_index_invalidate(const char *archive_path)
+{
+    G_LOCK(index_table);
+    if (index_table && g_hash_table_remove(index_table, archive_path)) {
+        GList *link = g_queue_find_custom(&index_order, archive_path, (GCompareFunc)g_strcmp0);
+        if (link) {
+            g_free(link->data);
+            g_queue_delete_link(&index_order, link);
+        }
+    }
+    G_UNLOCK(index_table);
+
+    char *cache_path = get_index_cache_path(archive_path);
+    g_unlink(cache_path);
+    g_free(cache_path);
+}
@@ -0,0 +1,44 @@
+#ifndef BRIGHTEYES_ARCHIVE_INDEX_H
+#define BRIGHTEYES_ARCHIVE_INDEX_H
+
+#include <glib.h>
+
+/* Archive index
+ *
+ * A table of the entries inside an archive (name, uncompressed size and, for
+ * ZIP/CBZ files, the offset of the entry's local header). The index is built
+ * once per archive, keyed by path + mtime + size, shared between all callers
+ * and persisted under ~/.cache/brighteyes/index so later sessions can skip
+ * the scan entirely.
+ */
+
+typedef struct {
+    char *name;
+    guint64 size;            /* Uncompressed size */
+    guint64 compressed_size;
+    gint64 offset;           /* Local header offset (ZIP only), -1 if unknown */
+    guint16 method;          /* ZIP compression method (0 = store, 8 = deflate) */
+    guint ordinal;           /* Position of the entry in the archive stream */
+} ArchiveIndexEntry;
+
+typedef struct _ArchiveIndex ArchiveIndex;
+
+/* Returns the index for archive_path, building (or loading from disk) when
+ * needed. Safe to call from worker threads. Caller owns the returned ref. */
+ArchiveIndex *archive_index_get(const char *archive_path, GError **error);
+ArchiveIndex *archive_index_ref(ArchiveIndex *index);
+void archive_index_unref(ArchiveIndex *index);
+
+/* TRUE when entries can be read directly at their recorded offsets (ZIP). */
+gboolean archive_index_is_seekable(ArchiveIndex *index);
+
+guint archive_index_get_n_entries(ArchiveIndex *index);
+const ArchiveIndexEntry *archive_index_get_entry(ArchiveIndex *index, guint i);
+const ArchiveIndexEntry *archive_index_lookup(ArchiveIndex *index, const char *name);
+
+/* Drop the in-memory and on-disk index for an archive (e.g. after rewriting it). */
+void archive_index_invalidate(const char *archive_path);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(ArchiveIndex, archive_index_unref)
+
+#endif /* BRIGHTEYES_ARCHIVE_INDEX_H */
@@ -0,0 +1,355 @@
+#include "cbzbatch.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include "archive.h"
+
+/* CBZ conversion batch (model)
+ *
+ * Converts a list of archives to CBZ:
+ * - Workers: a GThreadPool with one thread per two cores, as every
+ *   conversion also runs its own writer thread.
+ * - Progress: workers add the source bytes they have read to a shared
+ *   counter and queue at most one progress emission on the main thread at
+ *   a time, so thousands of pages do not flood the main loop.
+ * - Cancel: queued sources are dropped and running conversions stop after
+ *   their current page; their partial output is removed.
+ *
+ * Sections: helpers, workers, lifecycle, public API.
+ */
+
+struct _CbzBatch {
+    GObject parent_instance;
+    GPtrArray *sources;
+
+    GCancellable *cancellable;
+    GThreadPool *pool;
+
+    GMutex progress_lock;
+    guint64 bytes_total;
+    guint64 bytes_done;      /* Under progress_lock */
+    gint progress_queued;    /* Atomic: an emission is pending on the main loop */
+
+    guint total;
+    guint converted;         /* Converted, skipped or failed */
+    guint failed;
+    guint skipped;
+    guint pending;           /* Jobs queued or running */
+    char *last_error;
+    gboolean running;
+};
+
+typedef struct {
+    CbzBatch *batch; /* Keeps the batch alive until convert_job_done has counted this source */
+    char *source;
+    char *dest;
+    guint64 size;
+    guint64 done;    /* Bytes of source already added to bytes_done */
+    gboolean ok;
+    gboolean skipped;
+    GError *error;
+} ConvertJob;
+
+enum {
+    SIGNAL_PROGRESS,
+    SIGNAL_FINISHED,
+    N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_TYPE(CbzBatch, cbz_batch, G_TYPE_OBJECT)
+
+/* --- Helpers --- */
+
+static gboolean
+is_convertible_name(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    return ext && g_ascii_strcasecmp(ext, ".cbr") == 0;
+}
+
+static int
+compare_paths(gconstpointer a, gconstpointer b)
+{
+    return g_utf8_collate(*(const char **)a, *(const char **)b);
+}
+
+static void
+convert_job_free(ConvertJob *job)
+{
+    g_clear_object(&job->batch);
+    g_free(job->source);
+    g_free(job->dest);
+    g_clear_error(&job->error);
+    g_free(job);
+}
+
+/* --- Workers --- */
+
+static gboolean
+emit_progress(gpointer user_data)
+{
+    CbzBatch *self = BRIGHTEYES_CBZ_BATCH(user_data);
+
+    g_atomic_int_set(&self->progress_queued, 0);
+    g_mutex_lock(&self->progress_lock);
+    double fraction = self->bytes_total ? (double)self->bytes_done / (double)self->bytes_total : 1.0;
+    g_mutex_unlock(&self->progress_lock);
+
+    g_signal_emit(self, signals[SIGNAL_PROGRESS], 0, self->converted, self->total, MIN(fraction, 1.0));
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queue_progress(CbzBatch *self)
+{
+    if (g_atomic_int_compare_and_exchange(&self->progress_queued, 0, 1))
+        g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT_IDLE, emit_progress,
+                                   g_object_ref(self), g_object_unref);
+}
+
+static void
+add_bytes(ConvertJob *job, guint64 done)
+{
+    CbzBatch *self = job->batch;
+    done = MIN(done, job->size);
+    if (done <= job->done) return;
+
+    g_mutex_lock(&self->progress_lock);
+    self->bytes_done += done - job->done;
+    g_mutex_unlock(&self->progress_lock);
+    job->done = done;
+    queue_progress(self);
+}
+
+static void
+on_convert_progress(guint64 done, guint64 total, gpointer user_data)
+{
+    add_bytes(user_data, done);
+}
+
+static void
+cbz_batch_finish(CbzBatch *self)
+{
+    /* pending only reaches 0 after every convert_worker has handed its job
+     * back, so freeing the pool without waiting cannot drop a conversion */
+    g_thread_pool_free(self->pool, FALSE, FALSE);
+    self->pool = NULL;
+    self->running = FALSE;
+    g_signal_emit(self, signals[SIGNAL_FINISHED], 0, g_cancellable_is_cancelled(self->cancellable));
+}
+
+static gboolean
+convert_job_done(gpointer user_data)
+{
+    ConvertJob *job = user_data;
+    CbzBatch *self = job->batch;
+
+    self->converted++;
+    if (job->skipped) {
+        self->skipped++;
+    } else if (!job->ok && !g_error_matches(job->error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        self->failed++;
+        g_free(self->last_error);
+        self->last_error = g_strdup(job->error ? job->error->message : "Conversion failed");
+    }
+    self->pending--;
+
+    emit_progress(self);
+    if (self->pending == 0)
+        cbz_batch_finish(self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+convert_worker(gpointer data, gpointer user_data)
+{
+    ConvertJob *job = data;
+    CbzBatch *self = job->batch;
+
+    if (g_cancellable_set_error_if_cancelled(self->cancellable, &job->error)) {
+        /* Dropped */
+    } else if (archive_convert_to_cbz(job->source, job->dest, self->cancellable,
+                                      on_convert_progress, job, &job->error)) {
+        job->ok = TRUE;
+    } else if (g_error_matches(job->error, G_IO_ERROR, G_IO_ERROR_EXISTS)) {
+        /* The CBZ appeared since the folder was listed; it is left alone */
+        job->skipped = TRUE;
+    } else if (!g_error_matches(job->error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_warning("Conversion of %s failed: %s", job->source, job->error->message);
+    }
+
+    /* Whatever happened, this source no longer counts as unread */
+    add_bytes(job, job->size);
+    g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT, convert_job_done, job, (GDestroyNotify)convert_job_free);
+}
+
+/* --- Lifecycle --- */
+
+static void
+cbz_batch_dispose(GObject *object)
+{
+    CbzBatch *self = BRIGHTEYES_CBZ_BATCH(object);
+    /* Any conversion would still hold a ref through its ConvertJob; this
+     * only stops a batch the window let go of between start and finish */
+    g_cancellable_cancel(self->cancellable);
+    G_OBJECT_CLASS(cbz_batch_parent_class)->dispose(object);
+}
+
+static void
+cbz_batch_finalize(GObject *object)
+{
+    CbzBatch *self = BRIGHTEYES_CBZ_BATCH(object);
+    g_mutex_clear(&self->progress_lock);
+    g_clear_object(&self->cancellable);
+    g_ptr_array_unref(self->sources);
+    g_free(self->last_error);
+    G_OBJECT_CLASS(cbz_batch_parent_class)->finalize(object);
+}
+
+static void
+cbz_batch_class_init(CbzBatchClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = cbz_batch_dispose;
+    object_class->finalize = cbz_batch_finalize;
+
+    signals[SIGNAL_PROGRESS] = g_signal_new("progress",
+                                            G_TYPE_FROM_CLASS(klass),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL, NULL,
+                                            G_TYPE_NONE, 3,
+                                            G_TYPE_UINT, G_TYPE_UINT, G_TYPE_DOUBLE);
+
+    signals[SIGNAL_FINISHED] = g_signal_new("finished",
+                                            G_TYPE_FROM_CLASS(klass),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL, NULL,
+                                            G_TYPE_NONE, 1,
+                                            G_TYPE_BOOLEAN);
+}
+
+static void
+cbz_batch_init(CbzBatch *self)
+{
+    g_mutex_init(&self->progress_lock);
+    self->cancellable = g_cancellable_new();
+}
+
+/* --- Public API --- */
+
+CbzBatch *
+cbz_batch_new(GPtrArray *sources)
+{
+    CbzBatch *self = g_object_new(TYPE_CBZ_BATCH, NULL);
+    self->sources = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; sources && i < sources->len; i++)
+        g_ptr_array_add(self->sources, g_strdup(g_ptr_array_index(sources, i)));
+    return self;
+}
+
+GPtrArray *
+cbz_batch_find_sources(const char *dir)
+{
+    GPtrArray *sources = g_ptr_array_new_with_free_func(g_free);
+    GDir *d = g_dir_open(dir, 0, NULL);
+    if (!d) return sources;
+
+    const char *name;
+    while ((name = g_dir_read_name(d))) {
+        if (!is_convertible_name(name)) continue;
+        char *path = g_build_filename(dir, name, NULL);
+        char *dest = cbz_batch_destination_for(path);
+        if (!g_file_test(dest, G_FILE_TEST_EXISTS))
+            g_ptr_array_add(sources, path);
+        else
+            g_free(path);
+        g_free(dest);
+    }
+    g_dir_close(d);
+
+    g_ptr_array_sort(sources, compare_paths);
+    return sources;
+}
+
+char *
+cbz_batch_destination_for(const char *source)
+{
+    const char *dot = strrchr(source, '.');
+    const char *slash = strrchr(source, G_DIR_SEPARATOR);
+    if (dot && (!slash || dot > slash) && g_ascii_strcasecmp(dot, ".cbr") == 0) {
+        char *stem = g_strndup(source, dot - source);
+        char *dest = g_strconcat(stem, ".cbz", NULL);
+        g_free(stem);
+        return dest;
+    }
+    return g_strconcat(source, ".cbz", NULL);
+}
+
+void
+cbz_batch_start(CbzBatch *self)
+{
+    if (self->running) return;
+
+    self->total = self->sources->len;
+    self->converted = 0;
+    self->failed = 0;
+    self->skipped = 0;
+    self->pending = 0;
+    self->bytes_total = 0;
+    self->bytes_done = 0;
+    g_clear_pointer(&self->last_error, g_free);
+    self->running = TRUE;
+    g_cancellable_reset(self->cancellable);
+
+    guint threads = MAX(1, g_get_num_processors() / 2);
+    self->pool = g_thread_pool_new(convert_worker, NULL, (gint)threads, FALSE, NULL);
+    for (guint i = 0; i < self->sources->len; i++) {
+        const char *source = g_ptr_array_index(self->sources, i);
+        GStatBuf st;
+
+        ConvertJob *job = g_new0(ConvertJob, 1);
+        job->batch = g_object_ref(self);
+        job->source = g_strdup(source);
+        job->dest = cbz_batch_destination_for(source);
+        job->size = g_stat(source, &st) == 0 ? (guint64)st.st_size : 0;
+        self->bytes_total += job->size;
+        self->pending++;
+        g_thread_pool_push(self->pool, job, NULL);
+    }
+
+    emit_progress(self);
+    if (self->pending == 0)
+        cbz_batch_finish(self);
+}
+
+void
+cbz_batch_cancel(CbzBatch *self)
+{
+    g_cancellable_cancel(self->cancellable);
+}
+
+gboolean
+cbz_batch_is_running(CbzBatch *self)
+{
+    return self->running;
+}
+
+guint
+cbz_batch_get_n_failed(CbzBatch *self)
+{
+    return self->failed;
+}
+
+guint
+cbz_batch_get_n_skipped(CbzBatch *self)
+{
+    return self->skipped;
+}
+
+const char *
+cbz_batch_get_last_error(CbzBatch *self)
+{
+    return self->last_error;
+}
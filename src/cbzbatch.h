@@ -0,0 +1,43 @@
+#ifndef CBZBATCH_H
+#define CBZBATCH_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define TYPE_CBZ_BATCH (cbz_batch_get_type())
+G_DECLARE_FINAL_TYPE(CbzBatch, cbz_batch, BRIGHTEYES, CBZ_BATCH, GObject)
+
+/* Converts archives (typically CBR) to CBZ next to the originals, several
+ * at a time on a thread pool. Each conversion is itself a two-thread
+ * pipeline (see archive_convert_to_cbz). Sources whose CBZ already exists
+ * are skipped; originals are never removed.
+ *
+ * Signals (main thread):
+ *   "progress" (guint converted, guint total, gdouble fraction)
+ *     converted counts finished sources (converted, skipped or failed);
+ *     fraction is the share of all source bytes read so far. Emitted as
+ *     often as the main loop keeps up with.
+ *   "finished" (gboolean cancelled)
+ *     Once every source has been handled or dropped. */
+CbzBatch *cbz_batch_new(GPtrArray *sources);
+
+/* The archives in dir that can be converted and have no CBZ yet, sorted. */
+GPtrArray *cbz_batch_find_sources(const char *dir);
+
+/* Where source is converted to: its name with a .cbz extension. */
+char *cbz_batch_destination_for(const char *source);
+
+void cbz_batch_start(CbzBatch *self);
+void cbz_batch_cancel(CbzBatch *self);
+gboolean cbz_batch_is_running(CbzBatch *self);
+
+guint cbz_batch_get_n_failed(CbzBatch *self);
+guint cbz_batch_get_n_skipped(CbzBatch *self);
+
+/* Message of the last failure, or NULL */
+const char *cbz_batch_get_last_error(CbzBatch *self);
+
+G_END_DECLS
+
+#endif /* CBZBATCH_H */
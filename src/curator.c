@@ -8,24 +8,54 @@
  *
  * Maintains the list of supported media files in a directory and the
  * current index. Provides navigation helpers and file operations.
+ * Directories are scanned asynchronously in batches; each sorted batch is
+ * merged into the list and reported through "items-changed" so views can
+ * mirror the list without rebuilding it. Loaded directories are watched with
+ * a GFileMonitor and files that appear, disappear or are renamed are applied
+ * as sorted inserts and removals. Scans can be held back (during startup,
+ * so the first image is not competing with the enumeration for I/O) and
+ * start when released.
  *
- * Sections: lifecycle (init/dispose), public API (load/get/set), helpers.
+ * Sections: lifecycle (init/dispose), list changes, async scan, watching,
+ * public API (load/get/set), helpers.
  */
 
+#define LOAD_BATCH_SIZE 256
+
 struct _Curator {
     GObject parent_instance;
     GPtrArray *files; /* Array of full paths (strings) */
     int current_index;
     char *current_directory;
+    GCancellable *load_cancellable; /* Non-NULL while a scan is running */
+    GFileMonitor *monitor;          /* Watches current_directory (not archives) */
+    gboolean scans_held;            /* See curator_hold_scans */
+    char *held_scan;                /* Directory to scan once released */
+};
+
+enum {
+    SIGNAL_ITEMS_CHANGED,
+    SIGNAL_LOAD_PROGRESS,
+    N_SIGNALS
 };
 
+static guint signals[N_SIGNALS];
+
 G_DEFINE_TYPE(Curator, curator, G_TYPE_OBJECT)
 
+static int compare_paths(const char *a, const char *b);
+static int compare_strings(gconstpointer a, gconstpointer b);
+static void curator_cancel_load(Curator *self);
+static void curator_watch(Curator *self, const char *path);
+
 static void
 curator_dispose(GObject *object)
 {
     Curator *self = BRIGHTEYES_CURATOR(object);
 
+    curator_cancel_load(self);
+    curator_watch(self, NULL);
+
     if (self->files) {
         g_ptr_array_unref(self->files);
         self->files = NULL;
@@ -50,6 +80,22 @@ curator_class_init(CuratorClass *klass)
     GObjectClass *object_class = G_OBJECT_CLASS(klass);
     object_class->dispose = curator_dispose;
     object_class->finalize = curator_finalize;
+
+    /* Same meaning as GListModel::items-changed, for the files array */
+    signals[SIGNAL_ITEMS_CHANGED] = g_signal_new("items-changed",
+                                                 G_TYPE_FROM_CLASS(klass),
+                                                 G_SIGNAL_RUN_LAST,
+                                                 0, NULL, NULL, NULL,
+                                                 G_TYPE_NONE, 3,
+                                                 G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+
+    /* Emitted after each merged batch of a scan: (n_files, finished) */
+    signals[SIGNAL_LOAD_PROGRESS] = g_signal_new("load-progress",
+                                                 G_TYPE_FROM_CLASS(klass),
+                                                 G_SIGNAL_RUN_LAST,
+                                                 0, NULL, NULL, NULL,
+                                                 G_TYPE_NONE, 2,
+                                                 G_TYPE_UINT, G_TYPE_BOOLEAN);
 }
 
 static void
@@ -59,6 +105,333 @@ curator_init(Curator *self)
     self->current_index = -1;
 }
 
+/* --- List changes --- */
+
+static void
+emit_items_changed(Curator *self, guint position, guint removed, guint added)
+{
+    if (removed == 0 && added == 0) return;
+    g_signal_emit(self, signals[SIGNAL_ITEMS_CHANGED], 0, position, removed, added);
+}
+
+/* Empty the list, reporting the removal. */
+static void
+curator_clear(Curator *self)
+{
+    guint removed = self->files->len;
+    g_ptr_array_set_size(self->files, 0);
+    self->current_index = -1;
+    emit_items_changed(self, 0, removed, 0);
+}
+
+/* Merge a sorted batch into the (sorted) list. Takes ownership of the
+ * strings in batch; duplicates are dropped. One items-changed is emitted per
+ * run of consecutive inserts, in increasing order, after the merge. */
+static void
+curator_merge_sorted(Curator *self, GPtrArray *batch)
+{
+    if (batch->len == 0) return;
+
+    GPtrArray *old = self->files;
+    GPtrArray *merged = g_ptr_array_new_full(old->len + batch->len, g_free);
+    GArray *runs = g_array_new(FALSE, FALSE, sizeof(guint) * 2);
+    int new_current = self->current_index;
+    guint i = 0, j = 0;
+
+    while (i < old->len || j < batch->len) {
+        char *a = i < old->len ? g_ptr_array_index(old, i) : NULL;
+        char *b = j < batch->len ? g_ptr_array_index(batch, j) : NULL;
+        int cmp = !a ? 1 : !b ? -1 : compare_paths(a, b);
+
+        if (cmp == 0) {
+            g_free(b); /* Already listed */
+            j++;
+            continue;
+        }
+        if (cmp < 0) {
+            if ((int)i == self->current_index) new_current = merged->len;
+            g_ptr_array_add(merged, a);
+            i++;
+            continue;
+        }
+
+        guint *last = runs->len ? &g_array_index(runs, guint, (runs->len - 1) * 2) : NULL;
+        if (last && last[0] + last[1] == merged->len) {
+            last[1]++;
+        } else {
+            guint run[2] = { merged->len, 1 };
+            g_array_append_vals(runs, run, 1);
+        }
+        g_ptr_array_add(merged, b);
+        j++;
+    }
+
+    /* Strings moved to merged; drop the containers only */
+    g_ptr_array_set_free_func(old, NULL);
+    g_ptr_array_unref(old);
+    g_ptr_array_set_free_func(batch, NULL);
+    self->files = merged;
+    self->current_index = new_current;
+    if (self->current_index < 0 && merged->len > 0) self->current_index = 0;
+
+    for (guint r = 0; r < runs->len; r++) {
+        guint *run = &g_array_index(runs, guint, r * 2);
+        emit_items_changed(self, run[0], 0, run[1]);
+    }
+    g_array_unref(runs);
+}
+
+/* Binary search: TRUE with the index if path is listed, otherwise FALSE
+ * with the position where it would be inserted. */
+static gboolean
+curator_find_sorted(Curator *self, const char *path, guint *index)
+{
+    guint lo = 0, hi = self->files->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        int cmp = compare_paths(g_ptr_array_index(self->files, mid), path);
+        if (cmp == 0) {
+            *index = mid;
+            return TRUE;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    *index = lo;
+    return FALSE;
+}
+
+static void
+curator_insert_path(Curator *self, const char *path)
+{
+    guint index;
+    if (curator_find_sorted(self, path, &index)) return;
+
+    g_ptr_array_insert(self->files, (gint)index, g_strdup(path));
+    if (self->current_index < 0) self->current_index = 0;
+    else if ((int)index <= self->current_index) self->current_index++;
+    emit_items_changed(self, index, 0, 1);
+}
+
+static void
+curator_remove_path(Curator *self, const char *path)
+{
+    guint index;
+    if (!curator_find_sorted(self, path, &index)) return;
+
+    g_ptr_array_remove_index(self->files, index);
+    /* Removing the current item leaves the index on its successor */
+    if ((int)index < self->current_index) self->current_index--;
+    if (self->current_index >= (int)self->files->len) self->current_index = (int)self->files->len - 1;
+    emit_items_changed(self, index, 1, 0);
+}
+
+/* --- Async scan --- */
+
+typedef struct {
+    Curator *self;               /* Not a ref: only touched while not cancelled */
+    char *path;
+    GCancellable *cancellable;
+    GFileEnumerator *enumerator;
+} DirLoad;
+
+static void
+dir_load_free(DirLoad *load)
+{
+    g_free(load->path);
+    g_clear_object(&load->cancellable);
+    g_clear_object(&load->enumerator);
+    g_free(load);
+}
+
+static void
+dir_load_finish(DirLoad *load)
+{
+    Curator *self = load->self;
+    g_clear_object(&self->load_cancellable);
+    g_signal_emit(self, signals[SIGNAL_LOAD_PROGRESS], 0, self->files->len, TRUE);
+    dir_load_free(load);
+}
+
+static void
+on_next_files(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    DirLoad *load = user_data;
+    GError *err = NULL;
+    GList *infos = g_file_enumerator_next_files_finish(G_FILE_ENUMERATOR(source), res, &err);
+
+    /* Checked explicitly: the Curator may be gone once cancelled */
+    if (g_cancellable_is_cancelled(load->cancellable)) {
+        g_list_free_full(infos, g_object_unref);
+        g_clear_error(&err);
+        dir_load_free(load);
+        return;
+    }
+
+    if (!infos) {
+        if (err) g_warning("Failed to scan '%s': %s", load->path, err->message);
+        g_clear_error(&err);
+        dir_load_finish(load);
+        return;
+    }
+
+    GPtrArray *batch = g_ptr_array_new_with_free_func(g_free);
+    for (GList *l = infos; l; l = l->next) {
+        const char *name = g_file_info_get_name(G_FILE_INFO(l->data));
+        if (!g_str_has_prefix(name, ".") && curator_is_supported(name))
+            g_ptr_array_add(batch, g_build_filename(load->path, name, NULL));
+    }
+    g_list_free_full(infos, g_object_unref);
+
+    g_ptr_array_sort(batch, compare_strings);
+    curator_merge_sorted(load->self, batch);
+    g_ptr_array_unref(batch);
+
+    g_signal_emit(load->self, signals[SIGNAL_LOAD_PROGRESS], 0, load->self->files->len, FALSE);
+
+    g_file_enumerator_next_files_async(load->enumerator, LOAD_BATCH_SIZE, G_PRIORITY_DEFAULT,
+                                       load->cancellable, on_next_files, load);
+}
+
+static void
+on_enumerate_ready(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    DirLoad *load = user_data;
+    GError *err = NULL;
+    load->enumerator = g_file_enumerate_children_finish(G_FILE(source), res, &err);
+
+    if (g_cancellable_is_cancelled(load->cancellable)) {
+        g_clear_error(&err);
+        dir_load_free(load);
+        return;
+    }
+    if (!load->enumerator) {
+        g_warning("Failed to open '%s': %s", load->path, err ? err->message : "unknown");
+        g_clear_error(&err);
+        dir_load_finish(load);
+        return;
+    }
+
+    g_file_enumerator_next_files_async(load->enumerator, LOAD_BATCH_SIZE, G_PRIORITY_DEFAULT,
+                                       load->cancellable, on_next_files, load);
+}
+
+static void
+curator_cancel_load(Curator *self)
+{
+    g_clear_pointer(&self->held_scan, g_free);
+    if (!self->load_cancellable) return;
+    g_cancellable_cancel(self->load_cancellable);
+    g_clear_object(&self->load_cancellable);
+}
+
+/* --- Watching --- */
+
+static gboolean
+is_listable(GFile *file, const char *directory, char **out_path)
+{
+    char *path = file ? g_file_get_path(file) : NULL;
+    if (!path) return FALSE;
+
+    char *dirname = g_path_get_dirname(path);
+    char *basename = g_path_get_basename(path);
+    gboolean ok = g_strcmp0(dirname, directory) == 0 &&
+                  !g_str_has_prefix(basename, ".") && curator_is_supported(basename);
+    g_free(dirname);
+    g_free(basename);
+
+    if (ok) *out_path = path;
+    else g_free(path);
+    return ok;
+}
+
+static void
+on_directory_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
+                     GFileMonitorEvent event, gpointer user_data)
+{
+    Curator *self = BRIGHTEYES_CURATOR(user_data);
+    char *path = NULL;
+    char *other = NULL;
+    guint index;
+
+    switch (event) {
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_MOVED_IN:
+            if (is_listable(file, self->current_directory, &path))
+                curator_insert_path(self, path);
+            break;
+        case G_FILE_MONITOR_EVENT_DELETED:
+        case G_FILE_MONITOR_EVENT_MOVED_OUT:
+            if (is_listable(file, self->current_directory, &path))
+                curator_remove_path(self, path);
+            break;
+        case G_FILE_MONITOR_EVENT_RENAMED:
+            if (is_listable(file, self->current_directory, &path))
+                curator_remove_path(self, path);
+            if (is_listable(other_file, self->current_directory, &other))
+                curator_insert_path(self, other);
+            break;
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+            /* Rewritten in place (or finished copying in): have views
+               re-create the item so stale thumbnails are redone */
+            if (is_listable(file, self->current_directory, &path) &&
+                curator_find_sorted(self, path, &index))
+                emit_items_changed(self, index, 1, 1);
+            break;
+        default:
+            break;
+    }
+
+    g_free(path);
+    g_free(other);
+}
+
+/* Watch path for changes, replacing any previous watch; NULL stops watching. */
+static void
+curator_watch(Curator *self, const char *path)
+{
+    if (self->monitor) {
+        g_signal_handlers_disconnect_by_func(self->monitor, on_directory_changed, self);
+        g_file_monitor_cancel(self->monitor);
+        g_clear_object(&self->monitor);
+    }
+    if (!path) return;
+
+    GFile *dir = g_file_new_for_path(path);
+    GError *err = NULL;
+    self->monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_WATCH_MOVES, NULL, &err);
+    if (self->monitor)
+        g_signal_connect(self->monitor, "changed", G_CALLBACK(on_directory_changed), self);
+    else
+        g_debug("Not watching '%s': %s", path, err ? err->message : "unknown");
+    g_clear_error(&err);
+    g_object_unref(dir);
+}
+
+/* Start scanning path, merging results into the current list. Changes that
+ * happen during the scan are picked up by the watch, which starts first. */
+static void
+curator_start_scan(Curator *self, const char *path)
+{
+    curator_cancel_load(self);
+    if (self->scans_held) {
+        self->held_scan = g_strdup(path);
+        return;
+    }
+    curator_watch(self, path);
+
+    DirLoad *load = g_new0(DirLoad, 1);
+    load->self = self;
+    load->path = g_strdup(path);
+    load->cancellable = g_cancellable_new();
+    self->load_cancellable = g_object_ref(load->cancellable);
+
+    GFile *dir = g_file_new_for_path(path);
+    g_file_enumerate_children_async(dir, G_FILE_ATTRIBUTE_STANDARD_NAME, G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_DEFAULT, load->cancellable, on_enumerate_ready, load);
+    g_object_unref(dir);
+}
+
 Curator *
 curator_new(void)
 {
@@ -93,11 +466,8 @@ curator_is_supported(const char *filename)
 }
 
 static int
-compare_strings(gconstpointer a, gconstpointer b)
+compare_paths(const char *sa, const char *sb)
 {
-    const char *sa = *(const char **)a;
-    const char *sb = *(const char **)b;
-    
     /* Use strverscmp for natural sorting (e.g. 1.jpg, 2.jpg, 10.jpg) */
 #ifdef _GNU_SOURCE
     return strverscmp(sa, sb);
@@ -107,14 +477,22 @@ compare_strings(gconstpointer a, gconstpointer b)
 #endif
 }
 
+static int
+compare_strings(gconstpointer a, gconstpointer b)
+{
+    return compare_paths(*(const char **)a, *(const char **)b);
+}
+
 void
 curator_load_directory(Curator *self, const char *path)
 {
+    curator_cancel_load(self);
+    curator_watch(self, path);
+
     g_free(self->current_directory);
     self->current_directory = g_strdup(path);
     
-    g_ptr_array_set_size(self->files, 0);
-    self->current_index = -1;
+    curator_clear(self);
 
     GFile *dir = g_file_new_for_path(path);
     GFileEnumerator *enumerator = g_file_enumerate_children(dir,
@@ -137,6 +515,34 @@ curator_load_directory(Curator *self, const char *path)
     g_object_unref(dir);
 
     g_ptr_array_sort(self->files, compare_strings);
+    emit_items_changed(self, 0, 0, self->files->len);
+}
+
+void
+curator_load_directory_async(Curator *self, const char *path)
+{
+    g_free(self->current_directory);
+    self->current_directory = g_strdup(path);
+
+    curator_clear(self);
+    curator_start_scan(self, path);
+}
+
+gboolean
+curator_is_loading(Curator *self)
+{
+    return self->load_cancellable != NULL;
+}
+
+void
+curator_hold_scans(Curator *self, gboolean hold)
+{
+    self->scans_held = hold;
+    if (hold || !self->held_scan) return;
+
+    char *path = g_steal_pointer(&self->held_scan);
+    curator_start_scan(self, path);
+    g_free(path);
 }
 
 void
@@ -155,7 +561,9 @@ curator_set_current_file(Curator *self, const char *filepath)
             gboolean already_loaded = (self->current_directory && g_strcmp0(self->current_directory, archive_path) == 0 && self->files->len > 0);
             
             if (!already_loaded) {
-                g_ptr_array_set_size(self->files, 0);
+                curator_cancel_load(self);
+                curator_watch(self, NULL);
+                curator_clear(self);
                 g_free(self->current_directory);
                 self->current_directory = archive_path; /* Transfer ownership */
 
@@ -168,6 +576,7 @@ curator_set_current_file(Curator *self, const char *filepath)
                         g_ptr_array_add(self->files, virtual);
                     }
                     self->current_index = 0;
+                    emit_items_changed(self, 0, 0, self->files->len);
                 } else {
                     g_warning("Failed to read archive '%s': %s", self->current_directory, err ? err->message : "unknown");
                     g_clear_error(&err);
@@ -184,7 +593,9 @@ curator_set_current_file(Curator *self, const char *filepath)
         const char *ext = strrchr(filepath, '.');
         if (ext && (g_ascii_strcasecmp(ext, ".cbz") == 0 || g_ascii_strcasecmp(ext, ".cbr") == 0)) {
 
-        g_ptr_array_set_size(self->files, 0);
+        curator_cancel_load(self);
+        curator_watch(self, NULL);
+        curator_clear(self);
         g_free(self->current_directory);
         self->current_directory = g_strdup(filepath);
 
@@ -197,6 +608,7 @@ curator_set_current_file(Curator *self, const char *filepath)
                 g_ptr_array_add(self->files, virtual);
             }
             self->current_index = 0;
+            emit_items_changed(self, 0, 0, self->files->len);
         } else {
             g_warning("Failed to read archive '%s': %s", filepath, err ? err->message : "unknown");
             g_clear_error(&err);
@@ -206,12 +618,20 @@ curator_set_current_file(Curator *self, const char *filepath)
     }
     }
 
-    /* If file is not in current directory, load its directory first. 
+    /* If file is not in current directory, list just this file and scan the
+       directory in the background; the rest is merged in around it.
        Skip this for archive:// URIs as we handled them above. */
     if (!g_str_has_prefix(filepath, "archive://")) {
         char *dirname = g_path_get_dirname(filepath);
         if (!self->current_directory || g_strcmp0(dirname, self->current_directory) != 0) {
-            curator_load_directory(self, dirname);
+            curator_cancel_load(self);
+            g_free(self->current_directory);
+            self->current_directory = g_strdup(dirname);
+            curator_clear(self);
+            g_ptr_array_add(self->files, g_strdup(filepath));
+            self->current_index = 0;
+            emit_items_changed(self, 0, 0, 1);
+            curator_start_scan(self, dirname);
         }
         g_free(dirname);
     }
@@ -280,68 +700,50 @@ curator_get_prev(Curator *self)
     return g_ptr_array_index(self->files, self->current_index);
 }
 
+const char *
+curator_peek(Curator *self, int offset)
+{
+    int n = (int)self->files->len;
+    if (n == 0 || self->current_index < 0 || self->current_index >= n) return NULL;
+    /* Same wraparound as curator_get_next/prev, without moving */
+    int index = ((self->current_index + offset) % n + n) % n;
+    return g_ptr_array_index(self->files, index);
+}
+
 GPtrArray *
 curator_get_files(Curator *self)
 {
     return self->files;
 }
 
-gboolean
-curator_trash_current(Curator *self, GError **error)
+char *
+curator_remove_current(Curator *self)
 {
-    const char *current = curator_get_current(self);
-    if (!current) return FALSE;
+    if (self->current_index < 0 || self->current_index >= (int)self->files->len) return NULL;
 
-    /* Handle Archive Entry Deletion */
-    if (g_str_has_prefix(current, "archive://")) {
-        const char *sep = strstr(current, "::");
-        if (sep) {
-            size_t archive_len = sep - (current + strlen("archive://"));
-            char *archive_path = g_strndup(current + strlen("archive://"), archive_len);
-            char *entry_name = g_strdup(sep + 2);
-
-            gboolean res = archive_delete_entry(archive_path, entry_name, error);
-            g_free(archive_path);
-            g_free(entry_name);
-
-            if (!res) return FALSE;
+    guint position = (guint)self->current_index;
+    char *removed = g_ptr_array_steal_index(self->files, position);
 
-            /* Remove from list upon success */
-            if (self->current_index >= 0 && self->current_index < (int)self->files->len) {
-                g_ptr_array_remove_index(self->files, self->current_index);
-            }
-
-            if (self->files->len == 0) {
-                self->current_index = -1;
-                return TRUE;
-            }
-
-            if (self->current_index >= (int)self->files->len)
-                self->current_index = (int)self->files->len - 1;
-
-            return TRUE;
-        }
-        /* Fallthrough? No, malformed archive path */
-        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_FILENAME, "Invalid archive path");
-        return FALSE;
-    }
-
-    GFile *file = g_file_new_for_path(current);
-    gboolean ok = g_file_trash(file, NULL, error);
-    g_object_unref(file);
-    if (!ok) return FALSE;
-
-    if (self->current_index >= 0 && self->current_index < (int)self->files->len) {
-        g_ptr_array_remove_index(self->files, self->current_index);
-    }
-
-    if (self->files->len == 0) {
+    /* Settle the current file before handlers can ask for it */
+    if (self->files->len == 0)
         self->current_index = -1;
-        return TRUE;
-    }
-
-    if (self->current_index >= (int)self->files->len)
+    else if (self->current_index >= (int)self->files->len)
         self->current_index = (int)self->files->len - 1;
 
-    return TRUE;
+    emit_items_changed(self, position, 1, 0);
+    return removed;
+}
+
+void
+curator_restore(Curator *self, const char *path)
+{
+    char *container = NULL, *entry_name = NULL;
+    if (archive_split_path(path, &container, &entry_name))
+        g_free(entry_name);
+    else
+        container = g_path_get_dirname(path);
+
+    if (self->current_directory && g_strcmp0(container, self->current_directory) == 0)
+        curator_insert_path(self, path);
+    g_free(container);
 }
@@ -8,18 +8,46 @@ G_BEGIN_DECLS
 #define TYPE_CURATOR (curator_get_type())
 G_DECLARE_FINAL_TYPE(Curator, curator, BRIGHTEYES, CURATOR, GObject)
 
+/* Signals:
+ *   "items-changed" (guint position, guint removed, guint added)
+ *     The files array changed, with GListModel::items-changed semantics.
+ *   "load-progress" (guint n_files, gboolean finished)
+ *     Emitted after each batch of an asynchronous scan and once at the end. */
 Curator *curator_new(void);
 
 void curator_load_directory(Curator *self, const char *path);
+
+/* Scan path on GIO's worker threads, merging sorted batches into the list as
+ * they arrive. Cancels any scan in progress. */
+void curator_load_directory_async(Curator *self, const char *path);
+gboolean curator_is_loading(Curator *self);
+
+/* While held, scans that would start are remembered instead (only the
+ * latest) and run when released, along with watching their directory. */
+void curator_hold_scans(Curator *self, gboolean hold);
+
+/* Selects filepath. A file outside the current directory is listed alone
+ * at once and its directory is then scanned asynchronously. */
 void curator_set_current_file(Curator *self, const char *filepath);
 
 const char *curator_get_current(Curator *self);
 const char *curator_get_next(Curator *self);
 const char *curator_get_prev(Curator *self);
+
+/* Return the file offset positions away from the current one (wrapping like
+ * get_next/get_prev) without changing the current index. */
+const char *curator_peek(Curator *self, int offset);
 GPtrArray *curator_get_files(Curator *self);
 
-/* Move current file to trash; returns TRUE on success and updates the current index to a valid item if any remain. */
-gboolean curator_trash_current(Curator *self, GError **error);
+/* Drop the current file from the list without touching it on disk (see
+ * TrashQueue) and move the current index to a valid item if any remain.
+ * Returns the removed path, or NULL when nothing is selected. */
+char *curator_remove_current(Curator *self);
+
+/* Put back a file removed with curator_remove_current whose deletion did
+ * not happen, in sorted order, if it belongs to the folder or archive still
+ * listed. The current file stays the same. */
+void curator_restore(Curator *self, const char *path);
 
 /* Utility to check if file is supported */
 gboolean curator_is_supported(const char *filename);
@@ -0,0 +1,750 @@
+#include "dupindex.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "pixelops.h"
+#include "thumbnails.h"
+
+/* Duplicate index (model)
+ *
+ * Hashes the curator's files for duplicate detection:
+ * - Records: path, mtime, size, a SHA-1 of the contents and 64-bit dHash
+ *   and pHash values. The digest covers the whole file however large, as
+ *   exact matches are offered for deletion; a big file is read once and
+ *   only again when its mtime or size changes.
+ * - Perceptual hashes come from the 128px thumbnail tier (the persistent
+ *   one when it exists), so indexing a folder also fills the thumbnail
+ *   cache and a folder already browsed costs no decodes.
+ * - Workers: a GThreadPool with one thread per two cores. A job first
+ *   stats its file and stops there when the stored record still matches,
+ *   so reopening a folder or a change notification only rehashes what
+ *   actually changed. Replacing the curator's list drops queued jobs.
+ * - Groups: exact copies share a digest; near-duplicates are within
+ *   NEAR_DISTANCE bits on both perceptual hashes. Grouping only compares
+ *   the current list (quadratic, so it runs on a GTask); lookups of a
+ *   single file scan the whole index, across folders.
+ * - Persistence: one GVariant table under the user cache dir, written a
+ *   few seconds after changes settle and when the index goes away.
+ *
+ * Sections: records, hashing, grouping, persistence, workers, lifecycle,
+ * public API.
+ */
+
+#define INDEX_FORMAT_VERSION 2 /* 1 sampled files over 64 MiB */
+#define INDEX_VARIANT_TYPE "(ua(sxtsytt))"
+#define READ_CHUNK (256 * 1024)
+#define HASH_THUMBNAIL_SIZE 128
+#define NEAR_DISTANCE 10
+#define REGROUP_DELAY_MS 300
+#define SAVE_DELAY_SECONDS 5
+
+typedef struct {
+    char *path;
+    gint64 mtime;
+    guint64 size;
+    char *digest;        /* SHA-1, hex */
+    gboolean perceptual; /* dhash and phash are set */
+    guint64 dhash;
+    guint64 phash;
+} DupRecord;
+
+struct _DupIndex {
+    GObject parent_instance;
+    Curator *curator;
+    GHashTable *records;        /* path -> DupRecord */
+    GThreadPool *pool;
+    GCancellable *cancellable;  /* Shared by the jobs of the current list */
+    guint total;                /* Jobs queued for the current list */
+    guint done;
+
+    GHashTable *groups;         /* path -> group, current list only */
+    guint n_groups;
+    GCancellable *group_cancellable;
+    guint regroup_id;
+    guint save_id;
+    gboolean dirty;             /* Records changed since the last save */
+};
+
+typedef struct {
+    GWeakRef index;             /* Only dereferenced on the main thread */
+    GCancellable *cancellable;
+    char *path;
+    gint64 known_mtime;         /* Of the stored record, -1 without one */
+    guint64 known_size;
+    DupRecord *record;          /* Fresh record, NULL when current or failed */
+} HashJob;
+
+enum {
+    SIGNAL_PROGRESS,
+    SIGNAL_GROUPS_CHANGED,
+    N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_TYPE(DupIndex, dup_index, G_TYPE_OBJECT)
+
+/* --- Records --- */
+
+static DupRecord *
+dup_record_new(const char *path, gint64 mtime, guint64 size, const char *digest)
+{
+    DupRecord *r = g_new0(DupRecord, 1);
+    r->path = g_strdup(path);
+    r->mtime = mtime;
+    r->size = size;
+    r->digest = g_strdup(digest);
+    return r;
+}
+
+static DupRecord *
+dup_record_copy(const DupRecord *r)
+{
+    DupRecord *copy = dup_record_new(r->path, r->mtime, r->size, r->digest);
+    copy->perceptual = r->perceptual;
+    copy->dhash = r->dhash;
+    copy->phash = r->phash;
+    return copy;
+}
+
+static void
+dup_record_free(DupRecord *r)
+{
+    if (!r) return;
+    g_free(r->path);
+    g_free(r->digest);
+    g_free(r);
+}
+
+static guint
+hamming(guint64 a, guint64 b)
+{
+#ifdef __GNUC__
+    return (guint)__builtin_popcountll(a ^ b);
+#else
+    guint n = 0;
+    for (guint64 x = a ^ b; x; x &= x - 1) n++;
+    return n;
+#endif
+}
+
+static gboolean
+is_near(const DupRecord *a, const DupRecord *b)
+{
+    return a->perceptual && b->perceptual &&
+           hamming(a->dhash, b->dhash) <= NEAR_DISTANCE &&
+           hamming(a->phash, b->phash) <= NEAR_DISTANCE;
+}
+
+/* --- Hashing --- */
+
+/* SHA-1 of the whole file; NULL on error or when cancelled */
+static char *
+compute_digest(const char *path, GCancellable *cancellable)
+{
+    GFile *file = g_file_new_for_path(path);
+    GFileInputStream *in = g_file_read(file, cancellable, NULL);
+    g_object_unref(file);
+    if (!in) return NULL;
+
+    GChecksum *sum = g_checksum_new(G_CHECKSUM_SHA1);
+    guint8 *buf = g_malloc(READ_CHUNK);
+    gboolean ok = TRUE;
+    for (;;) {
+        gssize n = g_input_stream_read(G_INPUT_STREAM(in), buf, READ_CHUNK, cancellable, NULL);
+        if (n < 0) ok = FALSE;
+        if (n <= 0) break;
+        g_checksum_update(sum, buf, n);
+    }
+
+    char *digest = ok ? g_strdup(g_checksum_get_string(sum)) : NULL;
+    g_free(buf);
+    g_checksum_free(sum);
+    g_object_unref(in);
+    return digest;
+}
+
+/* Luma of pixbuf squeezed to width x height, or NULL */
+static guint8 *
+gray_at_size(GdkPixbuf *pixbuf, int width, int height)
+{
+    GdkPixbuf *small = pixel_ops_scale_down(pixbuf, width, height);
+    if (!small) return NULL;
+    guint8 *gray = pixel_ops_to_gray(small);
+    g_object_unref(small);
+    return gray;
+}
+
+/* dHash: whether each pixel of a 9x8 reduction is darker than its right neighbour */
+static gboolean
+compute_dhash(GdkPixbuf *pixbuf, guint64 *hash)
+{
+    guint8 *gray = gray_at_size(pixbuf, 9, 8);
+    if (!gray) return FALSE;
+
+    guint64 h = 0;
+    for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+            h = (h << 1) | (gray[y * 9 + x] < gray[y * 9 + x + 1]);
+    g_free(gray);
+    *hash = h;
+    return TRUE;
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/* pHash: the 8x8 lowest frequencies of a 32x32 DCT, each compared with
+ * their median (the DC term excluded, it only carries brightness). */
+static gboolean
+compute_phash(GdkPixbuf *pixbuf, guint64 *hash)
+{
+    static double cosines[8][32];
+    static gsize cosines_ready = 0;
+    if (g_once_init_enter(&cosines_ready)) {
+        for (int u = 0; u < 8; u++)
+            for (int x = 0; x < 32; x++)
+                cosines[u][x] = cos((2 * x + 1) * u * G_PI / 64.0);
+        g_once_init_leave(&cosines_ready, 1);
+    }
+
+    guint8 *gray = gray_at_size(pixbuf, 32, 32);
+    if (!gray) return FALSE;
+
+    double rows[32][8];
+    for (int y = 0; y < 32; y++) {
+        for (int u = 0; u < 8; u++) {
+            double s = 0;
+            for (int x = 0; x < 32; x++) s += gray[y * 32 + x] * cosines[u][x];
+            rows[y][u] = s;
+        }
+    }
+    g_free(gray);
+
+    double coeffs[64], sorted[63];
+    for (int v = 0; v < 8; v++) {
+        for (int u = 0; u < 8; u++) {
+            double s = 0;
+            for (int y = 0; y < 32; y++) s += rows[y][u] * cosines[v][y];
+            coeffs[v * 8 + u] = s;
+        }
+    }
+    memcpy(sorted, coeffs + 1, sizeof sorted);
+    qsort(sorted, G_N_ELEMENTS(sorted), sizeof sorted[0], compare_doubles);
+    double median = sorted[G_N_ELEMENTS(sorted) / 2];
+
+    guint64 h = 0;
+    for (int i = 0; i < 64; i++)
+        h = (h << 1) | (coeffs[i] > median);
+    *hash = h;
+    return TRUE;
+}
+
+static DupRecord *
+hash_file(const char *path, gint64 mtime, guint64 size, GCancellable *cancellable)
+{
+    char *digest = compute_digest(path, cancellable);
+    if (!digest) return NULL;
+
+    DupRecord *r = dup_record_new(path, mtime, size, digest);
+    g_free(digest);
+
+    /* Undecodable files still take part through their digest */
+    GdkPixbuf *thumb = thumbnail_load_pixbuf(path, HASH_THUMBNAIL_SIZE, cancellable, NULL);
+    if (thumb) {
+        r->perceptual = compute_dhash(thumb, &r->dhash) && compute_phash(thumb, &r->phash);
+        g_object_unref(thumb);
+    }
+    return r;
+}
+
+/* --- Grouping --- */
+
+typedef struct {
+    GPtrArray *records; /* DupRecord copies for the current list, in order */
+    guint *groups;      /* Result, one per record */
+    guint n_groups;
+} GroupTask;
+
+static void
+group_task_free(GroupTask *data)
+{
+    g_ptr_array_unref(data->records);
+    g_free(data->groups);
+    g_free(data);
+}
+
+static guint
+find_root(guint *parent, guint i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void
+join(guint *parent, guint a, guint b)
+{
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    /* The earlier root wins, so groups are numbered in list order */
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+static void
+group_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    GroupTask *data = task_data;
+    guint n = data->records->len;
+    guint *parent = g_new(guint, MAX(n, 1));
+    for (guint i = 0; i < n; i++) parent[i] = i;
+
+    GHashTable *by_digest = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < n; i++) {
+        DupRecord *r = g_ptr_array_index(data->records, i);
+        gpointer first;
+        if (g_hash_table_lookup_extended(by_digest, r->digest, NULL, &first))
+            join(parent, GPOINTER_TO_UINT(first), i);
+        else
+            g_hash_table_insert(by_digest, r->digest, GUINT_TO_POINTER(i));
+    }
+    g_hash_table_destroy(by_digest);
+
+    for (guint i = 0; i < n; i++) {
+        if (g_task_return_error_if_cancelled(task)) {
+            g_free(parent);
+            return;
+        }
+        DupRecord *a = g_ptr_array_index(data->records, i);
+        if (!a->perceptual) continue;
+        for (guint j = i + 1; j < n; j++) {
+            if (is_near(a, g_ptr_array_index(data->records, j)))
+                join(parent, i, j);
+        }
+    }
+
+    /* Number the roots that have company */
+    guint *members = g_new0(guint, MAX(n, 1));
+    guint *ids = g_new0(guint, MAX(n, 1));
+    data->groups = g_new0(guint, MAX(n, 1));
+    for (guint i = 0; i < n; i++) members[find_root(parent, i)]++;
+    for (guint i = 0; i < n; i++) {
+        guint root = find_root(parent, i);
+        if (members[root] < 2) continue;
+        if (!ids[root]) ids[root] = ++data->n_groups;
+        data->groups[i] = ids[root];
+    }
+    g_free(ids);
+    g_free(members);
+    g_free(parent);
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+on_group_ready(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    DupIndex *self = BRIGHTEYES_DUP_INDEX(source);
+    GroupTask *data = g_task_get_task_data(G_TASK(res));
+    if (!g_task_propagate_boolean(G_TASK(res), NULL)) return;
+
+    g_clear_object(&self->group_cancellable);
+    g_hash_table_remove_all(self->groups);
+    for (guint i = 0; i < data->records->len; i++) {
+        if (!data->groups[i]) continue;
+        DupRecord *r = g_ptr_array_index(data->records, i);
+        g_hash_table_insert(self->groups, g_strdup(r->path), GUINT_TO_POINTER(data->groups[i]));
+    }
+    self->n_groups = data->n_groups;
+    g_signal_emit(self, signals[SIGNAL_GROUPS_CHANGED], 0);
+}
+
+static gboolean
+regroup_timeout(gpointer user_data)
+{
+    DupIndex *self = BRIGHTEYES_DUP_INDEX(user_data);
+    self->regroup_id = 0;
+    if (!self->curator) return G_SOURCE_REMOVE;
+
+    if (self->group_cancellable) {
+        g_cancellable_cancel(self->group_cancellable);
+        g_clear_object(&self->group_cancellable);
+    }
+
+    GroupTask *data = g_new0(GroupTask, 1);
+    data->records = g_ptr_array_new_with_free_func((GDestroyNotify)dup_record_free);
+    GPtrArray *files = curator_get_files(self->curator);
+    for (guint i = 0; files && i < files->len; i++) {
+        DupRecord *r = g_hash_table_lookup(self->records, g_ptr_array_index(files, i));
+        if (r) g_ptr_array_add(data->records, dup_record_copy(r));
+    }
+
+    self->group_cancellable = g_cancellable_new();
+    GTask *task = g_task_new(self, self->group_cancellable, on_group_ready, NULL);
+    g_task_set_task_data(task, data, (GDestroyNotify)group_task_free);
+    g_task_run_in_thread(task, group_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queue_regroup(DupIndex *self)
+{
+    if (self->regroup_id == 0)
+        self->regroup_id = g_timeout_add(REGROUP_DELAY_MS, regroup_timeout, self);
+}
+
+/* --- Persistence --- */
+
+static char *
+get_index_cache_path(void)
+{
+    return g_build_filename(g_get_user_cache_dir(), "brighteyes", "duplicates", NULL);
+}
+
+static void
+load_from_disk(DupIndex *self)
+{
+    char *cache_path = get_index_cache_path();
+    char *contents = NULL;
+    gsize len = 0;
+    gboolean loaded = g_file_get_contents(cache_path, &contents, &len, NULL);
+    g_free(cache_path);
+    if (!loaded) return;
+
+    GVariant *v = g_variant_new_from_data(G_VARIANT_TYPE(INDEX_VARIANT_TYPE), contents, len,
+                                          FALSE, g_free, contents);
+    g_variant_ref_sink(v);
+
+    guint32 version = 0;
+    GVariantIter *iter = NULL;
+    g_variant_get(v, "(ua(sxtsytt))", &version, &iter);
+    if (version == INDEX_FORMAT_VERSION) {
+        const char *path, *digest;
+        gint64 mtime;
+        guint64 size, dhash, phash;
+        guint8 perceptual;
+        while (g_variant_iter_next(iter, "(&sxt&sytt)", &path, &mtime, &size, &digest, &perceptual, &dhash, &phash)) {
+            DupRecord *r = dup_record_new(path, mtime, size, digest);
+            r->perceptual = perceptual != 0;
+            r->dhash = dhash;
+            r->phash = phash;
+            g_hash_table_replace(self->records, r->path, r);
+        }
+    }
+    g_variant_iter_free(iter);
+    g_variant_unref(v);
+}
+
+static GBytes *
+serialize_records(DupIndex *self)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sxtsytt)"));
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, self->records);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        DupRecord *r = value;
+        /* GVariant strings must be valid UTF-8; such files are rehashed next session */
+        if (!g_utf8_validate(r->path, -1, NULL)) continue;
+        g_variant_builder_add(&builder, "(sxtsytt)", r->path, r->mtime, r->size, r->digest,
+                              (guint8)r->perceptual, r->dhash, r->phash);
+    }
+
+    GVariant *v = g_variant_new("(ua(sxtsytt))", (guint32)INDEX_FORMAT_VERSION, &builder);
+    g_variant_ref_sink(v);
+    GBytes *bytes = g_variant_get_data_as_bytes(v);
+    g_variant_unref(v);
+    return bytes;
+}
+
+static void
+write_bytes(GBytes *bytes)
+{
+    char *cache_path = get_index_cache_path();
+    char *dir = g_path_get_dirname(cache_path);
+    g_mkdir_with_parents(dir, 0700);
+    g_free(dir);
+
+    gsize len = 0;
+    const char *data = g_bytes_get_data(bytes, &len);
+    GError *err = NULL;
+    if (!g_file_set_contents(cache_path, data, (gssize)len, &err)) {
+        g_warning("Failed to save duplicate index: %s", err->message);
+        g_clear_error(&err);
+    }
+    g_free(cache_path);
+}
+
+static void
+save_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    write_bytes(task_data);
+    g_task_return_boolean(task, TRUE);
+}
+
+static gboolean
+save_timeout(gpointer user_data)
+{
+    DupIndex *self = BRIGHTEYES_DUP_INDEX(user_data);
+    self->save_id = 0;
+    self->dirty = FALSE;
+
+    /* Snapshot here, write on a worker */
+    GTask *task = g_task_new(NULL, NULL, NULL, NULL);
+    g_task_set_task_data(task, serialize_records(self), (GDestroyNotify)g_bytes_unref);
+    g_task_run_in_thread(task, save_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+mark_dirty(DupIndex *self)
+{
+    self->dirty = TRUE;
+    if (self->save_id) g_source_remove(self->save_id);
+    self->save_id = g_timeout_add_seconds(SAVE_DELAY_SECONDS, save_timeout, self);
+}
+
+/* --- Workers --- */
+
+static void
+hash_job_free(HashJob *job)
+{
+    g_weak_ref_clear(&job->index);
+    g_clear_object(&job->cancellable);
+    g_free(job->path);
+    dup_record_free(job->record);
+    g_free(job);
+}
+
+static gboolean
+hash_job_done(gpointer user_data)
+{
+    HashJob *job = user_data;
+    DupIndex *self = g_weak_ref_get(&job->index);
+    if (!self) return G_SOURCE_REMOVE;
+
+    /* Jobs of a list that has since been replaced no longer count */
+    if (job->cancellable == self->cancellable) {
+        self->done++;
+        g_signal_emit(self, signals[SIGNAL_PROGRESS], 0, self->done, self->total);
+    }
+    if (job->record) {
+        g_hash_table_replace(self->records, job->record->path, job->record);
+        job->record = NULL;
+        mark_dirty(self);
+        queue_regroup(self);
+    }
+    g_object_unref(self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+hash_worker(gpointer data, gpointer user_data)
+{
+    HashJob *job = data;
+    GStatBuf st;
+
+    if (!g_cancellable_is_cancelled(job->cancellable) &&
+        g_stat(job->path, &st) == 0 && S_ISREG(st.st_mode) &&
+        ((gint64)st.st_mtime != job->known_mtime || (guint64)st.st_size != job->known_size))
+        job->record = hash_file(job->path, (gint64)st.st_mtime, (guint64)st.st_size, job->cancellable);
+
+    g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT_IDLE, hash_job_done, job, (GDestroyNotify)hash_job_free);
+}
+
+static void
+queue_path(DupIndex *self, const char *path)
+{
+    if (g_str_has_prefix(path, "archive://")) return;
+
+    HashJob *job = g_new0(HashJob, 1);
+    g_weak_ref_init(&job->index, self);
+    job->cancellable = g_object_ref(self->cancellable);
+    job->path = g_strdup(path);
+    DupRecord *r = g_hash_table_lookup(self->records, path);
+    job->known_mtime = r ? r->mtime : -1;
+    job->known_size = r ? r->size : 0;
+    self->total++;
+    g_thread_pool_push(self->pool, job, NULL);
+}
+
+/* Drop the jobs of the previous list when the curator starts a new one */
+static void
+reset_queue(DupIndex *self)
+{
+    g_cancellable_cancel(self->cancellable);
+    g_object_unref(self->cancellable);
+    self->cancellable = g_cancellable_new();
+    self->total = 0;
+    self->done = 0;
+    g_signal_emit(self, signals[SIGNAL_PROGRESS], 0, 0, 0);
+}
+
+static void
+on_curator_items_changed(Curator *curator, guint position, guint removed, guint added, DupIndex *self)
+{
+    GPtrArray *files = curator_get_files(curator);
+    if (removed > 0 && files->len == added)
+        reset_queue(self);
+
+    /* Also covers files rewritten in place, which are reported as replaced */
+    for (guint i = 0; i < added; i++)
+        queue_path(self, g_ptr_array_index(files, position + i));
+    queue_regroup(self);
+}
+
+/* --- Lifecycle --- */
+
+static void
+dup_index_dispose(GObject *object)
+{
+    DupIndex *self = BRIGHTEYES_DUP_INDEX(object);
+
+    g_cancellable_cancel(self->cancellable);
+    if (self->group_cancellable) g_cancellable_cancel(self->group_cancellable);
+    if (self->regroup_id) {
+        g_source_remove(self->regroup_id);
+        self->regroup_id = 0;
+    }
+    if (self->save_id) {
+        g_source_remove(self->save_id);
+        self->save_id = 0;
+    }
+    if (self->dirty) {
+        GBytes *bytes = serialize_records(self);
+        write_bytes(bytes);
+        g_bytes_unref(bytes);
+        self->dirty = FALSE;
+    }
+    g_clear_object(&self->curator);
+    G_OBJECT_CLASS(dup_index_parent_class)->dispose(object);
+}
+
+static void
+dup_index_finalize(GObject *object)
+{
+    DupIndex *self = BRIGHTEYES_DUP_INDEX(object);
+    /* Jobs only hold weak refs; queued and running ones see the cancellable
+       and return at once */
+    g_thread_pool_free(self->pool, FALSE, TRUE);
+    g_clear_object(&self->cancellable);
+    g_clear_object(&self->group_cancellable);
+    g_hash_table_destroy(self->records);
+    g_hash_table_destroy(self->groups);
+    G_OBJECT_CLASS(dup_index_parent_class)->finalize(object);
+}
+
+static void
+dup_index_class_init(DupIndexClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dup_index_dispose;
+    object_class->finalize = dup_index_finalize;
+
+    signals[SIGNAL_PROGRESS] = g_signal_new("progress",
+                                            G_TYPE_FROM_CLASS(klass),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL, NULL,
+                                            G_TYPE_NONE, 2,
+                                            G_TYPE_UINT, G_TYPE_UINT);
+
+    signals[SIGNAL_GROUPS_CHANGED] = g_signal_new("groups-changed",
+                                                  G_TYPE_FROM_CLASS(klass),
+                                                  G_SIGNAL_RUN_LAST,
+                                                  0, NULL, NULL, NULL,
+                                                  G_TYPE_NONE, 0);
+}
+
+static void
+dup_index_init(DupIndex *self)
+{
+    self->records = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)dup_record_free);
+    self->groups = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    self->cancellable = g_cancellable_new();
+    guint threads = MAX(1, g_get_num_processors() / 2);
+    self->pool = g_thread_pool_new(hash_worker, NULL, (gint)threads, FALSE, NULL);
+}
+
+/* --- Public API --- */
+
+DupIndex *
+dup_index_new(Curator *curator)
+{
+    DupIndex *self = g_object_new(TYPE_DUP_INDEX, NULL);
+    load_from_disk(self);
+
+    self->curator = g_object_ref(curator);
+    g_signal_connect_object(curator, "items-changed", G_CALLBACK(on_curator_items_changed), self, 0);
+    GPtrArray *files = curator_get_files(curator);
+    for (guint i = 0; files && i < files->len; i++)
+        queue_path(self, g_ptr_array_index(files, i));
+    queue_regroup(self);
+    return self;
+}
+
+guint
+dup_index_get_group(DupIndex *self, const char *path)
+{
+    return GPOINTER_TO_UINT(g_hash_table_lookup(self->groups, path));
+}
+
+guint
+dup_index_get_n_groups(DupIndex *self)
+{
+    return self->n_groups;
+}
+
+GPtrArray *
+dup_index_find_matches(DupIndex *self, const char *path)
+{
+    GPtrArray *exact = g_ptr_array_new_with_free_func(g_free);
+    DupRecord *r = g_hash_table_lookup(self->records, path);
+    if (!r) return exact;
+
+    GPtrArray *near = g_ptr_array_new();
+    GPtrArray *missing = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, self->records);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        DupRecord *other = value;
+        if (other == r) continue;
+        gboolean same = g_strcmp0(other->digest, r->digest) == 0;
+        if (!same && !is_near(r, other)) continue;
+        if (!g_file_test(other->path, G_FILE_TEST_EXISTS))
+            g_ptr_array_add(missing, other->path);
+        else
+            g_ptr_array_add(same ? exact : near, g_strdup(other->path));
+    }
+
+    /* Forget deleted files as they turn up */
+    for (guint i = 0; i < missing->len; i++)
+        g_hash_table_remove(self->records, g_ptr_array_index(missing, i));
+    if (missing->len) mark_dirty(self);
+    g_ptr_array_free(missing, TRUE);
+
+    for (guint i = 0; i < near->len; i++)
+        g_ptr_array_add(exact, g_ptr_array_index(near, i));
+    g_ptr_array_free(near, TRUE);
+    return exact;
+}
+
+void
+dup_index_get_progress(DupIndex *self, guint *done, guint *total)
+{
+    if (done) *done = self->done;
+    if (total) *total = self->total;
+}
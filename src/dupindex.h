@@ -0,0 +1,40 @@
+#ifndef DUPINDEX_H
+#define DUPINDEX_H
+
+#include <glib-object.h>
+#include "curator.h"
+
+G_BEGIN_DECLS
+
+#define TYPE_DUP_INDEX (dup_index_get_type())
+G_DECLARE_FINAL_TYPE(DupIndex, dup_index, BRIGHTEYES, DUP_INDEX, GObject)
+
+/* Duplicate index. Follows the curator's list and hashes every file in it
+ * on worker threads: a content digest for exact copies and dHash/pHash
+ * perceptual hashes (from the 128px thumbnail) for near-duplicates such as
+ * re-encodes and resizes. Results persist under ~/.cache/brighteyes keyed
+ * by path + mtime + size, so only new or changed files are hashed again.
+ * Archive pages are not indexed.
+ *
+ * Signals (main thread):
+ *   "progress" (guint done, guint total)
+ *     Files of the current list hashed or found current, and the total.
+ *   "groups-changed"
+ *     dup_index_get_group results changed. */
+DupIndex *dup_index_new(Curator *curator);
+
+/* Duplicate group of path within the curator's list, numbered from 1 in
+ * list order; 0 when nothing else in the list matches it. */
+guint dup_index_get_group(DupIndex *self, const char *path);
+guint dup_index_get_n_groups(DupIndex *self);
+
+/* Other indexed files, in any folder, that are exact or near duplicates of
+ * path, exact ones first. Files that no longer exist are left out. */
+GPtrArray *dup_index_find_matches(DupIndex *self, const char *path);
+
+/* Files of the current list checked so far, out of total */
+void dup_index_get_progress(DupIndex *self, guint *done, guint *total);
+
+G_END_DECLS
+
+#endif /* DUPINDEX_H */
@@ -0,0 +1,254 @@
+#include "exifthumb.h"
+#include <string.h>
+
+/* Embedded thumbnails (helper)
+ *
+ * Finds camera previews without decoding the main image:
+ * - JPEG: the APP1 "Exif" segment holds a TIFF structure whose IFD1 points
+ *   (JPEGInterchangeFormat / JPEGInterchangeFormatLength) at a ~160px JPEG.
+ * - TIFF containers (many RAW formats too) carry the same tags in their own
+ *   IFD chain.
+ * Files are memory-mapped so only the pages holding the headers and the
+ * preview are read.
+ *
+ * Sections: TIFF reader, container parsing, decoding, public API.
+ */
+
+#define MAX_IFDS 4
+#define MAX_IFD_ENTRIES 512
+#define ASPECT_TOLERANCE 0.03
+
+typedef struct {
+    const guint8 *data;
+    gsize len;
+    gboolean big_endian;
+} TiffReader;
+
+typedef struct {
+    gsize jpeg_offset;
+    gsize jpeg_length;
+    guint main_width;  /* 0 if unknown */
+    guint main_height;
+} PreviewInfo;
+
+/* --- TIFF reader --- */
+
+static gboolean
+tiff_u16(const TiffReader *t, gsize off, guint16 *out)
+{
+    if (off > t->len || t->len - off < 2) return FALSE;
+    const guint8 *p = t->data + off;
+    *out = t->big_endian ? (guint16)((p[0] << 8) | p[1]) : (guint16)(p[0] | (p[1] << 8));
+    return TRUE;
+}
+
+static gboolean
+tiff_u32(const TiffReader *t, gsize off, guint32 *out)
+{
+    if (off > t->len || t->len - off < 4) return FALSE;
+    const guint8 *p = t->data + off;
+    if (t->big_endian)
+        *out = ((guint32)p[0] << 24) | ((guint32)p[1] << 16) | ((guint32)p[2] << 8) | p[3];
+    else
+        *out = p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+    return TRUE;
+}
+
+/* SHORT or LONG value stored inline in an IFD entry */
+static gboolean
+tiff_entry_uint(const TiffReader *t, gsize entry, guint32 *out)
+{
+    guint16 type;
+    if (!tiff_u16(t, entry + 2, &type)) return FALSE;
+    if (type == 3) {
+        guint16 v;
+        if (!tiff_u16(t, entry + 8, &v)) return FALSE;
+        *out = v;
+        return TRUE;
+    }
+    if (type == 4)
+        return tiff_u32(t, entry + 8, out);
+    return FALSE;
+}
+
+static gboolean
+tiff_reader_init(TiffReader *t, const guint8 *data, gsize len)
+{
+    if (len < 8) return FALSE;
+    if (memcmp(data, "II*\0", 4) == 0) t->big_endian = FALSE;
+    else if (memcmp(data, "MM\0*", 4) == 0) t->big_endian = TRUE;
+    else return FALSE;
+    t->data = data;
+    t->len = len;
+    return TRUE;
+}
+
+/* --- Container parsing --- */
+
+static void
+parse_exif_ifd(const TiffReader *t, guint32 ifd, PreviewInfo *info)
+{
+    guint16 count;
+    if (!tiff_u16(t, ifd, &count) || count > MAX_IFD_ENTRIES) return;
+    for (guint i = 0; i < count; i++) {
+        gsize entry = ifd + 2 + (gsize)i * 12;
+        guint16 tag;
+        guint32 value;
+        if (!tiff_u16(t, entry, &tag)) return;
+        if (tag == 0xA002 && tiff_entry_uint(t, entry, &value)) info->main_width = value;
+        else if (tag == 0xA003 && tiff_entry_uint(t, entry, &value)) info->main_height = value;
+    }
+}
+
+/* Walk the IFD chain looking for the JPEG preview. Offsets are relative to
+ * the TIFF header, which is the start of t->data. */
+static gboolean
+tiff_find_preview(const TiffReader *t, PreviewInfo *info)
+{
+    guint32 ifd;
+    if (!tiff_u32(t, 4, &ifd)) return FALSE;
+
+    for (int n = 0; n < MAX_IFDS && ifd != 0; n++) {
+        guint16 count;
+        if (!tiff_u16(t, ifd, &count) || count > MAX_IFD_ENTRIES) break;
+
+        guint32 offset = 0, length = 0;
+        for (guint i = 0; i < count; i++) {
+            gsize entry = ifd + 2 + (gsize)i * 12;
+            guint16 tag;
+            guint32 value;
+            if (!tiff_u16(t, entry, &tag)) return FALSE;
+            if (!tiff_entry_uint(t, entry, &value)) continue;
+            switch (tag) {
+                case 0x0100: if (n == 0 && !info->main_width) info->main_width = value; break;
+                case 0x0101: if (n == 0 && !info->main_height) info->main_height = value; break;
+                case 0x0201: offset = value; break;
+                case 0x0202: length = value; break;
+                case 0x8769: parse_exif_ifd(t, value, info); break;
+                default: break;
+            }
+        }
+
+        if (offset && length && offset < t->len && length <= t->len - offset &&
+            length >= 2 && t->data[offset] == 0xFF && t->data[offset + 1] == 0xD8) {
+            info->jpeg_offset = offset;
+            info->jpeg_length = length;
+            return TRUE;
+        }
+
+        guint32 next;
+        if (!tiff_u32(t, ifd + 2 + (gsize)count * 12, &next) || next == ifd) break;
+        ifd = next;
+    }
+    return FALSE;
+}
+
+/* Locate the TIFF structure inside a JPEG's APP1 Exif segment. */
+static gboolean
+jpeg_find_exif(const guint8 *data, gsize len, gsize *tiff_offset, gsize *tiff_length)
+{
+    if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) return FALSE;
+
+    gsize pos = 2;
+    while (pos + 4 <= len) {
+        if (data[pos] != 0xFF) return FALSE;
+        guint8 marker = data[pos + 1];
+        if (marker == 0xFF) { pos++; continue; } /* Fill byte */
+        if (marker == 0xDA || marker == 0xD9) return FALSE; /* Image data: no APP1 left */
+
+        gsize seglen = ((gsize)data[pos + 2] << 8) | data[pos + 3];
+        if (seglen < 2 || pos + 2 + seglen > len) return FALSE;
+        if (marker == 0xE1 && seglen >= 8 && memcmp(data + pos + 4, "Exif\0\0", 6) == 0) {
+            *tiff_offset = pos + 10;
+            *tiff_length = seglen - 8;
+            return TRUE;
+        }
+        pos += 2 + seglen;
+    }
+    return FALSE;
+}
+
+/* --- Decoding --- */
+
+typedef struct {
+    int size;
+    int width;
+    int height;
+} SizeRequest;
+
+static void
+on_size_prepared(GdkPixbufLoader *loader, int width, int height, gpointer user_data)
+{
+    SizeRequest *req = user_data;
+    req->width = width;
+    req->height = height;
+    if (width <= req->size && height <= req->size) return;
+    double scale = (double)req->size / MAX(width, height);
+    gdk_pixbuf_loader_set_size(loader, MAX(1, (int)(width * scale)), MAX(1, (int)(height * scale)));
+}
+
+static GdkPixbuf *
+decode_preview(const guint8 *jpeg, gsize len, const PreviewInfo *info, int size)
+{
+    GdkPixbufLoader *loader = gdk_pixbuf_loader_new_with_type("jpeg", NULL);
+    if (!loader) return NULL;
+
+    SizeRequest req = { size, 0, 0 };
+    g_signal_connect(loader, "size-prepared", G_CALLBACK(on_size_prepared), &req);
+
+    GdkPixbuf *result = NULL;
+    gboolean ok = gdk_pixbuf_loader_write(loader, jpeg, len, NULL);
+    ok = gdk_pixbuf_loader_close(loader, NULL) && ok;
+    if (ok && gdk_pixbuf_loader_get_pixbuf(loader))
+        result = g_object_ref(gdk_pixbuf_loader_get_pixbuf(loader));
+    g_object_unref(loader);
+    if (!result) return NULL;
+
+    /* Too small to fill the target: a full decode looks better */
+    if (MAX(req.width, req.height) < size) {
+        g_object_unref(result);
+        return NULL;
+    }
+
+    /* Some cameras letterbox the preview to 4:3; reject those */
+    if (info->main_width && info->main_height && req.height > 0) {
+        double main_aspect = (double)info->main_width / info->main_height;
+        double aspect = (double)req.width / req.height;
+        if (ABS(aspect - main_aspect) / main_aspect > ASPECT_TOLERANCE) {
+            g_object_unref(result);
+            return NULL;
+        }
+    }
+    return result;
+}
+
+/* --- Public API --- */
+
+GdkPixbuf *
+exif_thumbnail_from_data(const guint8 *data, gsize len, int size)
+{
+    TiffReader t;
+    gsize tiff_offset = 0, tiff_length = len;
+
+    if (!data) return NULL;
+    if (!tiff_reader_init(&t, data, len)) {
+        if (!jpeg_find_exif(data, len, &tiff_offset, &tiff_length)) return NULL;
+        if (!tiff_reader_init(&t, data + tiff_offset, tiff_length)) return NULL;
+    }
+
+    PreviewInfo info = { 0, 0, 0, 0 };
+    if (!tiff_find_preview(&t, &info)) return NULL;
+    return decode_preview(t.data + info.jpeg_offset, info.jpeg_length, &info, size);
+}
+
+GdkPixbuf *
+exif_thumbnail_from_file(const char *path, int size)
+{
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (!mapped) return NULL;
+
+    GdkPixbuf *pixbuf = exif_thumbnail_from_data((const guint8 *)g_mapped_file_get_contents(mapped),
+                                                 g_mapped_file_get_length(mapped), size);
+    g_mapped_file_unref(mapped);
+    return pixbuf;
+}
@@ -0,0 +1,18 @@
+#ifndef BRIGHTEYES_EXIFTHUMB_H
+#define BRIGHTEYES_EXIFTHUMB_H
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* Embedded thumbnails
+ *
+ * Extracts the preview JPEG that cameras store in the EXIF IFD1 of JPEG
+ * files and in the IFD chain of TIFF containers, scaled to fit size. Returns
+ * NULL when there is no usable preview (missing, smaller than size, or with
+ * an aspect ratio that differs from the main image) so callers can fall back
+ * to a full decode. Thread-safe.
+ */
+
+GdkPixbuf *exif_thumbnail_from_data(const guint8 *data, gsize len, int size);
+GdkPixbuf *exif_thumbnail_from_file(const char *path, int size);
+
+#endif /* BRIGHTEYES_EXIFTHUMB_H */
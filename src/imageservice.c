@@ -0,0 +1,839 @@
+#include "imageservice.h"
+#include <glib/gstdio.h>
+#include <string.h>
+#include "archive.h"
+#include "exifthumb.h"
+#include "metrics.h"
+#include "pixelops.h"
+#include "membudget.h"
+
+/* Image service (model)
+ *
+ * One place that reads and decodes images for the viewer, the prefetcher,
+ * the thumbnail bar, the metadata sidebar and batch OCR, so a page is
+ * extracted and decoded once however many of them want it:
+ * - Jobs: one per key (path and size). A request for a key that is already
+ *   being decoded waits for that job. The decode runs on the service pool,
+ *   on the thread of the first blocking request, or in the viewer (a claim),
+ *   which streams its decode to show progress.
+ * - Interest: a pool job is cancelled once every request waiting on it is
+ *   cancelled. A job whose runner was cancelled while others still wait is
+ *   restarted on the pool.
+ * - Cache: full-size results live in an LRU bounded by decoded bytes and are
+ *   validated against the source mtime (the archive's for archive:// paths).
+ *   Entries evicted while a consumer still holds the pixbuf stay reachable
+ *   through a weak reference, so an image that is still alive is never
+ *   decoded twice.
+ * - Scaled requests use a cached or in-flight full decode when there is one,
+ *   then an embedded camera preview, and only then decode at scale. They are
+ *   coalesced but not cached; the thumbnail bar has its own cache.
+ * - Entry reads: concurrent reads of one archive entry share an extraction.
+ * - Memory: cached decodes and archive entry bytes are accounted to the
+ *   process memory budget, which may trim the cache oldest first or empty
+ *   it under memory pressure.
+ *
+ * Async waiters are only touched on the main thread; everything the pool
+ * threads see is guarded by service_lock.
+ *
+ * Sections: helpers, cache, entry reads, jobs, decoding, public API.
+ */
+
+#define DEFAULT_BUDGET_MB 256
+#define WAIT_STEP_MS 50
+#define LIVE_SWEEP_THRESHOLD 256
+
+typedef struct {
+    char *key;
+    GdkPixbuf *pixbuf;
+    gint64 mtime;
+    gsize bytes;
+    GList link; /* Node in lru, data points back to the node */
+} CacheNode;
+
+typedef struct {
+    GWeakRef pixbuf;
+    gint64 mtime;
+} LiveNode;
+
+typedef struct {
+    gint ref_count;
+    char *key;
+    char *path;
+    int size;
+    GCancellable *cancellable; /* Pool runs only */
+    GList *waiters;            /* Waiter*, main thread only */
+    guint n_async;             /* Waiters still interested */
+    guint n_blocking;          /* Threads waiting in job_wait_locked */
+    gboolean done;
+    gint64 mtime;
+    GdkPixbuf *pixbuf;
+    GError *error;
+} ImageJob;
+
+typedef struct {
+    GTask *task;
+    ImageJob *job;
+    GSource *cancel_source;
+} Waiter;
+
+struct _ImageClaim {
+    ImageJob *job;
+};
+
+typedef struct {
+    gint ref_count;
+    gboolean done;
+    GBytes *bytes;
+    GError *error;
+} EntryRead;
+
+static GMutex service_lock;
+static GCond service_cond;
+static GHashTable *cache;       /* key -> CacheNode* */
+static GQueue lru = G_QUEUE_INIT; /* Least recently used first */
+static gsize cache_bytes = 0;
+static gsize budget = 0;
+static GHashTable *live;        /* key -> LiveNode*, evicted but maybe still in use */
+static GHashTable *jobs;        /* key -> ImageJob* */
+static GHashTable *entry_reads; /* path -> EntryRead* */
+static GThreadPool *decode_pool = NULL;
+
+static void pool_worker(gpointer data, gpointer user_data);
+static void cache_shed(MemShedLevel level, gsize excess, gpointer user_data);
+
+/* --- Helpers --- */
+
+static gint64
+get_source_mtime(const char *path)
+{
+    char *archive_path = NULL, *entry_name = NULL;
+    GStatBuf st;
+    int rc;
+
+    if (archive_split_path(path, &archive_path, &entry_name)) {
+        rc = g_stat(archive_path, &st);
+        g_free(archive_path);
+        g_free(entry_name);
+    } else {
+        rc = g_stat(path, &st);
+    }
+    return rc == 0 ? (gint64)st.st_mtime : -1;
+}
+
+static char *
+make_key(const char *path, int size)
+{
+    return size > 0 ? g_strdup_printf("%s\n%d", path, size) : g_strdup(path);
+}
+
+static void
+service_init(void)
+{
+    static gsize initialized = 0;
+    if (g_once_init_enter(&initialized)) {
+        guint64 budget_mb = DEFAULT_BUDGET_MB;
+        /* BRIGHTEYES_PREFETCH_MB is the name from before the cache was shared */
+        const char *env = g_getenv("BRIGHTEYES_IMAGE_CACHE_MB");
+        if (!env || !*env) env = g_getenv("BRIGHTEYES_PREFETCH_MB");
+        if (env && *env) {
+            guint64 v = g_ascii_strtoull(env, NULL, 10);
+            if (v > 0) budget_mb = v;
+        }
+        budget = (gsize)(budget_mb * 1024 * 1024);
+
+        cache = g_hash_table_new(g_str_hash, g_str_equal);
+        live = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        jobs = g_hash_table_new(g_str_hash, g_str_equal);
+        entry_reads = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        decode_pool = g_thread_pool_new(pool_worker, NULL, (gint)g_get_num_processors(), FALSE, NULL);
+        mem_budget_add_shedder(MEM_POOL_IMAGE_CACHE, cache_shed, NULL);
+        g_once_init_leave(&initialized, 1);
+    }
+}
+
+/* --- Cache (service_lock held) --- */
+
+static void
+live_node_free(LiveNode *node)
+{
+    g_weak_ref_clear(&node->pixbuf);
+    g_free(node);
+}
+
+static void
+live_remove(const char *key)
+{
+    LiveNode *node = g_hash_table_lookup(live, key);
+    if (!node) return;
+    g_hash_table_remove(live, key);
+    live_node_free(node);
+}
+
+/* Drop weak entries whose pixbuf has been finalized */
+static void
+live_sweep(void)
+{
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, live);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        LiveNode *node = value;
+        GdkPixbuf *pixbuf = g_weak_ref_get(&node->pixbuf);
+        if (pixbuf) {
+            g_object_unref(pixbuf);
+            continue;
+        }
+        g_hash_table_iter_remove(&iter);
+        live_node_free(node);
+    }
+}
+
+/* Evict a node; consumers holding the pixbuf keep it findable by weak ref */
+static void
+cache_remove(CacheNode *node)
+{
+    g_queue_unlink(&lru, &node->link);
+    cache_bytes -= node->bytes;
+    mem_budget_add(MEM_POOL_IMAGE_CACHE, -(gssize)node->bytes);
+    g_hash_table_remove(cache, node->key);
+
+    /* Track it before letting go; whether a consumer still holds it is only
+     * known once the weak ref is read back after our unref */
+    if (g_hash_table_size(live) >= LIVE_SWEEP_THRESHOLD) live_sweep();
+    live_remove(node->key);
+    LiveNode *weak = g_new0(LiveNode, 1);
+    g_weak_ref_init(&weak->pixbuf, node->pixbuf);
+    weak->mtime = node->mtime;
+    g_hash_table_insert(live, g_strdup(node->key), weak);
+
+    g_object_unref(node->pixbuf);
+    GdkPixbuf *alive = g_weak_ref_get(&weak->pixbuf);
+    if (alive) g_object_unref(alive); /* Dangling ones go in the next sweep */
+    else live_remove(node->key);
+    g_free(node->key);
+    g_free(node);
+}
+
+static void
+cache_add(const char *key, GdkPixbuf *pixbuf, gint64 mtime)
+{
+    gsize bytes = (gsize)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf);
+    if (bytes > budget) return;
+
+    CacheNode *old = g_hash_table_lookup(cache, key);
+    if (old) cache_remove(old);
+    live_remove(key);
+
+    CacheNode *node = g_new0(CacheNode, 1);
+    node->key = g_strdup(key);
+    node->pixbuf = g_object_ref(pixbuf);
+    node->mtime = mtime;
+    node->bytes = bytes;
+    node->link.data = node;
+    g_hash_table_insert(cache, node->key, node);
+    g_queue_push_tail_link(&lru, &node->link);
+    cache_bytes += bytes;
+    mem_budget_add(MEM_POOL_IMAGE_CACHE, (gssize)bytes);
+
+    while (cache_bytes > budget && lru.head) {
+        CacheNode *oldest = lru.head->data;
+        cache_remove(oldest);
+    }
+}
+
+/* Memory budget shedder (main thread, takes service_lock itself): evict
+ * oldest first. Images still in use stay reachable through the live table. */
+static void
+cache_shed(MemShedLevel level, gsize excess, gpointer user_data)
+{
+    gsize freed = 0;
+    g_mutex_lock(&service_lock);
+    while (lru.head && (level != MEM_SHED_TRIM || freed < excess)) {
+        CacheNode *oldest = lru.head->data;
+        freed += oldest->bytes;
+        cache_remove(oldest);
+    }
+    g_mutex_unlock(&service_lock);
+}
+
+static GdkPixbuf *
+cache_lookup(const char *key, gint64 mtime)
+{
+    CacheNode *node = g_hash_table_lookup(cache, key);
+    if (node) {
+        if (node->mtime != mtime) {
+            /* Changed on disk since it was decoded */
+            cache_remove(node);
+            live_remove(key);
+            return NULL;
+        }
+        g_queue_unlink(&lru, &node->link);
+        g_queue_push_tail_link(&lru, &node->link);
+        return g_object_ref(node->pixbuf);
+    }
+
+    LiveNode *weak = g_hash_table_lookup(live, key);
+    if (!weak) return NULL;
+    GdkPixbuf *pixbuf = weak->mtime == mtime ? g_weak_ref_get(&weak->pixbuf) : NULL;
+    if (pixbuf) cache_add(key, pixbuf, mtime); /* In memory anyway: cache it again */
+    else live_remove(key);
+    return pixbuf;
+}
+
+/* --- Entry reads --- */
+
+static void
+entry_read_unref(EntryRead *read)
+{
+    if (!g_atomic_int_dec_and_test(&read->ref_count)) return;
+    if (read->bytes) g_bytes_unref(read->bytes);
+    g_clear_error(&read->error);
+    g_free(read);
+}
+
+static GBytes *
+read_source_bytes(const char *path, GError **error)
+{
+    char *archive_path = NULL, *entry_name = NULL;
+    if (archive_split_path(path, &archive_path, &entry_name)) {
+        GBytes *bytes = archive_read_entry_bytes(archive_path, entry_name, error);
+        g_free(archive_path);
+        g_free(entry_name);
+        return mem_budget_track_bytes(MEM_POOL_ARCHIVE, bytes);
+    }
+
+    /* Not the reader's cancellable: others may be waiting for the bytes */
+    GFile *file = g_file_new_for_path(path);
+    GBytes *bytes = g_file_load_bytes(file, NULL, NULL, error);
+    g_object_unref(file);
+    return bytes;
+}
+
+/* --- Jobs --- */
+
+static ImageJob *
+job_ref(ImageJob *job)
+{
+    g_atomic_int_inc(&job->ref_count);
+    return job;
+}
+
+static void
+job_unref(ImageJob *job)
+{
+    if (!g_atomic_int_dec_and_test(&job->ref_count)) return;
+    g_free(job->key);
+    g_free(job->path);
+    g_clear_object(&job->cancellable);
+    g_clear_object(&job->pixbuf);
+    g_clear_error(&job->error);
+    g_free(job);
+}
+
+/* New job registered under its key (service_lock held). The table's
+ * reference is dropped when the job finishes. */
+static ImageJob *
+job_new_locked(const char *path, int size, const char *key)
+{
+    ImageJob *job = g_new0(ImageJob, 1);
+    job->ref_count = 1;
+    job->key = g_strdup(key);
+    job->path = g_strdup(path);
+    job->size = size;
+    g_hash_table_insert(jobs, job->key, job);
+    return job;
+}
+
+/* Cancel a pool job nobody waits for any more (service_lock held). */
+static GCancellable *
+job_take_idle_cancellable_locked(ImageJob *job)
+{
+    if (job->done || job->n_async + job->n_blocking > 0 || !job->cancellable) return NULL;
+    return g_object_ref(job->cancellable);
+}
+
+static void
+waiter_free(Waiter *waiter)
+{
+    if (waiter->cancel_source) {
+        g_source_destroy(waiter->cancel_source);
+        g_source_unref(waiter->cancel_source);
+    }
+    g_object_unref(waiter->task);
+    job_unref(waiter->job);
+    g_free(waiter);
+}
+
+/* Main thread: hand the result to every async waiter. */
+static gboolean
+job_dispatch(gpointer user_data)
+{
+    ImageJob *job = user_data;
+    GList *waiters = job->waiters;
+    job->waiters = NULL;
+
+    for (GList *l = waiters; l; l = l->next) {
+        Waiter *waiter = l->data;
+        if (job->pixbuf)
+            g_task_return_pointer(waiter->task, g_object_ref(job->pixbuf), g_object_unref);
+        else
+            g_task_return_error(waiter->task, g_error_copy(job->error));
+        waiter_free(waiter);
+    }
+    g_list_free(waiters);
+    return G_SOURCE_REMOVE;
+}
+
+/* Main thread: a waiter's cancellable fired before the job finished. */
+static gboolean
+on_waiter_cancelled(GCancellable *cancellable, gpointer user_data)
+{
+    Waiter *waiter = user_data;
+    ImageJob *job = waiter->job;
+    job->waiters = g_list_remove(job->waiters, waiter);
+
+    g_mutex_lock(&service_lock);
+    job->n_async--;
+    GCancellable *idle = job_take_idle_cancellable_locked(job);
+    g_mutex_unlock(&service_lock);
+    if (idle) {
+        g_cancellable_cancel(idle);
+        g_object_unref(idle);
+    }
+
+    g_task_return_error_if_cancelled(waiter->task);
+    /* The source is being dispatched; returning REMOVE destroys it */
+    g_source_unref(waiter->cancel_source);
+    waiter->cancel_source = NULL;
+    waiter_free(waiter);
+    return G_SOURCE_REMOVE;
+}
+
+/* Publish a result and wake everyone waiting; takes ownership of pixbuf
+ * and error. A cancelled run with waiters left is queued on the pool. */
+static void
+job_finish(ImageJob *job, GdkPixbuf *pixbuf, GError *error)
+{
+    g_mutex_lock(&service_lock);
+    if (!pixbuf && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED) &&
+        job->n_async + job->n_blocking > 0) {
+        g_clear_object(&job->cancellable);
+        job->cancellable = g_cancellable_new();
+        g_mutex_unlock(&service_lock);
+        g_error_free(error);
+        g_thread_pool_push(decode_pool, job_ref(job), NULL);
+        return;
+    }
+
+    job->done = TRUE;
+    job->pixbuf = pixbuf;
+    job->error = pixbuf ? NULL : (error ? error : g_error_new(G_IO_ERROR, G_IO_ERROR_FAILED, "Could not decode image"));
+    if (pixbuf && error) g_error_free(error);
+    if (pixbuf && job->size == 0) cache_add(job->key, pixbuf, job->mtime);
+    g_hash_table_remove(jobs, job->key);
+    g_cond_broadcast(&service_cond);
+    g_mutex_unlock(&service_lock);
+
+    /* Takes over the table's reference */
+    g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT, job_dispatch, job, (GDestroyNotify)job_unref);
+}
+
+/* Block until job is done or cancellable fires (service_lock held; it is
+ * released while waiting). Returns a new reference to the result. */
+static GdkPixbuf *
+job_wait_locked(ImageJob *job, GCancellable *cancellable, GError **error)
+{
+    job_ref(job);
+    job->n_blocking++;
+    while (!job->done) {
+        if (g_cancellable_is_cancelled(cancellable)) {
+            job->n_blocking--;
+            GCancellable *idle = job_take_idle_cancellable_locked(job);
+            if (idle) {
+                g_cancellable_cancel(idle);
+                g_object_unref(idle);
+            }
+            job_unref(job);
+            g_cancellable_set_error_if_cancelled(cancellable, error);
+            return NULL;
+        }
+        g_cond_wait_until(&service_cond, &service_lock, g_get_monotonic_time() + WAIT_STEP_MS * G_TIME_SPAN_MILLISECOND);
+    }
+    job->n_blocking--;
+
+    GdkPixbuf *pixbuf = job->pixbuf ? g_object_ref(job->pixbuf) : NULL;
+    if (!pixbuf) g_propagate_error(error, g_error_copy(job->error));
+    job_unref(job);
+    return pixbuf;
+}
+
+/* --- Decoding --- */
+
+static GdkPixbuf *
+scale_to_fit(GdkPixbuf *pixbuf, int size)
+{
+    int w = gdk_pixbuf_get_width(pixbuf);
+    int h = gdk_pixbuf_get_height(pixbuf);
+    if (w <= size && h <= size) return g_object_ref(pixbuf);
+
+    double scale = (double)size / MAX(w, h);
+    return pixel_ops_scale_down(pixbuf, MAX(1, (int)(w * scale)), MAX(1, (int)(h * scale)));
+}
+
+/* Full image for a scaled request if one is cached or being decoded; NULL
+ * (without an error) when a decode would have to start. */
+static GdkPixbuf *
+shared_full_image(const char *path, gint64 mtime, GCancellable *cancellable, GError **error)
+{
+    g_mutex_lock(&service_lock);
+    GdkPixbuf *pixbuf = cache_lookup(path, mtime);
+    ImageJob *job = pixbuf ? NULL : g_hash_table_lookup(jobs, path);
+    if (job) pixbuf = job_wait_locked(job, cancellable, error);
+    g_mutex_unlock(&service_lock);
+    return pixbuf;
+}
+
+/* Pool threads don't wait for a full decode: it could be queued behind them */
+static GdkPixbuf *
+decode_scaled(const char *path, int size, gint64 mtime, gboolean on_pool, GCancellable *cancellable, GError **error)
+{
+    GError *local_error = NULL;
+    GdkPixbuf *full = NULL;
+    if (on_pool) {
+        g_mutex_lock(&service_lock);
+        full = cache_lookup(path, mtime);
+        g_mutex_unlock(&service_lock);
+    } else {
+        full = shared_full_image(path, mtime, cancellable, &local_error);
+    }
+    if (full) {
+        GdkPixbuf *scaled = scale_to_fit(full, size);
+        g_object_unref(full);
+        return scaled;
+    }
+    if (g_error_matches(local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_propagate_error(error, local_error);
+        return NULL;
+    }
+    g_clear_error(&local_error); /* A failed full decode may still scale */
+
+    gboolean in_archive = g_str_has_prefix(path, "archive://");
+    GBytes *bytes = NULL;
+    GInputStream *stream = NULL;
+
+    /* Camera JPEGs usually carry a ~160px preview; skip the decode */
+    if (in_archive) {
+        bytes = image_service_read_bytes(path, cancellable, error);
+        if (!bytes) return NULL;
+        GdkPixbuf *preview = exif_thumbnail_from_data(g_bytes_get_data(bytes, NULL), g_bytes_get_size(bytes), size);
+        if (preview) {
+            g_bytes_unref(bytes);
+            return preview;
+        }
+        stream = g_memory_input_stream_new_from_bytes(bytes);
+        g_bytes_unref(bytes);
+    } else {
+        GdkPixbuf *preview = exif_thumbnail_from_file(path, size);
+        if (preview) return preview;
+
+        GFile *file = g_file_new_for_path(path);
+        stream = G_INPUT_STREAM(g_file_read(file, cancellable, error));
+        g_object_unref(file);
+        if (!stream) return NULL;
+    }
+
+    /* The JPEG loader picks a libjpeg DCT scale factor (down to 1/8) from the
+       requested size, so this is not a full-resolution decode either */
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream_at_scale(stream, size, size, TRUE, cancellable, error);
+    g_object_unref(stream);
+    return pixbuf;
+}
+
+static GdkPixbuf *
+decode_full(const char *path, GCancellable *cancellable, GError **error)
+{
+    GInputStream *stream = NULL;
+
+    if (g_str_has_prefix(path, "archive://")) {
+        GBytes *bytes = image_service_read_bytes(path, cancellable, error);
+        if (!bytes) return NULL;
+        stream = g_memory_input_stream_new_from_bytes(bytes);
+        g_bytes_unref(bytes);
+    } else {
+        GFile *file = g_file_new_for_path(path);
+        stream = G_INPUT_STREAM(g_file_read(file, cancellable, error));
+        g_object_unref(file);
+        if (!stream) return NULL;
+    }
+
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream(stream, cancellable, error);
+    g_object_unref(stream);
+    return pixbuf;
+}
+
+static void
+job_run(ImageJob *job, gboolean on_pool, GCancellable *cancellable)
+{
+    GError *error = NULL;
+    GdkPixbuf *pixbuf = NULL;
+
+    if (!g_cancellable_set_error_if_cancelled(cancellable, &error)) {
+        gint64 start = metrics_start();
+        pixbuf = job->size > 0 ? decode_scaled(job->path, job->size, job->mtime, on_pool, cancellable, &error)
+                               : decode_full(job->path, cancellable, &error);
+        if (pixbuf) metrics_record(METRICS_DECODE, start);
+    }
+    job_finish(job, pixbuf, error);
+}
+
+static void
+pool_worker(gpointer data, gpointer user_data)
+{
+    ImageJob *job = data;
+
+    g_mutex_lock(&service_lock);
+    GCancellable *cancellable = g_object_ref(job->cancellable);
+    g_mutex_unlock(&service_lock);
+
+    job_run(job, TRUE, cancellable);
+    g_object_unref(cancellable);
+    job_unref(job);
+}
+
+/* --- Public API --- */
+
+GdkPixbuf *
+image_service_peek(const char *path, int size)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    service_init();
+    if (size > 0) return NULL;
+
+    gint64 mtime = get_source_mtime(path);
+    g_mutex_lock(&service_lock);
+    GdkPixbuf *pixbuf = cache_lookup(path, mtime);
+    g_mutex_unlock(&service_lock);
+    return pixbuf;
+}
+
+GdkPixbuf *
+image_service_lookup(const char *path, int size)
+{
+    GdkPixbuf *pixbuf = image_service_peek(path, size);
+    metrics_count(pixbuf ? METRICS_IMAGE_CACHE_HIT : METRICS_IMAGE_CACHE_MISS);
+    return pixbuf;
+}
+
+gboolean
+image_service_is_pending(const char *path, int size)
+{
+    g_return_val_if_fail(path != NULL, FALSE);
+
+    service_init();
+    char *key = make_key(path, size);
+    g_mutex_lock(&service_lock);
+    gboolean pending = g_hash_table_contains(jobs, key);
+    g_mutex_unlock(&service_lock);
+    g_free(key);
+    return pending;
+}
+
+void
+image_service_request_async(const char *path, int size, GCancellable *cancellable,
+                            GAsyncReadyCallback callback, gpointer user_data)
+{
+    GTask *task = g_task_new(NULL, cancellable, callback, user_data);
+    g_task_set_source_tag(task, image_service_request_async);
+
+    GdkPixbuf *cached = image_service_lookup(path, size);
+    if (cached) {
+        g_task_return_pointer(task, cached, g_object_unref);
+        g_object_unref(task);
+        return;
+    }
+    if (g_task_return_error_if_cancelled(task)) {
+        g_object_unref(task);
+        return;
+    }
+
+    char *key = make_key(path, size);
+    gint64 mtime = get_source_mtime(path);
+    gboolean start = FALSE;
+
+    g_mutex_lock(&service_lock);
+    ImageJob *job = g_hash_table_lookup(jobs, key);
+    if (!job) {
+        job = job_new_locked(path, size, key);
+        job->mtime = mtime;
+        job->cancellable = g_cancellable_new();
+        start = TRUE;
+    }
+    job->n_async++;
+    g_mutex_unlock(&service_lock);
+    g_free(key);
+
+    Waiter *waiter = g_new0(Waiter, 1);
+    waiter->task = task;
+    waiter->job = job_ref(job);
+    job->waiters = g_list_prepend(job->waiters, waiter);
+    if (cancellable) {
+        waiter->cancel_source = g_cancellable_source_new(cancellable);
+        g_source_set_callback(waiter->cancel_source, (GSourceFunc)on_waiter_cancelled, waiter, NULL);
+        g_source_attach(waiter->cancel_source, NULL);
+    }
+
+    if (start) g_thread_pool_push(decode_pool, job_ref(job), NULL);
+}
+
+GdkPixbuf *
+image_service_request_finish(GAsyncResult *result, GError **error)
+{
+    return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+GdkPixbuf *
+image_service_request(const char *path, int size, GCancellable *cancellable, GError **error)
+{
+    GdkPixbuf *cached = image_service_lookup(path, size);
+    if (cached) return cached;
+
+    char *key = make_key(path, size);
+    gint64 mtime = get_source_mtime(path);
+
+    g_mutex_lock(&service_lock);
+    ImageJob *job = g_hash_table_lookup(jobs, key);
+    if (job) {
+        GdkPixbuf *pixbuf = job_wait_locked(job, cancellable, error);
+        g_mutex_unlock(&service_lock);
+        g_free(key);
+        return pixbuf;
+    }
+    job = job_ref(job_new_locked(path, size, key));
+    job->mtime = mtime;
+    g_mutex_unlock(&service_lock);
+    g_free(key);
+
+    /* Nobody else is decoding it: do it here */
+    job_run(job, FALSE, cancellable);
+
+    g_mutex_lock(&service_lock);
+    GdkPixbuf *pixbuf = job->pixbuf ? g_object_ref(job->pixbuf) : NULL;
+    gboolean done = job->done;
+    if (!pixbuf && done) g_propagate_error(error, g_error_copy(job->error));
+    g_mutex_unlock(&service_lock);
+
+    /* Cancelled here but handed to the pool for the others. A worker may
+     * finish it since, but this caller gave up first. */
+    if (!pixbuf && !done && !g_cancellable_set_error_if_cancelled(cancellable, error))
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled");
+    job_unref(job);
+    return pixbuf;
+}
+
+GBytes *
+image_service_read_bytes(const char *path, GCancellable *cancellable, GError **error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    service_init();
+
+    g_mutex_lock(&service_lock);
+    EntryRead *read = g_hash_table_lookup(entry_reads, path);
+    if (read) {
+        g_atomic_int_inc(&read->ref_count);
+        while (!read->done) {
+            if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+                g_mutex_unlock(&service_lock);
+                entry_read_unref(read);
+                return NULL;
+            }
+            g_cond_wait_until(&service_cond, &service_lock, g_get_monotonic_time() + WAIT_STEP_MS * G_TIME_SPAN_MILLISECOND);
+        }
+        GBytes *bytes = read->bytes ? g_bytes_ref(read->bytes) : NULL;
+        if (!bytes) g_propagate_error(error, g_error_copy(read->error));
+        g_mutex_unlock(&service_lock);
+        entry_read_unref(read);
+        return bytes;
+    }
+
+    read = g_new0(EntryRead, 1);
+    read->ref_count = 2; /* Table and this reader */
+    g_hash_table_insert(entry_reads, g_strdup(path), read);
+    g_mutex_unlock(&service_lock);
+
+    GError *local_error = NULL;
+    GBytes *bytes = read_source_bytes(path, &local_error);
+
+    g_mutex_lock(&service_lock);
+    read->done = TRUE;
+    read->bytes = bytes ? g_bytes_ref(bytes) : NULL;
+    read->error = local_error ? g_error_copy(local_error) : NULL;
+    g_hash_table_remove(entry_reads, path);
+    g_cond_broadcast(&service_cond);
+    g_mutex_unlock(&service_lock);
+    entry_read_unref(read); /* The table's reference */
+    entry_read_unref(read);
+
+    if (!bytes) g_propagate_error(error, local_error);
+    return bytes;
+}
+
+static void
+read_bytes_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    GError *error = NULL;
+    GBytes *bytes = image_service_read_bytes(task_data, cancellable, &error);
+    if (bytes)
+        g_task_return_pointer(task, bytes, (GDestroyNotify)g_bytes_unref);
+    else
+        g_task_return_error(task, error);
+}
+
+void
+image_service_read_bytes_async(const char *path, GCancellable *cancellable,
+                               GAsyncReadyCallback callback, gpointer user_data)
+{
+    GTask *task = g_task_new(NULL, cancellable, callback, user_data);
+    g_task_set_task_data(task, g_strdup(path), g_free);
+    g_task_run_in_thread(task, read_bytes_thread);
+    g_object_unref(task);
+}
+
+GBytes *
+image_service_read_bytes_finish(GAsyncResult *result, GError **error)
+{
+    return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+ImageClaim *
+image_service_claim(const char *path)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    service_init();
+    gint64 mtime = get_source_mtime(path);
+
+    g_mutex_lock(&service_lock);
+    if (g_hash_table_contains(jobs, path)) {
+        g_mutex_unlock(&service_lock);
+        return NULL;
+    }
+    ImageJob *job = job_new_locked(path, 0, path);
+    job->mtime = mtime;
+    g_mutex_unlock(&service_lock);
+
+    ImageClaim *claim = g_new0(ImageClaim, 1);
+    claim->job = job_ref(job);
+    return claim;
+}
+
+void
+image_service_complete(ImageClaim *claim, GdkPixbuf *pixbuf)
+{
+    if (!claim) return;
+
+    if (pixbuf)
+        job_finish(claim->job, g_object_ref(pixbuf), NULL);
+    else
+        job_finish(claim->job, NULL, g_error_new(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Decode abandoned"));
+    job_unref(claim->job);
+    g_free(claim);
+}
@@ -0,0 +1,64 @@
+#ifndef BRIGHTEYES_IMAGESERVICE_H
+#define BRIGHTEYES_IMAGESERVICE_H
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/* Shared image service
+ *
+ * Reads and decodes images (plain files and archive:// pages) for every
+ * part of the UI. Requests are keyed by path and size: size 0 is the full
+ * image, anything else fits the image in a size x size box. Concurrent
+ * requests for the same key share one decode, full-size results go into a
+ * decoded-image cache (BRIGHTEYES_IMAGE_CACHE_MB, default 256 MB), and
+ * scaled requests are answered from a full decode when one is cached or in
+ * flight.
+ *
+ * The _async functions must be called on the main thread and complete
+ * there; the blocking ones are for worker threads.
+ */
+
+/* Cached image for path, or NULL. Only full-size images are cached, so a
+ * size other than 0 always returns NULL. Any thread. Counts a cache hit or
+ * miss, as the requests below do; use it where the image is wanted. */
+GdkPixbuf *image_service_lookup(const char *path, int size);
+
+/* Same, without touching the metrics: for checks such as whether a
+ * neighbour still needs decoding, which would otherwise skew the hit rate. */
+GdkPixbuf *image_service_peek(const char *path, int size);
+
+/* TRUE while a request for path at size is being decoded. */
+gboolean image_service_is_pending(const char *path, int size);
+
+void image_service_request_async(const char *path, int size, GCancellable *cancellable,
+                                 GAsyncReadyCallback callback, gpointer user_data);
+GdkPixbuf *image_service_request_finish(GAsyncResult *result, GError **error);
+
+/* Blocking request. If nobody is decoding the key yet the decode runs on
+ * the calling thread. */
+GdkPixbuf *image_service_request(const char *path, int size, GCancellable *cancellable, GError **error);
+
+/* Encoded bytes of path (the entry for archive:// paths). Concurrent reads
+ * of the same path share one extraction. */
+GBytes *image_service_read_bytes(const char *path, GCancellable *cancellable, GError **error);
+void image_service_read_bytes_async(const char *path, GCancellable *cancellable,
+                                    GAsyncReadyCallback callback, gpointer user_data);
+GBytes *image_service_read_bytes_finish(GAsyncResult *result, GError **error);
+
+/* Decode the full-size path yourself (e.g. to show progress while it
+ * loads) while other requests for it wait for your result. Returns NULL
+ * when a decode is already in flight; join it with
+ * image_service_request_async instead. Main thread. */
+typedef struct _ImageClaim ImageClaim;
+ImageClaim *image_service_claim(const char *path);
+
+/* Hand over the result of a claim and free it. Pass NULL when the decode
+ * failed or was abandoned; requests still waiting are then decoded by the
+ * service. */
+void image_service_complete(ImageClaim *claim, GdkPixbuf *pixbuf);
+
+G_END_DECLS
+
+#endif /* BRIGHTEYES_IMAGESERVICE_H */
@@ -2,16 +2,37 @@
  *
  * Application startup, signal wiring and GResource registration live here.
  * Keeps the entrypoint small and delegates UI construction to window.c.
+ * Nothing heavy is initialised here: GStreamer and Tesseract start on
+ * first use, and the window defers everything but the first image until
+ * it has been painted.
  */
 
 #include <adwaita.h>
 #include <gtk/gtk.h>
-#include <gst/gst.h>
 #include "window.h"
+#include "startuptrace.h"
+#include "metrics.h"
+#include "membudget.h"
 
 /* Compiled GResource accessor (generated) */
 GResource *brighteyes_get_resource(void);
 
+/* app.metrics (boolean state) switches collection on and off and
+ * app.dump-metrics prints the current values; both are reachable over
+ * D-Bus, e.g. `gapplication action org.jeremy.BrightEyes dump-metrics`. */
+static void
+on_metrics_changed(GSimpleAction *action, GVariant *value, gpointer user_data)
+{
+    metrics_set_enabled(g_variant_get_boolean(value));
+    g_simple_action_set_state(action, value);
+}
+
+static void
+on_dump_metrics(GSimpleAction *action, GVariant *parameter, gpointer user_data)
+{
+    metrics_dump();
+}
+
 static void
 startup(GApplication *app, gpointer user_data)
 {
@@ -24,12 +45,26 @@ startup(GApplication *app, gpointer user_data)
         gtk_icon_theme_add_resource_path(theme, "/org/jeremy/BrightEyes/icons");
     }
     gtk_window_set_default_icon_name("org.jeremy.BrightEyes");
+
+    const GActionEntry app_entries[] = {
+        { "metrics", NULL, NULL, "false", on_metrics_changed },
+        { "dump-metrics", on_dump_metrics, NULL, NULL, NULL },
+    };
+    g_action_map_add_action_entries(G_ACTION_MAP(app), app_entries, G_N_ELEMENTS(app_entries), NULL);
+    if (metrics_get_enabled())
+        g_action_group_change_action_state(G_ACTION_GROUP(app), "metrics", g_variant_new_boolean(TRUE));
+
+    /* Primary instance only: remote invocations hold no images */
+    mem_budget_init();
+
+    startup_trace_mark("startup");
 }
 
 static void
 activate(GApplication *app, gpointer user_data)
 {
     BrightEyesWindow *win = bright_eyes_window_new(GTK_APPLICATION(app));
+    startup_trace_mark("window constructed");
     gtk_window_present(GTK_WINDOW(win));
 }
 
@@ -37,14 +72,17 @@ static void
 open(GApplication *app, GFile **files, gint n_files, const gchar *hint, gpointer user_data)
 {
     BrightEyesWindow *win;
+    gboolean created = FALSE;
     GList *windows = gtk_application_get_windows(GTK_APPLICATION(app));
     if (windows)
         win = BRIGHT_EYES_WINDOW(windows->data);
     else {
         win = bright_eyes_window_new(GTK_APPLICATION(app));
-        gtk_window_present(GTK_WINDOW(win)); 
+        startup_trace_mark("window constructed");
+        created = TRUE;
     }
 
+    /* Start the decode before presenting, so it overlaps the first layout */
     if (n_files >= 1) {
         char *path = g_file_get_path(files[0]);
         if (path) {
@@ -52,11 +90,16 @@ open(GApplication *app, GFile **files, gint n_files, const gchar *hint, gpointer
             g_free(path);
         }
     }
+
+    if (created) gtk_window_present(GTK_WINDOW(win));
 }
 
 int
 main(int argc, char **argv)
 {
+    startup_trace_mark("main");
+    metrics_init();
+
     /* Use Cairo renderer to avoid OpenGL/Vulkan artifacts (distorted tooltips) */
     g_setenv("GSK_RENDERER", "cairo", FALSE);
 
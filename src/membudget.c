@@ -0,0 +1,274 @@
+#include "membudget.h"
+#include <gio/gio.h>
+#include <unistd.h>
+
+/* Memory budget (model)
+ *
+ * Counters, limit and shedding behind membudget.h:
+ * - Accounting: one byte counter per pool under a lock. Crossing the limit
+ *   queues a single idle on the main loop; shedding never runs inside
+ *   mem_budget_add, whose callers may hold their own locks.
+ * - Shedding: pools are visited in priority order and each shedder is told
+ *   how much is still over the target (SHED_TARGET_PERCENT of the limit,
+ *   so a full cache does not trim on every insert). Trimming stops as soon
+ *   as the total is under the target; the medium and critical levels visit
+ *   every pool they cover.
+ * - GMemoryMonitor: a low warning trims to half of what is accounted,
+ *   medium drops the caches, critical sheds the viewer's previews as well.
+ *
+ * Sections: state, shedding, public API.
+ */
+
+#define DEFAULT_MIN_LIMIT_MB 512
+#define SHED_TARGET_PERCENT 75
+
+typedef struct {
+    guint id;
+    MemPool pool;
+    MemShedFunc func;
+    gpointer user_data;
+} Shedder;
+
+/* --- State --- */
+
+G_LOCK_DEFINE_STATIC(budget);
+static gsize used[MEM_N_POOLS];   /* Under the budget lock */
+static gsize limit = 0;           /* 0 until mem_budget_init or the first add */
+static GArray *shedders = NULL;   /* Shedder, under the budget lock */
+static guint next_shedder_id = 1;
+static gint shed_queued = 0;      /* Atomic: an over-limit idle is pending */
+static GMemoryMonitor *monitor = NULL;
+
+static gsize
+default_limit(void)
+{
+    guint64 physical = 0;
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) physical = (guint64)pages * (guint64)page_size;
+#endif
+    guint64 quarter = physical / 4;
+    return (gsize)MAX(quarter, (guint64)DEFAULT_MIN_LIMIT_MB * 1024 * 1024);
+}
+
+/* Caller holds the budget lock */
+static void
+ensure_limit_locked(void)
+{
+    if (limit) return;
+    const char *env = g_getenv("BRIGHTEYES_MEMORY_BUDGET_MB");
+    guint64 mb = env && *env ? g_ascii_strtoull(env, NULL, 10) : 0;
+    limit = mb > 0 ? (gsize)(mb * 1024 * 1024) : default_limit();
+}
+
+static gsize
+total_locked(void)
+{
+    gsize total = 0;
+    for (int i = 0; i < MEM_N_POOLS; i++) total += used[i];
+    return total;
+}
+
+/* --- Shedding --- */
+
+/* Visit pools up to last, in order, until the total is down to target. */
+static void
+run_shedders(MemShedLevel level, MemPool last, gsize target)
+{
+    G_LOCK(budget);
+    GArray *snapshot = shedders ? g_array_copy(shedders) : NULL;
+    G_UNLOCK(budget);
+    if (!snapshot) return;
+
+    for (int pool = 0; pool <= (int)last; pool++) {
+        for (guint i = 0; i < snapshot->len; i++) {
+            Shedder *s = &g_array_index(snapshot, Shedder, i);
+            if ((int)s->pool != pool) continue;
+
+            G_LOCK(budget);
+            gsize total = total_locked();
+            /* Dropped by an earlier shedder of this pass */
+            gboolean registered = FALSE;
+            for (guint j = 0; shedders && j < shedders->len; j++)
+                if (g_array_index(shedders, Shedder, j).id == s->id) registered = TRUE;
+            G_UNLOCK(budget);
+
+            if (level == MEM_SHED_TRIM && total <= target) goto done;
+            if (!registered) continue;
+            s->func(level, level == MEM_SHED_TRIM ? total - target : G_MAXSIZE, s->user_data);
+        }
+    }
+
+done:
+    g_array_unref(snapshot);
+    g_debug("Memory after shedding: %" G_GSIZE_FORMAT " MB of %" G_GSIZE_FORMAT " MB",
+            mem_budget_get_total() / (1024 * 1024), mem_budget_get_limit() / (1024 * 1024));
+}
+
+static gsize
+trim_target(void)
+{
+    return mem_budget_get_limit() / 100 * SHED_TARGET_PERCENT;
+}
+
+static gboolean
+shed_over_limit(gpointer user_data)
+{
+    g_atomic_int_set(&shed_queued, 0);
+    if (mem_budget_get_total() > mem_budget_get_limit())
+        run_shedders(MEM_SHED_TRIM, MEM_N_POOLS - 1, trim_target());
+    return G_SOURCE_REMOVE;
+}
+
+static void
+on_low_memory_warning(GMemoryMonitor *memory_monitor, GMemoryMonitorWarningLevel level, gpointer user_data)
+{
+    g_debug("Low memory warning (level %d)", (int)level);
+    if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+        mem_budget_shed(MEM_SHED_CRITICAL);
+    else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+        mem_budget_shed(MEM_SHED_CACHES);
+    else
+        mem_budget_shed(MEM_SHED_TRIM);
+}
+
+/* --- Public API --- */
+
+void
+mem_budget_init(void)
+{
+    if (monitor) return;
+
+    G_LOCK(budget);
+    ensure_limit_locked();
+    G_UNLOCK(budget);
+
+    monitor = g_memory_monitor_dup_default();
+    if (monitor)
+        g_signal_connect(monitor, "low-memory-warning", G_CALLBACK(on_low_memory_warning), NULL);
+}
+
+void
+mem_budget_add(MemPool pool, gssize delta)
+{
+    g_return_if_fail(pool < MEM_N_POOLS);
+
+    G_LOCK(budget);
+    ensure_limit_locked();
+    if (delta < 0 && (gsize)-delta > used[pool]) {
+        g_warning("Memory pool %d released more than it accounted", (int)pool);
+        used[pool] = 0;
+    } else {
+        used[pool] += delta;
+    }
+    gboolean over = total_locked() > limit;
+    G_UNLOCK(budget);
+
+    if (over && g_atomic_int_compare_and_exchange(&shed_queued, 0, 1))
+        g_idle_add_full(G_PRIORITY_DEFAULT, shed_over_limit, NULL, NULL);
+}
+
+gsize
+mem_budget_get_used(MemPool pool)
+{
+    g_return_val_if_fail(pool < MEM_N_POOLS, 0);
+    G_LOCK(budget);
+    gsize n = used[pool];
+    G_UNLOCK(budget);
+    return n;
+}
+
+gsize
+mem_budget_get_total(void)
+{
+    G_LOCK(budget);
+    gsize total = total_locked();
+    G_UNLOCK(budget);
+    return total;
+}
+
+gsize
+mem_budget_get_limit(void)
+{
+    G_LOCK(budget);
+    ensure_limit_locked();
+    gsize n = limit;
+    G_UNLOCK(budget);
+    return n;
+}
+
+guint
+mem_budget_add_shedder(MemPool pool, MemShedFunc func, gpointer user_data)
+{
+    g_return_val_if_fail(pool < MEM_N_POOLS && func != NULL, 0);
+
+    Shedder s = { 0, pool, func, user_data };
+    G_LOCK(budget);
+    if (!shedders) shedders = g_array_new(FALSE, FALSE, sizeof(Shedder));
+    s.id = next_shedder_id++;
+    g_array_append_val(shedders, s);
+    G_UNLOCK(budget);
+    return s.id;
+}
+
+void
+mem_budget_remove_shedder(guint id)
+{
+    G_LOCK(budget);
+    for (guint i = 0; shedders && i < shedders->len; i++) {
+        if (g_array_index(shedders, Shedder, i).id == id) {
+            g_array_remove_index(shedders, i);
+            break;
+        }
+    }
+    G_UNLOCK(budget);
+}
+
+void
+mem_budget_shed(MemShedLevel level)
+{
+    switch (level) {
+        case MEM_SHED_TRIM:
+            run_shedders(level, MEM_N_POOLS - 1, MIN(trim_target(), mem_budget_get_total() / 2));
+            break;
+        case MEM_SHED_CACHES:
+            run_shedders(level, MEM_POOL_IMAGE_CACHE, 0);
+            break;
+        case MEM_SHED_CRITICAL:
+            run_shedders(level, MEM_N_POOLS - 1, 0);
+            break;
+    }
+}
+
+typedef struct {
+    MemPool pool;
+    gsize size;
+    GBytes *bytes;
+} TrackedBytes;
+
+static void
+tracked_bytes_free(gpointer data)
+{
+    TrackedBytes *t = data;
+    mem_budget_add(t->pool, -(gssize)t->size);
+    g_bytes_unref(t->bytes);
+    g_free(t);
+}
+
+GBytes *
+mem_budget_track_bytes(MemPool pool, GBytes *bytes)
+{
+    if (!bytes) return NULL;
+
+    gsize size = 0;
+    gconstpointer data = g_bytes_get_data(bytes, &size);
+    if (size == 0) return bytes;
+
+    TrackedBytes *t = g_new0(TrackedBytes, 1);
+    t->pool = pool;
+    t->size = size;
+    t->bytes = bytes;
+    mem_budget_add(pool, (gssize)size);
+    return g_bytes_new_with_free_func(data, size, tracked_bytes_free, t);
+}
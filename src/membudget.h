@@ -0,0 +1,63 @@
+#ifndef MEMBUDGET_H
+#define MEMBUDGET_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Memory budget
+ *
+ * Process-wide accounting of the buffers that grow with image size, under
+ * one limit (BRIGHTEYES_MEMORY_BUDGET_MB, default a quarter of physical
+ * memory and at least 512 MB). Holders add and subtract their bytes from
+ * any thread. When the total goes over the limit, or GMemoryMonitor warns
+ * that the system is low on memory, the shedders registered for each pool
+ * are called on the main thread in the pool order below until enough has
+ * been freed. A pixbuf kept by several holders counts once for each, so
+ * the total errs on the high side.
+ */
+
+typedef enum {
+    MEM_POOL_THUMBNAILS,    /* Thumbnail LRU and thumbnails of unseen rows; shed first */
+    MEM_POOL_ARCHIVE,       /* Archive entries read into memory (accounted only) */
+    MEM_POOL_IMAGE_CACHE,   /* Full-size decodes kept by the image service */
+    MEM_POOL_VIEWER,        /* Open images and their preview levels; shed last */
+    MEM_N_POOLS
+} MemPool;
+
+typedef enum {
+    MEM_SHED_TRIM,          /* Over the limit or a low warning: free about excess bytes, oldest first */
+    MEM_SHED_CACHES,        /* Medium warning: drop everything that is only cached */
+    MEM_SHED_CRITICAL       /* Critical warning: also previews of what is on screen */
+} MemShedLevel;
+
+/* Called on the main thread. excess is G_MAXSIZE above MEM_SHED_TRIM. */
+typedef void (*MemShedFunc)(MemShedLevel level, gsize excess, gpointer user_data);
+
+/* Read the environment and start listening to GMemoryMonitor. Called from
+ * main; later calls do nothing. */
+void mem_budget_init(void);
+
+/* Account delta bytes (negative to release) to pool. Any thread; never
+ * calls a shedder directly. */
+void mem_budget_add(MemPool pool, gssize delta);
+
+gsize mem_budget_get_used(MemPool pool);
+gsize mem_budget_get_total(void);
+gsize mem_budget_get_limit(void);
+
+/* Shedders of a pool run in registration order. Returns an id for
+ * mem_budget_remove_shedder. Any thread. */
+guint mem_budget_add_shedder(MemPool pool, MemShedFunc func, gpointer user_data);
+void mem_budget_remove_shedder(guint id);
+
+/* Run the shedders for level now. Main thread. */
+void mem_budget_shed(MemShedLevel level);
+
+/* Bytes with the same contents that stay accounted to pool while alive.
+ * Takes ownership of bytes; NULL passes through. */
+GBytes *mem_budget_track_bytes(MemPool pool, GBytes *bytes);
+
+G_END_DECLS
+
+#endif /* MEMBUDGET_H */
@@ -2,16 +2,50 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <glib/gstdio.h>
 #include <adwaita.h>
+#include <string.h>
 #include "archive.h"
+#include "imageservice.h"
 
 /* Metadata sidebar utilities
  *
  * Helper functions and construction code for the metadata sidebar that
  * shows file details like size, type and properties.
  *
- * Sections: helpers, sidebar construction, update logic.
+ * Details are gathered on a worker thread so paging with the sidebar open
+ * never waits on the disk or an archive:
+ * - Only a bounded prefix of the file or archive entry is read. Format and
+ *   dimensions come from the loader's size-prepared signal (no pixels are
+ *   decoded), camera details from the EXIF block in the same prefix.
+ * - Dimensions the viewer has already decoded (reported by it, or found in
+ *   the image service's cache) replace the probed ones.
+ * - Each update cancels the previous job; stale results are dropped.
+ *
+ * Sections: helpers, header probing, EXIF, worker, sidebar construction,
+ * update logic.
  */
 
+#define HEADER_PROBE_SIZE (128 * 1024) /* Holds a full APP1 segment */
+#define PROBE_CHUNK 4096
+#define MAX_IFD_ENTRIES 512
+
+typedef struct {
+    char *path;
+    GPtrArray *file_rows;   /* Title, value, title, value, ... */
+    GPtrArray *camera_rows;
+    char *format;
+    int width;
+    int height;
+} MetadataInfo;
+
+typedef struct {
+    GtkWidget *box;
+    GCancellable *cancellable;
+    char *path;
+    MetadataInfo *info;     /* Result for path, NULL while it is gathered */
+    int known_width;        /* Reported by the viewer, 0 if not yet */
+    int known_height;
+} SidebarState;
+
 /* Helper to add a row to a group */
 static void
 add_pref_row(AdwPreferencesGroup *group, const char *title, const char *subtitle)
@@ -32,34 +66,402 @@ format_size(guint64 size)
     return g_format_size(size);
 }
 
-GtkWidget*
-find_box_recursive(GtkWidget *parent)
+static void
+add_row(GPtrArray *rows, const char *title, char *value)
+{
+    g_ptr_array_add(rows, g_strdup(title));
+    g_ptr_array_add(rows, value);
+}
+
+static void
+metadata_info_free(MetadataInfo *info)
+{
+    if (!info) return;
+    g_free(info->path);
+    g_ptr_array_unref(info->file_rows);
+    g_ptr_array_unref(info->camera_rows);
+    g_free(info->format);
+    g_free(info);
+}
+
+static void
+sidebar_state_free(SidebarState *state)
 {
-    if (GTK_IS_BOX(parent) && g_strcmp0(gtk_widget_get_name(parent), "metadata-content-box") == 0) {
-        return parent;
+    if (state->cancellable) {
+        g_cancellable_cancel(state->cancellable);
+        g_object_unref(state->cancellable);
     }
+    g_free(state->path);
+    metadata_info_free(state->info);
+    g_free(state);
+}
+
+/* --- Header probing --- */
+
+typedef struct {
+    int width;
+    int height;
+} ProbeResult;
+
+static void
+on_probe_size_prepared(GdkPixbufLoader *loader, int width, int height, gpointer user_data)
+{
+    ProbeResult *probe = user_data;
+    probe->width = width;
+    probe->height = height;
+}
+
+/* Feed the loader until it knows the size, which every gdk-pixbuf loader
+ * reports from the header before decoding any pixels. */
+static void
+probe_image_header(const guint8 *data, gsize len, MetadataInfo *info)
+{
+    GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+    ProbeResult probe = { 0, 0 };
+    g_signal_connect(loader, "size-prepared", G_CALLBACK(on_probe_size_prepared), &probe);
 
-    /* Fallback: If parent is a viewport, its child might be the box */
-    if (GTK_IS_VIEWPORT(parent)) {
-        GtkWidget *child = gtk_viewport_get_child(GTK_VIEWPORT(parent));
-        if (child) return find_box_recursive(child);
+    for (gsize off = 0; off < len && probe.width == 0; off += PROBE_CHUNK) {
+        if (!gdk_pixbuf_loader_write(loader, data + off, MIN(PROBE_CHUNK, len - off), NULL))
+            break;
     }
-    
-    /* Fallback: If parent is ScrolledWindow, check child */
-    if (GTK_IS_SCROLLED_WINDOW(parent)) {
-        GtkWidget *child = gtk_scrolled_window_get_child(GTK_SCROLLED_WINDOW(parent));
-        if (child) return find_box_recursive(child);
+
+    if (probe.width > 0 && probe.height > 0) {
+        GdkPixbufFormat *format = gdk_pixbuf_loader_get_format(loader);
+        info->width = probe.width;
+        info->height = probe.height;
+        if (format) info->format = gdk_pixbuf_format_get_name(format);
+    }
+
+    /* The data is usually truncated on purpose */
+    gdk_pixbuf_loader_close(loader, NULL);
+    g_object_unref(loader);
+}
+
+/* --- EXIF --- */
+
+typedef struct {
+    const guint8 *data;
+    gsize len;
+    gboolean big_endian;
+} TiffReader;
+
+static gboolean
+tiff_u16(const TiffReader *t, gsize off, guint16 *out)
+{
+    if (off > t->len || t->len - off < 2) return FALSE;
+    const guint8 *p = t->data + off;
+    *out = t->big_endian ? (guint16)((p[0] << 8) | p[1]) : (guint16)(p[0] | (p[1] << 8));
+    return TRUE;
+}
+
+static gboolean
+tiff_u32(const TiffReader *t, gsize off, guint32 *out)
+{
+    if (off > t->len || t->len - off < 4) return FALSE;
+    const guint8 *p = t->data + off;
+    if (t->big_endian)
+        *out = ((guint32)p[0] << 24) | ((guint32)p[1] << 16) | ((guint32)p[2] << 8) | p[3];
+    else
+        *out = p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+    return TRUE;
+}
+
+static gboolean
+tiff_reader_init(TiffReader *t, const guint8 *data, gsize len)
+{
+    if (len < 8) return FALSE;
+    if (memcmp(data, "II*\0", 4) == 0) t->big_endian = FALSE;
+    else if (memcmp(data, "MM\0*", 4) == 0) t->big_endian = TRUE;
+    else return FALSE;
+    t->data = data;
+    t->len = len;
+    return TRUE;
+}
+
+/* ASCII value of an IFD entry (inline when it fits in four bytes) */
+static char *
+tiff_entry_string(const TiffReader *t, gsize entry)
+{
+    guint16 type;
+    guint32 count, off = (guint32)(entry + 8);
+    if (!tiff_u16(t, entry + 2, &type) || type != 2 || !tiff_u32(t, entry + 4, &count) || count == 0)
+        return NULL;
+    if (count > 4 && !tiff_u32(t, entry + 8, &off)) return NULL;
+    if (off > t->len || count > t->len - off) return NULL;
+
+    char *str = g_strndup((const char *)t->data + off, count);
+    g_strstrip(str);
+    if (str[0] == '\0' || !g_utf8_validate(str, -1, NULL)) {
+        g_free(str);
+        return NULL;
+    }
+    return str;
+}
+
+/* First RATIONAL of an IFD entry; FALSE for other types or a zero divisor */
+static gboolean
+tiff_entry_rational(const TiffReader *t, gsize entry, guint32 *num, guint32 *den)
+{
+    guint16 type;
+    guint32 off;
+    if (!tiff_u16(t, entry + 2, &type) || type != 5 || !tiff_u32(t, entry + 8, &off)) return FALSE;
+    return tiff_u32(t, off, num) && tiff_u32(t, (gsize)off + 4, den) && *den != 0;
+}
+
+/* SHORT or LONG value stored inline in an IFD entry */
+static gboolean
+tiff_entry_uint(const TiffReader *t, gsize entry, guint32 *out)
+{
+    guint16 type;
+    if (!tiff_u16(t, entry + 2, &type)) return FALSE;
+    if (type == 3) {
+        guint16 v;
+        if (!tiff_u16(t, entry + 8, &v)) return FALSE;
+        *out = v;
+        return TRUE;
     }
+    if (type == 4)
+        return tiff_u32(t, entry + 8, out);
+    return FALSE;
+}
 
-    GtkWidget *child = gtk_widget_get_first_child(parent);
-    while (child) {
-        GtkWidget *found = find_box_recursive(child);
-        if (found) return found;
-        child = gtk_widget_get_next_sibling(child);
+/* Locate the TIFF structure inside a JPEG's APP1 Exif segment. */
+static gboolean
+jpeg_find_exif(const guint8 *data, gsize len, gsize *tiff_offset, gsize *tiff_length)
+{
+    if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) return FALSE;
+
+    gsize pos = 2;
+    while (pos + 4 <= len) {
+        if (data[pos] != 0xFF) return FALSE;
+        guint8 marker = data[pos + 1];
+        if (marker == 0xFF) { pos++; continue; } /* Fill byte */
+        if (marker == 0xDA || marker == 0xD9) return FALSE; /* Image data: no APP1 left */
+
+        gsize seglen = ((gsize)data[pos + 2] << 8) | data[pos + 3];
+        if (seglen < 2 || pos + 2 + seglen > len) return FALSE;
+        if (marker == 0xE1 && seglen >= 8 && memcmp(data + pos + 4, "Exif\0\0", 6) == 0) {
+            *tiff_offset = pos + 10;
+            *tiff_length = seglen - 8;
+            return TRUE;
+        }
+        pos += 2 + seglen;
     }
-    return NULL;
+    return FALSE;
 }
 
+static void
+parse_exif_ifd(const TiffReader *t, guint32 ifd, GPtrArray *rows)
+{
+    guint16 count;
+    if (!tiff_u16(t, ifd, &count) || count > MAX_IFD_ENTRIES) return;
+    for (guint i = 0; i < count; i++) {
+        gsize entry = ifd + 2 + (gsize)i * 12;
+        guint16 tag;
+        guint32 num, den, value;
+        char *str;
+        if (!tiff_u16(t, entry, &tag)) return;
+        switch (tag) {
+            case 0x9003: /* DateTimeOriginal, "YYYY:MM:DD HH:MM:SS" */
+                if ((str = tiff_entry_string(t, entry))) {
+                    if (strlen(str) >= 10) { str[4] = '-'; str[7] = '-'; }
+                    add_row(rows, "Taken", str);
+                }
+                break;
+            case 0x829A: /* ExposureTime */
+                if (tiff_entry_rational(t, entry, &num, &den) && num > 0)
+                    add_row(rows, "Exposure", num < den ? g_strdup_printf("1/%.0f s", (double)den / num)
+                                                        : g_strdup_printf("%.1f s", (double)num / den));
+                break;
+            case 0x829D: /* FNumber */
+                if (tiff_entry_rational(t, entry, &num, &den))
+                    add_row(rows, "Aperture", g_strdup_printf("f/%.1f", (double)num / den));
+                break;
+            case 0x8827: /* ISOSpeedRatings */
+                if (tiff_entry_uint(t, entry, &value))
+                    add_row(rows, "ISO", g_strdup_printf("%u", value));
+                break;
+            case 0x920A: /* FocalLength */
+                if (tiff_entry_rational(t, entry, &num, &den))
+                    add_row(rows, "Focal Length", g_strdup_printf("%.0f mm", (double)num / den));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/* Camera details from a JPEG's APP1 segment or a TIFF's first IFD. Offsets
+ * outside the prefix are skipped, not followed. */
+static void
+parse_exif(const guint8 *data, gsize len, GPtrArray *rows)
+{
+    gsize tiff_off = 0, tiff_len = len;
+    if (len >= 2 && data[0] == 0xFF && data[1] == 0xD8 &&
+        !jpeg_find_exif(data, len, &tiff_off, &tiff_len))
+        return;
+
+    TiffReader t;
+    guint32 ifd;
+    guint16 count;
+    if (!tiff_reader_init(&t, data + tiff_off, tiff_len) || !tiff_u32(&t, 4, &ifd) ||
+        !tiff_u16(&t, ifd, &count) || count > MAX_IFD_ENTRIES)
+        return;
+
+    char *make = NULL, *model = NULL;
+    guint32 exif_ifd = 0;
+    for (guint i = 0; i < count; i++) {
+        gsize entry = ifd + 2 + (gsize)i * 12;
+        guint16 tag;
+        if (!tiff_u16(&t, entry, &tag)) break;
+        if (tag == 0x010F && !make) make = tiff_entry_string(&t, entry);
+        else if (tag == 0x0110 && !model) model = tiff_entry_string(&t, entry);
+        else if (tag == 0x8769) tiff_entry_uint(&t, entry, &exif_ifd);
+    }
+
+    /* Most models already start with the make ("Canon EOS R6") */
+    if (model)
+        add_row(rows, "Camera", make && !g_str_has_prefix(model, make) ? g_strdup_printf("%s %s", make, model)
+                                                                      : g_strdup(model));
+    else if (make)
+        add_row(rows, "Camera", g_strdup(make));
+    g_free(make);
+    g_free(model);
+
+    if (exif_ifd) parse_exif_ifd(&t, exif_ifd, rows);
+}
+
+/* --- Worker --- */
+
+static void
+add_date_row(GPtrArray *rows, const char *title, GDateTime *dt)
+{
+    if (!dt) return;
+    add_row(rows, title, g_date_time_format(dt, "%Y-%m-%d %H:%M"));
+    g_date_time_unref(dt);
+}
+
+static GBytes *
+gather_file_details(const char *path, MetadataInfo *info, GCancellable *cancellable)
+{
+    GFile *file = g_file_new_for_path(path);
+    GError *error = NULL;
+    GFileInfo *finfo = g_file_query_info(file, "standard::*,time::*", G_FILE_QUERY_INFO_NONE, cancellable, &error);
+
+    if (!finfo) {
+        add_row(info->file_rows, "Error", g_strdup("Could not query file info"));
+        if (error) {
+            add_row(info->file_rows, "Message", g_strdup(error->message));
+            g_clear_error(&error);
+        }
+        g_object_unref(file);
+        return NULL;
+    }
+
+    add_row(info->file_rows, "Location", g_path_get_dirname(path));
+    add_row(info->file_rows, "Name", g_strdup(g_file_info_get_display_name(finfo)));
+    add_row(info->file_rows, "Size", format_size(g_file_info_get_size(finfo)));
+
+    const char *content_type = g_file_info_get_content_type(finfo);
+    if (content_type) {
+        char *desc = g_content_type_get_description(content_type);
+        add_row(info->file_rows, "Type", desc ? desc : g_strdup(content_type));
+    }
+    add_date_row(info->file_rows, "Created", g_file_info_get_creation_date_time(finfo));
+    add_date_row(info->file_rows, "Modified", g_file_info_get_modification_date_time(finfo));
+    g_object_unref(finfo);
+
+    /* Only the header prefix is read, however large the file */
+    GBytes *prefix = NULL;
+    GFileInputStream *stream = g_file_read(file, cancellable, NULL);
+    if (stream) {
+        guint8 *buf = g_malloc(HEADER_PROBE_SIZE);
+        gsize n = 0;
+        if (g_input_stream_read_all(G_INPUT_STREAM(stream), buf, HEADER_PROBE_SIZE, &n, cancellable, NULL) || n > 0)
+            prefix = g_bytes_new_take(g_realloc(buf, MAX(n, 1)), n);
+        else
+            g_free(buf);
+        g_object_unref(stream);
+    }
+    g_object_unref(file);
+    return prefix;
+}
+
+static GBytes *
+gather_archive_details(const char *path, MetadataInfo *info)
+{
+    char *archive_path = NULL, *entry_name = NULL;
+    archive_split_path(path, &archive_path, &entry_name);
+    if (!archive_path) {
+        add_row(info->file_rows, "Archive", g_strdup("Invalid archive path"));
+        return NULL;
+    }
+
+    add_row(info->file_rows, "Archive", g_path_get_dirname(archive_path));
+    add_row(info->file_rows, "Entry", g_strdup(entry_name));
+
+    GError *err = NULL;
+    guint64 esize = 0;
+    if (archive_get_entry_size(archive_path, entry_name, &esize, &err)) {
+        add_row(info->file_rows, "Size", format_size(esize));
+    } else if (err) {
+        add_row(info->file_rows, "Archive Error", g_strdup(err->message));
+        g_clear_error(&err);
+    }
+
+    GBytes *prefix = archive_read_entry_prefix(archive_path, entry_name, HEADER_PROBE_SIZE, &err);
+    if (!prefix && err) {
+        add_row(info->file_rows, "Image Error", g_strdup(err->message));
+        g_clear_error(&err);
+    }
+
+    g_free(archive_path);
+    g_free(entry_name);
+    return prefix;
+}
+
+static void
+metadata_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    const char *path = task_data;
+    MetadataInfo *info = g_new0(MetadataInfo, 1);
+    info->path = g_strdup(path);
+    info->file_rows = g_ptr_array_new_with_free_func(g_free);
+    info->camera_rows = g_ptr_array_new_with_free_func(g_free);
+
+    gboolean in_archive = g_str_has_prefix(path, "archive://");
+    GBytes *prefix = in_archive ? gather_archive_details(path, info)
+                                : gather_file_details(path, info, cancellable);
+
+    if (prefix && !g_cancellable_is_cancelled(cancellable)) {
+        gsize len;
+        const guint8 *data = g_bytes_get_data(prefix, &len);
+        probe_image_header(data, len, info);
+        parse_exif(data, len, info->camera_rows);
+        if (in_archive && info->format) {
+            char *fmt = g_strdup_printf("%s (in archive)", info->format);
+            g_free(info->format);
+            info->format = fmt;
+        }
+    }
+    if (prefix) g_bytes_unref(prefix);
+
+    GdkPixbuf *decoded = image_service_peek(path, 0);
+    if (decoded) {
+        info->width = gdk_pixbuf_get_width(decoded);
+        info->height = gdk_pixbuf_get_height(decoded);
+        g_object_unref(decoded);
+    }
+
+    if (g_task_return_error_if_cancelled(task)) {
+        metadata_info_free(info);
+        return;
+    }
+    g_task_return_pointer(task, info, (GDestroyNotify)metadata_info_free);
+}
+
+/* --- Sidebar construction --- */
+
 GtkWidget *
 metadata_sidebar_new(void)
 {
@@ -109,188 +511,122 @@ metadata_sidebar_new(void)
     gtk_box_append(GTK_BOX(bottom_bar), open_btn);
     gtk_box_append(GTK_BOX(container), bottom_bar);
 
+    SidebarState *state = g_new0(SidebarState, 1);
+    state->box = box;
+    g_object_set_data_full(G_OBJECT(container), "metadata-state", state, (GDestroyNotify)sidebar_state_free);
+
     return container;
 }
 
-void
-metadata_sidebar_update(GtkWidget *sidebar, const char *path)
+/* --- Update logic --- */
+
+static void
+clear_box(GtkWidget *box)
+{
+    GtkWidget *item = gtk_widget_get_first_child(box);
+    while (item) {
+        GtkWidget *next = gtk_widget_get_next_sibling(item);
+        gtk_box_remove(GTK_BOX(box), item);
+        item = next;
+    }
+}
+
+static void
+add_group(GtkWidget *box, const char *title, GPtrArray *rows)
 {
-    // Debug print
-    // g_print("DEBUG: metadata_sidebar_update called for path: %s\n", path ? path : "(null)");
+    if (rows->len == 0) return;
 
-    GtkWidget *box = find_box_recursive(sidebar);
+    GtkWidget *group = adw_preferences_group_new();
+    adw_preferences_group_set_title(ADW_PREFERENCES_GROUP(group), title);
+    gtk_box_append(GTK_BOX(box), group);
+    for (guint i = 0; i + 1 < rows->len; i += 2)
+        add_pref_row(ADW_PREFERENCES_GROUP(group), rows->pdata[i], rows->pdata[i + 1]);
+}
 
-    if (!box) {
-         g_warning("DEBUG: metadata-content-box NOT FOUND in sidebar widget hierarchy.");
-         return;
+static void
+sidebar_render(SidebarState *state)
+{
+    MetadataInfo *info = state->info;
+    clear_box(state->box);
+
+    add_group(state->box, "File Details", info->file_rows);
+
+    /* The viewer's decoded size wins over the header (e.g. for formats
+       whose loader reports the size late) */
+    int width = state->known_width > 0 ? state->known_width : info->width;
+    int height = state->known_height > 0 ? state->known_height : info->height;
+    if (width > 0 && height > 0) {
+        GPtrArray *rows = g_ptr_array_new_with_free_func(g_free);
+        add_row(rows, "Dimensions", g_strdup_printf("%d × %d", width, height));
+        if (info->format) add_row(rows, "Format", g_strdup(info->format));
+        add_group(state->box, "Image Properties", rows);
+        g_ptr_array_unref(rows);
     }
-    
-    if (!GTK_IS_BOX(box)) {
-        g_warning("DEBUG: Found widget is NOT a box! Type: %s", G_OBJECT_TYPE_NAME(box));
+
+    add_group(state->box, "Camera", info->camera_rows);
+}
+
+static void
+on_metadata_ready(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    MetadataInfo *info = g_task_propagate_pointer(G_TASK(res), NULL);
+    if (!info) return; /* Cancelled by a newer update */
+
+    SidebarState *state = g_object_get_data(source, "metadata-state");
+    if (!state || g_strcmp0(state->path, info->path) != 0) {
+        metadata_info_free(info);
         return;
     }
 
-    /* Clear */
-    GtkWidget *item = gtk_widget_get_first_child(box);
-    while (item) {
-        GtkWidget *next = gtk_widget_get_next_sibling(item);
-        gtk_box_remove(GTK_BOX(box), item);
-        item = next;
+    metadata_info_free(state->info);
+    state->info = info;
+    sidebar_render(state);
+}
+
+void
+metadata_sidebar_update(GtkWidget *sidebar, const char *path)
+{
+    SidebarState *state = g_object_get_data(G_OBJECT(sidebar), "metadata-state");
+    if (!state) {
+        g_warning("metadata_sidebar_update: widget is not a metadata sidebar");
+        return;
+    }
+
+    if (state->cancellable) {
+        g_cancellable_cancel(state->cancellable);
+        g_clear_object(&state->cancellable);
     }
+    g_free(state->path);
+    state->path = g_strdup(path);
+    g_clear_pointer(&state->info, metadata_info_free);
+    state->known_width = state->known_height = 0;
 
     if (!path) {
+        clear_box(state->box);
         GtkWidget *status = adw_status_page_new();
         adw_status_page_set_icon_name(ADW_STATUS_PAGE(status), "image-missing-symbolic");
         adw_status_page_set_title(ADW_STATUS_PAGE(status), "No Selection");
-        gtk_box_append(GTK_BOX(box), status);
+        gtk_box_append(GTK_BOX(state->box), status);
         return;
     }
 
-    /* File Details Group */
-    GtkWidget *file_group = adw_preferences_group_new();
-    adw_preferences_group_set_title(ADW_PREFERENCES_GROUP(file_group), "File Details");
-    gtk_box_append(GTK_BOX(box), file_group);
-
-    if (g_str_has_prefix(path, "archive://")) {
-        /* Parse archive://<archive_path>::<entry> */
-        const char *sep = strstr(path, "::");
-        if (sep) {
-            size_t archive_len = sep - (path + strlen("archive://"));
-            char *archive_path = g_strndup(path + strlen("archive://"), archive_len);
-            char *entry_name = g_strdup(sep + 2);
-
-            char *dirname = g_path_get_dirname(archive_path);
-            add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Archive", dirname);
-            g_free(dirname);
-
-            add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Entry", entry_name);
-
-            GError *err = NULL;
-            guint64 esize = 0;
-            if (archive_get_entry_size(archive_path, entry_name, &esize, &err)) {
-                char *size_str = format_size(esize);
-                add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Size", size_str);
-                g_free(size_str);
-            } else {
-                if (err) {
-                    add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Archive Error", err->message);
-                    g_clear_error(&err);
-                }
-            }
-
-            g_free(archive_path);
-            g_free(entry_name);
-        } else {
-            add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Archive", "Invalid archive path");
-        }
-    } else {
-        GFile *file = g_file_new_for_path(path);
-        GError *error = NULL;
-        GFileInfo *info = g_file_query_info(file, "standard::*,time::*", G_FILE_QUERY_INFO_NONE, NULL, &error);
-
-        if (info) {
-            char *dirname = g_path_get_dirname(path);
-            add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Location", dirname);
-            g_free(dirname);
-            
-            add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Name", g_file_info_get_display_name(info));
-            
-            char *size_str = format_size(g_file_info_get_size(info));
-            add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Size", size_str);
-            g_free(size_str);
-
-            const char *content_type = g_file_info_get_content_type(info);
-            if (content_type) {
-                 char *desc = g_content_type_get_description(content_type);
-                 add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Type", desc ? desc : content_type);
-                 g_free(desc);
-            }
-            
-            GDateTime *cdt = g_file_info_get_creation_date_time(info);
-            if (cdt) {
-                char *cdate_str = g_date_time_format(cdt, "%Y-%m-%d %H:%M");
-                add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Created", cdate_str);
-                g_free(cdate_str);
-                g_date_time_unref(cdt);
-            }
-
-            GDateTime *dt = g_file_info_get_modification_date_time(info);
-            if (dt) {
-                char *date_str = g_date_time_format(dt, "%Y-%m-%d %H:%M");
-                add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Modified", date_str);
-                g_free(date_str);
-                g_date_time_unref(dt);
-            }
-            g_object_unref(info);
-        } else {
-             add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Error", "Could not query file info");
-             if (error) {
-                 add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Message", error->message);
-                 g_clear_error(&error);
-             }
-        }
-        g_object_unref(file);
-    }
-    /* Image Properties Group */
-    /* Image properties: handle archive virtual paths specially */
-    int width = 0, height = 0;
-    gchar *fmt_name = NULL;
-
-    if (g_str_has_prefix(path, "archive://")) {
-        const char *sep = strstr(path, "::");
-        if (sep) {
-            size_t archive_len = sep - (path + strlen("archive://"));
-            char *archive_path = g_strndup(path + strlen("archive://"), archive_len);
-            char *entry_name = g_strdup(sep + 2);
-
-            GError *err = NULL;
-            GBytes *bytes = archive_read_entry_bytes(archive_path, entry_name, &err);
-            if (bytes) {
-                gsize bsize = g_bytes_get_size(bytes);
-                const guint8 *data = g_bytes_get_data(bytes, NULL);
-                guint8 *copy = g_malloc(bsize);
-                memcpy(copy, data, bsize);
-                GInputStream *mem = g_memory_input_stream_new_from_data(copy, (gssize)bsize, g_free);
-
-                GError *perr = NULL;
-                GdkPixbuf *pix = gdk_pixbuf_new_from_stream(G_INPUT_STREAM(mem), NULL, &perr);
-                if (pix) {
-                    width = gdk_pixbuf_get_width(pix);
-                    height = gdk_pixbuf_get_height(pix);
-                    fmt_name = g_strdup("image (in archive)");
-                    g_object_unref(pix);
-                } else {
-                    if (perr) g_clear_error(&perr);
-                }
-                g_object_unref(mem);
-                g_bytes_unref(bytes);
-            } else if (err) {
-                add_pref_row(ADW_PREFERENCES_GROUP(file_group), "Image Error", err->message);
-                g_clear_error(&err);
-            }
-
-            g_free(archive_path);
-            g_free(entry_name);
-        }
-    } else {
-        GdkPixbufFormat *format_info = gdk_pixbuf_get_file_info(path, &width, &height);
-        if (format_info) {
-            fmt_name = gdk_pixbuf_format_get_name(format_info);
-        }
-    }
-
-    if (width > 0 && height > 0) {
-        GtkWidget *img_group = adw_preferences_group_new();
-        adw_preferences_group_set_title(ADW_PREFERENCES_GROUP(img_group), "Image Properties");
-        gtk_box_append(GTK_BOX(box), img_group);
+    /* The previous page stays up until the new details arrive, which
+       avoids flashing an empty sidebar while paging */
+    state->cancellable = g_cancellable_new();
+    GTask *task = g_task_new(sidebar, state->cancellable, on_metadata_ready, NULL);
+    g_task_set_task_data(task, g_strdup(path), g_free);
+    g_task_run_in_thread(task, metadata_thread);
+    g_object_unref(task);
+}
 
-        char *dim = g_strdup_printf("%d × %d", width, height);
-        add_pref_row(ADW_PREFERENCES_GROUP(img_group), "Dimensions", dim);
-        g_free(dim);
+void
+metadata_sidebar_set_dimensions(GtkWidget *sidebar, const char *path, int width, int height)
+{
+    SidebarState *state = g_object_get_data(G_OBJECT(sidebar), "metadata-state");
+    if (!state || !path || g_strcmp0(state->path, path) != 0) return;
+    if (state->known_width == width && state->known_height == height) return;
 
-        if (fmt_name) {
-             add_pref_row(ADW_PREFERENCES_GROUP(img_group), "Format", fmt_name);
-             g_free(fmt_name);
-        }
-    }
+    state->known_width = width;
+    state->known_height = height;
+    if (state->info) sidebar_render(state);
 }
@@ -4,6 +4,14 @@
 G_BEGIN_DECLS
 
 GtkWidget *metadata_sidebar_new(void);
+
+/* Show details for path (NULL for no selection). The details are gathered in
+ * the background; a newer update cancels the pending one. */
 void metadata_sidebar_update(GtkWidget *sidebar, const char *path);
 
+/* Dimensions of path as decoded by the viewer, shown instead of the ones read
+ * from the file header. Ignored unless path is the one last passed to
+ * metadata_sidebar_update. */
+void metadata_sidebar_set_dimensions(GtkWidget *sidebar, const char *path, int width, int height);
+
 G_END_DECLS
@@ -0,0 +1,249 @@
+#include "metrics.h"
+#include "archive_cache.h"
+#include "membudget.h"
+
+/* Metrics (diagnostics)
+ *
+ * Storage behind metrics.h:
+ * - Counters and gauges: plain ints updated with g_atomic_int_*.
+ * - Histograms: power-of-two buckets of microseconds (bucket b holds
+ *   durations below 2^b us), plus an atomic count, sum and maximum. The
+ *   percentiles are read off the buckets, so they are upper bounds within
+ *   a factor of two; the mean and maximum are exact.
+ * - Reset and snapshot are not atomic as a whole: an update racing them
+ *   lands on either side.
+ *
+ * Sections: storage, updates, public API.
+ */
+
+#define N_BUCKETS 32
+
+typedef struct {
+    gint buckets[N_BUCKETS];
+    gint count;
+    gint max_us;
+    gsize sum_us;   /* g_atomic_pointer_add; wraps only after ~4000 s on 32-bit */
+} Histogram;
+
+gint metrics_active = 0;
+
+static gint counters[METRICS_N_COUNTERS];
+static gint gauges[METRICS_N_GAUGES];
+static Histogram histograms[METRICS_N_HISTOGRAMS];
+
+static const char *counter_names[METRICS_N_COUNTERS] = {
+    "thumb-cache-hits",
+    "thumb-cache-misses",
+    "thumb-ignored-notifies",
+    "video-thumbs-started",
+    "video-thumbs-completed",
+    "image-cache-hits",
+    "image-cache-misses",
+};
+
+static const char *gauge_names[METRICS_N_GAUGES] = {
+    "thumb-queue-depth",
+};
+
+static const char *histogram_names[METRICS_N_HISTOGRAMS] = {
+    "load-to-display",
+    "decode",
+    "archive-read",
+};
+
+/* --- Storage --- */
+
+/* Upper bound in ms of the bucket holding the p-th percentile */
+static double
+histogram_percentile(const gint *buckets, gint count, double p)
+{
+    if (count <= 0) return 0;
+    gint64 rank = (gint64)(p / 100.0 * count + 0.999999);
+    gint64 seen = 0;
+    for (guint b = 0; b < N_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return (double)((guint64)1 << b) / 1000.0;
+    }
+    return (double)((guint64)1 << (N_BUCKETS - 1)) / 1000.0;
+}
+
+typedef struct {
+    gint count;
+    double mean, p50, p90, p99, max;
+} HistogramSummary;
+
+static void
+histogram_summarize(Histogram *h, HistogramSummary *out)
+{
+    gint buckets[N_BUCKETS];
+    for (guint b = 0; b < N_BUCKETS; b++) buckets[b] = g_atomic_int_get(&h->buckets[b]);
+
+    out->count = g_atomic_int_get(&h->count);
+    gsize sum = (gsize)g_atomic_pointer_get(&h->sum_us);
+    out->mean = out->count ? (double)sum / out->count / 1000.0 : 0;
+    out->p50 = histogram_percentile(buckets, out->count, 50);
+    out->p90 = histogram_percentile(buckets, out->count, 90);
+    out->p99 = histogram_percentile(buckets, out->count, 99);
+    out->max = g_atomic_int_get(&h->max_us) / 1000.0;
+}
+
+/* --- Updates --- */
+
+void
+metrics_count_slow(MetricsCounter counter)
+{
+    g_atomic_int_inc(&counters[counter]);
+}
+
+void
+metrics_gauge_set_slow(MetricsGauge gauge, int value)
+{
+    g_atomic_int_set(&gauges[gauge], value);
+}
+
+void
+metrics_record_slow(MetricsHistogram histogram, gint64 start)
+{
+    gint64 us = MAX(g_get_monotonic_time() - start, 0);
+    Histogram *h = &histograms[histogram];
+
+    guint b = MIN(g_bit_storage((gulong)us), N_BUCKETS - 1);
+    g_atomic_int_inc(&h->buckets[b]);
+    g_atomic_int_inc(&h->count);
+    g_atomic_pointer_add(&h->sum_us, (gssize)us);
+
+    gint clipped = (gint)MIN(us, G_MAXINT);
+    gint max = g_atomic_int_get(&h->max_us);
+    while (clipped > max && !g_atomic_int_compare_and_exchange(&h->max_us, max, clipped))
+        max = g_atomic_int_get(&h->max_us);
+}
+
+/* --- Public API --- */
+
+void
+metrics_init(void)
+{
+    static gboolean done = FALSE;
+    if (done) return;
+    done = TRUE;
+
+    if (g_getenv("BRIGHTEYES_METRICS") || g_getenv("BRIGHTEYES_THUMBNAILS_DEBUG"))
+        metrics_set_enabled(TRUE);
+}
+
+gboolean
+metrics_get_enabled(void)
+{
+    return g_atomic_int_get(&metrics_active);
+}
+
+void
+metrics_set_enabled(gboolean enabled)
+{
+    g_atomic_int_set(&metrics_active, enabled ? 1 : 0);
+}
+
+void
+metrics_reset(void)
+{
+    for (guint i = 0; i < METRICS_N_COUNTERS; i++) g_atomic_int_set(&counters[i], 0);
+    for (guint i = 0; i < METRICS_N_HISTOGRAMS; i++) {
+        Histogram *h = &histograms[i];
+        for (guint b = 0; b < N_BUCKETS; b++) g_atomic_int_set(&h->buckets[b], 0);
+        g_atomic_int_set(&h->count, 0);
+        g_atomic_int_set(&h->max_us, 0);
+        g_atomic_pointer_set(&h->sum_us, 0);
+    }
+    /* Gauges describe the present, not a period */
+}
+
+GVariant *
+metrics_snapshot(void)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+
+    g_variant_builder_add(&builder, "{sv}", "enabled", g_variant_new_boolean(metrics_get_enabled()));
+    for (guint i = 0; i < METRICS_N_COUNTERS; i++)
+        g_variant_builder_add(&builder, "{sv}", counter_names[i],
+                              g_variant_new_int64(g_atomic_int_get(&counters[i])));
+    for (guint i = 0; i < METRICS_N_GAUGES; i++)
+        g_variant_builder_add(&builder, "{sv}", gauge_names[i],
+                              g_variant_new_int64(g_atomic_int_get(&gauges[i])));
+    for (guint i = 0; i < METRICS_N_HISTOGRAMS; i++) {
+        HistogramSummary s;
+        histogram_summarize(&histograms[i], &s);
+        g_variant_builder_add(&builder, "{sv}", histogram_names[i],
+                              g_variant_new("(xddddd)", (gint64)s.count, s.mean, s.p50, s.p90, s.p99, s.max));
+    }
+
+    ArchiveCacheStats stats;
+    archive_cache_get_stats(&stats);
+    g_variant_builder_add(&builder, "{sv}", "archive-cache-hits", g_variant_new_int64((gint64)stats.hits));
+    g_variant_builder_add(&builder, "{sv}", "archive-cache-misses", g_variant_new_int64((gint64)stats.misses));
+    g_variant_builder_add(&builder, "{sv}", "archive-cache-bytes", g_variant_new_int64((gint64)stats.bytes));
+
+    static const char *pool_names[MEM_N_POOLS] = {
+        "memory-thumbnails", "memory-archive", "memory-image-cache", "memory-viewer",
+    };
+    for (guint i = 0; i < MEM_N_POOLS; i++)
+        g_variant_builder_add(&builder, "{sv}", pool_names[i], g_variant_new_int64((gint64)mem_budget_get_used(i)));
+    g_variant_builder_add(&builder, "{sv}", "memory-budget", g_variant_new_int64((gint64)mem_budget_get_limit()));
+
+    return g_variant_builder_end(&builder);
+}
+
+static double
+hit_rate(gint hits, gint misses)
+{
+    return hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0;
+}
+
+char *
+metrics_format(void)
+{
+    GString *out = g_string_new(NULL);
+
+    for (guint i = 0; i < METRICS_N_HISTOGRAMS; i++) {
+        HistogramSummary s;
+        histogram_summarize(&histograms[i], &s);
+        g_string_append_printf(out, "%s: n=%d p50<%.1f p90<%.1f p99<%.1f max=%.1f ms\n",
+                               histogram_names[i], s.count, s.p50, s.p90, s.p99, s.max);
+    }
+
+    gint th = g_atomic_int_get(&counters[METRICS_THUMB_CACHE_HIT]);
+    gint tm = g_atomic_int_get(&counters[METRICS_THUMB_CACHE_MISS]);
+    gint ih = g_atomic_int_get(&counters[METRICS_IMAGE_CACHE_HIT]);
+    gint im = g_atomic_int_get(&counters[METRICS_IMAGE_CACHE_MISS]);
+    ArchiveCacheStats stats;
+    archive_cache_get_stats(&stats);
+
+    g_string_append_printf(out, "thumb cache: %.0f%% of %d\n", hit_rate(th, tm), th + tm);
+    g_string_append_printf(out, "image cache: %.0f%% of %d\n", hit_rate(ih, im), ih + im);
+    g_string_append_printf(out, "archive cache: %.0f%% of %" G_GUINT64_FORMAT "\n",
+                           stats.hits + stats.misses ? 100.0 * stats.hits / (stats.hits + stats.misses) : 0,
+                           stats.hits + stats.misses);
+    g_string_append_printf(out, "thumb queue: %d\n", g_atomic_int_get(&gauges[METRICS_THUMB_QUEUE_DEPTH]));
+    g_string_append_printf(out, "memory: %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " MB",
+                           mem_budget_get_total() / (1024 * 1024), mem_budget_get_limit() / (1024 * 1024));
+
+    return g_string_free(out, FALSE);
+}
+
+void
+metrics_dump(void)
+{
+    GVariant *snapshot = g_variant_ref_sink(metrics_snapshot());
+    GVariantIter iter;
+    const char *name;
+    GVariant *value;
+
+    g_variant_iter_init(&iter, snapshot);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value)) {
+        char *text = g_variant_print(value, FALSE);
+        g_print("METRICS: %s=%s\n", name, text);
+        g_free(text);
+        g_variant_unref(value);
+    }
+    g_variant_unref(snapshot);
+}
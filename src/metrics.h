@@ -0,0 +1,97 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Performance metrics
+ *
+ * App-wide counters, gauges and latency histograms, safe to update from
+ * any thread. Collection is off unless BRIGHTEYES_METRICS (or the older
+ * BRIGHTEYES_THUMBNAILS_DEBUG) is set or metrics_set_enabled turns it on;
+ * while off every call below is a single relaxed load and a branch, and no
+ * clock is read. Nothing is printed on update; metrics_format and
+ * metrics_dump report on demand.
+ */
+
+typedef enum {
+    METRICS_THUMB_CACHE_HIT,
+    METRICS_THUMB_CACHE_MISS,
+    METRICS_THUMB_IGNORED_NOTIFY,   /* Paintable arrived for a recycled row */
+    METRICS_VIDEO_THUMB_STARTED,
+    METRICS_VIDEO_THUMB_COMPLETED,
+    METRICS_IMAGE_CACHE_HIT,        /* Full-size lookups in the image service */
+    METRICS_IMAGE_CACHE_MISS,
+    METRICS_N_COUNTERS
+} MetricsCounter;
+
+typedef enum {
+    METRICS_THUMB_QUEUE_DEPTH,      /* Thumbnail jobs waiting for a worker */
+    METRICS_N_GAUGES
+} MetricsGauge;
+
+typedef enum {
+    METRICS_LOAD_TO_DISPLAY,        /* viewer_load_file until the full image is shown */
+    METRICS_DECODE,                 /* One image service decode, full or scaled */
+    METRICS_ARCHIVE_READ,           /* One archive entry read, cache hits included */
+    METRICS_N_HISTOGRAMS
+} MetricsHistogram;
+
+/* Internal: read through the helpers below */
+extern gint metrics_active;
+
+void metrics_count_slow(MetricsCounter counter);
+void metrics_gauge_set_slow(MetricsGauge gauge, int value);
+void metrics_record_slow(MetricsHistogram histogram, gint64 start);
+
+/* Read the environment. Called from main; later calls do nothing. */
+void metrics_init(void);
+
+gboolean metrics_get_enabled(void);
+void metrics_set_enabled(gboolean enabled);
+
+/* Zero every counter and histogram. */
+void metrics_reset(void);
+
+static inline void
+metrics_count(MetricsCounter counter)
+{
+    if (G_UNLIKELY(g_atomic_int_get(&metrics_active))) metrics_count_slow(counter);
+}
+
+static inline void
+metrics_gauge_set(MetricsGauge gauge, int value)
+{
+    if (G_UNLIKELY(g_atomic_int_get(&metrics_active))) metrics_gauge_set_slow(gauge, value);
+}
+
+/* Start time for metrics_record, or 0 when collection is off */
+static inline gint64
+metrics_start(void)
+{
+    return G_UNLIKELY(g_atomic_int_get(&metrics_active)) ? g_get_monotonic_time() : 0;
+}
+
+/* Add the time since start (from metrics_start) to histogram. */
+static inline void
+metrics_record(MetricsHistogram histogram, gint64 start)
+{
+    if (G_UNLIKELY(start != 0)) metrics_record_slow(histogram, start);
+}
+
+/* Current values as an a{sv} dictionary: counters and gauges as int64,
+ * histograms as (count, mean, p50, p90, p99, max) in milliseconds; the
+ * archive entry cache's own statistics and the memory budget's pools are
+ * included. */
+GVariant *metrics_snapshot(void);
+
+/* Short multi-line summary, e.g. for the viewer's debug overlay. */
+char *metrics_format(void);
+
+/* Print the snapshot to stdout as "METRICS: name=value" lines. */
+void metrics_dump(void);
+
+G_END_DECLS
+
+#endif /* METRICS_H */
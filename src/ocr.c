@@ -11,18 +11,185 @@
 #  include <tesseract/capi.h>
 #endif
 #include <leptonica/allheaders.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include "pixelops.h"
 
 /* OCR (Tesseract) helpers
  *
  * Provides an asynchronous OCR API that runs Tesseract in a background
  * thread and returns the recognized text via GTask callbacks.
+ * - Engine pool: loading traineddata costs about as much as recognising a
+ *   page, so initialised TessBaseAPI instances are kept per (language,
+ *   datapath) and reused. At most one engine per core exists; callers wait
+ *   for a free one, and an idle engine for another language is recycled
+ *   first. Engines idle for ENGINE_IDLE_SECONDS are deleted.
  *
- * Sections: task data, worker thread, public async API.
+ * Sections: engine pool, task data, worker thread, public async API.
  */
 
+#define ENGINE_IDLE_SECONDS 60
+
+typedef struct {
+    TessBaseAPI *api;
+    char *key;
+    gint64 last_used;
+} OcrEngine;
+
+static GMutex pool_lock;
+static GCond pool_cond;
+static GHashTable *idle_engines = NULL; /* key -> GQueue* of OcrEngine*, most recent last */
+static guint n_engines = 0;             /* Idle and in use */
+static guint sweep_id = 0;
+
+/* --- Engine pool --- */
+
+static char *
+engine_key(const char *lang, const char *datapath)
+{
+    return g_strdup_printf("%s\n%s", lang, datapath ? datapath : "");
+}
+
+static void
+ocr_engine_free(OcrEngine *engine)
+{
+    if (engine->api) {
+        TessBaseAPIEnd(engine->api);
+        TessBaseAPIDelete(engine->api);
+    }
+    g_free(engine->key);
+    g_free(engine);
+}
+
+static void
+idle_queue_free(GQueue *queue)
+{
+    g_queue_free_full(queue, (GDestroyNotify)ocr_engine_free);
+}
+
+/* Called with pool_lock held. Removes one idle engine for another key. */
+static OcrEngine *
+pool_steal_idle(const char *except_key)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, idle_engines);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        if (g_strcmp0(key, except_key) == 0) continue;
+        GQueue *queue = value;
+        OcrEngine *engine = g_queue_pop_head(queue);
+        if (engine) return engine;
+    }
+    return NULL;
+}
+
+static gboolean
+pool_sweep_cb(gpointer user_data)
+{
+    gint64 cutoff = g_get_monotonic_time() - ENGINE_IDLE_SECONDS * G_TIME_SPAN_SECOND;
+    GPtrArray *expired = g_ptr_array_new_with_free_func((GDestroyNotify)ocr_engine_free);
+    gboolean remaining = FALSE;
+
+    g_mutex_lock(&pool_lock);
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, idle_engines);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        GQueue *queue = value;
+        /* Oldest first */
+        while (queue->head && ((OcrEngine *)queue->head->data)->last_used < cutoff) {
+            g_ptr_array_add(expired, g_queue_pop_head(queue));
+            n_engines--;
+        }
+        remaining = remaining || queue->length > 0;
+    }
+    if (!remaining) sweep_id = 0;
+    g_cond_broadcast(&pool_cond);
+    g_mutex_unlock(&pool_lock);
+
+    /* Tesseract teardown happens outside the lock */
+    g_ptr_array_unref(expired);
+    return remaining ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static OcrEngine *
+ocr_engine_acquire(const char *lang, const char *datapath, GCancellable *cancellable, GError **error)
+{
+    char *key = engine_key(lang, datapath);
+    OcrEngine *recycled = NULL;
+
+    g_mutex_lock(&pool_lock);
+    if (!idle_engines)
+        idle_engines = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)idle_queue_free);
+
+    for (;;) {
+        GQueue *queue = g_hash_table_lookup(idle_engines, key);
+        OcrEngine *engine = queue ? g_queue_pop_tail(queue) : NULL;
+        if (engine) {
+            g_mutex_unlock(&pool_lock);
+            g_free(key);
+            return engine;
+        }
+        if (n_engines < g_get_num_processors()) {
+            n_engines++;
+            break;
+        }
+        /* At the limit: replace an idle engine for another language */
+        recycled = pool_steal_idle(key);
+        if (recycled) break;
+
+        if (g_cancellable_is_cancelled(cancellable)) {
+            g_mutex_unlock(&pool_lock);
+            g_free(key);
+            g_cancellable_set_error_if_cancelled(cancellable, error);
+            return NULL;
+        }
+        /* Woken when an engine is released; re-check cancellation now and then */
+        g_cond_wait_until(&pool_cond, &pool_lock, g_get_monotonic_time() + G_TIME_SPAN_SECOND);
+    }
+    g_mutex_unlock(&pool_lock);
+
+    if (recycled) ocr_engine_free(recycled);
+
+    OcrEngine *engine = g_new0(OcrEngine, 1);
+    engine->key = key;
+    engine->api = TessBaseAPICreate();
+    if (engine->api && TessBaseAPIInit3(engine->api, datapath, lang) == 0)
+        return engine;
+
+    g_set_error(error, g_quark_from_static_string("ocr"), engine->api ? 2 : 1,
+                engine->api ? "Tesseract init failed (language missing?)" : "Tesseract allocator failed");
+    ocr_engine_free(engine);
+    g_mutex_lock(&pool_lock);
+    n_engines--;
+    g_cond_signal(&pool_cond);
+    g_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+static void
+ocr_engine_release(OcrEngine *engine)
+{
+    /* Drop the image and results, keep the loaded models */
+    TessBaseAPIClear(engine->api);
+    engine->last_used = g_get_monotonic_time();
+
+    g_mutex_lock(&pool_lock);
+    GQueue *queue = g_hash_table_lookup(idle_engines, engine->key);
+    if (!queue) {
+        queue = g_queue_new();
+        g_hash_table_insert(idle_engines, g_strdup(engine->key), queue);
+    }
+    g_queue_push_tail(queue, engine);
+    if (!sweep_id)
+        sweep_id = g_timeout_add_seconds(ENGINE_IDLE_SECONDS, pool_sweep_cb, NULL);
+    g_cond_signal(&pool_cond);
+    g_mutex_unlock(&pool_lock);
+}
+
 /* Internal data passed to worker thread */
 typedef struct {
     char *path;
+    GdkPixbuf *pixbuf; /* Set instead of path for in-memory input */
     char *lang;
     char *datapath;
 } OcrTaskData;
@@ -32,52 +199,107 @@ ocr_task_data_free(OcrTaskData *data)
 {
     if (!data) return;
     g_free(data->path);
+    g_clear_object(&data->pixbuf);
     g_free(data->lang);
     g_free(data->datapath);
     g_free(data);
 }
 
-static void
-ocr_task_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+static char *
+engine_get_text(OcrEngine *engine)
 {
-    OcrTaskData *data = task_data;
-    char *result_text = NULL;
-
-    TessBaseAPI *api = TessBaseAPICreate();
-    if (!api) {
-        g_task_return_error(task, g_error_new(g_quark_from_static_string("ocr"), 1, "Tesseract allocator failed"));
-        return;
-    }
-
-    const char *lang = data->lang ? data->lang : "eng";
-    const char *datapath = data->datapath && *data->datapath ? data->datapath : NULL;
-
-    if (TessBaseAPIInit3(api, datapath, lang) != 0) {
-        TessBaseAPIDelete(api);
-        g_task_return_error(task, g_error_new(g_quark_from_static_string("ocr"), 2, "Tesseract init failed (language missing?)"));
-        return;
-    }
-
-    PIX *pix = pixRead(data->path);
-    if (!pix) {
-        TessBaseAPIDelete(api);
-        g_task_return_error(task, g_error_new(g_quark_from_static_string("ocr"), 3, "Failed to read image"));
-        return;
-    }
-
-    TessBaseAPISetImage2(api, (struct Pix *)pix);
-    char *out = TessBaseAPIGetUTF8Text(api);
+    char *result_text;
+    char *out = TessBaseAPIGetUTF8Text(engine->api);
     if (out) {
         result_text = g_strdup(out);
         TessDeleteText(out);
     } else {
         result_text = g_strdup("");
     }
+    return result_text;
+}
+
+/* Recognise pix with a pooled engine. Takes ownership of pix. */
+static char *
+recognize_pix(PIX *pix, const char *lang, const char *datapath, GCancellable *cancellable, GError **error)
+{
+    lang = lang ? lang : "eng";
+    datapath = datapath && *datapath ? datapath : NULL;
+
+    OcrEngine *engine = ocr_engine_acquire(lang, datapath, cancellable, error);
+    if (!engine) {
+        pixDestroy(&pix);
+        return NULL;
+    }
+
+    TessBaseAPISetImage2(engine->api, (struct Pix *)pix);
+    char *result_text = engine_get_text(engine);
 
     pixDestroy(&pix);
-    TessBaseAPIDelete(api);
+    ocr_engine_release(engine);
+    return result_text;
+}
+
+/* Recognise decoded pixels without a PIX copy. Tesseract binarises from
+ * luma anyway, so it is handed a gray plane converted here with the SIMD
+ * kernels; formats they do not cover go in as RGB(A) rows. */
+char *
+ocr_recognize_pixbuf(GdkPixbuf *pixbuf, const char *lang, const char *datapath, GCancellable *cancellable, GError **error)
+{
+    if (gdk_pixbuf_get_bits_per_sample(pixbuf) != 8 || gdk_pixbuf_get_colorspace(pixbuf) != GDK_COLORSPACE_RGB) {
+        g_set_error(error, g_quark_from_static_string("ocr"), 3, "Unsupported pixel format");
+        return NULL;
+    }
+
+    lang = lang ? lang : "eng";
+    datapath = datapath && *datapath ? datapath : NULL;
+
+    OcrEngine *engine = ocr_engine_acquire(lang, datapath, cancellable, error);
+    if (!engine) return NULL;
+
+    int w = gdk_pixbuf_get_width(pixbuf);
+    int h = gdk_pixbuf_get_height(pixbuf);
+    guint8 *gray = pixel_ops_to_gray(pixbuf);
+    if (gray)
+        TessBaseAPISetImage(engine->api, gray, w, h, 1, w);
+    else
+        TessBaseAPISetImage(engine->api, gdk_pixbuf_read_pixels(pixbuf), w, h,
+                            gdk_pixbuf_get_n_channels(pixbuf), gdk_pixbuf_get_rowstride(pixbuf));
+    char *result_text = engine_get_text(engine);
+    g_free(gray);
+
+    ocr_engine_release(engine);
+    return result_text;
+}
+
+static void
+ocr_task_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    OcrTaskData *data = task_data;
+    GError *error = NULL;
+    char *text = data->pixbuf
+        ? ocr_recognize_pixbuf(data->pixbuf, data->lang, data->datapath, cancellable, &error)
+        : ocr_recognize_file(data->path, data->lang, data->datapath, cancellable, &error);
+    if (text)
+        g_task_return_pointer(task, text, g_free);
+    else
+        g_task_return_error(task, error);
+}
 
-    g_task_return_pointer(task, result_text, g_free);
+static void
+ocr_warm_up_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    OcrTaskData *data = task_data;
+    const char *datapath = data->datapath && *data->datapath ? data->datapath : NULL;
+
+    GError *error = NULL;
+    OcrEngine *engine = ocr_engine_acquire(data->lang, datapath, cancellable, &error);
+    if (engine) {
+        ocr_engine_release(engine);
+        g_task_return_boolean(task, TRUE);
+    } else {
+        g_task_return_error(task, error);
+    }
 }
 
 void
@@ -94,6 +316,56 @@ ocr_recognize_image_async(const char *path, const char *lang, const char *datapa
     g_object_unref(task);
 }
 
+void
+ocr_recognize_pixbuf_async(GdkPixbuf *pixbuf, const char *lang, const char *datapath, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+    OcrTaskData *data = g_new0(OcrTaskData, 1);
+    data->pixbuf = g_object_ref(pixbuf);
+    data->lang = lang ? g_strdup(lang) : g_strdup("eng");
+    data->datapath = datapath ? g_strdup(datapath) : NULL;
+
+    GTask *task = g_task_new(NULL, cancellable, callback, user_data);
+    g_task_set_task_data(task, data, (GDestroyNotify)ocr_task_data_free);
+    g_task_run_in_thread(task, ocr_task_thread);
+    g_object_unref(task);
+}
+
+char *
+ocr_recognize_file(const char *path, const char *lang, const char *datapath, GCancellable *cancellable, GError **error)
+{
+    PIX *pix = pixRead(path);
+    if (!pix) {
+        g_set_error(error, g_quark_from_static_string("ocr"), 3, "Failed to read image");
+        return NULL;
+    }
+    return recognize_pix(pix, lang, datapath, cancellable, error);
+}
+
+char *
+ocr_recognize_data(const guint8 *data, gsize len, const char *lang, const char *datapath, GCancellable *cancellable, GError **error)
+{
+    PIX *pix = pixReadMem(data, len);
+    if (!pix) {
+        g_set_error(error, g_quark_from_static_string("ocr"), 3, "Failed to read image");
+        return NULL;
+    }
+    return recognize_pix(pix, lang, datapath, cancellable, error);
+}
+
+void
+ocr_warm_up(const char *lang, const char *datapath)
+{
+    OcrTaskData *data = g_new0(OcrTaskData, 1);
+    data->lang = g_strdup(lang ? lang : "eng");
+    data->datapath = datapath ? g_strdup(datapath) : NULL;
+
+    GTask *task = g_task_new(NULL, NULL, NULL, NULL);
+    g_task_set_task_data(task, data, (GDestroyNotify)ocr_task_data_free);
+    g_task_set_priority(task, G_PRIORITY_LOW);
+    g_task_run_in_thread(task, ocr_warm_up_thread);
+    g_object_unref(task);
+}
+
 char *
 ocr_recognize_image_finish(GAsyncResult *result, GError **error)
 {
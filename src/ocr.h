@@ -2,6 +2,7 @@
 #define OCR_H
 
 #include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 
 G_BEGIN_DECLS
 
@@ -13,6 +14,23 @@ G_BEGIN_DECLS
 void ocr_recognize_image_async(const char *path, const char *lang, const char *datapath, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
 char *ocr_recognize_image_finish(GAsyncResult *result, GError **error);
 
+/* Same, for an image that is already decoded: the pixels are handed to
+ * Tesseract as they are, with no file round trip. The pixbuf is kept
+ * alive (and must not be modified) until the callback runs. Finish with
+ * ocr_recognize_image_finish. */
+void ocr_recognize_pixbuf_async(GdkPixbuf *pixbuf, const char *lang, const char *datapath, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+
+/* Blocking variants for callers already on a worker thread (batch OCR).
+ * They share the engine pool with the async API. data holds an encoded
+ * image file; pixbuf is an already decoded image (RGB or RGBA, 8 bits). */
+char *ocr_recognize_file(const char *path, const char *lang, const char *datapath, GCancellable *cancellable, GError **error);
+char *ocr_recognize_data(const guint8 *data, gsize len, const char *lang, const char *datapath, GCancellable *cancellable, GError **error);
+char *ocr_recognize_pixbuf(GdkPixbuf *pixbuf, const char *lang, const char *datapath, GCancellable *cancellable, GError **error);
+
+/* Load the models for lang/datapath into a pooled engine in the background,
+ * so the next recognition with the same arguments starts immediately. */
+void ocr_warm_up(const char *lang, const char *datapath);
+
 G_END_DECLS
 
 #endif /* OCR_H */
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include "ocrbatch.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include "ocr.h"
+#include "archive.h"
+#include "imageservice.h"
+
+/* Batch OCR (model)
+ *
+ * Runs OCR over a whole folder or archive:
+ * - Workers: a GThreadPool with one thread per core; every worker takes an
+ *   engine from the shared pool in ocr.c, so models load once per thread.
+ * - Index: results are appended, and flushed, as each page finishes, to
+ *   $XDG_CACHE_HOME/brighteyes/ocr/<md5 of folder or archive>.tsv. Lines can
+ *   be searched with grep; the format is described in ocrbatch.h.
+ * - Resume: pages already in the index with a matching mtime are skipped.
+ *   Loading keeps only each page's latest line and rewrites the file when
+ *   older ones were superseded.
+ * - Pages: ones already decoded by the image service are recognised from
+ *   its pixels; archive pages are read through it, sharing an extraction
+ *   that is in progress.
+ * - Cancel: queued pages are dropped and pages in flight stop at the next
+ *   engine wait; their results are not written.
+ *
+ * Sections: helpers, index, workers, lifecycle, public API.
+ */
+
+struct _OcrBatch {
+    GObject parent_instance;
+    GPtrArray *paths;
+    char *lang;
+    char *datapath;
+    char *index_path;
+
+    GCancellable *cancellable;
+    GThreadPool *pool;
+    GMutex index_lock;
+    FILE *index; /* Appended to by the workers under index_lock */
+
+    guint total;
+    guint processed; /* Skipped, recognised or failed */
+    guint failed;
+    guint pending;   /* Jobs queued or running */
+    gboolean running;
+};
+
+typedef struct {
+    OcrBatch *batch; /* Owned ref, released on the main thread */
+    char *path;
+    gint64 mtime;
+    gboolean ok;
+} BatchJob;
+
+enum {
+    SIGNAL_PROGRESS,
+    SIGNAL_FINISHED,
+    N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_TYPE(OcrBatch, ocr_batch, G_TYPE_OBJECT)
+
+/* --- Helpers --- */
+
+static gint64
+get_source_mtime(const char *path)
+{
+    char *archive_path = NULL, *entry_name = NULL;
+    GStatBuf st;
+    int rc;
+
+    if (archive_split_path(path, &archive_path, &entry_name)) {
+        rc = g_stat(archive_path, &st);
+        g_free(archive_path);
+        g_free(entry_name);
+    } else {
+        rc = g_stat(path, &st);
+    }
+    return rc == 0 ? (gint64)st.st_mtime : -1;
+}
+
+/* Folder or archive the first path belongs to */
+static char *
+container_for(const char *path)
+{
+    char *archive_path = NULL, *entry_name = NULL;
+    if (archive_split_path(path, &archive_path, &entry_name)) {
+        g_free(entry_name);
+        return archive_path;
+    }
+    return g_path_get_dirname(path);
+}
+
+/* --- Index --- */
+
+static char *
+index_escape(const char *text)
+{
+    GString *out = g_string_sized_new(strlen(text) + 16);
+    for (const char *p = text; *p; p++) {
+        switch (*p) {
+            case '\\': g_string_append(out, "\\\\"); break;
+            case '\t': g_string_append(out, "\\t"); break;
+            case '\n': g_string_append(out, "\\n"); break;
+            case '\r': g_string_append(out, "\\r"); break;
+            default: g_string_append_c(out, *p); break;
+        }
+    }
+    return g_string_free(out, FALSE);
+}
+
+/* "<path>\t<mtime>" keys of the pages already recognised. A page OCRed
+ * again after it changed is appended as a new line, so when a path has
+ * several lines only the last one counts and the file is rewritten without
+ * the others (and without lines truncated by a crash). */
+static GHashTable *
+index_load_done(const char *index_path)
+{
+    GHashTable *done = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    char *contents = NULL;
+    if (!g_file_get_contents(index_path, &contents, NULL, NULL)) return done;
+
+    char **lines = g_strsplit(contents, "\n", -1);
+    GHashTable *latest = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL); /* path -> line + 1 */
+    guint n_lines = 0;
+    gboolean stale = FALSE;
+    for (guint i = 0; lines[i]; i++) {
+        if (!*lines[i]) continue;
+        n_lines++;
+        char *tab = strchr(lines[i], '\t');
+        char *tab2 = tab ? strchr(tab + 1, '\t') : NULL;
+        if (!tab2) {
+            stale = TRUE; /* Truncated by a crash */
+            continue;
+        }
+        char *path = g_strndup(lines[i], tab - lines[i]);
+        if (g_hash_table_contains(latest, path)) stale = TRUE;
+        g_hash_table_replace(latest, path, GUINT_TO_POINTER(i + 1));
+    }
+
+    GString *kept = stale ? g_string_sized_new(strlen(contents)) : NULL;
+    for (guint i = 0; lines[i]; i++) {
+        char *tab = strchr(lines[i], '\t');
+        char *tab2 = tab ? strchr(tab + 1, '\t') : NULL;
+        if (!tab2) continue;
+        char *path = g_strndup(lines[i], tab - lines[i]);
+        gboolean current = GPOINTER_TO_UINT(g_hash_table_lookup(latest, path)) == i + 1;
+        g_free(path);
+        if (!current) continue;
+
+        g_hash_table_add(done, g_strndup(lines[i], tab2 - lines[i]));
+        if (kept) g_string_append_printf(kept, "%s\n", lines[i]);
+    }
+
+    /* Written before the index is opened for appending, so no worker races it */
+    if (kept) {
+        GError *error = NULL;
+        if (!g_file_set_contents(index_path, kept->str, (gssize)kept->len, &error)) {
+            g_warning("Cannot compact OCR index %s: %s", index_path, error->message);
+            g_error_free(error);
+        } else {
+            g_debug("OCR index %s: kept %u of %u lines", index_path, g_hash_table_size(latest), n_lines);
+        }
+        g_string_free(kept, TRUE);
+    }
+
+    g_hash_table_unref(latest);
+    g_strfreev(lines);
+    g_free(contents);
+    return done;
+}
+
+static void
+index_append(OcrBatch *self, const char *path, gint64 mtime, const char *text)
+{
+    char *escaped = index_escape(text);
+    g_mutex_lock(&self->index_lock);
+    if (self->index) {
+        fprintf(self->index, "%s\t%" G_GINT64_FORMAT "\t%s\n", path, mtime, escaped);
+        fflush(self->index);
+    }
+    g_mutex_unlock(&self->index_lock);
+    g_free(escaped);
+}
+
+/* --- Workers --- */
+
+static void
+batch_job_free(BatchJob *job)
+{
+    g_clear_object(&job->batch);
+    g_free(job->path);
+    g_free(job);
+}
+
+static void
+ocr_batch_finish(OcrBatch *self)
+{
+    g_mutex_lock(&self->index_lock);
+    if (self->index) {
+        fclose(self->index);
+        self->index = NULL;
+    }
+    g_mutex_unlock(&self->index_lock);
+
+    /* Called from the last job, so the workers have nothing left to do */
+    g_thread_pool_free(self->pool, FALSE, FALSE);
+    self->pool = NULL;
+    self->running = FALSE;
+    g_signal_emit(self, signals[SIGNAL_FINISHED], 0, g_cancellable_is_cancelled(self->cancellable));
+}
+
+static gboolean
+batch_job_done(gpointer user_data)
+{
+    BatchJob *job = user_data;
+    OcrBatch *self = job->batch;
+
+    self->processed++;
+    if (!job->ok && !g_cancellable_is_cancelled(self->cancellable))
+        self->failed++;
+    self->pending--;
+
+    g_signal_emit(self, signals[SIGNAL_PROGRESS], 0, self->processed, self->total);
+    if (self->pending == 0)
+        ocr_batch_finish(self);
+    return G_SOURCE_REMOVE;
+}
+
+static char *
+recognize_page(OcrBatch *self, const char *path, GError **error)
+{
+    /* The page the viewer shows (or the prefetcher decoded) is already here */
+    GdkPixbuf *decoded = image_service_peek(path, 0);
+    if (decoded) {
+        char *text = ocr_recognize_pixbuf(decoded, self->lang, self->datapath, self->cancellable, error);
+        g_object_unref(decoded);
+        return text;
+    }
+
+    if (!g_str_has_prefix(path, "archive://"))
+        return ocr_recognize_file(path, self->lang, self->datapath, self->cancellable, error);
+
+    char *text = NULL;
+    GBytes *bytes = image_service_read_bytes(path, self->cancellable, error);
+    if (bytes) {
+        gsize len = 0;
+        const guint8 *data = g_bytes_get_data(bytes, &len);
+        text = ocr_recognize_data(data, len, self->lang, self->datapath, self->cancellable, error);
+        g_bytes_unref(bytes);
+    }
+    return text;
+}
+
+static void
+batch_worker(gpointer data, gpointer user_data)
+{
+    BatchJob *job = data;
+    OcrBatch *self = job->batch;
+
+    if (!g_cancellable_is_cancelled(self->cancellable)) {
+        GError *error = NULL;
+        char *text = recognize_page(self, job->path, &error);
+        if (text && !g_cancellable_is_cancelled(self->cancellable)) {
+            index_append(self, job->path, job->mtime, text);
+            job->ok = TRUE;
+        } else if (error && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("Batch OCR failed for %s: %s", job->path, error->message);
+        }
+        g_clear_error(&error);
+        g_free(text);
+    }
+
+    g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT, batch_job_done, job, (GDestroyNotify)batch_job_free);
+}
+
+/* --- Lifecycle --- */
+
+static void
+ocr_batch_dispose(GObject *object)
+{
+    OcrBatch *self = BRIGHTEYES_OCR_BATCH(object);
+    /* Jobs hold references, so no worker is running by now */
+    g_cancellable_cancel(self->cancellable);
+    G_OBJECT_CLASS(ocr_batch_parent_class)->dispose(object);
+}
+
+static void
+ocr_batch_finalize(GObject *object)
+{
+    OcrBatch *self = BRIGHTEYES_OCR_BATCH(object);
+    if (self->index) fclose(self->index);
+    g_mutex_clear(&self->index_lock);
+    g_clear_object(&self->cancellable);
+    g_ptr_array_unref(self->paths);
+    g_free(self->lang);
+    g_free(self->datapath);
+    g_free(self->index_path);
+    G_OBJECT_CLASS(ocr_batch_parent_class)->finalize(object);
+}
+
+static void
+ocr_batch_class_init(OcrBatchClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = ocr_batch_dispose;
+    object_class->finalize = ocr_batch_finalize;
+
+    signals[SIGNAL_PROGRESS] = g_signal_new("progress",
+                                            G_TYPE_FROM_CLASS(klass),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL, NULL,
+                                            G_TYPE_NONE, 2,
+                                            G_TYPE_UINT, G_TYPE_UINT);
+
+    signals[SIGNAL_FINISHED] = g_signal_new("finished",
+                                            G_TYPE_FROM_CLASS(klass),
+                                            G_SIGNAL_RUN_LAST,
+                                            0, NULL, NULL, NULL,
+                                            G_TYPE_NONE, 1,
+                                            G_TYPE_BOOLEAN);
+}
+
+static void
+ocr_batch_init(OcrBatch *self)
+{
+    g_mutex_init(&self->index_lock);
+    self->cancellable = g_cancellable_new();
+}
+
+/* --- Public API --- */
+
+OcrBatch *
+ocr_batch_new(GPtrArray *paths, const char *lang, const char *datapath)
+{
+    OcrBatch *self = g_object_new(TYPE_OCR_BATCH, NULL);
+    self->paths = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; paths && i < paths->len; i++) {
+        const char *path = g_ptr_array_index(paths, i);
+        if (!archive_is_video_path(path))
+            g_ptr_array_add(self->paths, g_strdup(path));
+    }
+    self->lang = g_strdup(lang ? lang : "eng");
+    self->datapath = datapath ? g_strdup(datapath) : NULL;
+
+    char *dir = g_build_filename(g_get_user_cache_dir(), "brighteyes", "ocr", NULL);
+    char *container = self->paths->len ? container_for(g_ptr_array_index(self->paths, 0)) : g_strdup("");
+    char *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, container, -1);
+    char *name = g_strconcat(md5, ".tsv", NULL);
+    self->index_path = g_build_filename(dir, name, NULL);
+    g_free(name);
+    g_free(md5);
+    g_free(container);
+    g_free(dir);
+    return self;
+}
+
+void
+ocr_batch_start(OcrBatch *self)
+{
+    if (self->running) return;
+
+    self->total = self->paths->len;
+    self->processed = 0;
+    self->failed = 0;
+    self->pending = 0;
+    self->running = TRUE;
+    g_cancellable_reset(self->cancellable);
+
+    char *dir = g_path_get_dirname(self->index_path);
+    g_mkdir_with_parents(dir, 0700);
+    g_free(dir);
+
+    GHashTable *done = index_load_done(self->index_path);
+    self->index = fopen(self->index_path, "a");
+    if (!self->index)
+        g_warning("Cannot write OCR index %s: %s", self->index_path, g_strerror(errno));
+
+    self->pool = g_thread_pool_new(batch_worker, NULL, (gint)g_get_num_processors(), FALSE, NULL);
+    for (guint i = 0; i < self->paths->len; i++) {
+        const char *path = g_ptr_array_index(self->paths, i);
+        gint64 mtime = get_source_mtime(path);
+
+        char *key = g_strdup_printf("%s\t%" G_GINT64_FORMAT, path, mtime);
+        gboolean indexed = g_hash_table_contains(done, key);
+        g_free(key);
+        if (indexed) {
+            self->processed++;
+            continue;
+        }
+
+        BatchJob *job = g_new0(BatchJob, 1);
+        job->batch = g_object_ref(self);
+        job->path = g_strdup(path);
+        job->mtime = mtime;
+        self->pending++;
+        g_thread_pool_push(self->pool, job, NULL);
+    }
+    g_hash_table_unref(done);
+
+    g_signal_emit(self, signals[SIGNAL_PROGRESS], 0, self->processed, self->total);
+    if (self->pending == 0)
+        ocr_batch_finish(self);
+}
+
+void
+ocr_batch_cancel(OcrBatch *self)
+{
+    g_cancellable_cancel(self->cancellable);
+}
+
+gboolean
+ocr_batch_is_running(OcrBatch *self)
+{
+    return self->running;
+}
+
+const char *
+ocr_batch_get_index_path(OcrBatch *self)
+{
+    return self->index_path;
+}
+
+guint
+ocr_batch_get_n_failed(OcrBatch *self)
+{
+    return self->failed;
+}
@@ -0,0 +1,36 @@
+#ifndef OCRBATCH_H
+#define OCRBATCH_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define TYPE_OCR_BATCH (ocr_batch_get_type())
+G_DECLARE_FINAL_TYPE(OcrBatch, ocr_batch, BRIGHTEYES, OCR_BATCH, GObject)
+
+/* Recognises every path (plain files and archive:// pages) on a pool of
+ * worker threads and appends the text to a per-folder index file, one line
+ * per page: "<path>\t<mtime>\t<text>" with backslash, tab, CR and newline
+ * escaped as \\, \t, \r and \n. Starting a batch over the same folder again
+ * skips pages already in the index whose mtime still matches, so a
+ * cancelled run resumes where it stopped; lines left behind by pages that
+ * changed and were recognised again are dropped at that point.
+ *
+ * Signals (main thread):
+ *   "progress" (guint processed, guint total)
+ *     After each page; processed includes pages skipped as already indexed.
+ *   "finished" (gboolean cancelled)
+ *     Once every queued page has been handled or dropped. */
+OcrBatch *ocr_batch_new(GPtrArray *paths, const char *lang, const char *datapath);
+
+void ocr_batch_start(OcrBatch *self);
+void ocr_batch_cancel(OcrBatch *self);
+gboolean ocr_batch_is_running(OcrBatch *self);
+
+/* Index file written by this batch */
+const char *ocr_batch_get_index_path(OcrBatch *self);
+guint ocr_batch_get_n_failed(OcrBatch *self);
+
+G_END_DECLS
+
+#endif /* OCRBATCH_H */
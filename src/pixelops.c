@@ -0,0 +1,402 @@
+#include "pixelops.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXELOPS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || (defined(__ARM_NEON) && defined(__GNUC__))
+#define PIXELOPS_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Pixel kernels (image processing)
+ *
+ * Row kernels behind pixelops.h:
+ * - Halving: each output channel is (a + b + c + d + 2) >> 2 of its 2x2
+ *   source block, summed in 16 bits.
+ * - Gray: Y = (38 R + 75 G + 15 B + 64) >> 7, the BT.601 weights scaled to
+ *   fit signed bytes so SSSE3's maddubs can apply them.
+ * - Dispatch: the kernels are chosen once. x86 kernels are compiled with
+ *   target attributes and only called after __builtin_cpu_supports says
+ *   the CPU has the instructions; NEON is part of every ARMv8 CPU.
+ * Each SIMD kernel returns how many output pixels of the row it produced;
+ * the scalar kernel finishes the rest. SIMD loads never read past the
+ * bytes that belong to the row, so unpadded last rows are safe.
+ *
+ * Sections: scalar kernels, x86 kernels, NEON kernels, dispatch, public API.
+ */
+
+typedef int (*HalveRowFunc)(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width);
+typedef int (*GrayRowFunc)(const guint8 *in, guint8 *out, int width);
+
+typedef struct {
+    const char *name;
+    HalveRowFunc halve3;
+    HalveRowFunc halve4;
+    GrayRowFunc gray3;
+    GrayRowFunc gray4;
+} Kernels;
+
+/* --- Scalar kernels --- */
+
+static void
+halve_row_c(const guint8 *r0, const guint8 *r1, guint8 *out, int from, int out_width, int nc)
+{
+    for (int x = from; x < out_width; x++) {
+        const guint8 *a = r0 + (gsize)x * 2 * nc;
+        const guint8 *b = r1 + (gsize)x * 2 * nc;
+        guint8 *o = out + (gsize)x * nc;
+        for (int c = 0; c < nc; c++)
+            o[c] = (guint8)((a[c] + a[c + nc] + b[c] + b[c + nc] + 2) >> 2);
+    }
+}
+
+static void
+gray_row_c(const guint8 *in, guint8 *out, int from, int width, int nc)
+{
+    for (int x = from; x < width; x++) {
+        const guint8 *p = in + (gsize)x * nc;
+        out[x] = (guint8)((38 * p[0] + 75 * p[1] + 15 * p[2] + 64) >> 7);
+    }
+}
+
+static int
+none_halve(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width)
+{
+    return 0;
+}
+
+static int
+none_gray(const guint8 *in, guint8 *out, int width)
+{
+    return 0;
+}
+
+/* --- x86 kernels --- */
+
+#ifdef PIXELOPS_X86
+
+/* Sum the two rows of four RGBX pixels and the adjacent pixel pairs:
+ * returns two rounded averages as 16-bit lanes. */
+__attribute__((target("sse2")))
+static inline __m128i
+box4_sse2(__m128i a, __m128i b)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+    __m128i s = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+    return _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16(2)), 2);
+}
+
+__attribute__((target("sse2")))
+static int
+sse2_halve4(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width)
+{
+    int x = 0;
+    for (; x + 2 <= out_width; x += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(r0 + (gsize)x * 8));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r1 + (gsize)x * 8));
+        __m128i s = box4_sse2(a, b);
+        _mm_storel_epi64((__m128i *)(out + (gsize)x * 4), _mm_packus_epi16(s, s));
+    }
+    return x;
+}
+
+__attribute__((target("ssse3")))
+static int
+ssse3_halve3(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width)
+{
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i compact = _mm_setr_epi8(0, 1, 2, 4, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    int x = 0;
+    /* 16-byte loads cover 4 pixels plus 4 bytes, and 8-byte stores 2 pixels
+       plus 2 bytes; stop early enough that both stay inside the row */
+    for (; x + 3 <= out_width; x += 2) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(r0 + (gsize)x * 6)), expand);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(r1 + (gsize)x * 6)), expand);
+        __m128i s = box4_sse2(a, b);
+        __m128i p = _mm_shuffle_epi8(_mm_packus_epi16(s, s), compact);
+        _mm_storel_epi64((__m128i *)(out + (gsize)x * 3), p);
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+static int
+avx2_halve4(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    int x = 0;
+    for (; x + 4 <= out_width; x += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(r0 + (gsize)x * 8));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(r1 + (gsize)x * 8));
+        /* Per 128-bit lane, exactly as box4_sse2 */
+        __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        __m256i s = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+        s = _mm256_srli_epi16(_mm256_add_epi16(s, two), 2);
+        __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(s, s), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(out + (gsize)x * 4), _mm256_castsi256_si128(p));
+    }
+    return x;
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i
+gray8_ssse3(__m128i px0, __m128i px1)
+{
+    const __m128i weights = _mm_setr_epi8(38, 75, 15, 0, 38, 75, 15, 0, 38, 75, 15, 0, 38, 75, 15, 0);
+    __m128i s = _mm_hadd_epi16(_mm_maddubs_epi16(px0, weights), _mm_maddubs_epi16(px1, weights));
+    s = _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16(64)), 7);
+    return _mm_packus_epi16(s, s);
+}
+
+__attribute__((target("ssse3")))
+static int
+ssse3_gray4(const guint8 *in, guint8 *out, int width)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(in + (gsize)x * 4));
+        __m128i b = _mm_loadu_si128((const __m128i *)(in + (gsize)x * 4 + 16));
+        _mm_storel_epi64((__m128i *)(out + x), gray8_ssse3(a, b));
+    }
+    return x;
+}
+
+__attribute__((target("ssse3")))
+static int
+ssse3_gray3(const guint8 *in, guint8 *out, int width)
+{
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    int x = 0;
+    /* The second load reads 16 bytes from pixel x + 4 */
+    for (; x + 10 <= width; x += 8) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + (gsize)x * 3)), expand);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + (gsize)x * 3 + 12)), expand);
+        _mm_storel_epi64((__m128i *)(out + x), gray8_ssse3(a, b));
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+static int
+avx2_gray4(const guint8 *in, guint8 *out, int width)
+{
+    const __m256i weights = _mm256_setr_epi8(38, 75, 15, 0, 38, 75, 15, 0, 38, 75, 15, 0, 38, 75, 15, 0,
+                                             38, 75, 15, 0, 38, 75, 15, 0, 38, 75, 15, 0, 38, 75, 15, 0);
+    const __m256i round = _mm256_set1_epi16(64);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(in + (gsize)x * 4));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(in + (gsize)x * 4 + 32));
+        /* hadd works per lane: pixels come out as 0-3, 8-11, 4-7, 12-15 */
+        __m256i s = _mm256_hadd_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+        s = _mm256_permute4x64_epi64(s, _MM_SHUFFLE(3, 1, 2, 0));
+        s = _mm256_srli_epi16(_mm256_add_epi16(s, round), 7);
+        __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(s, s), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(out + x), _mm256_castsi256_si128(p));
+    }
+    return x;
+}
+
+#endif /* PIXELOPS_X86 */
+
+/* --- NEON kernels --- */
+
+#ifdef PIXELOPS_NEON
+
+static int
+neon_halve3(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width)
+{
+    int x = 0;
+    for (; x + 8 <= out_width; x += 8) {
+        uint8x16x3_t a = vld3q_u8(r0 + (gsize)x * 6);
+        uint8x16x3_t b = vld3q_u8(r1 + (gsize)x * 6);
+        uint8x8x3_t o;
+        for (int c = 0; c < 3; c++)
+            o.val[c] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[c]), b.val[c]), 2);
+        vst3_u8(out + (gsize)x * 3, o);
+    }
+    return x;
+}
+
+static int
+neon_halve4(const guint8 *r0, const guint8 *r1, guint8 *out, int out_width)
+{
+    int x = 0;
+    for (; x + 8 <= out_width; x += 8) {
+        uint8x16x4_t a = vld4q_u8(r0 + (gsize)x * 8);
+        uint8x16x4_t b = vld4q_u8(r1 + (gsize)x * 8);
+        uint8x8x4_t o;
+        for (int c = 0; c < 4; c++)
+            o.val[c] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[c]), b.val[c]), 2);
+        vst4_u8(out + (gsize)x * 4, o);
+    }
+    return x;
+}
+
+static inline uint8x8_t
+gray8_neon(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+{
+    uint16x8_t y = vmull_u8(r, vdup_n_u8(38));
+    y = vmlal_u8(y, g, vdup_n_u8(75));
+    y = vmlal_u8(y, b, vdup_n_u8(15));
+    return vrshrn_n_u16(y, 7);
+}
+
+static int
+neon_gray3(const guint8 *in, guint8 *out, int width)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x3_t p = vld3_u8(in + (gsize)x * 3);
+        vst1_u8(out + x, gray8_neon(p.val[0], p.val[1], p.val[2]));
+    }
+    return x;
+}
+
+static int
+neon_gray4(const guint8 *in, guint8 *out, int width)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t p = vld4_u8(in + (gsize)x * 4);
+        vst1_u8(out + x, gray8_neon(p.val[0], p.val[1], p.val[2]));
+    }
+    return x;
+}
+
+#endif /* PIXELOPS_NEON */
+
+/* --- Dispatch --- */
+
+static const Kernels *
+get_kernels(void)
+{
+    static const Kernels scalar = { "scalar", none_halve, none_halve, none_gray, none_gray };
+#ifdef PIXELOPS_X86
+    static const Kernels sse2 = { "sse2", none_halve, sse2_halve4, none_gray, none_gray };
+    static const Kernels ssse3 = { "ssse3", ssse3_halve3, sse2_halve4, ssse3_gray3, ssse3_gray4 };
+    static const Kernels avx2 = { "avx2", ssse3_halve3, avx2_halve4, ssse3_gray3, avx2_gray4 };
+#endif
+#ifdef PIXELOPS_NEON
+    static const Kernels neon = { "neon", neon_halve3, neon_halve4, neon_gray3, neon_gray4 };
+#endif
+    static gsize chosen = 0;
+
+    if (g_once_init_enter(&chosen)) {
+        const Kernels *k = &scalar;
+        if (g_strcmp0(g_getenv("BRIGHTEYES_PIXELOPS"), "scalar") != 0) {
+#ifdef PIXELOPS_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) k = &avx2;
+            else if (__builtin_cpu_supports("ssse3")) k = &ssse3;
+            else if (__builtin_cpu_supports("sse2")) k = &sse2;
+#endif
+#ifdef PIXELOPS_NEON
+            k = &neon;
+#endif
+        }
+        g_debug("Pixel kernels: %s", k->name);
+        g_once_init_leave(&chosen, (gsize)k);
+    }
+    return (const Kernels *)chosen;
+}
+
+static gboolean
+is_supported(GdkPixbuf *pixbuf)
+{
+    int nc = gdk_pixbuf_get_n_channels(pixbuf);
+    return gdk_pixbuf_get_colorspace(pixbuf) == GDK_COLORSPACE_RGB &&
+           gdk_pixbuf_get_bits_per_sample(pixbuf) == 8 &&
+           (nc == 3 || (nc == 4 && gdk_pixbuf_get_has_alpha(pixbuf)));
+}
+
+/* --- Public API --- */
+
+GdkPixbuf *
+pixel_ops_halve(GdkPixbuf *src)
+{
+    int w = gdk_pixbuf_get_width(src) / 2;
+    int h = gdk_pixbuf_get_height(src) / 2;
+    if (w < 1 || h < 1) return gdk_pixbuf_scale_simple(src, MAX(w, 1), MAX(h, 1), GDK_INTERP_BILINEAR);
+    if (!is_supported(src)) return gdk_pixbuf_scale_simple(src, w, h, GDK_INTERP_BILINEAR);
+
+    GdkPixbuf *dest = gdk_pixbuf_new(GDK_COLORSPACE_RGB, gdk_pixbuf_get_has_alpha(src), 8, w, h);
+    if (!dest) return NULL;
+
+    const Kernels *k = get_kernels();
+    int nc = gdk_pixbuf_get_n_channels(src);
+    HalveRowFunc row = nc == 4 ? k->halve4 : k->halve3;
+    const guint8 *in = gdk_pixbuf_read_pixels(src);
+    int in_stride = gdk_pixbuf_get_rowstride(src);
+    guint8 *out = gdk_pixbuf_get_pixels(dest);
+    int out_stride = gdk_pixbuf_get_rowstride(dest);
+
+    for (int y = 0; y < h; y++) {
+        const guint8 *r0 = in + (gsize)(2 * y) * in_stride;
+        const guint8 *r1 = r0 + in_stride;
+        guint8 *o = out + (gsize)y * out_stride;
+        halve_row_c(r0, r1, o, row(r0, r1, o, w), w, nc);
+    }
+    return dest;
+}
+
+GdkPixbuf *
+pixel_ops_scale_down(GdkPixbuf *src, int width, int height)
+{
+    width = MAX(width, 1);
+    height = MAX(height, 1);
+
+    GdkPixbuf *current = g_object_ref(src);
+    while (gdk_pixbuf_get_width(current) / 2 >= width && gdk_pixbuf_get_height(current) / 2 >= height) {
+        GdkPixbuf *half = pixel_ops_halve(current);
+        if (!half) break;
+        g_object_unref(current);
+        current = half;
+    }
+
+    if (gdk_pixbuf_get_width(current) == width && gdk_pixbuf_get_height(current) == height) {
+        /* Never hand back src itself: callers own the result */
+        if (current == src) {
+            g_object_unref(current);
+            return gdk_pixbuf_copy(src);
+        }
+        return current;
+    }
+
+    GdkPixbuf *scaled = gdk_pixbuf_scale_simple(current, width, height, GDK_INTERP_BILINEAR);
+    g_object_unref(current);
+    return scaled;
+}
+
+guint8 *
+pixel_ops_to_gray(GdkPixbuf *src)
+{
+    if (!is_supported(src)) return NULL;
+
+    int w = gdk_pixbuf_get_width(src);
+    int h = gdk_pixbuf_get_height(src);
+    int nc = gdk_pixbuf_get_n_channels(src);
+    int stride = gdk_pixbuf_get_rowstride(src);
+    const guint8 *in = gdk_pixbuf_read_pixels(src);
+    const Kernels *k = get_kernels();
+    GrayRowFunc row = nc == 4 ? k->gray4 : k->gray3;
+
+    guint8 *gray = g_malloc((gsize)w * h);
+    for (int y = 0; y < h; y++) {
+        const guint8 *r = in + (gsize)y * stride;
+        guint8 *o = gray + (gsize)y * w;
+        gray_row_c(r, o, row(r, o, w), w, nc);
+    }
+    return gray;
+}
+
+const char *
+pixel_ops_get_implementation(void)
+{
+    return get_kernels()->name;
+}
@@ -0,0 +1,38 @@
+#ifndef PIXELOPS_H
+#define PIXELOPS_H
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/* Pixel kernels
+ *
+ * Downscaling and grayscale conversion for 8-bit RGB and RGBA pixbufs,
+ * with SSE2/SSSE3/AVX2 (x86) or NEON (ARM) versions picked at runtime.
+ * Every implementation gives bit-identical results. Other pixel formats
+ * fall back to gdk-pixbuf. All functions are thread-safe and meant for
+ * worker threads; they never touch GTK.
+ *
+ * BRIGHTEYES_PIXELOPS=scalar forces the portable C kernels.
+ */
+
+/* Halve both sides with a 2x2 box filter (odd last rows and columns are
+ * dropped, as for the w >> 1 sizes of a mip level). */
+GdkPixbuf *pixel_ops_halve(GdkPixbuf *src);
+
+/* Fit src into width x height (no larger than src): halve while the result
+ * stays at least as big as the target, then finish with one bilinear pass.
+ * Large reductions thereby average every source pixel instead of sampling
+ * a few of them. */
+GdkPixbuf *pixel_ops_scale_down(GdkPixbuf *src, int width, int height);
+
+/* BT.601 luma of src as width x height bytes (rows are width long), or NULL
+ * for unsupported formats. Free with g_free. */
+guint8 *pixel_ops_to_gray(GdkPixbuf *src);
+
+/* Kernel set in use: "avx2", "ssse3", "sse2", "neon" or "scalar" */
+const char *pixel_ops_get_implementation(void);
+
+G_END_DECLS
+
+#endif /* PIXELOPS_H */
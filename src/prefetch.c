@@ -0,0 +1,193 @@
+#include "prefetch.h"
+#include <gio/gio.h>
+#include <string.h>
+#include "archive.h"
+#include "imageservice.h"
+
+/* Prefetcher (model)
+ *
+ * Read-ahead for the viewer. Around the curator's current item the next and
+ * previous `radius` images are requested from the image service, whose
+ * decoded-image cache the viewer reads from, so paging through a folder or
+ * comic shows already decoded pixbufs.
+ * - Scheduling: every request has its own GCancellable; when the user jumps,
+ *   requests for items that fell out of the window are cancelled (the
+ *   service drops the decode once nobody else wants it).
+ *
+ * Sections: helpers, scheduling, lifecycle, public API.
+ */
+
+#define DEFAULT_RADIUS 2
+
+struct _Prefetcher {
+    GObject parent_instance;
+    Curator *curator;
+    guint radius;
+
+    GHashTable *inflight; /* path -> GCancellable* */
+};
+
+typedef struct {
+    Prefetcher *prefetcher;
+    char *path;
+    GCancellable *cancellable;
+} PrefetchRequest;
+
+G_DEFINE_TYPE(Prefetcher, prefetcher, G_TYPE_OBJECT)
+
+/* --- Helpers --- */
+
+static void
+prefetch_request_free(PrefetchRequest *req)
+{
+    g_object_unref(req->prefetcher);
+    g_object_unref(req->cancellable);
+    g_free(req->path);
+    g_free(req);
+}
+
+/* --- Scheduling --- */
+
+static void
+on_decode_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    PrefetchRequest *req = user_data;
+    Prefetcher *self = req->prefetcher;
+    GError *error = NULL;
+    GdkPixbuf *pixbuf = image_service_request_finish(res, &error);
+
+    /* Only the most recent request for a path owns the inflight slot */
+    if (self->inflight && g_hash_table_lookup(self->inflight, req->path) == req->cancellable)
+        g_hash_table_remove(self->inflight, req->path);
+
+    if (!pixbuf && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_debug("Prefetch of %s failed: %s", req->path, error ? error->message : "unknown");
+
+    g_clear_error(&error);
+    g_clear_object(&pixbuf);
+    prefetch_request_free(req);
+}
+
+static void
+start_decode(Prefetcher *self, const char *path)
+{
+    PrefetchRequest *req = g_new0(PrefetchRequest, 1);
+    req->prefetcher = g_object_ref(self);
+    req->path = g_strdup(path);
+    req->cancellable = g_cancellable_new();
+    g_hash_table_insert(self->inflight, g_strdup(path), g_object_ref(req->cancellable));
+
+    image_service_request_async(path, 0, req->cancellable, on_decode_done, req);
+}
+
+/* --- Lifecycle --- */
+
+static void
+prefetcher_dispose(GObject *object)
+{
+    Prefetcher *self = BRIGHTEYES_PREFETCHER(object);
+
+    if (self->inflight) {
+        GHashTableIter iter;
+        gpointer value;
+        g_hash_table_iter_init(&iter, self->inflight);
+        while (g_hash_table_iter_next(&iter, NULL, &value))
+            g_cancellable_cancel(G_CANCELLABLE(value));
+        g_clear_pointer(&self->inflight, g_hash_table_unref);
+    }
+
+    g_clear_object(&self->curator);
+    G_OBJECT_CLASS(prefetcher_parent_class)->dispose(object);
+}
+
+static void
+prefetcher_class_init(PrefetcherClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = prefetcher_dispose;
+}
+
+static void
+prefetcher_init(Prefetcher *self)
+{
+    self->radius = DEFAULT_RADIUS;
+    self->inflight = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+}
+
+/* --- Public API --- */
+
+Prefetcher *
+prefetcher_new(Curator *curator)
+{
+    Prefetcher *self = g_object_new(TYPE_PREFETCHER, NULL);
+    self->curator = g_object_ref(curator);
+    return self;
+}
+
+void
+prefetcher_set_radius(Prefetcher *self, guint radius)
+{
+    self->radius = radius;
+}
+
+guint
+prefetcher_get_radius(Prefetcher *self)
+{
+    return self->radius;
+}
+
+void
+prefetcher_update(Prefetcher *self)
+{
+    const char *current = curator_get_current(self->curator);
+    if (!current) return;
+
+    /* Nearest first: +1, -1, +2, -2, ... The current item stays wanted so a
+     * decode the viewer is waiting for is never cancelled. */
+    GPtrArray *wanted = g_ptr_array_new();
+    GHashTable *wanted_set = g_hash_table_new(g_str_hash, g_str_equal);
+    g_hash_table_add(wanted_set, (gpointer)current);
+
+    guint n_files = curator_get_files(self->curator)->len;
+    guint radius = MIN(self->radius, n_files / 2);
+    for (guint d = 1; d <= radius; d++) {
+        const char *candidates[2] = { curator_peek(self->curator, (int)d), curator_peek(self->curator, -(int)d) };
+        for (guint i = 0; i < 2; i++) {
+            const char *path = candidates[i];
+            if (!path || archive_is_video_path(path) || g_hash_table_contains(wanted_set, path)) continue;
+            g_hash_table_add(wanted_set, (gpointer)path);
+            g_ptr_array_add(wanted, (gpointer)path);
+        }
+    }
+
+    /* Cancel work that fell out of the window */
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, self->inflight);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        if (!g_hash_table_contains(wanted_set, key)) {
+            g_cancellable_cancel(G_CANCELLABLE(value));
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+
+    /* Start missing neighbours, nearest first; looking cached ones up in
+     * reverse keeps the nearest images the last to be evicted. */
+    GHashTable *cached = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = wanted->len; i > 0; i--) {
+        const char *path = g_ptr_array_index(wanted, i - 1);
+        GdkPixbuf *pixbuf = image_service_peek(path, 0);
+        if (!pixbuf) continue;
+        g_hash_table_add(cached, (gpointer)path);
+        g_object_unref(pixbuf);
+    }
+    for (guint i = 0; i < wanted->len; i++) {
+        const char *path = g_ptr_array_index(wanted, i);
+        if (g_hash_table_contains(cached, path) || g_hash_table_contains(self->inflight, path)) continue;
+        start_decode(self, path);
+    }
+    g_hash_table_unref(cached);
+
+    g_hash_table_unref(wanted_set);
+    g_ptr_array_unref(wanted);
+}
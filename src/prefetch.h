@@ -0,0 +1,27 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <glib-object.h>
+#include "curator.h"
+
+G_BEGIN_DECLS
+
+#define TYPE_PREFETCHER (prefetcher_get_type())
+G_DECLARE_FINAL_TYPE(Prefetcher, prefetcher, BRIGHTEYES, PREFETCHER, GObject)
+
+/* Requests the images around the curator's current item from the image
+ * service ahead of time, so they are in its decoded-image cache by the time
+ * the viewer asks for them. */
+Prefetcher *prefetcher_new(Curator *curator);
+
+/* Number of items decoded on each side of the current one (0 disables). */
+void  prefetcher_set_radius(Prefetcher *self, guint radius);
+guint prefetcher_get_radius(Prefetcher *self);
+
+/* Re-plan around the curator's current item: start missing neighbours and
+ * cancel work for items that are no longer close. */
+void prefetcher_update(Prefetcher *self);
+
+G_END_DECLS
+
+#endif /* PREFETCH_H */
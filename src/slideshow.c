@@ -0,0 +1,298 @@
+#include "slideshow.h"
+#include <string.h>
+#include "archive.h"
+#include "imageservice.h"
+
+/* Slideshow (model)
+ *
+ * Timing engine for the slideshow:
+ * - Preload: as soon as a slide is shown the next one is requested from the
+ *   image service and held until its turn, so the swap only has to present
+ *   an already decoded image (through the viewer's crossfade stack).
+ * - Deadlines: a tick callback on the viewer checks every frame. The slide
+ *   is swapped on the first frame whose presentation is at most half a
+ *   refresh before the deadline, and the next deadline is a whole interval
+ *   after the previous one, so the cadence does not drift. After a late
+ *   slide the cadence restarts from the frame it appeared on.
+ * - Misses: late decodes are logged; slides that fail to decode, or miss by
+ *   a whole interval, are skipped.
+ *
+ * Sections: helpers, preloading, ticking, lifecycle, public API.
+ */
+
+#define DEFAULT_INTERVAL_S 3
+#define FALLBACK_REFRESH_US (G_USEC_PER_SEC / 60)
+
+struct _Slideshow {
+    GObject parent_instance;
+    Curator *curator;
+    GtkWidget *widget;       /* Frame clock source */
+    guint tick_id;
+    gint64 interval;         /* Microseconds */
+    gint64 deadline;         /* Frame time the next slide is due, 0 before the first frame */
+    gboolean late;           /* The next slide missed its deadline */
+
+    char *next_path;         /* Slide being preloaded */
+    GdkPixbuf *next_pixbuf;  /* Held so the viewer finds it in the cache */
+    gboolean next_ready;
+    gboolean next_failed;
+    GCancellable *cancellable;
+
+    guint n_shown;
+    guint n_late;
+    guint n_skipped;
+};
+
+enum {
+    SIGNAL_ADVANCE,
+    SIGNAL_STOPPED,
+    N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_TYPE(Slideshow, slideshow, G_TYPE_OBJECT)
+
+/* --- Helpers --- */
+
+static void
+slideshow_clear_next(Slideshow *self)
+{
+    if (self->cancellable) {
+        g_cancellable_cancel(self->cancellable);
+        g_clear_object(&self->cancellable);
+    }
+    g_clear_pointer(&self->next_path, g_free);
+    g_clear_object(&self->next_pixbuf);
+    self->next_ready = FALSE;
+    self->next_failed = FALSE;
+}
+
+/* --- Preloading --- */
+
+static void
+on_preload_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    Slideshow *self = BRIGHTEYES_SLIDESHOW(user_data);
+    GError *error = NULL;
+    GdkPixbuf *pixbuf = image_service_request_finish(res, &error);
+
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        /* Superseded or stopped */
+        g_clear_error(&error);
+        g_object_unref(self);
+        return;
+    }
+
+    if (pixbuf) {
+        self->next_pixbuf = pixbuf;
+        self->next_ready = TRUE;
+    } else {
+        g_message("Slideshow: skipping %s: %s", self->next_path, error ? error->message : "decode failed");
+        self->next_failed = TRUE;
+        g_clear_error(&error);
+    }
+    g_object_unref(self);
+}
+
+/* Start decoding the slide after the current one. */
+static void
+slideshow_preload(Slideshow *self)
+{
+    slideshow_clear_next(self);
+
+    const char *path = curator_peek(self->curator, 1);
+    if (!path) return;
+    self->next_path = g_strdup(path);
+
+    /* Videos start playing when shown; there is nothing to decode ahead */
+    if (archive_is_video_path(path)) {
+        self->next_ready = TRUE;
+        return;
+    }
+
+    self->next_pixbuf = image_service_peek(path, 0);
+    if (self->next_pixbuf) {
+        self->next_ready = TRUE;
+        return;
+    }
+
+    self->cancellable = g_cancellable_new();
+    image_service_request_async(path, 0, self->cancellable, on_preload_done, g_object_ref(self));
+}
+
+/* --- Ticking --- */
+
+/* Move the curator past the next slide without showing it. */
+static void
+slideshow_skip(Slideshow *self, gint64 now)
+{
+    curator_get_next(self->curator);
+    self->n_skipped++;
+    /* Already behind: the next one goes up as soon as it is decoded */
+    self->deadline = now;
+    self->late = TRUE;
+    slideshow_preload(self);
+}
+
+static void
+slideshow_advance(Slideshow *self, gint64 now)
+{
+    const char *path = curator_get_next(self->curator);
+    if (!path) return;
+
+    /* next_pixbuf is only dropped by the preload below, so the viewer's
+       cache lookup cannot miss. The handler may change the curator. */
+    char *shown = g_strdup(path);
+    g_signal_emit(self, signals[SIGNAL_ADVANCE], 0, shown);
+    g_free(shown);
+    self->n_shown++;
+
+    self->deadline = self->late ? now + self->interval : self->deadline + self->interval;
+    if (self->deadline <= now) self->deadline = now + self->interval; /* E.g. after being unmapped */
+    self->late = FALSE;
+    slideshow_preload(self);
+}
+
+static gboolean
+slideshow_tick(GtkWidget *widget, GdkFrameClock *clock, gpointer user_data)
+{
+    Slideshow *self = BRIGHTEYES_SLIDESHOW(user_data);
+    gint64 now = gdk_frame_clock_get_frame_time(clock);
+
+    if (self->deadline == 0) {
+        self->deadline = now + self->interval;
+        return G_SOURCE_CONTINUE;
+    }
+
+    gint64 refresh = 0;
+    gdk_frame_clock_get_refresh_info(clock, now, &refresh, NULL);
+    if (refresh <= 0) refresh = FALLBACK_REFRESH_US;
+    if (now + refresh / 2 < self->deadline) return G_SOURCE_CONTINUE;
+
+    if (!curator_peek(self->curator, 1)) {
+        self->tick_id = 0; /* Removed by returning G_SOURCE_REMOVE */
+        slideshow_clear_next(self);
+        g_signal_emit(self, signals[SIGNAL_STOPPED], 0);
+        return G_SOURCE_REMOVE;
+    }
+
+    /* The user paged by hand: what we decoded is not next any more */
+    if (g_strcmp0(curator_peek(self->curator, 1), self->next_path) != 0)
+        slideshow_preload(self);
+
+    if (self->next_failed) {
+        slideshow_skip(self, now);
+        return G_SOURCE_CONTINUE;
+    }
+
+    if (!self->next_ready) {
+        if (!self->late) {
+            g_message("Slideshow: %s was not decoded by its deadline", self->next_path);
+            self->n_late++;
+            self->late = TRUE;
+        }
+        if (now - self->deadline >= self->interval) {
+            g_message("Slideshow: skipping %s, still decoding one interval later", self->next_path);
+            slideshow_skip(self, now);
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    slideshow_advance(self, now);
+    return G_SOURCE_CONTINUE;
+}
+
+/* --- Lifecycle --- */
+
+static void
+slideshow_dispose(GObject *object)
+{
+    Slideshow *self = BRIGHTEYES_SLIDESHOW(object);
+
+    slideshow_stop(self);
+    g_clear_object(&self->widget);
+    g_clear_object(&self->curator);
+    G_OBJECT_CLASS(slideshow_parent_class)->dispose(object);
+}
+
+static void
+slideshow_class_init(SlideshowClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = slideshow_dispose;
+
+    signals[SIGNAL_ADVANCE] = g_signal_new("advance",
+                                           G_TYPE_FROM_CLASS(klass),
+                                           G_SIGNAL_RUN_LAST,
+                                           0,
+                                           NULL, NULL,
+                                           NULL,
+                                           G_TYPE_NONE,
+                                           1,
+                                           G_TYPE_STRING);
+
+    signals[SIGNAL_STOPPED] = g_signal_new("stopped",
+                                           G_TYPE_FROM_CLASS(klass),
+                                           G_SIGNAL_RUN_LAST,
+                                           0,
+                                           NULL, NULL,
+                                           NULL,
+                                           G_TYPE_NONE,
+                                           0);
+}
+
+static void
+slideshow_init(Slideshow *self)
+{
+    self->interval = (gint64)DEFAULT_INTERVAL_S * G_USEC_PER_SEC;
+}
+
+/* --- Public API --- */
+
+Slideshow *
+slideshow_new(Curator *curator, GtkWidget *widget)
+{
+    Slideshow *self = g_object_new(TYPE_SLIDESHOW, NULL);
+    self->curator = g_object_ref(curator);
+    self->widget = g_object_ref(widget);
+    return self;
+}
+
+void
+slideshow_start(Slideshow *self)
+{
+    if (self->tick_id) return;
+
+    self->deadline = 0;
+    self->late = FALSE;
+    self->n_shown = self->n_late = self->n_skipped = 0;
+    slideshow_preload(self);
+    self->tick_id = gtk_widget_add_tick_callback(self->widget, slideshow_tick, self, NULL);
+}
+
+void
+slideshow_stop(Slideshow *self)
+{
+    if (!self->tick_id) return;
+
+    gtk_widget_remove_tick_callback(self->widget, self->tick_id);
+    self->tick_id = 0;
+    slideshow_clear_next(self);
+    g_debug("Slideshow: %u shown, %u late, %u skipped", self->n_shown, self->n_late, self->n_skipped);
+}
+
+gboolean
+slideshow_is_running(Slideshow *self)
+{
+    return self->tick_id != 0;
+}
+
+void
+slideshow_set_interval(Slideshow *self, guint seconds)
+{
+    gint64 interval = (gint64)MAX(seconds, 1) * G_USEC_PER_SEC;
+    /* Keep the current slide's start time, just move its end */
+    if (self->deadline) self->deadline += interval - self->interval;
+    self->interval = interval;
+}
@@ -0,0 +1,35 @@
+#ifndef SLIDESHOW_H
+#define SLIDESHOW_H
+
+#include <gtk/gtk.h>
+#include "curator.h"
+
+G_BEGIN_DECLS
+
+#define TYPE_SLIDESHOW (slideshow_get_type())
+G_DECLARE_FINAL_TYPE(Slideshow, slideshow, BRIGHTEYES, SLIDESHOW, GObject)
+
+/* Steps through the curator's files at a fixed interval. The next slide is
+ * decoded while the current one is on screen and swapped in on the frame of
+ * widget's frame clock nearest its deadline, so the interval does not grow
+ * by the decode time. A slide that is not decoded by its deadline is shown
+ * as soon as it is (and logged); one that is still not ready a whole
+ * interval later, or fails to decode, is skipped.
+ *
+ * Signals:
+ *   "advance" (const char *path)
+ *     The curator has moved to path; show it. Its decoded image is in the
+ *     image service's cache while the signal runs.
+ *   "stopped" ()
+ *     The slideshow stopped itself (the folder is empty). */
+Slideshow *slideshow_new(Curator *curator, GtkWidget *widget);
+
+void slideshow_start(Slideshow *self);
+void slideshow_stop(Slideshow *self);
+gboolean slideshow_is_running(Slideshow *self);
+
+void slideshow_set_interval(Slideshow *self, guint seconds);
+
+G_END_DECLS
+
+#endif /* SLIDESHOW_H */
@@ -0,0 +1,34 @@
+#include "startuptrace.h"
+
+/* Startup trace (diagnostics)
+ *
+ * Marks the milestones between process start and the first presented
+ * frame so cold start regressions can be measured:
+ * - Clock: g_get_monotonic_time, zero at the first mark.
+ * - Output: one line per mark on stdout only, so tools/smoke.sh style
+ *   scripts can grep for it and G_MESSAGES_DEBUG does not print it twice.
+ *
+ * Main thread only.
+ */
+
+static gint64 trace_start;
+
+gboolean
+startup_trace_enabled(void)
+{
+    static int enabled = -1;
+    if (enabled < 0) enabled = g_getenv("BRIGHTEYES_STARTUP_TRACE") != NULL;
+    return enabled;
+}
+
+void
+startup_trace_mark(const char *event)
+{
+    if (!startup_trace_enabled()) return;
+
+    gint64 now = g_get_monotonic_time();
+    if (trace_start == 0) trace_start = now;
+
+    double ms = (double)(now - trace_start) / 1000.0;
+    g_print("STARTUP-TRACE: %.1f ms %s\n", ms, event);
+}
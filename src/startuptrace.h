@@ -0,0 +1,17 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Time-to-first-frame tracing, enabled by BRIGHTEYES_STARTUP_TRACE. Each
+ * mark prints the milliseconds since the first mark (made at the top of
+ * main) as "STARTUP-TRACE: <ms> ms <event>". Does nothing when disabled. */
+void startup_trace_mark(const char *event);
+
+gboolean startup_trace_enabled(void);
+
+G_END_DECLS
+
+#endif /* STARTUPTRACE_H */
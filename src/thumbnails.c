@@ -1,18 +1,68 @@
 #include "thumbnails.h"
 #include <gdk-pixbuf/gdk-pixbuf.h>
-#include <gst/gst.h>
+#include <glib/gstdio.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "imageservice.h"
 #include "archive.h"
+#include "videothumb.h"
+#include "metrics.h"
+#include "pixelops.h"
+#include "dupindex.h"
+#include "membudget.h"
 
 /* Thumbnails (UI)
  *
  * Implements the thumbnail list UI used by the main window.
  * - ThumbnailItem: lightweight GObject holding a file path and paintable.
  * - ThumbnailsBar: container that manages the grid/list and async loading.
+ * - Caching: a session LRU of paintables backed by PNGs on disk following
+ *   the freedesktop thumbnail spec (~/.cache/thumbnails/{normal,large,x-large}).
+ *   Archive pages have no real URI and live under ~/.cache/brighteyes/thumbnails.
+ * - Memory: the LRU is accounted to the process memory budget; under
+ *   pressure it is trimmed oldest first and rows off screen drop theirs.
+ * - Tiers: thumbnails come in 128/256/512px sizes. The bar picks the tier
+ *   matching its scale factor, and a smaller tier is scaled down from a
+ *   larger one already in memory or on disk instead of decoding the source.
+ * - Scheduling: a single pool sized to the core count runs all decode work,
+ *   nearest to the viewport first; unbound items have their jobs cancelled.
+ * - Duplicates: a header toggle starts a DupIndex for the curator and then
+ *   shows only files with a duplicate in the list, sorted by group, with
+ *   their matches in other folders in the tooltip. The view filters and
+ *   sorts the store, which keeps mirroring the curator unchanged.
  *
- * Sections: ThumbnailItem, helpers, lifecycle (init/dispose), and bar API.
+ * Sections: ThumbnailItem, helpers, disk cache, scheduler, duplicates,
+ * lifecycle (init/dispose), and bar API.
  */
 
+/* Size tiers, in the freedesktop layout. Thumbnails are drawn in a box of
+ * THUMBNAIL_DISPLAY_SIZE logical pixels, so HiDPI outputs use a larger tier. */
+#define THUMBNAIL_DISPLAY_SIZE 128
+
+typedef struct {
+    int size;
+    const char *dir;
+} ThumbnailTier;
+
+static const ThumbnailTier thumbnail_tiers[] = {
+    { 128, "normal" },
+    { 256, "large" },
+    { 512, "x-large" },
+};
+
+/* Smallest tier that is not upscaled at the given scale factor */
+static int
+thumbnail_tier_for_scale(int scale)
+{
+    int wanted = THUMBNAIL_DISPLAY_SIZE * MAX(scale, 1);
+    for (guint i = 0; i < G_N_ELEMENTS(thumbnail_tiers); i++) {
+        if (thumbnail_tiers[i].size >= wanted) return thumbnail_tiers[i].size;
+    }
+    return thumbnail_tiers[G_N_ELEMENTS(thumbnail_tiers) - 1].size;
+}
+
 /* --- ThumbnailItem Object --- */
 
 #define TYPE_THUMBNAIL_ITEM (thumbnail_item_get_type())
@@ -24,6 +74,11 @@ struct _ThumbnailItem {
     GdkPaintable *paintable;
     gboolean loading;
     guint load_timeout_id; /* non-zero when a delayed load is scheduled */
+    guint position;        /* Index in the bar's store, used for scheduling */
+    GCancellable *cancellable; /* Set while a job is queued or running */
+    int size;              /* Tier wanted by the bar */
+    int loaded_size;       /* Tier of paintable, 0 when there is none */
+    gboolean bound;        /* Shown by a list item widget */
 };
 
 enum {
@@ -48,6 +103,7 @@ thumbnail_item_finalize(GObject *object)
     }
     g_free(self->path);
     g_clear_object(&self->paintable);
+    g_clear_object(&self->cancellable);
     G_OBJECT_CLASS(thumbnail_item_parent_class)->finalize(object);
 } 
 
@@ -94,35 +150,7 @@ static void
 thumbnail_item_init(ThumbnailItem *self) {
     self->loading = FALSE;
     self->load_timeout_id = 0;
-}
-
-static void on_pixbuf_loaded(GObject *source, GAsyncResult *res, gpointer user_data);
-
-static void
-on_archive_thumbnail_bytes_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
-{
-    ThumbnailItem *self = BRIGHTEYES_THUMBNAIL_ITEM(user_data);
-    GError *err = NULL;
-    GBytes *bytes = archive_read_entry_bytes_finish(res, &err);
-    
-    if (bytes) {
-        gsize size = g_bytes_get_size(bytes);
-        const guint8 *data = g_bytes_get_data(bytes, NULL);
-        guint8 *copy = g_malloc(size);
-        memcpy(copy, data, size);
-        GInputStream *mem = g_memory_input_stream_new_from_data(copy, (gssize)size, g_free);
-        g_bytes_unref(bytes);
-        
-        gdk_pixbuf_new_from_stream_at_scale_async(G_INPUT_STREAM(mem), 128, 128, TRUE, NULL, on_pixbuf_loaded, self);
-        g_object_unref(mem);
-    } else {
-        if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-             g_warning("Failed to load archive thumb %s: %s", self->path, err->message);
-        }
-        g_clear_error(&err);
-        self->loading = FALSE;
-        g_object_unref(self);
-    }
+    self->size = thumbnail_tiers[0].size;
 }
 
 static ThumbnailItem *
@@ -130,36 +158,56 @@ thumbnail_item_new(const char *path) {
     return g_object_new(TYPE_THUMBNAIL_ITEM, "path", path, NULL);
 }
 
-/* Video thumbnail worker pool - limits concurrency for expensive work */
-static GThreadPool *video_thread_pool = NULL;
-static void video_pool_worker(gpointer data, gpointer user_data);
+/* Thumbnail scheduler: one pool sized to the core count runs every job (disk
+ * tier lookup, image, archive page or video frame decode). Queued jobs are
+ * ordered by distance from the item at the centre of the viewport and are
+ * re-sorted when scrolling moves that centre. */
+static GThreadPool *thumb_pool = NULL;
+static gint thumb_view_center = 0; /* Store index at the viewport centre */
+static void thumb_pool_worker(gpointer data, gpointer user_data);
 static void thumbnail_item_ensure_loaded(ThumbnailItem *self);
 static gboolean thumbnail_load_timeout_cb(gpointer user_data);
 
-/* LRU in-memory cache for paintables (session only). Key is path + mtime+size. */
-static GHashTable *thumbnail_cache_map = NULL; /* key (char*) -> GdkPaintable* */
-static GQueue *thumbnail_cache_lru = NULL;     /* queue of key pointers in LRU order */
-static guint thumbnail_cache_max_entries = 256;
+/* LRU in-memory cache for paintables (session only). Key is path + mtime+size
+ * + tier.
+ * Bounded by decoded bytes (BRIGHTEYES_THUMBNAIL_CACHE_MB, default 32). When
+ * BRIGHTEYES_THUMBNAIL_CACHE_COMPRESSED_MB is set, evicted entries move to a
+ * second tier holding PNG bytes, which is much denser than decoded pixels. */
+typedef struct {
+    char *key;
+    GdkPaintable *paintable; /* Decoded tier */
+    GBytes *png;             /* Compressed tier */
+    gsize bytes;
+    GList link;              /* Node in the tier's queue; data points to the entry */
+} LruEntry;
+
+typedef struct {
+    GHashTable *map;  /* key -> LruEntry* (owned) */
+    GQueue queue;     /* Least recently used first */
+    gsize bytes;
+    gsize budget;
+} LruTier;
+
+static LruTier thumbnail_cache = { NULL, G_QUEUE_INIT, 0, 0 };
+static LruTier thumbnail_cache_compressed = { NULL, G_QUEUE_INIT, 0, 0 };
 static void lru_cache_init(void);
-static gchar *make_cache_key(const char *path);
+static gchar *make_cache_key(const char *path, int size);
 static GdkPaintable *lru_cache_get(const char *key);
 static void lru_cache_put(const char *key, GdkPaintable *paintable);
 static void lru_cache_destroy(void);
 
-/* --- Instrumentation counters (optional; enabled by env) --- */
-static guint instr_cache_hits = 0;
-static guint instr_cache_misses = 0;
-static guint instr_ignored_notifies = 0;
-static guint instr_video_tasks_started = 0;
-static guint instr_video_tasks_completed = 0;
+/* Persistent PNG tier (freedesktop thumbnail spec) */
+static GThreadPool *disk_write_pool = NULL;
+static void disk_cache_store(const char *path, int size, GdkPixbuf *pixbuf);
+
+/* --- Instrumentation (counters live in metrics.c; the summary is printed
+ * when BRIGHTEYES_THUMBNAILS_DEBUG is set) --- */
 static gboolean instrumentation_enabled = FALSE;
 static void instrumentation_init(void);
 static void thumbnails_print_instrumentation(void);
 
 /* Forward declare helper */
-static gboolean is_video(const char *path);
 static void on_item_destroyed(gpointer data, GObject *where);
-static void on_pixbuf_loaded(GObject *source, GAsyncResult *res, gpointer user_data);
 
 static GdkTexture *
 texture_from_pixbuf(GdkPixbuf *pixbuf) {
@@ -180,24 +228,136 @@ texture_from_pixbuf(GdkPixbuf *pixbuf) {
     return texture;
 }
 
+static void
+lru_entry_free(LruEntry *entry)
+{
+    g_clear_object(&entry->paintable);
+    g_clear_pointer(&entry->png, g_bytes_unref);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+static gsize
+budget_from_env(const char *name, gsize default_mb)
+{
+    const char *env = g_getenv(name);
+    if (env && *env) return (gsize)g_ascii_strtoull(env, NULL, 10) * 1024 * 1024;
+    return default_mb * 1024 * 1024;
+}
+
+static void lru_cache_shed(MemShedLevel level, gsize excess, gpointer user_data);
+
 static void
 lru_cache_init(void)
 {
-    if (thumbnail_cache_map) return;
-    thumbnail_cache_map = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
-    thumbnail_cache_lru = g_queue_new();
+    static guint shedder_id = 0;
+    if (!shedder_id)
+        shedder_id = mem_budget_add_shedder(MEM_POOL_THUMBNAILS, lru_cache_shed, NULL);
+
+    if (thumbnail_cache.map) return;
+    thumbnail_cache.map = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)lru_entry_free);
+    thumbnail_cache.budget = budget_from_env("BRIGHTEYES_THUMBNAIL_CACHE_MB", 32);
+    thumbnail_cache_compressed.map = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)lru_entry_free);
+    thumbnail_cache_compressed.budget = budget_from_env("BRIGHTEYES_THUMBNAIL_CACHE_COMPRESSED_MB", 0);
 
     /* Initialize instrumentation lazily whenever cache is used */
     instrumentation_init();
 }
 
+static void
+lru_tier_unlink(LruTier *tier, LruEntry *entry)
+{
+    g_queue_unlink(&tier->queue, &entry->link);
+    tier->bytes -= entry->bytes;
+    mem_budget_add(MEM_POOL_THUMBNAILS, -(gssize)entry->bytes);
+    g_hash_table_steal(tier->map, entry->key);
+}
+
+static void
+lru_tier_remove(LruTier *tier, LruEntry *entry)
+{
+    lru_tier_unlink(tier, entry);
+    lru_entry_free(entry);
+}
+
+static void
+lru_tier_push(LruTier *tier, LruEntry *entry)
+{
+    entry->link.data = entry;
+    g_hash_table_insert(tier->map, entry->key, entry);
+    g_queue_push_tail_link(&tier->queue, &entry->link);
+    tier->bytes += entry->bytes;
+    mem_budget_add(MEM_POOL_THUMBNAILS, (gssize)entry->bytes);
+}
+
+static void
+lru_tier_touch(LruTier *tier, LruEntry *entry)
+{
+    g_queue_unlink(&tier->queue, &entry->link);
+    g_queue_push_tail_link(&tier->queue, &entry->link);
+}
+
+static gsize
+paintable_bytes(GdkPaintable *paintable)
+{
+    /* Memory textures built by texture_from_pixbuf keep RGB(A) pixels alive */
+    if (GDK_IS_TEXTURE(paintable))
+        return (gsize)gdk_texture_get_width(GDK_TEXTURE(paintable)) * gdk_texture_get_height(GDK_TEXTURE(paintable)) * 4;
+    return (gsize)gdk_paintable_get_intrinsic_width(paintable) * gdk_paintable_get_intrinsic_height(paintable) * 4;
+}
+
+/* Memory budget: the compressed tier holds the oldest entries, so it goes
+ * first. Paintables still shown by rows stay alive through their items. */
+static void
+lru_cache_shed(MemShedLevel level, gsize excess, gpointer user_data)
+{
+    LruTier *tiers[] = { &thumbnail_cache_compressed, &thumbnail_cache };
+    gsize freed = 0;
+    for (guint i = 0; i < G_N_ELEMENTS(tiers); i++) {
+        while (tiers[i]->queue.head && (level != MEM_SHED_TRIM || freed < excess)) {
+            LruEntry *old = tiers[i]->queue.head->data;
+            freed += old->bytes;
+            lru_tier_remove(tiers[i], old);
+        }
+    }
+}
+
+static void
+lru_compressed_evict(void)
+{
+    while (thumbnail_cache_compressed.bytes > thumbnail_cache_compressed.budget && thumbnail_cache_compressed.queue.head)
+        lru_tier_remove(&thumbnail_cache_compressed, thumbnail_cache_compressed.queue.head->data);
+}
+
+/* Evict least recently used decoded entries; demote them to PNG bytes when
+ * the compressed tier is enabled. */
+static void
+lru_cache_evict(void)
+{
+    while (thumbnail_cache.bytes > thumbnail_cache.budget && thumbnail_cache.queue.head) {
+        LruEntry *old = thumbnail_cache.queue.head->data;
+        lru_tier_unlink(&thumbnail_cache, old);
+
+        if (thumbnail_cache_compressed.budget > 0 && GDK_IS_TEXTURE(old->paintable)) {
+            old->png = gdk_texture_save_to_png_bytes(GDK_TEXTURE(old->paintable));
+            g_clear_object(&old->paintable);
+            old->bytes = old->png ? g_bytes_get_size(old->png) : 0;
+            if (old->png && old->bytes <= thumbnail_cache_compressed.budget) {
+                lru_tier_push(&thumbnail_cache_compressed, old);
+                continue;
+            }
+        }
+        lru_entry_free(old);
+    }
+    lru_compressed_evict();
+}
+
 static void
 instrumentation_init(void)
 {
     if (instrumentation_enabled) return;
     if (g_getenv("BRIGHTEYES_THUMBNAILS_DEBUG") != NULL) {
         instrumentation_enabled = TRUE;
-        g_info("THUMBS-INSTR: instrumentation enabled");
         g_print("THUMBS-INSTR: instrumentation enabled\n");
     }
 }
@@ -206,17 +366,30 @@ static void
 thumbnails_print_instrumentation(void)
 {
     if (!instrumentation_enabled) return;
-    g_info("THUMBS-INSTR: cache_hits=%u cache_misses=%u ignored_notifies=%u video_started=%u video_completed=%u",
-           instr_cache_hits, instr_cache_misses, instr_ignored_notifies, instr_video_tasks_started, instr_video_tasks_completed);
+
+    GVariant *snapshot = g_variant_ref_sink(metrics_snapshot());
+    gint64 hits = 0, misses = 0, ignored = 0, started = 0, completed = 0;
+    g_variant_lookup(snapshot, "thumb-cache-hits", "x", &hits);
+    g_variant_lookup(snapshot, "thumb-cache-misses", "x", &misses);
+    g_variant_lookup(snapshot, "thumb-ignored-notifies", "x", &ignored);
+    g_variant_lookup(snapshot, "video-thumbs-started", "x", &started);
+    g_variant_lookup(snapshot, "video-thumbs-completed", "x", &completed);
+    g_variant_unref(snapshot);
+
+    /* stdout only, like STARTUP-TRACE, so G_MESSAGES_DEBUG does not double it */
+    g_print("THUMBS-INSTR: cache_hits=%" G_GINT64_FORMAT " cache_misses=%" G_GINT64_FORMAT
+            " ignored_notifies=%" G_GINT64_FORMAT " video_started=%" G_GINT64_FORMAT
+            " video_completed=%" G_GINT64_FORMAT "\n",
+            hits, misses, ignored, started, completed);
 }
 
 static gchar *
-make_cache_key(const char *path)
+make_cache_key(const char *path, int size)
 {
     if (!path) return NULL;
     struct stat st;
-    if (stat(path, &st) != 0) return g_strdup(path); /* fallback to path only */
-    return g_strdup_printf("%s:%llu:%llu", path, (unsigned long long)st.st_mtime, (unsigned long long)st.st_size);
+    if (stat(path, &st) != 0) return g_strdup_printf("%s@%d", path, size); /* fallback to path only */
+    return g_strdup_printf("%s:%llu:%llu@%d", path, (unsigned long long)st.st_mtime, (unsigned long long)st.st_size, size);
 }
 
 static GdkPaintable *
@@ -224,21 +397,27 @@ lru_cache_get(const char *key)
 {
     if (!key) return NULL;
     lru_cache_init();
-    gpointer actual_key = NULL;
-    gpointer val = NULL;
-    if (g_hash_table_lookup_extended(thumbnail_cache_map, key, &actual_key, &val)) {
-        /* Move key to tail (most-recent) */
-        g_queue_remove(thumbnail_cache_lru, actual_key);
-        g_queue_push_tail(thumbnail_cache_lru, actual_key);
-        g_object_ref(val);
-        if (instrumentation_enabled) {
-            instr_cache_hits++;
-            g_info("THUMBS-INSTR: cache hit -> %s (hits=%u)", key, instr_cache_hits);
-            g_print("THUMBS-INSTR: cache hit -> %s (hits=%u)\n", key, instr_cache_hits);
-        }
-        return GDK_PAINTABLE(val);
+
+    LruEntry *entry = g_hash_table_lookup(thumbnail_cache.map, key);
+    if (entry) {
+        /* Move to tail (most-recent) in O(1) */
+        lru_tier_touch(&thumbnail_cache, entry);
+    } else {
+        LruEntry *packed = g_hash_table_lookup(thumbnail_cache_compressed.map, key);
+        if (!packed) return NULL;
+
+        /* Promote back to the decoded tier */
+        GdkTexture *texture = gdk_texture_new_from_bytes(packed->png, NULL);
+        lru_tier_remove(&thumbnail_cache_compressed, packed);
+        if (!texture) return NULL;
+        lru_cache_put(key, GDK_PAINTABLE(texture));
+        g_object_unref(texture);
+        entry = g_hash_table_lookup(thumbnail_cache.map, key);
+        if (!entry) return NULL;
     }
-    return NULL;
+
+    metrics_count(METRICS_THUMB_CACHE_HIT);
+    return g_object_ref(entry->paintable);
 }
 
 static void
@@ -247,166 +426,367 @@ lru_cache_put(const char *key, GdkPaintable *paintable)
     if (!key || !paintable) return;
     lru_cache_init();
 
-    gpointer actual_key = NULL;
-    gpointer val = NULL;
-    if (g_hash_table_lookup_extended(thumbnail_cache_map, key, &actual_key, &val)) {
-        /* Replace value (hash table will unref old one via destroy notify) */
-        g_hash_table_insert(thumbnail_cache_map, actual_key, g_object_ref(paintable));
-        /* Move key to tail */
-        g_queue_remove(thumbnail_cache_lru, actual_key);
-        g_queue_push_tail(thumbnail_cache_lru, actual_key);
-    } else {
-        char *kdup = g_strdup(key);
-        g_hash_table_insert(thumbnail_cache_map, kdup, g_object_ref(paintable));
-        g_queue_push_tail(thumbnail_cache_lru, kdup);
-    }
+    LruEntry *old = g_hash_table_lookup(thumbnail_cache.map, key);
+    if (old) lru_tier_remove(&thumbnail_cache, old);
+    old = g_hash_table_lookup(thumbnail_cache_compressed.map, key);
+    if (old) lru_tier_remove(&thumbnail_cache_compressed, old);
 
-    /* Evict if needed */
-    while (g_hash_table_size(thumbnail_cache_map) > thumbnail_cache_max_entries) {
-        char *old_key = g_queue_pop_head(thumbnail_cache_lru);
-        if (old_key) {
-            g_hash_table_remove(thumbnail_cache_map, old_key);
-            /* g_hash_table_remove will free the key and unref the value */
-        }
-    }
+    LruEntry *entry = g_new0(LruEntry, 1);
+    entry->key = g_strdup(key);
+    entry->paintable = g_object_ref(paintable);
+    entry->bytes = paintable_bytes(paintable);
+    lru_tier_push(&thumbnail_cache, entry);
+
+    lru_cache_evict();
 }
 
 static void
 lru_cache_destroy(void)
 {
-    if (thumbnail_cache_map) {
-        g_hash_table_destroy(thumbnail_cache_map);
-        thumbnail_cache_map = NULL;
-    }
-    if (thumbnail_cache_lru) {
-        g_queue_free(thumbnail_cache_lru);
-        thumbnail_cache_lru = NULL;
+    mem_budget_add(MEM_POOL_THUMBNAILS, -(gssize)(thumbnail_cache.bytes + thumbnail_cache_compressed.bytes));
+    g_queue_init(&thumbnail_cache.queue);
+    g_clear_pointer(&thumbnail_cache.map, g_hash_table_destroy);
+    thumbnail_cache.bytes = 0;
+    g_queue_init(&thumbnail_cache_compressed.queue);
+    g_clear_pointer(&thumbnail_cache_compressed.map, g_hash_table_destroy);
+    thumbnail_cache_compressed.bytes = 0;
+}
+
+GdkPaintable *
+thumbnail_cache_lookup(const char *path)
+{
+    /* Largest first: it makes the sharpest stand-in */
+    GdkPaintable *paintable = NULL;
+    for (int i = G_N_ELEMENTS(thumbnail_tiers) - 1; i >= 0 && !paintable; i--) {
+        gchar *key = make_cache_key(path, thumbnail_tiers[i].size);
+        paintable = lru_cache_get(key);
+        g_free(key);
     }
+    return paintable;
 }
 
+/* --- Disk cache (freedesktop thumbnail spec) --- */
 
+/* pixbuf itself when it fits a size x size box, else a scaled-down copy */
+static GdkPixbuf *
+fit_pixbuf(GdkPixbuf *pixbuf, int size)
+{
+    int w = gdk_pixbuf_get_width(pixbuf);
+    int h = gdk_pixbuf_get_height(pixbuf);
+    if (w <= size && h <= size) return g_object_ref(pixbuf);
 
-static void
-create_video_thumbnail_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
-    char *path = (char *)task_data;
-    GError *err = NULL;
+    double scale = (double)size / MAX(w, h);
+    return pixel_ops_scale_down(pixbuf, MAX(1, (int)(w * scale)), MAX(1, (int)(h * scale)));
+}
 
-    if (!gst_is_initialized()) gst_init(NULL, NULL);
+static const char *
+tier_dir(int size)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(thumbnail_tiers); i++) {
+        if (thumbnail_tiers[i].size == size) return thumbnail_tiers[i].dir;
+    }
+    return thumbnail_tiers[0].dir;
+}
 
-    if (!path || path[0] == '\0') {
-        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED, "Invalid path");
-        return;
+/* URI and mtime recorded in the PNG's Thumb::URI / Thumb::MTime keys. Archive
+ * pages use their virtual path as URI and the archive's mtime. */
+static gboolean
+thumbnail_source_info(const char *path, char **uri, gint64 *mtime)
+{
+    GStatBuf st;
+
+    char *arch_path = NULL, *entry_name = NULL;
+    if (archive_split_path(path, &arch_path, &entry_name)) {
+        int rc = g_stat(arch_path, &st);
+        g_free(arch_path);
+        g_free(entry_name);
+        if (rc != 0) return FALSE;
+        *uri = g_strdup(path);
+    } else {
+        if (g_stat(path, &st) != 0) return FALSE;
+        *uri = g_filename_to_uri(path, NULL, NULL);
+        if (!*uri) return FALSE;
+    }
+    *mtime = (gint64)st.st_mtime;
+    return TRUE;
+}
+
+static char *
+disk_thumbnail_file(const char *path, const char *uri, const char *size_dir)
+{
+    char *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+    char *name = g_strconcat(md5, ".png", NULL);
+    char *file;
+    if (g_str_has_prefix(path, "archive://"))
+        file = g_build_filename(g_get_user_cache_dir(), "brighteyes", "thumbnails", size_dir, name, NULL);
+    else
+        file = g_build_filename(g_get_user_cache_dir(), "thumbnails", size_dir, name, NULL);
+    g_free(name);
+    g_free(md5);
+    return file;
+}
+
+/* Load a cached thumbnail if it is still valid for the source: the tier for
+ * size itself, or a larger one scaled down. */
+static GdkPixbuf *
+disk_cache_read(const char *path, int size)
+{
+    char *uri = NULL;
+    gint64 mtime = 0;
+    if (!thumbnail_source_info(path, &uri, &mtime)) return NULL;
+
+    GdkPixbuf *result = NULL;
+    for (guint i = 0; i < G_N_ELEMENTS(thumbnail_tiers) && !result; i++) {
+        if (thumbnail_tiers[i].size < size) continue;
+        char *file = disk_thumbnail_file(path, uri, thumbnail_tiers[i].dir);
+        GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(file, NULL);
+        g_free(file);
+        if (!pixbuf) continue;
+
+        const char *thumb_uri = gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::URI");
+        const char *thumb_mtime = gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::MTime");
+        if (g_strcmp0(thumb_uri, uri) != 0 || !thumb_mtime ||
+            g_ascii_strtoll(thumb_mtime, NULL, 10) != mtime) {
+            g_object_unref(pixbuf); /* Stale: the source changed since */
+            continue;
+        }
+
+        result = fit_pixbuf(pixbuf, size);
+        g_object_unref(pixbuf);
     }
 
-    gchar *uri = g_filename_to_uri(path, NULL, NULL);
-    /* Request 128px width, variable height to preserve aspect ratio. */
-    gchar *pipeline_cmd = g_strdup_printf(
-        "uridecodebin uri=\"%s\" ! videoconvert ! videoscale ! video/x-raw,width=128,pixel-aspect-ratio=1/1 ! gdkpixbufsink name=sink",
-        uri
-    );
     g_free(uri);
+    return result;
+}
 
-    GstElement *pipeline = gst_parse_launch(pipeline_cmd, &err);
-    g_free(pipeline_cmd);
+typedef struct {
+    char *path;
+    GdkPixbuf *pixbuf;
+    int size;
+} DiskWriteJob;
 
-    if (!pipeline) {
-        g_task_return_error(task, err);
-        return;
+/* Writer thread: save the PNG under a temporary name then rename it, as the
+ * spec requires, so other readers never see a partial file. */
+static void
+disk_write_worker(gpointer data, gpointer user_data)
+{
+    DiskWriteJob *job = data;
+    char *uri = NULL;
+    gint64 mtime = 0;
+
+    if (thumbnail_source_info(job->path, &uri, &mtime)) {
+        /* Video frames are size wide; tall ones must still fit the box */
+        GdkPixbuf *pixbuf = fit_pixbuf(job->pixbuf, job->size);
+
+        char *file = disk_thumbnail_file(job->path, uri, tier_dir(job->size));
+        char *dir = g_path_get_dirname(file);
+        g_mkdir_with_parents(dir, 0700);
+        g_free(dir);
+
+        char *tmp = g_strconcat(file, ".XXXXXX", NULL);
+        int fd = g_mkstemp_full(tmp, O_RDWR, 0600);
+        if (fd >= 0) {
+            close(fd);
+            char *mtime_str = g_strdup_printf("%" G_GINT64_FORMAT, mtime);
+            if (gdk_pixbuf_save(pixbuf, tmp, "png", NULL,
+                                "tEXt::Thumb::URI", uri,
+                                "tEXt::Thumb::MTime", mtime_str,
+                                "tEXt::Software", "BrightEyes",
+                                NULL) && g_rename(tmp, file) == 0) {
+                /* Written */
+            } else {
+                g_unlink(tmp);
+            }
+            g_free(mtime_str);
+        }
+
+        g_free(tmp);
+        g_free(file);
+        g_object_unref(pixbuf);
+        g_free(uri);
     }
 
-    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
-    
-    gst_element_set_state(pipeline, GST_STATE_PAUSED);
-    GstStateChangeReturn ret = gst_element_get_state(pipeline, NULL, NULL, 5 * GST_SECOND);
+    g_object_unref(job->pixbuf);
+    g_free(job->path);
+    g_free(job);
+}
 
-    GdkPixbuf *pixbuf = NULL;
-    if (ret == GST_STATE_CHANGE_SUCCESS || ret == GST_STATE_CHANGE_NO_PREROLL) {
-        g_object_get(sink, "last-pixbuf", &pixbuf, NULL);
-    } 
+static void
+disk_cache_store(const char *path, int size, GdkPixbuf *pixbuf)
+{
+    /* Called from the thumbnail pool threads */
+    if (g_once_init_enter(&disk_write_pool))
+        g_once_init_leave(&disk_write_pool, g_thread_pool_new(disk_write_worker, NULL, 1, FALSE, NULL));
+
+    DiskWriteJob *job = g_new0(DiskWriteJob, 1);
+    job->path = g_strdup(path);
+    job->pixbuf = g_object_ref(pixbuf);
+    job->size = size;
+    g_thread_pool_push(disk_write_pool, job, NULL);
+}
 
-    gst_element_set_state(pipeline, GST_STATE_NULL);
-    gst_object_unref(pipeline);
-    if (sink) gst_object_unref(sink);
+/* Decode a thumbnail from the source (runs in a pool thread). Images go
+ * through the image service, which scales a full decode the viewer or the
+ * prefetcher already has instead of decoding the file again. */
+static GdkPixbuf *
+decode_thumbnail(const char *path, int size, GCancellable *cancellable, GError **error)
+{
+    if (archive_is_video_path(path))
+        return video_thumbnail_capture(path, size, cancellable, error);
 
-    if (!pixbuf) {
-         g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to capture video frame");
-    } else {
-        g_task_return_pointer(task, pixbuf, g_object_unref);
+    if (g_str_has_prefix(path, "archive://") && !strstr(path, "::")) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid archive path");
+        return NULL;
     }
+    return image_service_request(path, size, cancellable, error);
+}
+
+GdkPixbuf *
+thumbnail_load_pixbuf(const char *path, int size, GCancellable *cancellable, GError **error)
+{
+    GdkPixbuf *pixbuf = disk_cache_read(path, size);
+    if (pixbuf) return pixbuf;
+
+    pixbuf = decode_thumbnail(path, size, cancellable, error);
+    if (pixbuf)
+        disk_cache_store(path, size, pixbuf);
+    return pixbuf;
 }
 
-/* Worker wrapper to execute GTask-based video thumbnail jobs inside a bounded pool. */
+typedef struct {
+    char *path;
+    int size;
+    GdkTexture *source; /* Larger tier to scale down, or NULL */
+} ThumbJob;
+
 static void
-video_pool_worker(gpointer data, gpointer user_data)
+thumb_job_free(ThumbJob *job)
 {
-    GTask *task = G_TASK(data);
-    /* Reuse the same thread function implementation to perform work */
-    create_video_thumbnail_thread(task,
-                                 g_task_get_source_object(task),
-                                 g_task_get_task_data(task),
-                                 g_task_get_cancellable(task));
-    /* Worker owned reference - drop it now that the task has returned */
-    g_object_unref(task);
+    g_free(job->path);
+    g_clear_object(&job->source);
+    g_free(job);
+}
+
+/* Memory textures are immutable, so reading one back is safe off the main thread */
+static GdkPixbuf *
+pixbuf_from_texture(GdkTexture *texture)
+{
+    GdkTextureDownloader *downloader = gdk_texture_downloader_new(texture);
+    gdk_texture_downloader_set_format(downloader, GDK_MEMORY_R8G8B8A8);
+    gsize stride = 0;
+    GBytes *bytes = gdk_texture_downloader_download_bytes(downloader, &stride);
+    gdk_texture_downloader_free(downloader);
+
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_bytes(bytes, GDK_COLORSPACE_RGB, TRUE, 8,
+                                                  gdk_texture_get_width(texture),
+                                                  gdk_texture_get_height(texture), (int)stride);
+    g_bytes_unref(bytes);
+    return pixbuf;
 }
 
+/* Job body: a larger tier from memory if the job carries one, else the
+ * persistent tier, else a full decode whose result is queued for the disk
+ * writer. Jobs cancelled while queued return at once. */
 static void
-on_video_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
+thumbnail_job_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
 {
-    ThumbnailItem *self = BRIGHTEYES_THUMBNAIL_ITEM(source);
+    ThumbJob *job = task_data;
     GError *err = NULL;
-    GdkPixbuf *pixbuf = g_task_propagate_pointer(G_TASK(res), &err);
 
-    self->loading = FALSE;
-    
-    if (pixbuf) {
-        GdkTexture *texture = texture_from_pixbuf(pixbuf);
-        gchar *key = make_cache_key(self->path);
-        if (key) {
-            lru_cache_put(key, GDK_PAINTABLE(texture));
-            g_free(key);
-        }
-        g_object_set(self, "paintable", texture, NULL);
-        g_object_unref(texture);
-        g_object_unref(pixbuf);
-    } else {
-        g_clear_error(&err);
+    if (g_cancellable_set_error_if_cancelled(cancellable, &err)) {
+        g_task_return_error(task, err);
+        return;
     }
 
-    if (instrumentation_enabled) {
-        instr_video_tasks_completed++;
-        g_info("THUMBS-INSTR: video task completed for %s (completed=%u)", self->path ? self->path : "(null)", instr_video_tasks_completed);
-        g_print("THUMBS-INSTR: video task completed for %s (completed=%u)\n", self->path ? self->path : "(null)", instr_video_tasks_completed);
+    if (job->source) {
+        GdkPixbuf *larger = pixbuf_from_texture(job->source);
+        GdkPixbuf *pixbuf = fit_pixbuf(larger, job->size);
+        g_object_unref(larger);
+        g_task_return_pointer(task, pixbuf, g_object_unref);
+        return;
     }
 
-    g_object_unref(self);
+    GdkPixbuf *pixbuf = thumbnail_load_pixbuf(job->path, job->size, cancellable, &err);
+    if (pixbuf)
+        g_task_return_pointer(task, pixbuf, g_object_unref);
+    else
+        g_task_return_error(task, err);
 }
 
+/* Worker wrapper to execute GTask-based thumbnail jobs inside the bounded pool. */
 static void
-on_pixbuf_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
+thumb_pool_worker(gpointer data, gpointer user_data)
 {
-    ThumbnailItem *self = BRIGHTEYES_THUMBNAIL_ITEM(user_data);
+    GTask *task = G_TASK(data);
+    metrics_gauge_set(METRICS_THUMB_QUEUE_DEPTH, (int)g_thread_pool_unprocessed(thumb_pool));
+    thumbnail_job_thread(task,
+                         g_task_get_source_object(task),
+                         g_task_get_task_data(task),
+                         g_task_get_cancellable(task));
+    /* Worker owned reference - drop it now that the task has returned */
+    g_object_unref(task);
+}
+
+/* Queue order: closest to the viewport centre first. */
+static gint
+thumb_job_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    ThumbnailItem *ia = g_task_get_source_object(G_TASK(a));
+    ThumbnailItem *ib = g_task_get_source_object(G_TASK(b));
+    gint center = g_atomic_int_get(&thumb_view_center);
+    guint da = (guint)ABS((gint)ia->position - center);
+    guint db = (guint)ABS((gint)ib->position - center);
+    return (da > db) - (da < db);
+}
+
+static void
+thumb_scheduler_set_center(gint index)
+{
+    if (g_atomic_int_get(&thumb_view_center) == index) return;
+    g_atomic_int_set(&thumb_view_center, index);
+    /* Setting the sort function re-sorts the jobs that haven't started yet */
+    if (thumb_pool)
+        g_thread_pool_set_sort_function(thumb_pool, thumb_job_compare, NULL);
+}
+
+static void
+on_thumbnail_job_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    ThumbnailItem *self = BRIGHTEYES_THUMBNAIL_ITEM(source);
+    ThumbJob *job = g_task_get_task_data(G_TASK(res));
     GError *err = NULL;
-    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream_finish(res, &err);
-    
-    self->loading = FALSE;
+    GdkPixbuf *pixbuf = g_task_propagate_pointer(G_TASK(res), &err);
+
+    /* An unbind may have cancelled this job and a rebind queued a new one */
+    if (g_task_get_cancellable(G_TASK(res)) == self->cancellable) {
+        self->loading = FALSE;
+        g_clear_object(&self->cancellable);
+    }
 
     if (pixbuf) {
         GdkTexture *texture = texture_from_pixbuf(pixbuf);
-        gchar *key = make_cache_key(self->path);
+        gchar *key = make_cache_key(self->path, job->size);
         if (key) {
-             lru_cache_put(key, GDK_PAINTABLE(texture));
-             g_free(key);
+            lru_cache_put(key, GDK_PAINTABLE(texture));
+            g_free(key);
         }
+        self->loaded_size = job->size;
         g_object_set(self, "paintable", texture, NULL);
         g_object_unref(texture);
         g_object_unref(pixbuf);
+
+        /* The bar moved to another tier while this one was loading */
+        if (self->bound && self->loaded_size < self->size)
+            thumbnail_item_ensure_loaded(self);
     } else {
-         if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-             /* g_warning("Failed to load thumbnail pixbuf: %s", err ? err->message : "?"); */
-         }
-         g_clear_error(&err);
+        if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            /* g_warning("Failed to load thumbnail %s: %s", self->path, err ? err->message : "?"); */
+        }
+        g_clear_error(&err);
     }
-    g_object_unref(self);
+
+    if (metrics_get_enabled() && archive_is_video_path(self->path))
+        metrics_count(METRICS_VIDEO_THUMB_COMPLETED);
 }
 
 /* Delayed load callback used to debounce loads while the user is scrolling. */
@@ -420,36 +800,45 @@ thumbnail_load_timeout_cb(gpointer user_data)
     return G_SOURCE_REMOVE;
 }
 
+/* A cached texture of a tier larger than the item wants, or NULL */
+static GdkTexture *
+lru_cache_get_larger(const char *path, int size)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(thumbnail_tiers); i++) {
+        if (thumbnail_tiers[i].size <= size) continue;
+        gchar *key = make_cache_key(path, thumbnail_tiers[i].size);
+        GdkPaintable *cached = lru_cache_get(key);
+        g_free(key);
+        if (cached && GDK_IS_TEXTURE(cached)) return GDK_TEXTURE(cached);
+        g_clear_object(&cached);
+    }
+    return NULL;
+}
+
 static gboolean
-is_video(const char *path) {
-    const char *ext = strrchr(path, '.');
-    if (!ext) return FALSE;
-    return (g_ascii_strcasecmp(ext, ".mp4") == 0 || g_ascii_strcasecmp(ext, ".mkv") == 0 ||
-            g_ascii_strcasecmp(ext, ".webm") == 0 || g_ascii_strcasecmp(ext, ".avi") == 0);
+thumbnail_item_needs_load(ThumbnailItem *self)
+{
+    return !self->loading && (!self->paintable || self->loaded_size < self->size);
 }
 
 static void
 thumbnail_item_ensure_loaded(ThumbnailItem *self)
 {
-    /* Avoid starting work if already loaded or loading */
-    if (self->paintable || self->loading) return;
+    /* Avoid starting work if already loaded (at this tier) or loading */
+    if (!thumbnail_item_needs_load(self)) return;
 
     /* Check LRU cache first */
-    gchar *key = make_cache_key(self->path);
+    gchar *key = make_cache_key(self->path, self->size);
     if (key) {
         GdkPaintable *cached = lru_cache_get(key);
         if (cached) {
+            self->loaded_size = self->size;
             g_object_set(self, "paintable", cached, NULL);
             g_object_unref(cached);
             g_free(key);
             return;
         }
-        /* Cache miss */
-        if (instrumentation_enabled) {
-            instr_cache_misses++;
-            g_info("THUMBS-INSTR: cache miss -> %s (misses=%u)", key, instr_cache_misses);
-            g_print("THUMBS-INSTR: cache miss -> %s (misses=%u)\n", key, instr_cache_misses);
-        }
+        metrics_count(METRICS_THUMB_CACHE_MISS);
         g_free(key);
     }
 
@@ -460,60 +849,37 @@ thumbnail_item_ensure_loaded(ThumbnailItem *self)
         self->load_timeout_id = 0;
     }
 
-    g_object_ref(self); /* Keep alive during async */
+    if (metrics_get_enabled() && archive_is_video_path(self->path))
+        metrics_count(METRICS_VIDEO_THUMB_STARTED);
 
-    if (is_video(self->path)) {
-        if (instrumentation_enabled) {
-            instr_video_tasks_started++;
-            g_info("THUMBS-INSTR: video task start for %s (started=%u)", self->path, instr_video_tasks_started);
-            g_print("THUMBS-INSTR: video task start for %s (started=%u)\n", self->path, instr_video_tasks_started);
-        }
-
-        GTask *task = g_task_new(self, NULL, on_video_loaded, NULL);
-        g_task_set_task_data(task, g_strdup(self->path), g_free);
-        /* Use a bounded pool for video processing (heavy) to avoid creating too many threads */
-        if (!video_thread_pool) {
-            video_thread_pool = g_thread_pool_new(video_pool_worker, NULL, 2, FALSE, NULL);
-        }
-        /* Ensure the task stays alive until the worker runs and releases it */
-        g_object_ref(task);
-        g_thread_pool_push(video_thread_pool, task, NULL);
-        /* Drop caller's temporary ref; worker holds the ref until completion */
-        g_object_unref(task);
-        return;
-    }
-    
-    /* Archive detection */
-    if (g_str_has_prefix(self->path, "archive://")) {
-        const char *sep = strstr(self->path, "::");
-        if (sep) {
-            size_t len = sep - (self->path + strlen("archive://"));
-            char *arch_path = g_strndup(self->path + strlen("archive://"), len);
-            char *entry_name = g_strdup(sep + 2);
-            /* archive_read_entry_bytes_async takes ownership of self via callback user_data? No, we used g_object_ref(self) above. */
-            archive_read_entry_bytes_async(arch_path, entry_name, NULL, on_archive_thumbnail_bytes_loaded, self);
-            g_free(arch_path);
-            g_free(entry_name);
-            /* Don't unref self here, callback will */
-            return;
-        }
+    if (!thumb_pool) {
+        thumb_pool = g_thread_pool_new(thumb_pool_worker, NULL, (gint)MAX(1u, g_get_num_processors()), FALSE, NULL);
+        g_thread_pool_set_sort_function(thumb_pool, thumb_job_compare, NULL);
     }
 
-    GFile *file = g_file_new_for_path(self->path);
-    /* Note: Sync read of file handle, but decoding is async. Acceptable for now. */
-    GFileInputStream *stream = g_file_read(file, NULL, NULL); 
-    
-    if (stream) {
-        gdk_pixbuf_new_from_stream_at_scale_async(G_INPUT_STREAM(stream), 128, 128, TRUE, NULL, on_pixbuf_loaded, self);
-        g_object_unref(stream);
-    } else {
-        /* Failed to open */
-        self->loading = FALSE;
-        g_object_unref(self);
-    }
-    g_object_unref(file);
+    /* The task keeps self alive until its callback has run */
+    ThumbJob *job = g_new0(ThumbJob, 1);
+    job->path = g_strdup(self->path);
+    job->size = self->size;
+    job->source = lru_cache_get_larger(self->path, self->size);
+
+    self->cancellable = g_cancellable_new();
+    GTask *task = g_task_new(self, self->cancellable, on_thumbnail_job_done, NULL);
+    g_task_set_task_data(task, job, (GDestroyNotify)thumb_job_free);
+    /* Pool owns this reference; the worker drops it */
+    g_thread_pool_push(thumb_pool, task, NULL);
+    metrics_gauge_set(METRICS_THUMB_QUEUE_DEPTH, (int)g_thread_pool_unprocessed(thumb_pool));
 }
 
+/* Cancel a job that is queued (or running) for an item leaving the view. */
+static void
+thumbnail_item_cancel_load(ThumbnailItem *self)
+{
+    if (!self->cancellable) return;
+    g_cancellable_cancel(self->cancellable);
+    g_clear_object(&self->cancellable);
+    self->loading = FALSE;
+}
 
 /* --- ThumbnailsBar --- */
 
@@ -523,7 +889,15 @@ struct _ThumbnailsBar {
     GtkScrolledWindow *scroller;
     GtkGridView *grid_view;
     GListStore *store;
+    GtkFilterListModel *filter_model; /* store, filtered when showing duplicates */
+    GtkSortListModel *sort_model;     /* filter_model, sorted by group then */
     GtkSingleSelection *selection_model;
+    guint renumber_id; /* Idle that refreshes ThumbnailItem positions */
+    int thumbnail_size; /* Tier for the current scale factor */
+    GtkLabel *status_label;
+    DupIndex *dup_index; /* Created the first time duplicates are shown */
+    gboolean show_duplicates;
+    guint shedder_id;    /* Memory budget */
 };
 
 enum {
@@ -548,7 +922,7 @@ setup_list_item(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpoin
     gtk_box_append(GTK_BOX(box), overlay);
     
     GtkWidget *picture = gtk_picture_new();
-    gtk_widget_set_size_request(picture, 128, 128);
+    gtk_widget_set_size_request(picture, THUMBNAIL_DISPLAY_SIZE, THUMBNAIL_DISPLAY_SIZE);
     gtk_picture_set_can_shrink(GTK_PICTURE(picture), TRUE);
     gtk_widget_set_halign(picture, GTK_ALIGN_CENTER);
     gtk_overlay_set_child(GTK_OVERLAY(overlay), picture);
@@ -575,17 +949,36 @@ on_item_paintable_notify(ThumbnailItem *item, GParamSpec *pspec, gpointer user_d
        recycled widgets being reused for different items) */
     ThumbnailItem *bound = g_object_get_data(G_OBJECT(picture), "thumbnail-bound-item");
     if (bound != item) {
-        if (instrumentation_enabled) {
-            instr_ignored_notifies++;
-            g_info("THUMBS-INSTR: ignored notify for item %s (ignored=%u)", item->path ? item->path : "(null)", instr_ignored_notifies);
-            g_print("THUMBS-INSTR: ignored notify for item %s (ignored=%u)\n", item->path ? item->path : "(null)", instr_ignored_notifies);
-        }
+        metrics_count(METRICS_THUMB_IGNORED_NOTIFY);
         return;
     }
 
     gtk_picture_set_paintable(picture, item->paintable);
 }
 
+#define TOOLTIP_MAX_MATCHES 8
+
+/* The path followed by the files it duplicates, or NULL when it has none */
+static char *
+duplicates_tooltip(ThumbnailsBar *self, const char *path)
+{
+    if (!self->dup_index) return NULL;
+    GPtrArray *matches = dup_index_find_matches(self->dup_index, path);
+    if (matches->len == 0) {
+        g_ptr_array_unref(matches);
+        return NULL;
+    }
+
+    GString *text = g_string_new(path);
+    g_string_append(text, "\n\nDuplicates:");
+    for (guint i = 0; i < MIN(matches->len, TOOLTIP_MAX_MATCHES); i++)
+        g_string_append_printf(text, "\n%s", (const char *)g_ptr_array_index(matches, i));
+    if (matches->len > TOOLTIP_MAX_MATCHES)
+        g_string_append_printf(text, "\n(%u more)", matches->len - TOOLTIP_MAX_MATCHES);
+    g_ptr_array_unref(matches);
+    return g_string_free(text, FALSE);
+}
+
 static void
 on_item_destroyed(gpointer data, GObject *where)
 {
@@ -613,13 +1006,16 @@ bind_list_item(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpoint
     GtkWidget *icon = child;
     
     /* Tooltip remains useful */
-    gtk_widget_set_tooltip_text(box, item->path);
+    ThumbnailsBar *bar = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    char *tooltip = bar->show_duplicates ? duplicates_tooltip(bar, item->path) : NULL;
+    gtk_widget_set_tooltip_text(box, tooltip ? tooltip : item->path);
+    g_free(tooltip);
     
     /* Set Image */
     gtk_picture_set_paintable(GTK_PICTURE(picture), item->paintable);
     
     /* Set Icon Type */
-    if (is_video(item->path)) {
+    if (archive_is_video_path(item->path)) {
         gtk_image_set_from_icon_name(GTK_IMAGE(icon), "video-x-generic-symbolic");
     } else {
         gtk_image_set_from_icon_name(GTK_IMAGE(icon), "image-x-generic-symbolic");
@@ -646,12 +1042,14 @@ bind_list_item(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpoint
         g_object_weak_ref(G_OBJECT(item), (GWeakNotify)on_item_destroyed, picture);
     } 
 
+    item->bound = TRUE;
+
     /* Trigger load with a small debounce to avoid bursts during fast scrolling.
        Use a longer delay for videos so we only generate video thumbnails after
        the user stops scrolling. */
-    if (!item->paintable && !item->loading) {
+    if (thumbnail_item_needs_load(item)) {
         if (item->load_timeout_id == 0) {
-            guint delay = is_video(item->path) ? 500 : 80;
+            guint delay = archive_is_video_path(item->path) ? 500 : 80;
             g_object_ref(item);
             item->load_timeout_id = g_timeout_add(delay, thumbnail_load_timeout_cb, item);
         }
@@ -683,12 +1081,16 @@ unbind_list_item(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpoi
         }
     }
 
-    /* Cancel any pending delayed load */
+    /* Cancel any pending delayed load, and queued work that no longer has
+       a widget to show it */
     ThumbnailItem *item = gtk_list_item_get_item(list_item);
+    if (item != NULL) item->bound = FALSE;
     if (item != NULL && item->load_timeout_id != 0) {
         g_source_remove(item->load_timeout_id);
         item->load_timeout_id = 0;
     }
+    if (item != NULL)
+        thumbnail_item_cancel_load(item);
 
     (void)factory;
     (void)user_data;
@@ -706,6 +1108,161 @@ on_selection_changed(GtkSelectionModel *model, guint position, guint n_items, gp
     }
 }
 
+/* Track the item at the centre of the viewport so the scheduler can serve
+ * visible thumbnails first. Rows have a uniform height, so the index is
+ * proportional to the scroll position. */
+static void
+on_scroll_changed(GtkAdjustment *adj, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    if (!self->selection_model) return;
+
+    /* Rows are those of the (possibly filtered) view; jobs are ordered by
+       store position, so translate through the item */
+    GListModel *shown = G_LIST_MODEL(self->selection_model);
+    guint n_items = g_list_model_get_n_items(shown);
+    double upper = gtk_adjustment_get_upper(adj) - gtk_adjustment_get_lower(adj);
+    if (n_items == 0 || upper <= 0) return;
+
+    double center = gtk_adjustment_get_value(adj) - gtk_adjustment_get_lower(adj) +
+                    gtk_adjustment_get_page_size(adj) / 2.0;
+    gint index = CLAMP((gint)(center / upper * n_items), 0, (gint)n_items - 1);
+    ThumbnailItem *item = g_list_model_get_item(shown, (guint)index);
+    thumb_scheduler_set_center((gint)item->position);
+    g_object_unref(item);
+}
+
+/* --- Duplicates --- */
+
+static gboolean
+filter_duplicate(gpointer item, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    return self->dup_index && dup_index_get_group(self->dup_index, BRIGHTEYES_THUMBNAIL_ITEM(item)->path) != 0;
+}
+
+/* Groups are numbered in list order, and stay in list order inside */
+static int
+compare_groups(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    const ThumbnailItem *ia = a, *ib = b;
+    if (!self->dup_index) return GTK_ORDERING_EQUAL;
+    guint ga = dup_index_get_group(self->dup_index, ia->path);
+    guint gb = dup_index_get_group(self->dup_index, ib->path);
+    if (ga != gb) return ga < gb ? GTK_ORDERING_SMALLER : GTK_ORDERING_LARGER;
+    if (ia->position != ib->position) return ia->position < ib->position ? GTK_ORDERING_SMALLER : GTK_ORDERING_LARGER;
+    return GTK_ORDERING_EQUAL;
+}
+
+static void
+update_duplicates_status(ThumbnailsBar *self)
+{
+    if (!self->show_duplicates) {
+        gtk_widget_set_visible(GTK_WIDGET(self->status_label), FALSE);
+        return;
+    }
+
+    guint done, total;
+    guint n_groups = dup_index_get_n_groups(self->dup_index);
+    dup_index_get_progress(self->dup_index, &done, &total);
+    char *text = done < total
+        ? g_strdup_printf("Indexing %u/%u", done, total)
+        : g_strdup_printf(n_groups == 1 ? "%u group" : "%u groups", n_groups);
+    gtk_label_set_text(self->status_label, text);
+    gtk_widget_set_visible(GTK_WIDGET(self->status_label), TRUE);
+    g_free(text);
+}
+
+static void
+on_dup_progress(DupIndex *index, guint done, guint total, gpointer user_data)
+{
+    update_duplicates_status(BRIGHTEYES_THUMBNAILS_BAR(user_data));
+}
+
+static void
+on_dup_groups_changed(DupIndex *index, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    if (!self->show_duplicates || !self->filter_model) return;
+
+    gtk_filter_changed(gtk_filter_list_model_get_filter(self->filter_model), GTK_FILTER_CHANGE_DIFFERENT);
+    gtk_sorter_changed(gtk_sort_list_model_get_sorter(self->sort_model), GTK_SORTER_CHANGE_DIFFERENT);
+    update_duplicates_status(self);
+}
+
+static void
+on_duplicates_toggled(GtkToggleButton *button, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    gboolean active = gtk_toggle_button_get_active(button);
+    if (active == self->show_duplicates || !self->filter_model) return;
+    if (active && !self->curator) {
+        gtk_toggle_button_set_active(button, FALSE);
+        return;
+    }
+
+    if (active && !self->dup_index) {
+        self->dup_index = dup_index_new(self->curator);
+        g_signal_connect_object(self->dup_index, "progress", G_CALLBACK(on_dup_progress), self, 0);
+        g_signal_connect_object(self->dup_index, "groups-changed", G_CALLBACK(on_dup_groups_changed), self, 0);
+    }
+    self->show_duplicates = active;
+
+    if (active) {
+        GtkCustomFilter *filter = gtk_custom_filter_new(filter_duplicate, self, NULL);
+        GtkCustomSorter *sorter = gtk_custom_sorter_new(compare_groups, self, NULL);
+        gtk_filter_list_model_set_filter(self->filter_model, GTK_FILTER(filter));
+        gtk_sort_list_model_set_sorter(self->sort_model, GTK_SORTER(sorter));
+        g_object_unref(filter);
+        g_object_unref(sorter);
+    } else {
+        gtk_filter_list_model_set_filter(self->filter_model, NULL);
+        gtk_sort_list_model_set_sorter(self->sort_model, NULL);
+    }
+    update_duplicates_status(self);
+}
+
+/* Move every item to the tier for the new scale factor; the ones on screen
+ * reload now (usually by scaling a tier already in memory), the rest when
+ * they are bound again. */
+static void
+on_scale_factor_changed(GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(object);
+    int size = thumbnail_tier_for_scale(gtk_widget_get_scale_factor(GTK_WIDGET(self)));
+    if (size == self->thumbnail_size || !self->store) return;
+
+    self->thumbnail_size = size;
+    guint n = g_list_model_get_n_items(G_LIST_MODEL(self->store));
+    for (guint i = 0; i < n; i++) {
+        ThumbnailItem *item = g_list_model_get_item(G_LIST_MODEL(self->store), i);
+        item->size = size;
+        if (item->bound) thumbnail_item_ensure_loaded(item);
+        g_object_unref(item);
+    }
+}
+
+/* Under memory pressure, rows that are not on screen give their
+ * thumbnails back; they reload (usually from disk) when bound again. */
+static void
+thumbnails_bar_shed(MemShedLevel level, gsize excess, gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    if (level == MEM_SHED_TRIM || !self->store) return;
+
+    guint n = g_list_model_get_n_items(G_LIST_MODEL(self->store));
+    for (guint i = 0; i < n; i++) {
+        ThumbnailItem *item = g_list_model_get_item(G_LIST_MODEL(self->store), i);
+        if (!item->bound && item->paintable) {
+            thumbnail_item_cancel_load(item);
+            item->loaded_size = 0;
+            g_object_set(item, "paintable", NULL, NULL);
+        }
+        g_object_unref(item);
+    }
+}
+
 static void
 thumbnails_bar_init(ThumbnailsBar *self)
 {
@@ -732,6 +1289,9 @@ thumbnails_bar_init(ThumbnailsBar *self)
     }
 
     gtk_orientable_set_orientation(GTK_ORIENTABLE(self), GTK_ORIENTATION_VERTICAL);
+    self->thumbnail_size = thumbnail_tier_for_scale(1);
+    g_signal_connect(self, "notify::scale-factor", G_CALLBACK(on_scale_factor_changed), NULL);
+    self->shedder_id = mem_budget_add_shedder(MEM_POOL_THUMBNAILS, thumbnails_bar_shed, self);
     
     /* Header */
     GtkWidget *header_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
@@ -742,7 +1302,22 @@ thumbnails_bar_init(ThumbnailsBar *self)
     
     GtkWidget *title = gtk_label_new("Files");
     gtk_widget_add_css_class(title, "title-4");
+    gtk_widget_set_hexpand(title, TRUE);
+    gtk_widget_set_halign(title, GTK_ALIGN_START);
     gtk_box_append(GTK_BOX(header_box), title);
+
+    self->status_label = GTK_LABEL(gtk_label_new(NULL));
+    gtk_widget_add_css_class(GTK_WIDGET(self->status_label), "dim-label");
+    gtk_widget_set_margin_end(GTK_WIDGET(self->status_label), 6);
+    gtk_widget_set_visible(GTK_WIDGET(self->status_label), FALSE);
+    gtk_box_append(GTK_BOX(header_box), GTK_WIDGET(self->status_label));
+
+    GtkWidget *duplicates = gtk_toggle_button_new();
+    gtk_button_set_icon_name(GTK_BUTTON(duplicates), "edit-copy-symbolic");
+    gtk_widget_set_tooltip_text(duplicates, "Show duplicates only");
+    gtk_widget_add_css_class(duplicates, "flat");
+    g_signal_connect(duplicates, "toggled", G_CALLBACK(on_duplicates_toggled), self);
+    gtk_box_append(GTK_BOX(header_box), duplicates);
     gtk_box_append(GTK_BOX(self), header_box);
     gtk_box_append(GTK_BOX(self), gtk_separator_new(GTK_ORIENTATION_HORIZONTAL));
     
@@ -753,8 +1328,11 @@ thumbnails_bar_init(ThumbnailsBar *self)
     gtk_box_append(GTK_BOX(self), GTK_WIDGET(self->scroller));
     
     /* Grid View Setup */
+    /* Each model takes ownership of the one below it */
     self->store = g_list_store_new(TYPE_THUMBNAIL_ITEM);
-    self->selection_model = gtk_single_selection_new(G_LIST_MODEL(self->store));
+    self->filter_model = gtk_filter_list_model_new(G_LIST_MODEL(self->store), NULL);
+    self->sort_model = gtk_sort_list_model_new(G_LIST_MODEL(self->filter_model), NULL);
+    self->selection_model = gtk_single_selection_new(G_LIST_MODEL(self->sort_model));
     g_signal_connect(self->selection_model, "selection-changed", G_CALLBACK(on_selection_changed), self);
     
     GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
@@ -767,6 +1345,10 @@ thumbnails_bar_init(ThumbnailsBar *self)
     gtk_grid_view_set_min_columns(self->grid_view, 1);
     
     gtk_scrolled_window_set_child(self->scroller, GTK_WIDGET(self->grid_view));
+
+    GtkAdjustment *vadj = gtk_scrolled_window_get_vadjustment(self->scroller);
+    g_signal_connect_object(vadj, "value-changed", G_CALLBACK(on_scroll_changed), self, 0);
+    g_signal_connect_object(vadj, "changed", G_CALLBACK(on_scroll_changed), self, 0);
 }
 
 static void
@@ -782,16 +1364,28 @@ thumbnails_bar_dispose(GObject *object)
        Clearing the store prematurely causes crashes when GTK tries to access
        the model during its own cleanup. */
     
+    if (self->shedder_id) {
+        mem_budget_remove_shedder(self->shedder_id);
+        self->shedder_id = 0;
+    }
     self->store = NULL;
+    self->filter_model = NULL;
+    self->sort_model = NULL;
     self->selection_model = NULL;
     self->grid_view = NULL;
+    if (self->renumber_id) {
+        g_source_remove(self->renumber_id);
+        self->renumber_id = 0;
+    }
 
     /* Destroy in-memory thumbnail cache on dispose to free memory */
     lru_cache_destroy();
+    video_thumbnail_engines_release();
 
     /* If instrumentation was enabled, print a summary to the logs */
     thumbnails_print_instrumentation();
 
+    g_clear_object(&self->dup_index);
     g_clear_object(&self->curator);
     G_OBJECT_CLASS(thumbnails_bar_parent_class)->dispose(object);
 }
@@ -813,28 +1407,55 @@ thumbnails_bar_class_init(ThumbnailsBarClass *klass)
                                                   G_TYPE_STRING);
 }
 
+/* Positions only steer scheduling, so they are refreshed once per burst of
+ * changes rather than on every splice. */
+static gboolean
+renumber_items_idle(gpointer user_data)
+{
+    ThumbnailsBar *self = BRIGHTEYES_THUMBNAILS_BAR(user_data);
+    self->renumber_id = 0;
+    if (!self->store) return G_SOURCE_REMOVE;
+
+    guint n = g_list_model_get_n_items(G_LIST_MODEL(self->store));
+    for (guint i = 0; i < n; i++) {
+        ThumbnailItem *item = g_list_model_get_item(G_LIST_MODEL(self->store), i);
+        item->position = i;
+        g_object_unref(item);
+    }
+    /* Groups keep list order inside, which is by position */
+    if (self->show_duplicates)
+        gtk_sorter_changed(gtk_sort_list_model_get_sorter(self->sort_model), GTK_SORTER_CHANGE_DIFFERENT);
+    return G_SOURCE_REMOVE;
+}
+
+/* Mirror the curator's files array into the store. */
+static void
+on_curator_items_changed(Curator *curator, guint position, guint removed, guint added, ThumbnailsBar *self)
+{
+    if (!self->store) return;
+
+    GPtrArray *files = curator_get_files(curator);
+    ThumbnailItem **items = g_new(ThumbnailItem *, MAX(added, 1));
+    for (guint i = 0; i < added; i++) {
+        items[i] = thumbnail_item_new(g_ptr_array_index(files, position + i));
+        items[i]->position = position + i;
+        items[i]->size = self->thumbnail_size;
+    }
+    g_list_store_splice(self->store, position, removed, (gpointer *)items, added);
+    for (guint i = 0; i < added; i++)
+        g_object_unref(items[i]); /* Store takes ownership */
+    g_free(items);
+
+    if (self->renumber_id == 0)
+        self->renumber_id = g_idle_add(renumber_items_idle, self);
+}
+
 ThumbnailsBar *
 thumbnails_bar_new(Curator *curator)
 {
     ThumbnailsBar *self = g_object_new(TYPE_THUMBNAILS_BAR, NULL);
     self->curator = curator ? g_object_ref(curator) : NULL;
+    if (self->curator)
+        g_signal_connect_object(self->curator, "items-changed", G_CALLBACK(on_curator_items_changed), self, 0);
     return self;
 }
-
-void
-thumbnails_bar_refresh(ThumbnailsBar *self)
-{
-    if (!self->curator) return;
-    
-    g_list_store_remove_all(self->store);
-    
-    GPtrArray *files = curator_get_files(self->curator);
-    if (!files) return;
-    
-    for (guint i = 0; i < files->len; i++) {
-        const char *path = g_ptr_array_index(files, i);
-        ThumbnailItem *item = thumbnail_item_new(path);
-        g_list_store_append(self->store, item);
-        g_object_unref(item); /* Store takes ownership */
-    }
-}
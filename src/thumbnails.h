@@ -10,8 +10,17 @@ G_BEGIN_DECLS
 #define TYPE_THUMBNAILS_BAR (thumbnails_bar_get_type())
 G_DECLARE_FINAL_TYPE(ThumbnailsBar, thumbnails_bar, BRIGHTEYES, THUMBNAILS_BAR, GtkBox)
 
+/* The bar mirrors the curator through its "items-changed" signal. */
 ThumbnailsBar *thumbnails_bar_new(Curator *curator);
-void thumbnails_bar_refresh(ThumbnailsBar *self);
+
+/* Thumbnail already held in memory for path, or NULL. Never decodes, so it
+ * is cheap enough to call while opening an image. Main thread only. */
+GdkPaintable *thumbnail_cache_lookup(const char *path);
+
+/* Pixels of the size tier (128, 256 or 512) for path: the persistent
+ * thumbnail when it is current, else a fresh decode that is then written
+ * back. Blocking and thread-safe; for worker threads. */
+GdkPixbuf *thumbnail_load_pixbuf(const char *path, int size, GCancellable *cancellable, GError **error);
 
 G_END_DECLS
 
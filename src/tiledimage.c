@@ -0,0 +1,510 @@
+#include "tiledimage.h"
+#include <math.h>
+#include "pixelops.h"
+#include "membudget.h"
+
+/* Tiled image (paintable)
+ *
+ * Draws large images without uploading them as one texture:
+ * - Levels: level 0 is the decoded pixbuf, level n is 1/2^n of it. Levels
+ *   are scaled on GIO worker threads from the nearest finer level when a
+ *   snapshot first needs them.
+ * - Tiles: TILE_SIZE squares cut from a level. Tile textures reference the
+ *   level's pixels directly and are kept in a small LRU so scrolling does
+ *   not re-upload tiles that stay on screen.
+ * - Snapshot: picks the coarsest level that still has at least one pixel
+ *   per device pixel, falling back to any ready level while it is built,
+ *   and appends only the tiles intersecting the visible area.
+ * - Rotation: applied as a transform around the tiles at snapshot time, so
+ *   turning the image never copies or re-uploads pixels.
+ * - Memory: generated levels are accounted to the viewer's share of the
+ *   memory budget. Trimming drops them (and the tiles cut from them) except
+ *   the level last drawn; they are rebuilt when a snapshot needs them.
+ * Images up to SINGLE_TILE_MAX on both sides are drawn as one tile of one
+ * level, which is exactly the plain texture they used to be.
+ *
+ * Sections: types, tile cache, level generation, GdkPaintable, public API.
+ */
+
+#define TILE_SIZE 512
+#define MAX_CACHED_TILES 192
+#define SINGLE_TILE_MAX 3000
+
+typedef struct {
+    GdkPixbuf *pixbuf; /* NULL until generated */
+    int width;
+    int height;
+    gboolean pending;
+} TileLevel;
+
+typedef struct {
+    guint64 key;
+    GdkTexture *texture;
+    GList link;
+} TileEntry;
+
+struct _TiledImage {
+    GObject parent_instance;
+    int width;
+    int height;
+    int tile_size;
+    int rotation; /* Degrees counter-clockwise, as gdk_pixbuf_rotate_simple */
+    guint n_levels;
+    TileLevel *levels;
+    guint drawn_level;   /* Level of the last snapshot */
+    int scale_factor;    /* Device pixels per paintable unit */
+
+    GHashTable *tiles;   /* guint64 key -> TileEntry* (owned) */
+    GQueue tile_lru;     /* Least recently drawn first */
+
+    graphene_rect_t visible; /* Fractions of the unrotated image size */
+    graphene_rect_t drawn;   /* Area covered by the last snapshot, same units */
+    GCancellable *cancellable;
+};
+
+static void tiled_image_paintable_init(GdkPaintableInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(TiledImage, tiled_image, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(GDK_TYPE_PAINTABLE, tiled_image_paintable_init))
+
+/* --- Tile cache --- */
+
+static guint64
+tile_key(guint level, int tx, int ty)
+{
+    return ((guint64)level << 48) | ((guint64)(guint)ty << 24) | (guint64)(guint)tx;
+}
+
+static void
+tile_entry_free(TileEntry *entry)
+{
+    g_clear_object(&entry->texture);
+    g_free(entry);
+}
+
+/* Zero-copy texture for one tile: a GBytes window onto the level's rows. */
+static GdkTexture *
+tile_texture_new(GdkPixbuf *pixbuf, int x, int y, int w, int h)
+{
+    int stride = gdk_pixbuf_get_rowstride(pixbuf);
+    int n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+    gsize offset = (gsize)y * stride + (gsize)x * n_channels;
+    gsize length = (gsize)(h - 1) * stride + (gsize)w * n_channels;
+
+    GBytes *all = g_bytes_new_with_free_func(gdk_pixbuf_read_pixels(pixbuf),
+                                             (gsize)stride * gdk_pixbuf_get_height(pixbuf),
+                                             (GDestroyNotify)g_object_unref,
+                                             g_object_ref(pixbuf));
+    GBytes *bytes = g_bytes_new_from_bytes(all, offset, length);
+    g_bytes_unref(all);
+
+    GdkTexture *texture = gdk_memory_texture_new(w, h,
+                                                 gdk_pixbuf_get_has_alpha(pixbuf) ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8,
+                                                 bytes, stride);
+    g_bytes_unref(bytes);
+    return texture;
+}
+
+static GdkTexture *
+tile_lookup(TiledImage *self, guint level, int tx, int ty)
+{
+    guint64 key = tile_key(level, tx, ty);
+    TileEntry *entry = g_hash_table_lookup(self->tiles, &key);
+    if (entry) {
+        g_queue_unlink(&self->tile_lru, &entry->link);
+        g_queue_push_tail_link(&self->tile_lru, &entry->link);
+        return entry->texture;
+    }
+
+    TileLevel *lv = &self->levels[level];
+    int ts = self->tile_size;
+    int x = tx * ts;
+    int y = ty * ts;
+    entry = g_new0(TileEntry, 1);
+    entry->key = key;
+    entry->texture = tile_texture_new(lv->pixbuf, x, y, MIN(ts, lv->width - x), MIN(ts, lv->height - y));
+    entry->link.data = entry;
+    g_hash_table_insert(self->tiles, &entry->key, entry);
+    g_queue_push_tail_link(&self->tile_lru, &entry->link);
+
+    /* Snapshot nodes hold their own refs, so evicting here is safe */
+    while (self->tile_lru.length > MAX_CACHED_TILES) {
+        TileEntry *old = self->tile_lru.head->data;
+        g_queue_unlink(&self->tile_lru, &old->link);
+        g_hash_table_remove(self->tiles, &old->key);
+    }
+    return entry->texture;
+}
+
+/* --- Level generation --- */
+
+typedef struct {
+    guint level;
+    GdkPixbuf *source;
+    int width;
+    int height;
+} LevelJob;
+
+static void
+level_job_free(LevelJob *job)
+{
+    g_clear_object(&job->source);
+    g_free(job);
+}
+
+static void
+level_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    LevelJob *job = task_data;
+    if (g_task_return_error_if_cancelled(task)) return;
+
+    /* Level sizes are w >> level, so this is a chain of exact 2x2 halvings */
+    GdkPixbuf *scaled = pixel_ops_scale_down(job->source, job->width, job->height);
+    if (scaled)
+        g_task_return_pointer(task, scaled, g_object_unref);
+    else
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to scale level %u", job->level);
+}
+
+static void
+on_level_ready(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    TiledImage *self = BRIGHTEYES_TILED_IMAGE(source);
+    LevelJob *job = g_task_get_task_data(G_TASK(res));
+    GdkPixbuf *pixbuf = g_task_propagate_pointer(G_TASK(res), NULL);
+
+    self->levels[job->level].pending = FALSE;
+    if (!pixbuf) return;
+
+    self->levels[job->level].pixbuf = pixbuf;
+    mem_budget_add(MEM_POOL_VIEWER, (gssize)gdk_pixbuf_get_byte_length(pixbuf));
+    gdk_paintable_invalidate_contents(GDK_PAINTABLE(self));
+}
+
+static void
+level_request(TiledImage *self, guint level)
+{
+    TileLevel *lv = &self->levels[level];
+    if (lv->pixbuf || lv->pending) return;
+
+    /* Scale from the nearest finer level that exists: much less work than
+       starting from full resolution each time */
+    guint from = level;
+    while (from > 0 && !self->levels[from].pixbuf) from--;
+
+    LevelJob *job = g_new0(LevelJob, 1);
+    job->level = level;
+    job->source = g_object_ref(self->levels[from].pixbuf);
+    job->width = lv->width;
+    job->height = lv->height;
+    lv->pending = TRUE;
+
+    GTask *task = g_task_new(self, self->cancellable, on_level_ready, NULL);
+    g_task_set_task_data(task, job, (GDestroyNotify)level_job_free);
+    g_task_set_priority(task, G_PRIORITY_LOW);
+    g_task_run_in_thread(task, level_thread);
+    g_object_unref(task);
+}
+
+/* Level with roughly one texel per output pixel at the given scale
+ * (output size / full size). Returns a ready level and queues the ideal
+ * one if it is missing. */
+static guint
+level_for_scale(TiledImage *self, double scale)
+{
+    guint ideal = 0;
+    if (scale > 0 && scale < 1.0)
+        ideal = (guint)floor(log2(1.0 / scale));
+    ideal = MIN(ideal, self->n_levels - 1);
+
+    if (self->levels[ideal].pixbuf) return ideal;
+    level_request(self, ideal);
+
+    /* Meanwhile: coarser levels are cheap to draw, finer ones are exact */
+    for (guint l = ideal + 1; l < self->n_levels; l++)
+        if (self->levels[l].pixbuf) return l;
+    for (guint l = ideal; l-- > 0; )
+        if (self->levels[l].pixbuf) return l;
+    return 0;
+}
+
+/* --- GdkPaintable --- */
+
+static gboolean
+is_quarter_turn(int rotation)
+{
+    return rotation == 90 || rotation == 270;
+}
+
+static void
+draw_tiles(TiledImage *self, GtkSnapshot *snapshot, double width, double height)
+{
+    int ts = self->tile_size;
+    /* In device pixels, so HiDPI screens get the finer level they can show */
+    double scale = MIN(width / self->width, height / self->height) * self->scale_factor;
+    guint level = level_for_scale(self, scale);
+    TileLevel *lv = &self->levels[level];
+    self->drawn_level = level;
+
+    /* Paintable units per level pixel */
+    double sx = width / lv->width;
+    double sy = height / lv->height;
+
+    double vx0 = self->visible.origin.x * width;
+    double vy0 = self->visible.origin.y * height;
+    double vx1 = vx0 + self->visible.size.width * width;
+    double vy1 = vy0 + self->visible.size.height * height;
+
+    int n_tx = (lv->width + ts - 1) / ts;
+    int n_ty = (lv->height + ts - 1) / ts;
+    /* One tile of margin so short pans stay inside what was drawn */
+    int tx0 = CLAMP((int)floor(vx0 / (ts * sx)) - 1, 0, n_tx - 1);
+    int ty0 = CLAMP((int)floor(vy0 / (ts * sy)) - 1, 0, n_ty - 1);
+    int tx1 = CLAMP((int)ceil(vx1 / (ts * sx)) + 1, 1, n_tx);
+    int ty1 = CLAMP((int)ceil(vy1 / (ts * sy)) + 1, 1, n_ty);
+
+    graphene_rect_init(&self->drawn,
+                       (float)((double)tx0 * ts / lv->width), (float)((double)ty0 * ts / lv->height),
+                       (float)((double)MIN(tx1 * ts, lv->width) / lv->width - (double)tx0 * ts / lv->width),
+                       (float)((double)MIN(ty1 * ts, lv->height) / lv->height - (double)ty0 * ts / lv->height));
+
+    for (int ty = ty0; ty < ty1; ty++) {
+        for (int tx = tx0; tx < tx1; tx++) {
+            int x = tx * ts;
+            int y = ty * ts;
+            int w = MIN(ts, lv->width - x);
+            int h = MIN(ts, lv->height - y);
+            graphene_rect_t bounds = GRAPHENE_RECT_INIT((float)(x * sx), (float)(y * sy), (float)(w * sx), (float)(h * sy));
+            gtk_snapshot_append_texture(snapshot, tile_lookup(self, level, tx, ty), &bounds);
+        }
+    }
+}
+
+static void
+tiled_image_snapshot(GdkPaintable *paintable, GdkSnapshot *snapshot, double width, double height)
+{
+    TiledImage *self = BRIGHTEYES_TILED_IMAGE(paintable);
+    GtkSnapshot *gsnapshot = GTK_SNAPSHOT(snapshot);
+    if (width <= 0 || height <= 0) return;
+
+    if (self->rotation == 0) {
+        draw_tiles(self, gsnapshot, width, height);
+        return;
+    }
+
+    /* Rotate the coordinate system so the tiles land in the (width, height)
+       box; GTK angles are clockwise, ours counter-clockwise */
+    gtk_snapshot_save(gsnapshot);
+    switch (self->rotation) {
+        case 90:
+            gtk_snapshot_translate(gsnapshot, &GRAPHENE_POINT_INIT(0, (float)height));
+            break;
+        case 180:
+            gtk_snapshot_translate(gsnapshot, &GRAPHENE_POINT_INIT((float)width, (float)height));
+            break;
+        default:
+            gtk_snapshot_translate(gsnapshot, &GRAPHENE_POINT_INIT((float)width, 0));
+            break;
+    }
+    gtk_snapshot_rotate(gsnapshot, (float)-self->rotation);
+    if (is_quarter_turn(self->rotation))
+        draw_tiles(self, gsnapshot, height, width);
+    else
+        draw_tiles(self, gsnapshot, width, height);
+    gtk_snapshot_restore(gsnapshot);
+}
+
+static int
+tiled_image_get_intrinsic_width(GdkPaintable *paintable)
+{
+    TiledImage *self = BRIGHTEYES_TILED_IMAGE(paintable);
+    return is_quarter_turn(self->rotation) ? self->height : self->width;
+}
+
+static int
+tiled_image_get_intrinsic_height(GdkPaintable *paintable)
+{
+    TiledImage *self = BRIGHTEYES_TILED_IMAGE(paintable);
+    return is_quarter_turn(self->rotation) ? self->width : self->height;
+}
+
+static GdkPaintableFlags
+tiled_image_get_flags(GdkPaintable *paintable)
+{
+    /* Size changes with rotation */
+    return 0;
+}
+
+static void
+tiled_image_paintable_init(GdkPaintableInterface *iface)
+{
+    iface->snapshot = tiled_image_snapshot;
+    iface->get_intrinsic_width = tiled_image_get_intrinsic_width;
+    iface->get_intrinsic_height = tiled_image_get_intrinsic_height;
+    iface->get_flags = tiled_image_get_flags;
+}
+
+/* Release generated level l, which must not be pending */
+static void
+level_drop(TiledImage *self, guint l)
+{
+    TileLevel *lv = &self->levels[l];
+    if (l == 0 || !lv->pixbuf) return;
+    mem_budget_add(MEM_POOL_VIEWER, -(gssize)gdk_pixbuf_get_byte_length(lv->pixbuf));
+    g_clear_object(&lv->pixbuf);
+}
+
+/* --- Lifecycle --- */
+
+static void
+tiled_image_dispose(GObject *object)
+{
+    TiledImage *self = BRIGHTEYES_TILED_IMAGE(object);
+
+    if (self->cancellable) {
+        g_cancellable_cancel(self->cancellable);
+        g_clear_object(&self->cancellable);
+    }
+    g_queue_init(&self->tile_lru);
+    g_clear_pointer(&self->tiles, g_hash_table_destroy);
+    if (self->levels) {
+        for (guint l = 0; l < self->n_levels; l++) {
+            level_drop(self, l);
+            g_clear_object(&self->levels[l].pixbuf);
+        }
+        g_clear_pointer(&self->levels, g_free);
+    }
+
+    G_OBJECT_CLASS(tiled_image_parent_class)->dispose(object);
+}
+
+static void
+tiled_image_class_init(TiledImageClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = tiled_image_dispose;
+}
+
+static void
+tiled_image_init(TiledImage *self)
+{
+    self->tiles = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, (GDestroyNotify)tile_entry_free);
+    g_queue_init(&self->tile_lru);
+    graphene_rect_init(&self->visible, 0, 0, 1, 1);
+    graphene_rect_init(&self->drawn, 0, 0, 0, 0);
+    self->scale_factor = 1;
+    self->cancellable = g_cancellable_new();
+}
+
+/* --- Public API --- */
+
+TiledImage *
+tiled_image_new(GdkPixbuf *pixbuf)
+{
+    g_return_val_if_fail(GDK_IS_PIXBUF(pixbuf), NULL);
+
+    TiledImage *self = g_object_new(TYPE_TILED_IMAGE, NULL);
+    self->width = gdk_pixbuf_get_width(pixbuf);
+    self->height = gdk_pixbuf_get_height(pixbuf);
+
+    /* Halve until the whole level fits in one tile */
+    int max_dim = MAX(self->width, self->height);
+    self->tile_size = max_dim <= SINGLE_TILE_MAX ? MAX(1, max_dim) : TILE_SIZE;
+    self->n_levels = 1;
+    for (int dim = max_dim; dim > self->tile_size; dim = (dim + 1) / 2)
+        self->n_levels++;
+
+    self->levels = g_new0(TileLevel, self->n_levels);
+    for (guint l = 0; l < self->n_levels; l++) {
+        self->levels[l].width = MAX(1, self->width >> l);
+        self->levels[l].height = MAX(1, self->height >> l);
+    }
+    self->levels[0].pixbuf = g_object_ref(pixbuf);
+    return self;
+}
+
+GdkPixbuf *
+tiled_image_get_pixbuf(TiledImage *self)
+{
+    return self->levels[0].pixbuf;
+}
+
+void
+tiled_image_set_visible_area(TiledImage *self, double x, double y, double width, double height)
+{
+    x = CLAMP(x, 0.0, 1.0);
+    y = CLAMP(y, 0.0, 1.0);
+    width = CLAMP(width, 0.0, 1.0 - x);
+    height = CLAMP(height, 0.0, 1.0 - y);
+
+    /* Back from the rotated box to unrotated image fractions */
+    graphene_rect_t area;
+    switch (self->rotation) {
+        case 90:
+            graphene_rect_init(&area, (float)(1.0 - (y + height)), (float)x, (float)height, (float)width);
+            break;
+        case 180:
+            graphene_rect_init(&area, (float)(1.0 - (x + width)), (float)(1.0 - (y + height)), (float)width, (float)height);
+            break;
+        case 270:
+            graphene_rect_init(&area, (float)y, (float)(1.0 - (x + width)), (float)height, (float)width);
+            break;
+        default:
+            graphene_rect_init(&area, (float)x, (float)y, (float)width, (float)height);
+            break;
+    }
+    if (graphene_rect_equal(&area, &self->visible)) return;
+
+    /* Scrolling only translates the cached render node; snapshot again when
+       the view reaches tiles the last snapshot skipped */
+    self->visible = area;
+    if (!graphene_rect_contains_rect(&self->drawn, &area))
+        gdk_paintable_invalidate_contents(GDK_PAINTABLE(self));
+}
+
+int
+tiled_image_get_rotation(TiledImage *self)
+{
+    return self->rotation;
+}
+
+void
+tiled_image_set_rotation(TiledImage *self, int rotation)
+{
+    rotation = ((rotation % 360) + 360) % 360;
+    g_return_if_fail(rotation % 90 == 0);
+    if (rotation == self->rotation) return;
+
+    gboolean size_changed = is_quarter_turn(rotation) != is_quarter_turn(self->rotation);
+    self->rotation = rotation;
+
+    /* The viewer reports the new visible area once layout settles */
+    graphene_rect_init(&self->visible, 0, 0, 1, 1);
+    if (size_changed)
+        gdk_paintable_invalidate_size(GDK_PAINTABLE(self));
+    gdk_paintable_invalidate_contents(GDK_PAINTABLE(self));
+}
+
+void
+tiled_image_set_scale_factor(TiledImage *self, int scale_factor)
+{
+    scale_factor = MAX(1, scale_factor);
+    if (scale_factor == self->scale_factor) return;
+    self->scale_factor = scale_factor;
+    gdk_paintable_invalidate_contents(GDK_PAINTABLE(self));
+}
+
+void
+tiled_image_trim(TiledImage *self)
+{
+    /* Tile textures keep their level's pixels alive, so they go first */
+    for (GList *l = self->tile_lru.head; l; ) {
+        TileEntry *entry = l->data;
+        l = l->next;
+        if ((guint)(entry->key >> 48) == self->drawn_level) continue;
+        g_queue_unlink(&self->tile_lru, &entry->link);
+        g_hash_table_remove(self->tiles, &entry->key);
+    }
+    for (guint l = 1; l < self->n_levels; l++)
+        if (l != self->drawn_level) level_drop(self, l);
+}
@@ -0,0 +1,41 @@
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <gtk/gtk.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+#define TYPE_TILED_IMAGE (tiled_image_get_type())
+G_DECLARE_FINAL_TYPE(TiledImage, tiled_image, BRIGHTEYES, TILED_IMAGE, GObject)
+
+/* A GdkPaintable that draws a decoded image as a pyramid of fixed-size
+ * tiles. Level 0 tiles are views into the pixbuf (no copy); each further
+ * level halves the resolution and is built on a worker thread the first
+ * time it is needed. Only tiles inside the visible area are snapshotted.
+ * Small images become a single tile, so every image can go through here. */
+TiledImage *tiled_image_new(GdkPixbuf *pixbuf);
+
+GdkPixbuf *tiled_image_get_pixbuf(TiledImage *self);
+
+/* Part of the image currently on screen, as fractions (0..1) of the
+ * paintable's (rotated) width and height. Defaults to the whole image. */
+void tiled_image_set_visible_area(TiledImage *self, double x, double y, double width, double height);
+
+/* Counter-clockwise rotation in multiples of 90 degrees, with the same
+ * meaning as gdk_pixbuf_rotate_simple(). Applied when drawing; the pixels
+ * are never touched. Intrinsic width and height swap for 90 and 270. */
+void tiled_image_set_rotation(TiledImage *self, int rotation);
+int tiled_image_get_rotation(TiledImage *self);
+
+/* Device pixels per paintable unit, i.e. the scale factor of the widget
+ * drawing it; levels are picked for that resolution. Defaults to 1. */
+void tiled_image_set_scale_factor(TiledImage *self, int scale_factor);
+
+/* Free the generated levels and their tiles, except those of the level
+ * last drawn. They are built again when a snapshot needs them. */
+void tiled_image_trim(TiledImage *self);
+
+G_END_DECLS
+
+#endif /* TILEDIMAGE_H */
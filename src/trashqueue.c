@@ -0,0 +1,299 @@
+#include "trashqueue.h"
+#include <gio/gio.h>
+#include <string.h>
+#include "archive.h"
+
+/* Trash queue (model)
+ *
+ * Deletion without blocking the UI:
+ * - Files: moved to the trash with g_file_trash_async.
+ * - Archive pages: collected per archive. A rewrite starts FLUSH_DELAY_MS
+ *   after the last page of that archive was queued and removes all of them
+ *   in one pass (archive_delete_entries writes a temp file and renames it
+ *   over the original). Pages queued while it runs wait for the next pass.
+ * - Lifetime: while anything is pending the queue holds a reference on
+ *   itself and on the default GApplication, so neither closing the window
+ *   nor quitting cuts a rewrite short.
+ *
+ * Sections: helpers, archive batches, files, lifecycle, public API.
+ */
+
+#define FLUSH_DELAY_MS 750
+
+struct _TrashQueue {
+    GObject parent_instance;
+    GHashTable *batches; /* Archive path -> ArchiveBatch */
+    guint n_trashing;    /* Plain files being trashed */
+    gboolean held;       /* Self and the application are referenced */
+};
+
+typedef struct {
+    TrashQueue *queue;
+    char *archive_path;
+    GPtrArray *pending;  /* Entry names for the next rewrite */
+    guint flush_id;
+    gboolean running;
+} ArchiveBatch;
+
+typedef struct {
+    char *archive_path;
+    char **entries;
+} RewriteData;
+
+enum {
+    SIGNAL_FAILED,
+    N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+G_DEFINE_TYPE(TrashQueue, trash_queue, G_TYPE_OBJECT)
+
+/* --- Helpers --- */
+
+/* Take or drop the references that keep pending work alive. May release
+ * the last reference to self, so call it last. */
+static void
+update_hold(TrashQueue *self)
+{
+    gboolean busy = trash_queue_is_busy(self);
+    if (busy == self->held) return;
+
+    self->held = busy;
+    GApplication *app = g_application_get_default();
+    if (busy) {
+        g_object_ref(self);
+        if (app) g_application_hold(app);
+    } else {
+        if (app) g_application_release(app);
+        g_object_unref(self);
+    }
+}
+
+/* --- Archive batches --- */
+
+static void
+archive_batch_free(ArchiveBatch *batch)
+{
+    if (batch->flush_id) g_source_remove(batch->flush_id);
+    g_free(batch->archive_path);
+    g_ptr_array_unref(batch->pending);
+    g_free(batch);
+}
+
+static void
+rewrite_data_free(RewriteData *data)
+{
+    g_free(data->archive_path);
+    g_strfreev(data->entries);
+    g_free(data);
+}
+
+static void
+rewrite_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    RewriteData *data = task_data;
+    GError *error = NULL;
+
+    if (archive_delete_entries(data->archive_path, (const char * const *)data->entries, &error))
+        g_task_return_boolean(task, TRUE);
+    else
+        g_task_return_error(task, error);
+}
+
+static void archive_batch_start(ArchiveBatch *batch);
+
+static void
+on_rewrite_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    TrashQueue *self = BRIGHTEYES_TRASH_QUEUE(source);
+    ArchiveBatch *batch = user_data;
+    RewriteData *data = g_task_get_task_data(G_TASK(res));
+    GError *error = NULL;
+
+    batch->running = FALSE;
+    if (!g_task_propagate_boolean(G_TASK(res), &error)) {
+        guint n = g_strv_length(data->entries);
+        char **items = g_new0(char *, n + 1);
+        for (guint i = 0; i < n; i++)
+            items[i] = g_strdup_printf("archive://%s::%s", data->archive_path, data->entries[i]);
+
+        g_warning("Failed to delete pages from %s: %s", data->archive_path, error->message);
+        g_signal_emit(self, signals[SIGNAL_FAILED], 0, data->archive_path, n, error->message, items);
+        g_strfreev(items);
+        g_clear_error(&error);
+    }
+
+    if (batch->pending->len > 0) {
+        /* Queued during the rewrite; their delay has already passed unless
+           more pages are still arriving */
+        if (!batch->flush_id) archive_batch_start(batch);
+    } else if (!batch->flush_id) {
+        g_hash_table_remove(self->batches, batch->archive_path);
+    }
+
+    update_hold(self);
+}
+
+static void
+archive_batch_start(ArchiveBatch *batch)
+{
+    if (batch->flush_id) {
+        g_source_remove(batch->flush_id);
+        batch->flush_id = 0;
+    }
+    if (batch->running || batch->pending->len == 0) return;
+
+    RewriteData *data = g_new0(RewriteData, 1);
+    data->archive_path = g_strdup(batch->archive_path);
+    g_ptr_array_add(batch->pending, NULL);
+    data->entries = (char **)g_ptr_array_free(batch->pending, FALSE);
+    batch->pending = g_ptr_array_new_with_free_func(g_free);
+    batch->running = TRUE;
+
+    GTask *task = g_task_new(batch->queue, NULL, on_rewrite_done, batch);
+    g_task_set_task_data(task, data, (GDestroyNotify)rewrite_data_free);
+    g_task_run_in_thread(task, rewrite_thread);
+    g_object_unref(task);
+}
+
+static gboolean
+on_flush_timeout(gpointer user_data)
+{
+    ArchiveBatch *batch = user_data;
+    batch->flush_id = 0;
+    /* A running rewrite starts the next one when it finishes */
+    if (!batch->running) archive_batch_start(batch);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+queue_archive_entry(TrashQueue *self, char *archive_path, char *entry_name, GError **error)
+{
+    if (!archive_supports_deletion(archive_path)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Pages can only be deleted from Zip/CBZ archives");
+        g_free(archive_path);
+        g_free(entry_name);
+        return FALSE;
+    }
+
+    ArchiveBatch *batch = g_hash_table_lookup(self->batches, archive_path);
+    if (!batch) {
+        batch = g_new0(ArchiveBatch, 1);
+        batch->queue = self;
+        batch->archive_path = archive_path;
+        batch->pending = g_ptr_array_new_with_free_func(g_free);
+        g_hash_table_insert(self->batches, batch->archive_path, batch);
+    } else {
+        g_free(archive_path);
+    }
+
+    g_ptr_array_add(batch->pending, entry_name);
+
+    /* Restart the delay so a run of deletions becomes one rewrite */
+    if (batch->flush_id) g_source_remove(batch->flush_id);
+    batch->flush_id = g_timeout_add(FLUSH_DELAY_MS, on_flush_timeout, batch);
+    return TRUE;
+}
+
+/* --- Files --- */
+
+static void
+on_trash_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    TrashQueue *self = BRIGHTEYES_TRASH_QUEUE(user_data);
+    GError *error = NULL;
+
+    if (!g_file_trash_finish(G_FILE(source), res, &error)) {
+        char *path = g_file_get_path(G_FILE(source));
+        char *items[] = { path, NULL };
+        g_warning("Failed to move to trash: %s", error->message);
+        g_signal_emit(self, signals[SIGNAL_FAILED], 0, path, 0, error->message, items);
+        g_free(path);
+        g_clear_error(&error);
+    }
+
+    self->n_trashing--;
+    update_hold(self);
+}
+
+/* --- Lifecycle --- */
+
+static void
+trash_queue_finalize(GObject *object)
+{
+    TrashQueue *self = BRIGHTEYES_TRASH_QUEUE(object);
+    g_hash_table_destroy(self->batches);
+    G_OBJECT_CLASS(trash_queue_parent_class)->finalize(object);
+}
+
+static void
+trash_queue_class_init(TrashQueueClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->finalize = trash_queue_finalize;
+
+    signals[SIGNAL_FAILED] = g_signal_new("failed",
+                                          G_TYPE_FROM_CLASS(klass),
+                                          G_SIGNAL_RUN_LAST,
+                                          0,
+                                          NULL, NULL,
+                                          NULL,
+                                          G_TYPE_NONE,
+                                          4,
+                                          G_TYPE_STRING, G_TYPE_UINT, G_TYPE_STRING, G_TYPE_STRV);
+}
+
+static void
+trash_queue_init(TrashQueue *self)
+{
+    self->batches = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)archive_batch_free);
+}
+
+/* --- Public API --- */
+
+TrashQueue *
+trash_queue_new(void)
+{
+    return g_object_new(TYPE_TRASH_QUEUE, NULL);
+}
+
+gboolean
+trash_queue_add(TrashQueue *self, const char *path, GError **error)
+{
+    if (g_str_has_prefix(path, "archive://")) {
+        char *archive_path = NULL;
+        char *entry_name = NULL;
+        if (!archive_split_path(path, &archive_path, &entry_name)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_FILENAME, "Invalid archive path");
+            return FALSE;
+        }
+        if (!queue_archive_entry(self, archive_path, entry_name, error)) return FALSE;
+    } else {
+        GFile *file = g_file_new_for_path(path);
+        self->n_trashing++;
+        g_file_trash_async(file, G_PRIORITY_DEFAULT, NULL, on_trash_done, self);
+        g_object_unref(file);
+    }
+
+    /* Takes the reference the callbacks above rely on */
+    update_hold(self);
+    return TRUE;
+}
+
+void
+trash_queue_flush(TrashQueue *self)
+{
+    GHashTableIter iter;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, self->batches);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        archive_batch_start(value);
+}
+
+gboolean
+trash_queue_is_busy(TrashQueue *self)
+{
+    return self->n_trashing > 0 || g_hash_table_size(self->batches) > 0;
+}
@@ -0,0 +1,36 @@
+#ifndef TRASHQUEUE_H
+#define TRASHQUEUE_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define TYPE_TRASH_QUEUE (trash_queue_get_type())
+G_DECLARE_FINAL_TYPE(TrashQueue, trash_queue, BRIGHTEYES, TRASH_QUEUE, GObject)
+
+/* Deletes files off the main thread. Plain files are moved to the trash
+ * with g_file_trash_async. archive:// pages are collected per archive and
+ * removed together in one rewrite on a worker thread, started once no page
+ * of that archive has been added for a moment (or on trash_queue_flush);
+ * pages added while a rewrite runs go into the next one. The application
+ * is held while anything is pending, so quitting does not lose deletions.
+ *
+ * Signals (main thread):
+ *   "failed" (const char *path, guint n_pages, const char *message, GStrv items)
+ *     Trashing the file at path (n_pages 0), or deleting n_pages pages of
+ *     the archive at path, failed. Nothing was changed on disk; items are
+ *     the paths given to trash_queue_add that are therefore still there. */
+TrashQueue *trash_queue_new(void);
+
+/* Queue path for deletion. Fails at once, queueing nothing, when path can
+ * never be deleted (e.g. a page of a RAR archive). */
+gboolean trash_queue_add(TrashQueue *self, const char *path, GError **error);
+
+/* Start every waiting archive rewrite now. */
+void trash_queue_flush(TrashQueue *self);
+
+gboolean trash_queue_is_busy(TrashQueue *self);
+
+G_END_DECLS
+
+#endif /* TRASHQUEUE_H */
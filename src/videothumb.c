@@ -0,0 +1,233 @@
+#include "videothumb.h"
+#include <gst/gst.h>
+
+/* Video thumbnails (engine pool)
+ *
+ * Building a pipeline per file costs more than grabbing the frame, so
+ * engines (a playbin whose video sink is videoconvert ! videoscale !
+ * gdkpixbufsink) are kept in an idle queue and reset to READY between files:
+ * - Decoders: at first use the ranks of VA-API and NVDEC decoders that are
+ *   installed are raised above the software ones, so decodebin picks them.
+ *   This is process-wide, which also benefits playback in the viewer.
+ * - Capture: preroll in PAUSED, seek to the key frame nearest 10% of the
+ *   duration (the first frame is often black), take the sink's last pixbuf.
+ * - Waiting: state changes are polled in short steps so a timeout or a
+ *   cancelled job ends the wait promptly. An engine that failed is dropped
+ *   rather than reused.
+ *
+ * Sections: decoder ranking, engines, waiting, public API.
+ */
+
+#define VIDEO_TIMEOUT_MS 4000
+#define WAIT_STEP_MS 50
+#define SEEK_FRACTION 10 /* Seek to duration / SEEK_FRACTION */
+
+/* GstPlayFlags: video only, no audio or subtitles */
+#define PLAY_FLAG_VIDEO 0x1
+
+typedef struct {
+    GstElement *playbin;
+    GstElement *caps;
+    GstElement *sink;
+    int width;
+} VideoEngine;
+
+static GAsyncQueue *idle_engines = NULL;
+
+/* --- Decoder ranking --- */
+
+static const char *hw_decoders[] = {
+    "vah264dec", "vah265dec", "vavp9dec", "vaav1dec",
+    "nvh264dec", "nvh265dec", "nvvp9dec", "nvav1dec",
+    "vaapih264dec", "vaapih265dec", "vaapivp9dec",
+    NULL
+};
+
+static void
+prefer_hardware_decoders(void)
+{
+    const char *env = g_getenv("BRIGHTEYES_VIDEO_HWDEC");
+    if (env && g_strcmp0(env, "0") == 0) return;
+
+    for (int i = 0; hw_decoders[i]; i++) {
+        GstElementFactory *factory = gst_element_factory_find(hw_decoders[i]);
+        if (!factory) continue;
+        gst_plugin_feature_set_rank(GST_PLUGIN_FEATURE(factory), GST_RANK_PRIMARY + 1);
+        g_debug("videothumb: preferring %s", hw_decoders[i]);
+        gst_object_unref(factory);
+    }
+}
+
+static void
+video_thumbnail_init(void)
+{
+    static gsize initialized = 0;
+    if (g_once_init_enter(&initialized)) {
+        if (!gst_is_initialized()) gst_init(NULL, NULL);
+        prefer_hardware_decoders();
+        idle_engines = g_async_queue_new();
+        g_once_init_leave(&initialized, 1);
+    }
+}
+
+/* --- Engines --- */
+
+static void
+video_engine_free(VideoEngine *engine)
+{
+    if (engine->playbin) {
+        gst_element_set_state(engine->playbin, GST_STATE_NULL);
+        gst_object_unref(engine->playbin);
+    }
+    g_clear_pointer(&engine->caps, gst_object_unref);
+    g_clear_pointer(&engine->sink, gst_object_unref);
+    g_free(engine);
+}
+
+static VideoEngine *
+video_engine_new(GError **error)
+{
+    GstElement *bin = gst_parse_bin_from_description(
+        "videoconvert ! videoscale ! capsfilter name=caps ! gdkpixbufsink name=sink", TRUE, error);
+    if (!bin) return NULL;
+
+    GstElement *playbin = gst_element_factory_make("playbin", NULL);
+    if (!playbin) {
+        gst_object_unref(bin);
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "GStreamer playbin is not available");
+        return NULL;
+    }
+
+    VideoEngine *engine = g_new0(VideoEngine, 1);
+    engine->playbin = gst_object_ref_sink(playbin);
+    engine->caps = gst_bin_get_by_name(GST_BIN(bin), "caps");
+    engine->sink = gst_bin_get_by_name(GST_BIN(bin), "sink");
+    g_object_set(playbin, "video-sink", bin, "flags", PLAY_FLAG_VIDEO, NULL);
+    return engine;
+}
+
+static VideoEngine *
+video_engine_acquire(GError **error)
+{
+    VideoEngine *engine = g_async_queue_try_pop(idle_engines);
+    return engine ? engine : video_engine_new(error);
+}
+
+static void
+video_engine_release(VideoEngine *engine, gboolean reusable)
+{
+    /* READY keeps the sinks; only the decoding branch is rebuilt per URI */
+    if (reusable && gst_element_set_state(engine->playbin, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE &&
+        g_async_queue_length(idle_engines) < (gint)g_get_num_processors()) {
+        GstBus *bus = gst_element_get_bus(engine->playbin);
+        gst_bus_set_flushing(bus, TRUE);
+        gst_bus_set_flushing(bus, FALSE);
+        gst_object_unref(bus);
+        g_async_queue_push(idle_engines, engine);
+        return;
+    }
+    video_engine_free(engine);
+}
+
+static void
+video_engine_set_width(VideoEngine *engine, int width)
+{
+    if (engine->width == width) return;
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+                                        "width", G_TYPE_INT, width,
+                                        "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                                        NULL);
+    g_object_set(engine->caps, "caps", caps, NULL);
+    gst_caps_unref(caps);
+    engine->width = width;
+}
+
+/* --- Waiting --- */
+
+/* Wait for a pending state change to finish. */
+static gboolean
+video_engine_wait(VideoEngine *engine, gint64 deadline, GCancellable *cancellable, GError **error)
+{
+    for (;;) {
+        GstStateChangeReturn ret = gst_element_get_state(engine->playbin, NULL, NULL, WAIT_STEP_MS * GST_MSECOND);
+        if (ret == GST_STATE_CHANGE_SUCCESS || ret == GST_STATE_CHANGE_NO_PREROLL)
+            return TRUE;
+        if (ret == GST_STATE_CHANGE_FAILURE) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Could not decode video");
+            return FALSE;
+        }
+        if (g_cancellable_set_error_if_cancelled(cancellable, error))
+            return FALSE;
+        if (g_get_monotonic_time() >= deadline) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "Timed out waiting for a video frame");
+            return FALSE;
+        }
+    }
+}
+
+/* --- Public API --- */
+
+GdkPixbuf *
+video_thumbnail_capture(const char *path, int width, GCancellable *cancellable, GError **error)
+{
+    if (!path || path[0] == '\0') {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid path");
+        return NULL;
+    }
+
+    video_thumbnail_init();
+    VideoEngine *engine = video_engine_acquire(error);
+    if (!engine) return NULL;
+
+    gchar *uri = g_filename_to_uri(path, NULL, error);
+    if (!uri) {
+        video_engine_release(engine, TRUE);
+        return NULL;
+    }
+
+    video_engine_set_width(engine, width);
+    g_object_set(engine->playbin, "uri", uri, NULL);
+    g_free(uri);
+
+    gint64 deadline = g_get_monotonic_time() + VIDEO_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+    gst_element_set_state(engine->playbin, GST_STATE_PAUSED);
+    gboolean ok = video_engine_wait(engine, deadline, cancellable, error);
+
+    if (ok) {
+        gint64 duration = 0;
+        if (gst_element_query_duration(engine->playbin, GST_FORMAT_TIME, &duration) && duration > 0 &&
+            gst_element_seek_simple(engine->playbin, GST_FORMAT_TIME,
+                                    GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, duration / SEEK_FRACTION)) {
+            /* A failed seek still leaves the prerolled first frame */
+            GError *seek_error = NULL;
+            if (!video_engine_wait(engine, deadline, cancellable, &seek_error) &&
+                g_error_matches(seek_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_propagate_error(error, seek_error);
+                ok = FALSE;
+            } else {
+                g_clear_error(&seek_error);
+            }
+        }
+    }
+
+    GdkPixbuf *pixbuf = NULL;
+    if (ok) {
+        g_object_get(engine->sink, "last-pixbuf", &pixbuf, NULL);
+        if (!pixbuf)
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to capture video frame");
+    }
+
+    /* Only engines that worked go back to the pool */
+    video_engine_release(engine, pixbuf != NULL);
+    return pixbuf;
+}
+
+void
+video_thumbnail_engines_release(void)
+{
+    if (!idle_engines) return;
+
+    VideoEngine *engine;
+    while ((engine = g_async_queue_try_pop(idle_engines)))
+        video_engine_free(engine);
+}
@@ -0,0 +1,24 @@
+#ifndef BRIGHTEYES_VIDEOTHUMB_H
+#define BRIGHTEYES_VIDEOTHUMB_H
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* Video thumbnails
+ *
+ * Grabs one frame, scaled to width pixels wide, from about 10% into the
+ * video. Pipelines are pooled and reused between files, and hardware
+ * decoders are preferred when GStreamer has them. Blocks until the frame is
+ * ready, the per-file timeout expires or cancellable fires. Thread-safe:
+ * meant for the thumbnail pool threads.
+ *
+ * BRIGHTEYES_VIDEO_HWDEC=0 keeps GStreamer's default (software) decoder
+ * ranking.
+ */
+
+GdkPixbuf *video_thumbnail_capture(const char *path, int width, GCancellable *cancellable, GError **error);
+
+/* Drop idle pipelines (e.g. when the window goes away). */
+void video_thumbnail_engines_release(void);
+
+#endif /* BRIGHTEYES_VIDEOTHUMB_H */
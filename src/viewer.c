@@ -13,7 +13,27 @@
 #include <string.h>
 #include <math.h>
 #include <adwaita.h>
+#include "imageservice.h"
 #include "archive.h"
+#include "thumbnails.h"
+#include "exifthumb.h"
+#include "tiledimage.h"
+#include "metrics.h"
+#include "membudget.h"
+
+/* Smallest embedded preview worth showing while the full image decodes */
+#define PREVIEW_SIZE 160
+
+/* Streaming decode: bytes handed to the loader per read, and how often
+ * (after a short grace period, so fast loads never show one) a partially
+ * decoded image is put on screen, downscaled to at most PARTIAL_SIZE. */
+#define LOAD_CHUNK_SIZE (64 * 1024)
+#define PARTIAL_DELAY (150 * G_TIME_SPAN_MILLISECOND)
+#define PARTIAL_INTERVAL (250 * G_TIME_SPAN_MILLISECOND)
+#define PARTIAL_SIZE 1024
+
+/* How often the metrics overlay is redrawn while shown */
+#define METRICS_REFRESH_MS 500
 
 /* Animation pipeline removed to simplify the code; zooming will be reimplemented later. */
 
@@ -36,14 +56,10 @@ struct _Viewer {
     
     /* State */
     GdkPixbuf *original_pixbuf;
-    /* Cached full-resolution texture derived from rotated pixbuf to avoid expensive
-     * scaling each frame during animated zooms. We regenerate when the source pixbuf
-     * or rotation changes.
-     * preview_texture: a downscaled version used during animated zoom to reduce GPU
-     * scaling costs for very large images. */
-    GdkTexture *original_texture;
-    GdkTexture *preview_texture;
-    int original_texture_rotation_angle;
+    /* Paintable wrapping original_pixbuf without copying it. Built once per
+     * pixbuf; zoom and rotation are applied when drawing. Large images are
+     * drawn tile by tile from a mip pyramid built on demand. */
+    TiledImage *tiled_image;
     double zoom_level;
     gboolean fit_to_window;
     gboolean fit_to_width;
@@ -58,8 +74,15 @@ struct _Viewer {
     GtkWidget *selection_overlay; /* draws selection rectangle */
     GtkGesture *selection_gesture;
 
-    /* Debug overlay for allocation inspection */
+    /* Debug overlay: allocation details and, when enabled, live metrics */
     GtkWidget *debug_label;
+    char *alloc_info;
+    guint metrics_refresh_id;
+    gint64 load_started; /* metrics_start() of the latest load */
+
+    /* Memory budget: bytes of original_pixbuf accounted, and our shedder */
+    gsize accounted_bytes;
+    guint shedder_id;
 
     /* Panning state */
     double pan_start_adj_h;
@@ -87,6 +110,15 @@ struct _Viewer {
     double scroll_accumulator;
     guint scroll_timeout_id;
     GCancellable *load_cancellable;
+
+    /* Shared decoding */
+    char *loading_path;        /* Path passed to the latest viewer_load_file */
+    ImageClaim *claim;         /* Set while our own decode of loading_path runs */
+
+    /* Two-phase display: a thumbnail-sized preview stands in until the full
+     * decode arrives, which then crossfades in on the other picture. */
+    gboolean image_pending;     /* loading_path is an image not shown yet */
+    GtkWidget *preview_picture; /* Picture stretched for a preview, or NULL */
 };
 
 /* scroll_timeout_cb removed: unused while scroll-wheel zoom is disabled. */
@@ -95,6 +127,7 @@ enum {
     SIGNAL_ZOOM_CHANGED,
     SIGNAL_OPEN_REQUESTED,
     SIGNAL_PLAYBACK_CHANGED,
+    SIGNAL_IMAGE_LOADED,
     N_SIGNALS
 };
 
@@ -112,6 +145,9 @@ static void viewer_update_image(Viewer *self);
 static double get_fit_zoom_level(Viewer *self);
 static double get_fit_width_zoom(Viewer *self);
 static void viewer_set_zoom_level_internal(Viewer *self, double target_scale, gboolean center);
+static void viewer_update_visible_area(Viewer *self);
+static void viewer_show_preview(Viewer *self, GdkPaintable *preview);
+static void viewer_update_debug_label(Viewer *self);
 
 /* Animation helpers */
 /* Animation helpers removed. */
@@ -273,6 +309,21 @@ on_volume_changed(GtkRange *range, Viewer *self)
     update_volume_icon(self);
 }
 
+static void
+on_scroll_value_changed(GtkAdjustment *adj, Viewer *self)
+{
+    viewer_update_visible_area(self);
+}
+
+/* Moving to a monitor of another scale changes which level is sharp */
+static void
+on_scale_factor_changed(GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+    Viewer *self = VIEWER(object);
+    if (self->tiled_image)
+        tiled_image_set_scale_factor(self->tiled_image, gtk_widget_get_scale_factor(GTK_WIDGET(self)));
+}
+
 static void
 on_viewport_resize(GObject *object, GParamSpec *pspec, gpointer user_data)
 {
@@ -292,6 +343,24 @@ on_viewport_resize(GObject *object, GParamSpec *pspec, gpointer user_data)
     }
 }
 
+/* Keep the memory budget in step with original_pixbuf */
+static void
+viewer_account_memory(Viewer *self)
+{
+    gsize bytes = self->original_pixbuf ? gdk_pixbuf_get_byte_length(self->original_pixbuf) : 0;
+    mem_budget_add(MEM_POOL_VIEWER, (gssize)bytes - (gssize)self->accounted_bytes);
+    self->accounted_bytes = bytes;
+}
+
+/* Last in line under memory pressure: the image on screen stays, its
+ * preview levels and tile textures are rebuilt when next needed. */
+static void
+viewer_shed_memory(MemShedLevel level, gsize excess, gpointer user_data)
+{
+    Viewer *self = VIEWER(user_data);
+    if (self->tiled_image) tiled_image_trim(self->tiled_image);
+}
+
 /* Lifecycle (GObject)
  *
  * GObject lifecycle methods for the Viewer: instance initialization,
@@ -307,8 +376,9 @@ viewer_init(Viewer *self)
     self->scroll_accumulator = 0.0;
     self->scroll_timeout_id = 0;
     /* animation pipeline removed; no animation state */
-    self->original_texture = NULL;
-    self->original_texture_rotation_angle = -1;
+    self->tiled_image = NULL;
+    self->shedder_id = mem_budget_add_shedder(MEM_POOL_VIEWER, viewer_shed_memory, self);
+    g_signal_connect(self, "notify::scale-factor", G_CALLBACK(on_scale_factor_changed), NULL);
 
     /* Start with full volume by default */
     self->saved_volume = 1.0;
@@ -327,7 +397,9 @@ viewer_init(Viewer *self)
         ".video-overlay { border-radius: 9999px; padding: 0 10px; min-height: 40px; } \n"
         ".video-overlay button { min-height: 24px; min-width: 24px; padding: 4px; margin: 2px; border-radius: 9999px; } \n"
         ".video-overlay image { margin: 0 8px; } \n"
-        ".video-overlay scale { margin: 0 6px; }");
+        ".video-overlay scale { margin: 0 6px; } \n"
+        ".debug-overlay { background-color: alpha(black, 0.6); color: white; padding: 6px 8px; "
+        "border-radius: 6px; font-family: monospace; font-size: smaller; }");
     gtk_style_context_add_provider_for_display(gdk_display_get_default(),
                                                GTK_STYLE_PROVIDER(provider),
                                                GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
@@ -362,6 +434,11 @@ viewer_init(Viewer *self)
     /* Also listen for page_size changes (e.g. scrollbar appearance) to refine fit-to-width */
     GtkAdjustment *hadj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(self->scrolled_window));
     g_signal_connect(hadj, "notify::page-size", G_CALLBACK(on_viewport_resize), self);
+
+    /* Tiled images draw only what is on screen; keep them informed */
+    GtkAdjustment *vadj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(self->scrolled_window));
+    g_signal_connect(hadj, "value-changed", G_CALLBACK(on_scroll_value_changed), self);
+    g_signal_connect(vadj, "value-changed", G_CALLBACK(on_scroll_value_changed), self);
     
     /* Image Stack for Transitions */
     self->image_stack = gtk_stack_new();
@@ -572,10 +649,22 @@ viewer_dispose(GObject *gobject)
     
     viewer_stop_playback(self);
 
+    image_service_complete(g_steal_pointer(&self->claim), NULL);
+    g_clear_pointer(&self->loading_path, g_free);
+
+    if (self->metrics_refresh_id) {
+        g_source_remove(self->metrics_refresh_id);
+        self->metrics_refresh_id = 0;
+    }
+    g_clear_pointer(&self->alloc_info, g_free);
+
+    if (self->shedder_id) {
+        mem_budget_remove_shedder(self->shedder_id);
+        self->shedder_id = 0;
+    }
     g_clear_object(&self->original_pixbuf);
-    g_clear_object(&self->original_texture);
-    g_clear_object(&self->preview_texture);
-    self->original_texture_rotation_angle = -1;
+    g_clear_object(&self->tiled_image);
+    viewer_account_memory(self);
     G_OBJECT_CLASS(viewer_parent_class)->dispose(gobject);
 }
 
@@ -613,6 +702,16 @@ viewer_class_init(ViewerClass *klass)
                                                     G_TYPE_NONE,
                                                     1,
                                                     G_TYPE_BOOLEAN);
+
+    signals[SIGNAL_IMAGE_LOADED] = g_signal_new("image-loaded",
+                                                G_TYPE_FROM_CLASS(klass),
+                                                G_SIGNAL_RUN_LAST,
+                                                0,
+                                                NULL, NULL,
+                                                NULL,
+                                                G_TYPE_NONE,
+                                                3,
+                                                G_TYPE_STRING, G_TYPE_INT, G_TYPE_INT);
 }
 
 Viewer *
@@ -632,55 +731,218 @@ viewer_is_playing(Viewer *self)
     return state == GST_STATE_PLAYING;
 }
 
+/* Show a decoded image in the active picture and reset per-image view state. */
+static void
+viewer_show_pixbuf(Viewer *self, GdkPixbuf *pixbuf)
+{
+    /* Replace stored pixbuf with the newly loaded one and invalidate cached textures */
+    g_clear_object(&self->original_pixbuf);
+    g_clear_object(&self->tiled_image);
+
+    self->original_pixbuf = g_object_ref(pixbuf);
+    viewer_account_memory(self);
+    self->image_pending = FALSE;
+
+    /* The preview sits in the active picture: draw the full image in the
+       other one so the stack crossfades between them */
+    if (self->preview_picture == self->active_picture)
+        self->active_picture = (self->active_picture == self->picture_1) ? self->picture_2 : self->picture_1;
+
+    self->zoom_level = 1.0;
+    self->rotation_angle = 0;
+    /* Preserve fit-to-width across page loads (e.g. comics). */
+    self->fit_to_window = self->fit_to_width ? FALSE : self->default_fit;
+
+    /* Update the image now that we have a pixbuf */
+    viewer_update_image(self);
+
+    const char *view_name = (self->active_picture == self->picture_1) ? "view1" : "view2";
+    gtk_stack_set_visible_child_name(GTK_STACK(self->image_stack), view_name);
+
+    metrics_record(METRICS_LOAD_TO_DISPLAY, self->load_started);
+    self->load_started = 0;
+
+    g_signal_emit(self, signals[SIGNAL_IMAGE_LOADED], 0, self->loading_path,
+                  gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+}
+
+typedef struct {
+    GInputStream *stream;
+    gint64 started;
+    gint64 last_partial;
+    int decoded_rows; /* Rows the loader has reported as written */
+    gboolean dirty;   /* New rows since the last partial image */
+} StreamLoad;
+
+typedef struct {
+    Viewer *viewer;
+    GCancellable *cancellable;
+    GdkPixbuf *pixbuf;
+} PartialImage;
+
+static void
+stream_load_free(StreamLoad *load)
+{
+    g_clear_object(&load->stream);
+    g_free(load);
+}
+
+static void
+partial_image_free(PartialImage *partial)
+{
+    g_clear_object(&partial->viewer);
+    g_clear_object(&partial->cancellable);
+    g_clear_object(&partial->pixbuf);
+    g_free(partial);
+}
+
+static gboolean
+partial_image_show(gpointer user_data)
+{
+    PartialImage *partial = user_data;
+    if (!g_cancellable_is_cancelled(partial->cancellable)) {
+        GdkTexture *texture = gdk_texture_new_for_pixbuf(partial->pixbuf);
+        viewer_show_preview(partial->viewer, GDK_PAINTABLE(texture));
+        g_object_unref(texture);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/* Worker thread: runs between loader writes, so the pixbuf is not being
+ * written while it is read here. */
+static void
+on_loader_area_updated(GdkPixbufLoader *loader, int x, int y, int width, int height, gpointer user_data)
+{
+    StreamLoad *load = user_data;
+    load->decoded_rows = MAX(load->decoded_rows, y + height);
+    load->dirty = TRUE;
+}
+
+/* Downscaled copy of what has been decoded so far; rows not decoded yet stay
+ * transparent rather than showing uninitialised memory. */
+static GdkPixbuf *
+partial_snapshot(GdkPixbuf *pixbuf, int decoded_rows)
+{
+    int w = gdk_pixbuf_get_width(pixbuf);
+    int h = gdk_pixbuf_get_height(pixbuf);
+    double scale = MIN(1.0, (double)PARTIAL_SIZE / MAX(w, h));
+    int dw = MAX(1, (int)(w * scale));
+    int dh = MAX(1, (int)(h * scale));
+
+    GdkPixbuf *dest = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, dw, dh);
+    if (!dest) return NULL;
+    gdk_pixbuf_fill(dest, 0);
+    int rows = MIN(dh, (int)(decoded_rows * scale));
+    if (rows > 0)
+        gdk_pixbuf_scale(pixbuf, dest, 0, 0, dw, rows, 0, 0, scale, scale, GDK_INTERP_BILINEAR);
+    return dest;
+}
+
+static void
+stream_load_publish(GTask *task, StreamLoad *load, GdkPixbufLoader *loader)
+{
+    gint64 now = g_get_monotonic_time();
+    if (!load->dirty || now - load->started < PARTIAL_DELAY || now - load->last_partial < PARTIAL_INTERVAL)
+        return;
+
+    GdkPixbuf *pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+    if (!pixbuf) return;
+
+    load->dirty = FALSE;
+    load->last_partial = now;
+
+    PartialImage *partial = g_new0(PartialImage, 1);
+    partial->pixbuf = partial_snapshot(pixbuf, load->decoded_rows);
+    if (!partial->pixbuf) {
+        g_free(partial);
+        return;
+    }
+    partial->viewer = g_object_ref(g_task_get_source_object(task));
+    partial->cancellable = g_object_ref(g_task_get_cancellable(task));
+    g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT, partial_image_show, partial,
+                               (GDestroyNotify)partial_image_free);
+}
+
+/* Feed the stream to a GdkPixbufLoader chunk by chunk, so decoding overlaps
+ * the reads and slow sources show rows as they arrive. */
+static void
+stream_load_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    StreamLoad *load = task_data;
+    GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+    g_signal_connect(loader, "area-updated", G_CALLBACK(on_loader_area_updated), load);
+    load->started = g_get_monotonic_time();
+
+    guint8 *buffer = g_malloc(LOAD_CHUNK_SIZE);
+    GError *error = NULL;
+    gboolean ok = TRUE;
+    for (;;) {
+        gssize n = g_input_stream_read(load->stream, buffer, LOAD_CHUNK_SIZE, cancellable, &error);
+        if (n <= 0) {
+            ok = (n == 0);
+            break;
+        }
+        if (!gdk_pixbuf_loader_write(loader, buffer, (gsize)n, &error)) {
+            ok = FALSE;
+            break;
+        }
+        stream_load_publish(task, load, loader);
+    }
+    g_free(buffer);
+
+    /* The loader must always be closed; keep the first error */
+    if (ok)
+        ok = gdk_pixbuf_loader_close(loader, &error);
+    else
+        gdk_pixbuf_loader_close(loader, NULL);
+
+    GdkPixbuf *pixbuf = ok ? gdk_pixbuf_loader_get_pixbuf(loader) : NULL;
+    if (pixbuf)
+        g_task_return_pointer(task, g_object_ref(pixbuf), g_object_unref);
+    else if (error)
+        g_task_return_error(task, error);
+    else
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED, "Unrecognised image data");
+    g_object_unref(loader);
+}
+
 static void
 on_pixbuf_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
 {
-    Viewer *self = VIEWER(user_data);
+    Viewer *self = VIEWER(source);
     GError *err = NULL;
-    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream_finish(res, &err);
+    GdkPixbuf *pixbuf = g_task_propagate_pointer(G_TASK(res), &err);
 
     if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        /* Superseded by a newer load, which cancelled ours */
         g_clear_error(&err);
-        g_object_unref(self);
         return;
     }
 
+    /* Hand the result to anyone waiting for it; it is also cached so
+       stepping back to this image is instant */
+    image_service_complete(g_steal_pointer(&self->claim), pixbuf);
+
     if (!pixbuf) {
         g_warning("Failed to load image: %s", err ? err->message : "Unknown error");
         g_clear_error(&err);
-        g_object_unref(self);
         return;
     }
 
-    /* If we have a new cancellable (i.e. another load started), discard this result? 
-       No, the cancellable we passed would have been triggered. 
-       But self->load_cancellable might be DIFFERENT now if a new load started and we didn't use the one passed?
-       In this design, we use self->load_cancellable passed to the async func. 
-       If a new load started, self->load_cancellable was replaced and the old one cancelled. 
-       So checking G_IO_ERROR_CANCELLED is sufficient.
-    */
-
-    /* Replace stored pixbuf with the newly loaded one and invalidate cached textures */
-    g_clear_object(&self->original_pixbuf);
-    g_clear_object(&self->original_texture);
-    g_clear_object(&self->preview_texture);
-    self->original_texture_rotation_angle = -1;
-
-    /* Take ownership of the loaded pixbuf */
-    self->original_pixbuf = pixbuf;
-
-    self->zoom_level = 1.0;
-    self->rotation_angle = 0;
-    /* Preserve fit-to-width across page loads (e.g. comics). */
-    self->fit_to_window = self->fit_to_width ? FALSE : self->default_fit;
+    viewer_show_pixbuf(self, pixbuf);
+    g_object_unref(pixbuf);
+}
 
-    /* Update the image now that we have a pixbuf */
-    viewer_update_image(self);
+static void
+viewer_decode_stream(Viewer *self, GInputStream *stream)
+{
+    StreamLoad *load = g_new0(StreamLoad, 1);
+    load->stream = g_object_ref(stream);
 
-    const char *view_name = (self->active_picture == self->picture_1) ? "view1" : "view2";
-    gtk_stack_set_visible_child_name(GTK_STACK(self->image_stack), view_name);
-    
-    g_object_unref(self);
+    GTask *task = g_task_new(self, self->load_cancellable, on_pixbuf_loaded, NULL);
+    g_task_set_task_data(task, load, (GDestroyNotify)stream_load_free);
+    g_task_run_in_thread(task, stream_load_thread);
+    g_object_unref(task);
 }
 
 static void
@@ -688,7 +950,7 @@ on_archive_entry_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
 {
     Viewer *self = VIEWER(user_data);
     GError *err = NULL;
-    GBytes *bytes = archive_read_entry_bytes_finish(res, &err);
+    GBytes *bytes = image_service_read_bytes_finish(res, &err);
 
     if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
         g_clear_error(&err);
@@ -699,6 +961,7 @@ on_archive_entry_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
     if (!bytes) {
         g_warning("Failed to read archive entry: %s", err ? err->message : "unknown");
         g_clear_error(&err);
+        image_service_complete(g_steal_pointer(&self->claim), NULL);
         /* If we fail, we still own the ref to self, so unref it */
         g_object_unref(self);
         return;
@@ -706,21 +969,12 @@ on_archive_entry_loaded(GObject *source, GAsyncResult *res, gpointer user_data)
 
     g_debug("Got %zu bytes from archive entry (async)", g_bytes_get_size(bytes));
 
-    /* Create memory input stream from a copy of the bytes */
-    gsize size = g_bytes_get_size(bytes);
-    const guint8 *data = g_bytes_get_data(bytes, NULL);
-    guint8 *copy = g_malloc(size);
-    memcpy(copy, data, size);
-    GInputStream *mem = g_memory_input_stream_new_from_data(copy, (gssize)size, g_free);
+    /* The stream shares the entry's bytes; no copy needed */
+    GInputStream *mem = g_memory_input_stream_new_from_bytes(bytes);
     g_bytes_unref(bytes);
-
-    /* Feed into gdk-pixbuf async loader */
-    /* Pass ownership of 'self' to the next callback */
-    gdk_pixbuf_new_from_stream_async(G_INPUT_STREAM(mem), 
-                                     self->load_cancellable, 
-                                     on_pixbuf_loaded, 
-                                     self);
+    viewer_decode_stream(self, mem);
     g_object_unref(mem);
+    g_object_unref(self);
 }
 
 static void
@@ -739,16 +993,129 @@ on_file_read(GObject *source, GAsyncResult *res, gpointer user_data)
     if (!stream) {
         g_warning("Failed to open file: %s", err ? err->message : "Unknown error");
         g_clear_error(&err);
+        image_service_complete(g_steal_pointer(&self->claim), NULL);
         g_object_unref(self);
         return;
     }
 
-    gdk_pixbuf_new_from_stream_async(G_INPUT_STREAM(stream), 
-                                     self->load_cancellable, 
-                                     on_pixbuf_loaded, 
-                                     self);
-    
+    viewer_decode_stream(self, G_INPUT_STREAM(stream));
     g_object_unref(stream);
+    g_object_unref(self);
+}
+
+/* Phase one of an image load: put a cheap preview on screen right away. */
+static void
+viewer_show_preview(Viewer *self, GdkPaintable *preview)
+{
+    if (!self->image_pending) return;
+
+    /* Stretch the small preview to where the fitted image will be */
+    GtkWidget *picture = self->active_picture;
+    gtk_picture_set_paintable(GTK_PICTURE(picture), preview);
+    gtk_picture_set_can_shrink(GTK_PICTURE(picture), TRUE);
+    gtk_widget_set_size_request(picture, -1, -1);
+    gtk_widget_set_halign(picture, GTK_ALIGN_FILL);
+    gtk_widget_set_valign(picture, GTK_ALIGN_FILL);
+    gtk_widget_set_size_request(self->image_stack, -1, -1);
+    gtk_widget_set_halign(self->image_stack, GTK_ALIGN_FILL);
+    gtk_widget_set_valign(self->image_stack, GTK_ALIGN_FILL);
+    self->preview_picture = picture;
+
+    const char *view_name = (picture == self->picture_1) ? "view1" : "view2";
+    gtk_stack_set_visible_child_name(GTK_STACK(self->image_stack), view_name);
+}
+
+static void
+preview_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    if (g_task_return_error_if_cancelled(task)) return;
+
+    GdkPixbuf *pixbuf = exif_thumbnail_from_file(task_data, PREVIEW_SIZE);
+    if (pixbuf)
+        g_task_return_pointer(task, pixbuf, g_object_unref);
+    else
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No embedded preview");
+}
+
+static void
+on_preview_ready(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    Viewer *self = VIEWER(source);
+    /* Cancelled (superseded) loads come back as errors */
+    GdkPixbuf *pixbuf = g_task_propagate_pointer(G_TASK(res), NULL);
+    if (!pixbuf) return;
+
+    GdkTexture *texture = gdk_texture_new_for_pixbuf(pixbuf);
+    viewer_show_preview(self, GDK_PAINTABLE(texture));
+    g_object_unref(texture);
+    g_object_unref(pixbuf);
+}
+
+/* Look for a preview of path: the thumbnail bar's cache first, then the
+ * camera preview embedded in the file (read on a worker; the file may be on
+ * slow storage). */
+static void
+viewer_start_preview(Viewer *self, const char *path)
+{
+    self->image_pending = TRUE;
+
+    GdkPaintable *cached = thumbnail_cache_lookup(path);
+    if (cached) {
+        viewer_show_preview(self, cached);
+        g_object_unref(cached);
+        return;
+    }
+
+    /* Archive entries must be read whole anyway; the full decode is next */
+    if (g_str_has_prefix(path, "archive://")) return;
+
+    GTask *task = g_task_new(self, self->load_cancellable, on_preview_ready, NULL);
+    g_task_set_task_data(task, g_strdup(path), g_free);
+    g_task_run_in_thread(task, preview_thread);
+    g_object_unref(task);
+}
+
+/* Start decoding an image (plain file or archive entry) into the active picture. */
+static void
+viewer_start_image_load(Viewer *self, const char *path)
+{
+    /* Archive virtual path handling: archive://<archive_path>::<entry_name> */
+    if (g_str_has_prefix(path, "archive://")) {
+        const char *sep = strstr(path, "::");
+        if (!sep) {
+            g_warning("Invalid archive path: %s", path);
+            return;
+        }
+        g_debug("Loading image from archive entry '%s'", sep + 2);
+
+        /* Shares the extraction with a thumbnail being made of the same page */
+        g_object_ref(self);
+        image_service_read_bytes_async(path, self->load_cancellable, on_archive_entry_loaded, self);
+        return;
+    }
+
+    GFile *file = g_file_new_for_path(path);
+    g_object_ref(self);
+    g_file_read_async(file, G_PRIORITY_DEFAULT, self->load_cancellable, on_file_read, self);
+    g_object_unref(file);
+}
+
+/* Someone else (usually the prefetcher) was already decoding the image */
+static void
+on_shared_image_ready(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    Viewer *self = VIEWER(user_data);
+    GError *err = NULL;
+    GdkPixbuf *pixbuf = image_service_request_finish(res, &err);
+
+    if (pixbuf) {
+        viewer_show_pixbuf(self, pixbuf);
+        g_object_unref(pixbuf);
+    } else if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_warning("Failed to load image: %s", err ? err->message : "Unknown error");
+    }
+    g_clear_error(&err);
+    g_object_unref(self);
 }
 
 void
@@ -760,6 +1127,11 @@ viewer_load_file(Viewer *self, const char *path)
         g_clear_object(&self->load_cancellable);
     }
     self->load_cancellable = g_cancellable_new();
+    image_service_complete(g_steal_pointer(&self->claim), NULL);
+    self->image_pending = FALSE;
+    g_free(self->loading_path);
+    self->loading_path = g_strdup(path);
+    self->load_started = metrics_start();
 
     /* Reset selection mode and clear selection on file change */
     self->selection_mode = FALSE;
@@ -778,131 +1150,127 @@ viewer_load_file(Viewer *self, const char *path)
     /* Prepare transition: load into the non-active picture */
     GtkWidget *target_picture = (self->active_picture == self->picture_1) ? self->picture_2 : self->picture_1;
     self->active_picture = target_picture;
+    if (self->preview_picture == target_picture) {
+        /* Undo the stretching from an earlier preview */
+        gtk_widget_set_halign(target_picture, GTK_ALIGN_CENTER);
+        gtk_widget_set_valign(target_picture, GTK_ALIGN_CENTER);
+        self->preview_picture = NULL;
+    }
 
     if (self->stack)
         gtk_stack_set_visible_child_name(self->stack, "content");
 
     g_debug("Loading file: %s", path);
 
-    /* Archive virtual path handling: archive://<archive_path>::<entry_name> */
-    if (g_str_has_prefix(path, "archive://")) {
-        const char *sep = strstr(path, "::");
-        if (!sep) {
-            g_warning("Invalid archive path: %s", path);
+    /* Images: archive pages are never videos */
+    if (g_str_has_prefix(path, "archive://") || !archive_is_video_path(path)) {
+        g_debug("File detected as image.");
+        viewer_stop_playback(self);
+
+        GdkPixbuf *ready = image_service_lookup(path, 0);
+        if (ready) {
+            g_debug("Using cached image for %s", path);
+            viewer_show_pixbuf(self, ready);
+            g_object_unref(ready);
             return;
         }
-        size_t archive_len = sep - (path + strlen("archive://"));
-        char *archive_path = g_strndup(path + strlen("archive://"), archive_len);
-        char *entry_name = g_strdup(sep + 2);
 
-        g_debug("Loading image from archive '%s' entry '%s'", archive_path, entry_name);
+        viewer_start_preview(self, path);
 
-        g_object_ref(self);
-        archive_read_entry_bytes_async(archive_path, entry_name, self->load_cancellable, on_archive_entry_loaded, self);
+        self->claim = image_service_claim(path);
+        if (!self->claim) {
+            /* Already being decoded: wait for it instead of decoding twice */
+            image_service_request_async(path, 0, self->load_cancellable, on_shared_image_ready, g_object_ref(self));
+            return;
+        }
 
-        g_free(archive_path);
-        g_free(entry_name);
+        viewer_start_image_load(self, path);
         return;
     }
 
-    const char *ext = strrchr(path, '.');
-    if (ext && (g_ascii_strcasecmp(ext, ".mp4") == 0 || g_ascii_strcasecmp(ext, ".mkv") == 0 ||
-                g_ascii_strcasecmp(ext, ".webm") == 0 || g_ascii_strcasecmp(ext, ".avi") == 0)) {
-        
-        g_debug("File detected as video.");
-        if (!gst_is_initialized()) {
-            g_debug("Initializing GStreamer...");
-            gst_init(NULL, NULL);
-        }
+    /* Video */
+    g_debug("File detected as video.");
+    if (!gst_is_initialized()) {
+        g_debug("Initializing GStreamer...");
+        gst_init(NULL, NULL);
+    }
 
-        /* Stop old playback */
-        viewer_stop_playback(self);
+    /* Stop old playback */
+    viewer_stop_playback(self);
 
-        g_debug("Creating playbin...");
-        self->playbin = gst_element_factory_make("playbin", "player");
-        if (!self->playbin) {
-            g_warning("Failed to create playbin");
-            return;
-        }
-        g_object_ref_sink(self->playbin);
-
-        /* Connect to bus for errors */
-        GstBus *bus = gst_element_get_bus(self->playbin);
-        gst_bus_add_signal_watch(bus);
-        g_signal_connect(bus, "message::error", G_CALLBACK(on_gst_error), self);
-        gst_object_unref(bus);
-
-        g_debug("Creating video sink...");
-        GstElement *sink = gst_element_factory_make("gtk4paintablesink", "video-sink");
-        if (sink) {
-            /* Safely handle sink ownership */
-            g_object_ref(sink); /* Keep a ref while we use it */
-            
-            g_object_set(self->playbin, "video-sink", sink, NULL); /* playbin takes ownership too */
-
-            GdkPaintable *paintable = NULL;
-            g_object_get(sink, "paintable", &paintable, NULL);
-            
-            if (paintable) {
-                gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), paintable);
-                if (self->fit_to_window) {
-                    gtk_picture_set_can_shrink(GTK_PICTURE(self->active_picture), TRUE);
-                }
-                g_object_unref(paintable);
+    g_debug("Creating playbin...");
+    self->playbin = gst_element_factory_make("playbin", "player");
+    if (!self->playbin) {
+        g_warning("Failed to create playbin");
+        return;
+    }
+    g_object_ref_sink(self->playbin);
+
+    /* Connect to bus for errors */
+    GstBus *bus = gst_element_get_bus(self->playbin);
+    gst_bus_add_signal_watch(bus);
+    g_signal_connect(bus, "message::error", G_CALLBACK(on_gst_error), self);
+    gst_object_unref(bus);
+
+    g_debug("Creating video sink...");
+    GstElement *sink = gst_element_factory_make("gtk4paintablesink", "video-sink");
+    if (sink) {
+        /* Safely handle sink ownership */
+        g_object_ref(sink); /* Keep a ref while we use it */
+        
+        g_object_set(self->playbin, "video-sink", sink, NULL); /* playbin takes ownership too */
+
+        GdkPaintable *paintable = NULL;
+        g_object_get(sink, "paintable", &paintable, NULL);
+        
+        if (paintable) {
+            gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), paintable);
+            if (self->fit_to_window) {
+                gtk_picture_set_can_shrink(GTK_PICTURE(self->active_picture), TRUE);
             }
-            
-            g_object_unref(sink); /* Release our temp ref */
+            g_object_unref(paintable);
         }
+        
+        g_object_unref(sink); /* Release our temp ref */
+    }
 
-        /* Configure playbin */
-        gchar *uri = g_filename_to_uri(path, NULL, NULL);
-        g_object_set(self->playbin, "uri", uri, NULL);
-        g_free(uri);
-
-        /* Cleanup original pixbuf to save memory */
-        g_clear_object(&self->original_pixbuf);
-        g_clear_object(&self->original_texture);
-        g_clear_object(&self->preview_texture);
-        self->original_texture_rotation_angle = -1;
-
-        g_debug("Starting playback...");
-        GstStateChangeReturn ret = gst_element_set_state(self->playbin, GST_STATE_PLAYING);
-        if (ret == GST_STATE_CHANGE_FAILURE) {
-            g_warning("Failed to start playback");
-        } else {
-            gtk_widget_set_visible(self->video_controls_overlay, TRUE);
-            /* Reset Play button icon */
-            gtk_button_set_icon_name(GTK_BUTTON(self->play_pause_btn), "media-playback-pause-symbolic");
-            
-            /* Apply current volume to new playbin */
-            g_object_set(self->playbin, "volume", gtk_range_get_value(GTK_RANGE(self->volume_scale)), NULL);
-            update_volume_icon(self);
-
-            /* Reset seek bar */
-            g_signal_handlers_block_by_func(self->seek_scale, on_seek_value_changed, self);
-            gtk_range_set_value(GTK_RANGE(self->seek_scale), 0);
-            g_signal_handlers_unblock_by_func(self->seek_scale, on_seek_value_changed, self);
-            
-            if (self->video_update_id == 0)
-                self->video_update_id = g_timeout_add(200, on_video_update, self);
-
-            /* Start Transition for Video */
-            const char *view_name = (self->active_picture == self->picture_1) ? "view1" : "view2";
-            gtk_stack_set_visible_child_name(GTK_STACK(self->image_stack), view_name);
-
-            /* Emit playback changed */
-            g_signal_emit(self, signals[SIGNAL_PLAYBACK_CHANGED], 0, TRUE);
-        }
-    
+    /* Configure playbin */
+    gchar *uri = g_filename_to_uri(path, NULL, NULL);
+    g_object_set(self->playbin, "uri", uri, NULL);
+    g_free(uri);
+
+    /* Cleanup original pixbuf to save memory */
+    g_clear_object(&self->original_pixbuf);
+    g_clear_object(&self->tiled_image);
+    viewer_account_memory(self);
+
+    g_debug("Starting playback...");
+    GstStateChangeReturn ret = gst_element_set_state(self->playbin, GST_STATE_PLAYING);
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+        g_warning("Failed to start playback");
     } else {
-        g_debug("File detected as image.");
-        /* Load image */
-        viewer_stop_playback(self);
+        gtk_widget_set_visible(self->video_controls_overlay, TRUE);
+        /* Reset Play button icon */
+        gtk_button_set_icon_name(GTK_BUTTON(self->play_pause_btn), "media-playback-pause-symbolic");
         
-        GFile *file = g_file_new_for_path(path);
-        g_object_ref(self);
-        g_file_read_async(file, G_PRIORITY_DEFAULT, self->load_cancellable, on_file_read, self);
-        g_object_unref(file);
+        /* Apply current volume to new playbin */
+        g_object_set(self->playbin, "volume", gtk_range_get_value(GTK_RANGE(self->volume_scale)), NULL);
+        update_volume_icon(self);
+
+        /* Reset seek bar */
+        g_signal_handlers_block_by_func(self->seek_scale, on_seek_value_changed, self);
+        gtk_range_set_value(GTK_RANGE(self->seek_scale), 0);
+        g_signal_handlers_unblock_by_func(self->seek_scale, on_seek_value_changed, self);
+        
+        if (self->video_update_id == 0)
+            self->video_update_id = g_timeout_add(200, on_video_update, self);
+
+        /* Start Transition for Video */
+        const char *view_name = (self->active_picture == self->picture_1) ? "view1" : "view2";
+        gtk_stack_set_visible_child_name(GTK_STACK(self->image_stack), view_name);
+
+        /* Emit playback changed */
+        g_signal_emit(self, signals[SIGNAL_PLAYBACK_CHANGED], 0, TRUE);
     }
 }
 
@@ -911,67 +1279,17 @@ viewer_update_image(Viewer *self)
 {
     if (!self->original_pixbuf) return;
 
-    GdkPixbuf *rotated = NULL;
-    if (self->rotation_angle != 0) {
-        rotated = gdk_pixbuf_rotate_simple(self->original_pixbuf, self->rotation_angle);
-    } else {
-        rotated = g_object_ref(self->original_pixbuf);
-    }
-
-    gboolean has_alpha = gdk_pixbuf_get_has_alpha(rotated);
-    
-    /* Use a cached full-resolution texture derived from the rotated pixbuf.
-       Avoid CPU-intensive per-frame scaling for animated zoom; instead set the
-       widget size request and let the GPU/texture scaling handle the visual
-       scaling. */
-    if (self->original_texture == NULL || self->original_texture_rotation_angle != self->rotation_angle) {
-        /* (Re)create cached texture for current rotation */
-        g_clear_object(&self->original_texture);
-
-        int rwidth = gdk_pixbuf_get_width(rotated);
-        int rheight = gdk_pixbuf_get_height(rotated);
-        int rstride = gdk_pixbuf_get_rowstride(rotated);
-
-        g_object_ref(rotated);
-        GBytes *rbytes = g_bytes_new_with_free_func(gdk_pixbuf_get_pixels(rotated),
-                                                    (gsize)rstride * rheight,
-                                                    (GDestroyNotify)g_object_unref,
-                                                    rotated);
-
-        self->original_texture = gdk_memory_texture_new(rwidth, rheight,
-                                                         has_alpha ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8,
-                                                         rbytes, rstride);
-        g_bytes_unref(rbytes);
-        self->original_texture_rotation_angle = self->rotation_angle;
-
-        /* Create a downscaled preview texture for very large images to use during
-           animated zoom. This reduces GPU memory bandwidth and can make animation
-           smoother on systems where scaling huge textures is expensive. */
-        g_clear_object(&self->preview_texture);
-        const int MAX_PREVIEW_DIM = 3000;
-        if (rwidth > MAX_PREVIEW_DIM || rheight > MAX_PREVIEW_DIM) {
-            double scale = (double)MAX_PREVIEW_DIM / (double)MAX(rwidth, rheight);
-            int pw = MAX(1, (int)(rwidth * scale));
-            int ph = MAX(1, (int)(rheight * scale));
-
-            /* Create a scaled-down pixbuf and make a texture from it */
-            GdkPixbuf *preview_pix = gdk_pixbuf_scale_simple(rotated, pw, ph, GDK_INTERP_BILINEAR);
-            int pstride = gdk_pixbuf_get_rowstride(preview_pix);
-            g_object_ref(preview_pix);
-            GBytes *pbytes = g_bytes_new_with_free_func(gdk_pixbuf_get_pixels(preview_pix), (gsize)pstride * ph,
-                                                        (GDestroyNotify)g_object_unref, preview_pix);
-            self->preview_texture = gdk_memory_texture_new(pw, ph,
-                                                           has_alpha ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8,
-                                                           pbytes, pstride);
-            g_bytes_unref(pbytes);
-        }
-    }
-
-    /* Choose texture depending on whether an animated zoom is in progress */
-    GdkTexture *texture_to_use = self->original_texture;
-    if (self->preview_texture)
-        texture_to_use = self->preview_texture; /* prefer preview if available */
+    /* The paintable references the decoded pixels directly. Avoid CPU-intensive
+       per-frame scaling for animated zoom; instead set the widget size request
+       and let the GPU/texture scaling handle the visual scaling. Rotation is a
+       transform in the paintable's snapshot, so turning the image allocates
+       nothing. */
+    if (self->tiled_image == NULL)
+        self->tiled_image = tiled_image_new(self->original_pixbuf);
+    tiled_image_set_rotation(self->tiled_image, self->rotation_angle);
+    tiled_image_set_scale_factor(self->tiled_image, gtk_widget_get_scale_factor(GTK_WIDGET(self)));
 
+    GdkPaintable *paintable = GDK_PAINTABLE(self->tiled_image);
 
     /* For manual zoom, set the picture widget's size request to the desired
        logical size and let GTK scale the cached texture at draw time. */
@@ -981,8 +1299,8 @@ viewer_update_image(Viewer *self)
             self->zoom_level = get_fit_width_zoom(self);
         }
 
-        int width = gdk_pixbuf_get_width(rotated);
-        int height = gdk_pixbuf_get_height(rotated);
+        int width = gdk_paintable_get_intrinsic_width(paintable);
+        int height = gdk_paintable_get_intrinsic_height(paintable);
         int new_width = MAX(1, (int)(width * self->zoom_level));
         int new_height = MAX(1, (int)(height * self->zoom_level));
 
@@ -1023,40 +1341,13 @@ viewer_update_image(Viewer *self)
         gtk_widget_set_halign(self->active_picture, GTK_ALIGN_FILL);
         gtk_widget_set_valign(self->active_picture, GTK_ALIGN_FILL);
 
-        /* Ensure we always set a paintable: prefer preview (during animation), then full texture,
-           finally fall back to creating a temporary texture from the rotated pixbuf. */
-        if (texture_to_use) {
-            gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), GDK_PAINTABLE(texture_to_use));
-            g_debug("viewer_update_image: using %s texture for paintable", (self->preview_texture) ? "preview" : "original");
-        } else {
-            /* Fallback: construct a temporary texture from the rotated pixbuf so the view is never empty */
-            g_warning("viewer_update_image: texture_to_use is NULL, falling back to temporary texture");
-            g_object_ref(rotated);
-            GBytes *tmpbytes = g_bytes_new_with_free_func(gdk_pixbuf_get_pixels(rotated), (gsize)gdk_pixbuf_get_rowstride(rotated) * gdk_pixbuf_get_height(rotated),
-                                                          (GDestroyNotify)g_object_unref, rotated);
-            GdkTexture *tmp_tex = gdk_memory_texture_new(gdk_pixbuf_get_width(rotated), gdk_pixbuf_get_height(rotated),
-                                                         has_alpha ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8,
-                                                         tmpbytes, gdk_pixbuf_get_rowstride(rotated));
-            g_bytes_unref(tmpbytes);
-            if (tmp_tex) {
-                gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), GDK_PAINTABLE(tmp_tex));
-                g_debug("viewer_update_image: using temporary texture paintable (w=%d h=%d)", gdk_pixbuf_get_width(rotated), gdk_pixbuf_get_height(rotated));
-                g_clear_object(&tmp_tex);
-            } else {
-                g_warning("viewer_update_image: fallback temporary texture creation failed");
-            }
-        }
+        gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), paintable);
 
         g_debug("viewer_update_image: requested=(%d,%d) zoom=%f upper=(%f,%f) page=(%f,%f)",
                 new_width, new_height, self->zoom_level, gtk_adjustment_get_upper(hadj), gtk_adjustment_get_upper(vadj), page_x, page_y);
     } else {
         /* Fit to window: let the picture shrink to fit and remove explicit size request */
-        if (texture_to_use) {
-            gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), GDK_PAINTABLE(texture_to_use));
-            g_debug("viewer_update_image: using %s texture for paintable (fit)", (self->preview_texture) ? "preview" : "original");
-        } else {
-            g_warning("viewer_update_image: no texture available to set for fit-to-window");
-        }
+        gtk_picture_set_paintable(GTK_PICTURE(self->active_picture), paintable);
         gtk_picture_set_can_shrink(GTK_PICTURE(self->active_picture), TRUE);
         gtk_widget_set_size_request(self->active_picture, -1, -1);
 
@@ -1065,9 +1356,6 @@ viewer_update_image(Viewer *self)
         gtk_widget_set_valign(self->image_stack, GTK_ALIGN_FILL);
     }
 
-    
-    g_object_unref(rotated);
-    
     /* Emit zoom changed */
     g_signal_emit(self, signals[SIGNAL_ZOOM_CHANGED], 0, viewer_get_zoom_level_percentage(self));
 
@@ -1148,16 +1436,68 @@ update_alloc_overlay(gpointer user_data)
             new_val_x, new_val_y, upper_h, upper_v);
     }
 
-    if (self->debug_label) {
-        gchar *txt = g_strdup_printf("zoom=%.3f\nalloc=%dx%d\norig=%dx%d",
-                                     self->zoom_level, alloc_w, alloc_h, orig_w_disp, orig_h_disp);
-        gtk_label_set_text(GTK_LABEL(self->debug_label), txt);
-        g_free(txt);
-    }
+    viewer_update_visible_area(self);
+
+    g_free(self->alloc_info);
+    self->alloc_info = g_strdup_printf("zoom=%.3f\nalloc=%dx%d\norig=%dx%d",
+                                       self->zoom_level, alloc_w, alloc_h, orig_w_disp, orig_h_disp);
+    viewer_update_debug_label(self);
 
     return G_SOURCE_REMOVE;
 }
 
+static void
+viewer_update_debug_label(Viewer *self)
+{
+    if (!self->debug_label || !gtk_widget_get_visible(self->debug_label)) return;
+
+    char *metrics = self->metrics_refresh_id ? metrics_format() : NULL;
+    char *txt = g_strdup_printf("%s%s%s", self->alloc_info ? self->alloc_info : "",
+                                self->alloc_info && metrics ? "\n" : "", metrics ? metrics : "");
+    gtk_label_set_text(GTK_LABEL(self->debug_label), txt);
+    g_free(txt);
+    g_free(metrics);
+}
+
+static gboolean
+on_metrics_refresh(gpointer user_data)
+{
+    viewer_update_debug_label(VIEWER(user_data));
+    return G_SOURCE_CONTINUE;
+}
+
+/* Tell the tiled image which part of it the scrolled window shows. The
+ * paintable is drawn centred with CONTAIN fit inside the active picture. */
+static void
+viewer_update_visible_area(Viewer *self)
+{
+    if (!self->tiled_image || !self->active_picture) return;
+
+    int pic_w = gtk_widget_get_width(self->active_picture);
+    int pic_h = gtk_widget_get_height(self->active_picture);
+    GdkPaintable *paintable = GDK_PAINTABLE(self->tiled_image);
+    double img_w = gdk_paintable_get_intrinsic_width(paintable);
+    double img_h = gdk_paintable_get_intrinsic_height(paintable);
+    if (pic_w <= 0 || pic_h <= 0 || img_w <= 0 || img_h <= 0) return;
+
+    double draw_scale = MIN(pic_w / img_w, pic_h / img_h);
+    double draw_w = img_w * draw_scale;
+    double draw_h = img_h * draw_scale;
+    double off_x = (pic_w - draw_w) / 2.0;
+    double off_y = (pic_h - draw_h) / 2.0;
+
+    graphene_point_t origin = GRAPHENE_POINT_INIT(0, 0);
+    graphene_point_t top_left;
+    if (!gtk_widget_compute_point(self->scrolled_window, self->active_picture, &origin, &top_left))
+        return;
+
+    double view_w = gtk_widget_get_width(self->scrolled_window);
+    double view_h = gtk_widget_get_height(self->scrolled_window);
+    tiled_image_set_visible_area(self->tiled_image,
+                                 (top_left.x - off_x) / draw_w, (top_left.y - off_y) / draw_h,
+                                 view_w / draw_w, view_h / draw_h);
+}
+
 static double
 get_fit_zoom_level(Viewer *self)
 {
@@ -1324,21 +1664,17 @@ viewer_get_selection_pixbuf(Viewer *self)
 {
     if (!self->has_selection || !self->original_pixbuf) return NULL;
 
-    GdkPixbuf *rotated = NULL;
-    if (self->rotation_angle != 0)
-        rotated = gdk_pixbuf_rotate_simple(self->original_pixbuf, self->rotation_angle);
-    else
-        rotated = g_object_ref(self->original_pixbuf);
-
-    int img_w = gdk_pixbuf_get_width(rotated);
-    int img_h = gdk_pixbuf_get_height(rotated);
+    /* Work in the rotated frame the user sees, but only ever rotate the
+       cropped region, never the whole image */
+    int orig_w = gdk_pixbuf_get_width(self->original_pixbuf);
+    int orig_h = gdk_pixbuf_get_height(self->original_pixbuf);
+    gboolean swapped = (self->rotation_angle == 90 || self->rotation_angle == 270);
+    int img_w = swapped ? orig_h : orig_w;
+    int img_h = swapped ? orig_w : orig_h;
 
     int pic_w = gtk_widget_get_width(self->active_picture);
     int pic_h = gtk_widget_get_height(self->active_picture);
-    if (pic_w <= 0 || pic_h <= 0) {
-        g_object_unref(rotated);
-        return NULL;
-    }
+    if (pic_w <= 0 || pic_h <= 0) return NULL;
 
     double x0 = MIN(self->sel_x0, self->sel_x1);
     double y0 = MIN(self->sel_y0, self->sel_y1);
@@ -1386,16 +1722,40 @@ viewer_get_selection_pixbuf(Viewer *self)
     if (ix + iw > img_w) iw = img_w - ix;
     if (iy + ih > img_h) ih = img_h - iy;
 
-    if (iw <= 0 || ih <= 0) {
-        g_object_unref(rotated);
-        return NULL;
+    if (iw <= 0 || ih <= 0) return NULL;
+
+    /* Map the rectangle back into the unrotated pixbuf (angles are
+       counter-clockwise, as for gdk_pixbuf_rotate_simple) */
+    int ox = ix, oy = iy, ow = iw, oh = ih;
+    switch (self->rotation_angle) {
+        case 90:
+            ox = orig_w - (iy + ih); oy = ix; ow = ih; oh = iw;
+            break;
+        case 180:
+            ox = orig_w - (ix + iw); oy = orig_h - (iy + ih);
+            break;
+        case 270:
+            ox = iy; oy = orig_h - (ix + iw); ow = ih; oh = iw;
+            break;
+        default:
+            break;
     }
 
-    GdkPixbuf *sub = gdk_pixbuf_new_subpixbuf(rotated, ix, iy, iw, ih);
-    GdkPixbuf *copy = gdk_pixbuf_copy(sub);
+    GdkPixbuf *sub = gdk_pixbuf_new_subpixbuf(self->original_pixbuf, ox, oy, ow, oh);
+    GdkPixbuf *result = (self->rotation_angle != 0)
+        ? gdk_pixbuf_rotate_simple(sub, self->rotation_angle)
+        : gdk_pixbuf_copy(sub);
     g_object_unref(sub);
-    g_object_unref(rotated);
-    return copy;
+    return result;
+}
+
+GdkPixbuf *
+viewer_get_pixbuf(Viewer *self)
+{
+    if (!self->original_pixbuf) return NULL;
+    if (self->rotation_angle == 0)
+        return g_object_ref(self->original_pixbuf);
+    return gdk_pixbuf_rotate_simple(self->original_pixbuf, self->rotation_angle);
 }
 
 void
@@ -1647,3 +2007,18 @@ guint viewer_get_zoom_level_percentage(Viewer *self) {
     return (guint)(self->zoom_level * 100);
 }
 
+
+void
+viewer_set_metrics_overlay(Viewer *self, gboolean show)
+{
+    if (show == (self->metrics_refresh_id != 0)) return;
+
+    if (show) {
+        self->metrics_refresh_id = g_timeout_add(METRICS_REFRESH_MS, on_metrics_refresh, self);
+    } else {
+        g_source_remove(self->metrics_refresh_id);
+        self->metrics_refresh_id = 0;
+    }
+    gtk_widget_set_visible(self->debug_label, show);
+    viewer_update_debug_label(self);
+}
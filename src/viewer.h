@@ -51,6 +51,15 @@ GdkPixbuf *viewer_get_selection_pixbuf(Viewer *self);
 /* Clear any existing selection. */
 void viewer_clear_selection(Viewer *self);
 
+/* The current image as displayed (rotation applied), or NULL when no image
+ * is shown. Shares the decoded pixels unless the image is rotated. Caller
+ * owns the returned reference. */
+GdkPixbuf *viewer_get_pixbuf(Viewer *self);
+
+/* Show the debug overlay with live metrics (see metrics.h), refreshed
+ * twice a second. Does not itself enable collection. */
+void viewer_set_metrics_overlay(Viewer *self, gboolean show);
+
 G_END_DECLS
 
 #endif // VIEWER_H
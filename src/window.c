@@ -4,6 +4,11 @@
  * thumbnails, metadata sidebar, and OCR interactions. Handles application
  * level UI actions, menus and window lifecycle.
  *
+ * Startup: until the first image has been painted, directory scans are
+ * held in the curator and prefetching waits, so the file being opened is
+ * the only thing decoding. The first "after-paint" once it has loaded
+ * (or any paint, when nothing was opened) releases them.
+ *
  * Sections: internal helpers, lifecycle (class_init/dispose), UI setup and
  * signal connection handlers.
  */
@@ -11,10 +16,17 @@
 #include "window.h"
 #include "viewer.h"
 #include "curator.h"
+#include "prefetch.h"
 #include "thumbnails.h"
 #include "metadata.h"
 #include "ocr.h"
+#include "ocrbatch.h"
+#include "slideshow.h"
+#include "trashqueue.h"
+#include "cbzbatch.h"
 #include "archive.h"
+#include "startuptrace.h"
+#include "metrics.h"
 #include <gio/gio.h>
 
 #include <unistd.h>
@@ -23,23 +35,37 @@
 #include <errno.h>
 #include <string.h>
 
+/* Longest the first frame may hold back scans and prefetching */
+#define STARTUP_TIMEOUT_MS 2000
+
 static void request_delete_current(BrightEyesWindow *self);
 static void delete_current_now(BrightEyesWindow *self);
 static void on_next_clicked(GtkButton *btn, BrightEyesWindow *self);
 static void on_playback_changed(Viewer *viewer, gboolean playing, BrightEyesWindow *self);
+static void on_viewer_image_loaded(Viewer *viewer, const char *path, int width, int height, BrightEyesWindow *self);
 
-static void start_ocr_for_path(BrightEyesWindow *self, const char *path, const char *tmp_path);
+static void start_ocr_for_pixbuf(BrightEyesWindow *self, GdkPixbuf *pixbuf);
 struct _BrightEyesWindow {
     AdwApplicationWindow parent_instance;
     Viewer *viewer;
     Curator *curator;
+    Prefetcher *prefetcher;
+    gboolean awaiting_first_image; /* Show the first file a scan produces */
+
+    /* Startup (see the header comment) */
+    gboolean starting;
+    gboolean first_image_pending; /* Opened, but not decoded yet */
+    GdkFrameClock *startup_clock;
+    gulong after_paint_id;
+    guint startup_timeout_id;
     ThumbnailsBar *thumbnails;
     GtkHeaderBar *header_bar;
     AdwOverlaySplitView *split_view; /* Thumbnails (Outer) */
     AdwOverlaySplitView *metadata_view; /* Metadata (Inner) */
     GtkWidget *toast_overlay; /* Added toast overlay */
     GtkWidget *metadata_sidebar;
-    guint slideshow_id;
+    Slideshow *slideshow;
+    TrashQueue *trash_queue;
     guint slideshow_duration;
     GtkWidget *slideshow_btn;
     GtkWidget *status_label;
@@ -47,6 +73,7 @@ struct _BrightEyesWindow {
     gboolean viewer_dark_background;
     gboolean confirm_delete;
     gboolean default_fit_to_window; /* TRUE=fit, FALSE=100% */
+    guint prefetch_radius; /* Images decoded ahead on each side */
 
     /* Buttons we may disable during video playback */
     GtkWidget *zoom_out_btn;
@@ -63,6 +90,12 @@ struct _BrightEyesWindow {
 
     /* OCR */
     char *ocr_language; /* Tesseract language code, e.g. "eng" */
+    OcrBatch *ocr_batch;      /* Last batch run, kept so it can be stopped */
+    AdwToast *ocr_batch_toast; /* Progress toast while the batch runs */
+
+    /* CBZ conversion */
+    CbzBatch *cbz_batch;       /* Last conversion run, kept so it can be stopped */
+    AdwToast *cbz_batch_toast; /* Progress toast while it runs */
 };
 
 G_DEFINE_TYPE(BrightEyesWindow, bright_eyes_window, ADW_TYPE_APPLICATION_WINDOW)
@@ -140,6 +173,30 @@ collect_missing_best(const char *lang, const char *cache_dir)
     return missing;
 }
 
+/* Datapath for OCR that should not prompt for downloads: the best data when
+ * it is all downloaded (as start_ocr_for_pixbuf would pick), otherwise NULL
+ * for the bundled lite data. */
+static char *
+available_ocr_datapath(const char *lang)
+{
+    char *cache_dir = tessdata_cache_dir();
+    GPtrArray *missing = cache_dir ? collect_missing_best(lang, cache_dir) : NULL;
+    gboolean have_best = missing && missing->len == 0;
+    if (missing) g_ptr_array_free(missing, TRUE);
+    if (!have_best) g_clear_pointer(&cache_dir, g_free);
+    return cache_dir;
+}
+
+/* Load the OCR models the next scan will use while the user is still
+ * drawing the selection. */
+static void
+warm_up_ocr(BrightEyesWindow *self)
+{
+    const char *lang = self->ocr_language ? self->ocr_language : "eng";
+    g_autofree char *datapath = available_ocr_datapath(lang);
+    ocr_warm_up(lang, datapath);
+}
+
 typedef struct {
     char *url;
     char *dest_path;
@@ -277,6 +334,17 @@ on_playback_changed(Viewer *viewer, gboolean playing, BrightEyesWindow *self)
     if (self->rot_right_btn) gtk_widget_set_sensitive(self->rot_right_btn, enabled);
 }
 
+/* The sidebar reads only headers; the viewer knows the real size */
+static void
+on_viewer_image_loaded(Viewer *viewer, const char *path, int width, int height, BrightEyesWindow *self)
+{
+    metadata_sidebar_set_dimensions(self->metadata_sidebar, path, width, height);
+    if (self->first_image_pending) {
+        self->first_image_pending = FALSE;
+        startup_trace_mark("first image decoded");
+    }
+}
+
 static void
 update_zoom_ui_for_file_type(BrightEyesWindow *self, const char *path)
 {
@@ -295,11 +363,20 @@ void
 load_image_path(BrightEyesWindow *self, const char *path)
 {
     update_zoom_ui_for_file_type(self, path);
+
+    /* Update metadata whenever an image is loaded. This comes first so a
+       prefetched image the viewer shows right away can report its size. */
+    metadata_sidebar_update(self->metadata_sidebar, path);
+
+    /* Set first: a cached image reports "image-loaded" from viewer_load_file */
+    if (self->starting && path) self->first_image_pending = TRUE;
+
     viewer_load_file(self->viewer, path);
     update_title(self);
-    
-    /* Update metadata whenever an image is loaded */
-    metadata_sidebar_update(self->metadata_sidebar, path);
+
+    /* Decode the neighbours while the user looks at this one; during
+       startup finish_startup does it */
+    if (!self->starting) prefetcher_update(self->prefetcher);
 
     /* Update actions */
     gboolean can_convert = FALSE;
@@ -361,25 +438,26 @@ on_rotate_right_clicked(GtkButton *btn, BrightEyesWindow *self) {
     viewer_rotate_cw(self->viewer);
 }
 
-static gboolean
-slideshow_tick(gpointer user_data) {
-    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
-    const char *next = curator_get_next(self->curator);
-    if (!next) return FALSE;
-    load_image_path(self, next);
-    return TRUE;
+/* The slideshow has already decoded path and moved the curator to it */
+static void
+on_slideshow_advance(Slideshow *slideshow, const char *path, BrightEyesWindow *self) {
+    load_image_path(self, path);
+}
+
+static void
+on_slideshow_stopped(Slideshow *slideshow, BrightEyesWindow *self) {
+    gtk_button_set_icon_name(GTK_BUTTON(self->slideshow_btn), "media-playback-start-symbolic");
 }
 
 static void
 toggle_slideshow(BrightEyesWindow *self) {
-    if (self->slideshow_id > 0) {
-        g_source_remove(self->slideshow_id);
-        self->slideshow_id = 0;
+    if (slideshow_is_running(self->slideshow)) {
+        slideshow_stop(self->slideshow);
         gtk_button_set_icon_name(GTK_BUTTON(self->slideshow_btn), "media-playback-start-symbolic");
     } else {
-        self->slideshow_id = g_timeout_add_seconds(self->slideshow_duration, slideshow_tick, self);
+        slideshow_set_interval(self->slideshow, self->slideshow_duration);
+        slideshow_start(self->slideshow);
         gtk_button_set_icon_name(GTK_BUTTON(self->slideshow_btn), "media-playback-pause-symbolic");
-        slideshow_tick(self);
     }
 }
 
@@ -392,6 +470,30 @@ on_thumbnail_activated(ThumbnailsBar *bar, const char *path, BrightEyesWindow *s
     }
 }
 
+/* Scan results stream in; show the first image as soon as there is one. */
+static void
+on_curator_load_progress(Curator *curator, guint n_files, gboolean finished, BrightEyesWindow *self)
+{
+    const char *current = curator_get_current(curator);
+    if (self->awaiting_first_image && (current || finished)) {
+        /* An empty directory still clears the viewer, as before */
+        self->awaiting_first_image = FALSE;
+        load_image_path(self, current);
+    } else if (finished && self->prefetcher) {
+        /* Neighbours of the current item may have arrived since it loaded */
+        prefetcher_update(self->prefetcher);
+    }
+}
+
+static void
+open_directory(BrightEyesWindow *self, const char *path)
+{
+    self->awaiting_first_image = TRUE;
+    curator_load_directory_async(self->curator, path);
+    /* Show sidebar when folder is loaded */
+    adw_overlay_split_view_set_show_sidebar(self->split_view, TRUE);
+}
+
 static void
 on_folder_opened(GObject *source, GAsyncResult *result, gpointer user_data)
 {
@@ -403,12 +505,7 @@ on_folder_opened(GObject *source, GAsyncResult *result, gpointer user_data)
     if (file) {
         char *path = g_file_get_path(file);
         if (path) {
-            curator_load_directory(self->curator, path);
-            const char *current = curator_get_current(self->curator);
-            load_image_path(self, current);
-            thumbnails_bar_refresh(self->thumbnails);
-            /* Show sidebar when folder is loaded */
-            adw_overlay_split_view_set_show_sidebar(self->split_view, TRUE);
+            open_directory(self, path);
             g_free(path);
         }
         g_object_unref(file);
@@ -467,8 +564,78 @@ on_ocr_whole_action(GSimpleAction *action, GVariant *parameter, gpointer user_da
     (void)action;
     (void)parameter;
     BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
-    const char *path = curator_get_current(self->curator);
-    start_ocr_for_path(self, path, NULL);
+    /* The viewer already holds the decoded image (archive pages included) */
+    GdkPixbuf *pixbuf = viewer_get_pixbuf(self->viewer);
+    if (!pixbuf) return;
+    start_ocr_for_pixbuf(self, pixbuf);
+    g_object_unref(pixbuf);
+}
+
+static void
+on_ocr_batch_progress(OcrBatch *batch, guint processed, guint total, BrightEyesWindow *self)
+{
+    if (!self->ocr_batch_toast) return;
+    g_autofree char *title = g_strdup_printf("OCR: %u of %u pages", processed, total);
+    adw_toast_set_title(self->ocr_batch_toast, title);
+}
+
+static void
+on_ocr_batch_finished(OcrBatch *batch, gboolean cancelled, BrightEyesWindow *self)
+{
+    if (self->ocr_batch_toast) {
+        adw_toast_dismiss(self->ocr_batch_toast);
+        g_clear_object(&self->ocr_batch_toast);
+    }
+
+    guint failed = ocr_batch_get_n_failed(batch);
+    g_autofree char *title = NULL;
+    if (cancelled)
+        title = g_strdup("OCR stopped. Run it again to continue where it left off.");
+    else if (failed > 0)
+        title = g_strdup_printf("OCR finished; %u pages could not be read", failed);
+    else
+        title = g_strdup("OCR finished");
+
+    AdwToast *toast = adw_toast_new(title);
+    adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), toast);
+    g_debug("OCR index: %s", ocr_batch_get_index_path(batch));
+}
+
+/* Start OCR over every item in the current list, or stop the one running. */
+static void
+on_ocr_batch_action(GSimpleAction *action, GVariant *parameter, gpointer user_data)
+{
+    (void)action;
+    (void)parameter;
+    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
+
+    if (self->ocr_batch && ocr_batch_is_running(self->ocr_batch)) {
+        ocr_batch_cancel(self->ocr_batch);
+        return;
+    }
+
+    GPtrArray *files = curator_get_files(self->curator);
+    if (!files || files->len == 0) return;
+
+    if (self->ocr_batch) {
+        g_signal_handlers_disconnect_by_data(self->ocr_batch, self);
+        g_clear_object(&self->ocr_batch);
+    }
+
+    const char *lang = self->ocr_language ? self->ocr_language : "eng";
+    g_autofree char *datapath = available_ocr_datapath(lang);
+    self->ocr_batch = ocr_batch_new(files, lang, datapath);
+    g_signal_connect(self->ocr_batch, "progress", G_CALLBACK(on_ocr_batch_progress), self);
+    g_signal_connect(self->ocr_batch, "finished", G_CALLBACK(on_ocr_batch_finished), self);
+
+    AdwToast *toast = adw_toast_new("OCR: starting…");
+    adw_toast_set_timeout(toast, 0); /* Persist until the batch ends */
+    adw_toast_set_button_label(toast, "Stop");
+    adw_toast_set_action_name(toast, "win.ocr-batch");
+    self->ocr_batch_toast = g_object_ref(toast);
+    adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), toast);
+
+    ocr_batch_start(self->ocr_batch);
 }
 
 static void
@@ -520,6 +687,7 @@ on_ocr_selection_action(GSimpleAction *action, GVariant *parameter, gpointer use
     } else {
          /* Turn on selection mode */
          viewer_set_selection_mode(self->viewer, TRUE);
+         warm_up_ocr(self);
          
          /* Show a toast to inform the user with a Scan button */
          AdwToast *toast = adw_toast_new("Selection Mode: Draw a box on the image.");
@@ -541,33 +709,10 @@ on_ocr_selection_action(GSimpleAction *action, GVariant *parameter, gpointer use
         return;
     }
 
-    /* Create temp file */
-    char *tmpl = g_strdup_printf("%s/brighteyes-ocr-XXXXXX", g_get_tmp_dir());
-    int fd = mkstemp(tmpl);
-    if (fd == -1) {
-        g_warning("Failed to create temp file %s: %s", tmpl, g_strerror(errno));
-        g_free(tmpl);
-        g_object_unref(sel);
-        return;
-    }
-    close(fd);
-
-    GError *err = NULL;
-    if (!gdk_pixbuf_save(sel, tmpl, "png", &err, NULL)) {
-        g_warning("Failed to save selection to %s: %s", tmpl, err ? err->message : "unknown");
-        if (err) g_clear_error(&err);
-        unlink(tmpl);
-        g_free(tmpl);
-        g_object_unref(sel);
-        return;
-    }
-
+    /* Hand the cropped pixels straight to OCR */
+    start_ocr_for_pixbuf(self, sel);
     g_object_unref(sel);
 
-    /* Start OCR flow using temporary file; it will be removed after OCR completes */
-    start_ocr_for_path(self, tmpl, tmpl);
-    g_free(tmpl);
-    
     /* Auto-clear selection and disable mode after triggering scan */
     viewer_clear_selection(self->viewer);
     viewer_set_selection_mode(self->viewer, FALSE);
@@ -595,7 +740,7 @@ toggle_metadata(BrightEyesWindow *self)
      adw_overlay_split_view_set_show_sidebar(self->metadata_view, !show);
 }
 
-typedef struct { BrightEyesWindow *win; GtkWindow *dlg; char *text; char *tmp_path; } OCRCallbackData;
+typedef struct { BrightEyesWindow *win; GtkWindow *dlg; char *text; } OCRCallbackData;
 
 typedef struct {
     GtkWindow *window;
@@ -632,14 +777,14 @@ create_spinner_window(BrightEyesWindow *self, const char *title, const char *mes
     return ui;
 }
 
-static void begin_ocr_async(BrightEyesWindow *self, const char *path, const char *lang, const char *datapath, const char *tmp_path);
-static void start_ocr_for_path(BrightEyesWindow *self, const char *path, const char *tmp_path);
+static void begin_ocr_async(BrightEyesWindow *self, GdkPixbuf *pixbuf, const char *lang, const char *datapath);
+static void start_ocr_for_pixbuf(BrightEyesWindow *self, GdkPixbuf *pixbuf);
 
 static void show_ocr_result_dialog(BrightEyesWindow *w, const char *text);
 static void ocr_done_cb(GObject *source, GAsyncResult *res, gpointer user_data);
 
 static void
-begin_ocr_async(BrightEyesWindow *self, const char *path, const char *lang, const char *datapath, const char *tmp_path)
+begin_ocr_async(BrightEyesWindow *self, GdkPixbuf *pixbuf, const char *lang, const char *datapath)
 {
     SpinnerWindow ui = create_spinner_window(self, "Recognizing...", "Performing OCR...");
 
@@ -648,17 +793,16 @@ begin_ocr_async(BrightEyesWindow *self, const char *path, const char *lang, cons
     OCRCallbackData *cbdata = g_new0(OCRCallbackData, 1);
     cbdata->win = self;
     cbdata->dlg = ui.window;
-    cbdata->tmp_path = tmp_path ? g_strdup(tmp_path) : NULL;
 
     const char *effective_lang = lang ? lang : "eng";
-    ocr_recognize_image_async(path, effective_lang, datapath, NULL, ocr_done_cb, cbdata);
+    ocr_recognize_pixbuf_async(pixbuf, effective_lang, datapath, NULL, ocr_done_cb, cbdata);
 
     gtk_window_present(ui.window);
 }
 
 typedef struct {
     BrightEyesWindow *win;
-    char *path;
+    GdkPixbuf *pixbuf;
     char *lang;
     char *cache_dir;
     GPtrArray *missing;
@@ -679,7 +823,7 @@ download_lang_finished(GObject *source, GAsyncResult *res, gpointer user_data)
         g_warning("Download failed: %s", err ? err->message : "unknown error");
         if (ctx->ui.window)
             gtk_window_destroy(ctx->ui.window);
-        begin_ocr_async(ctx->win, ctx->path, ctx->lang, NULL, NULL); /* fallback to lite */
+        begin_ocr_async(ctx->win, ctx->pixbuf, ctx->lang, NULL); /* fallback to lite */
         download_flow_free(ctx);
         g_clear_error(&err);
         return;
@@ -694,7 +838,7 @@ download_lang_finished(GObject *source, GAsyncResult *res, gpointer user_data)
     if (ctx->ui.window)
         gtk_window_destroy(ctx->ui.window);
 
-    begin_ocr_async(ctx->win, ctx->path, ctx->lang, ctx->cache_dir, NULL);
+    begin_ocr_async(ctx->win, ctx->pixbuf, ctx->lang, ctx->cache_dir);
     download_flow_free(ctx);
 }
 
@@ -702,7 +846,7 @@ static void
 download_next_lang(DownloadFlow *ctx)
 {
     if (ctx->index >= ctx->missing->len) {
-        begin_ocr_async(ctx->win, ctx->path, ctx->lang, ctx->cache_dir, NULL);
+        begin_ocr_async(ctx->win, ctx->pixbuf, ctx->lang, ctx->cache_dir);
         download_flow_free(ctx);
         return;
     }
@@ -713,7 +857,7 @@ download_next_lang(DownloadFlow *ctx)
         g_warning("No download source for %s; using lite model", code);
         if (ctx->ui.window)
             gtk_window_destroy(ctx->ui.window);
-        begin_ocr_async(ctx->win, ctx->path, ctx->lang, NULL, NULL);
+        begin_ocr_async(ctx->win, ctx->pixbuf, ctx->lang, NULL);
         download_flow_free(ctx);
         return;
     }
@@ -731,7 +875,7 @@ download_flow_free(DownloadFlow *ctx)
 {
     if (!ctx) return;
     g_clear_object(&ctx->win);
-    g_free(ctx->path);
+    g_clear_object(&ctx->pixbuf);
     g_free(ctx->lang);
     g_free(ctx->cache_dir);
     if (ctx->missing)
@@ -740,11 +884,11 @@ download_flow_free(DownloadFlow *ctx)
 }
 
 static void
-start_best_download(BrightEyesWindow *self, const char *path, const char *lang, const char *cache_dir, GPtrArray *missing)
+start_best_download(BrightEyesWindow *self, GdkPixbuf *pixbuf, const char *lang, const char *cache_dir, GPtrArray *missing)
 {
     DownloadFlow *ctx = g_new0(DownloadFlow, 1);
     ctx->win = g_object_ref(self);
-    ctx->path = g_strdup(path);
+    ctx->pixbuf = g_object_ref(pixbuf);
     ctx->lang = g_strdup(lang ? lang : "eng");
     ctx->cache_dir = g_strdup(cache_dir);
     ctx->missing = missing; /* take ownership */
@@ -756,7 +900,7 @@ start_best_download(BrightEyesWindow *self, const char *path, const char *lang,
 
 typedef struct {
     BrightEyesWindow *win;
-    char *path;
+    GdkPixbuf *pixbuf;
     char *lang;
     char *cache_dir;
     GPtrArray *missing;
@@ -767,7 +911,7 @@ ocr_request_free(OcrRequest *req)
 {
     if (!req) return;
     g_clear_object(&req->win);
-    g_free(req->path);
+    g_clear_object(&req->pixbuf);
     g_free(req->lang);
     g_free(req->cache_dir);
     if (req->missing)
@@ -781,23 +925,23 @@ on_best_choice(AdwMessageDialog *dialog, const char *response, gpointer user_dat
     OcrRequest *req = user_data;
 
     if (g_strcmp0(response, "download") == 0) {
-        start_best_download(req->win, req->path, req->lang, req->cache_dir, req->missing);
+        start_best_download(req->win, req->pixbuf, req->lang, req->cache_dir, req->missing);
         req->missing = NULL; /* ownership transferred */
     } else {
-        begin_ocr_async(req->win, req->path, req->lang, NULL, NULL);
+        begin_ocr_async(req->win, req->pixbuf, req->lang, NULL);
     }
 
     ocr_request_free(req);
 }
 
-static void start_ocr_for_path(BrightEyesWindow *self, const char *path, const char *tmp_path)
+static void start_ocr_for_pixbuf(BrightEyesWindow *self, GdkPixbuf *pixbuf)
 {
-    if (!path) return;
+    if (!pixbuf) return;
 
     const char *lang = self->ocr_language ? self->ocr_language : "eng";
     g_autofree char *cache_dir = tessdata_cache_dir();
     if (!cache_dir) {
-        begin_ocr_async(self, path, lang, NULL, tmp_path);
+        begin_ocr_async(self, pixbuf, lang, NULL);
         return;
     }
 
@@ -805,7 +949,7 @@ static void start_ocr_for_path(BrightEyesWindow *self, const char *path, const c
     if (!ensure_dir_exists(cache_dir, &dir_err)) {
         g_warning("Cannot prepare cache dir: %s", dir_err ? dir_err->message : "unknown error");
         g_clear_error(&dir_err);
-        begin_ocr_async(self, path, lang, NULL, tmp_path);
+        begin_ocr_async(self, pixbuf, lang, NULL);
         return;
     }
 
@@ -813,7 +957,7 @@ static void start_ocr_for_path(BrightEyesWindow *self, const char *path, const c
     if (!missing || missing->len == 0) {
         if (missing)
             g_ptr_array_free(missing, TRUE);
-        begin_ocr_async(self, path, lang, cache_dir, tmp_path);
+        begin_ocr_async(self, pixbuf, lang, cache_dir);
         return;
     }
 
@@ -826,7 +970,7 @@ static void start_ocr_for_path(BrightEyesWindow *self, const char *path, const c
 
     OcrRequest *req = g_new0(OcrRequest, 1);
     req->win = g_object_ref(self);
-    req->path = g_strdup(path);
+    req->pixbuf = g_object_ref(pixbuf);
     req->lang = g_strdup(lang);
     req->cache_dir = g_strdup(cache_dir);
     req->missing = missing; /* ownership moved */
@@ -878,12 +1022,6 @@ ocr_done_cb(GObject *source, GAsyncResult *res, gpointer user_data)
         show_ocr_result_dialog(w, text ? text : "");
     }
 
-    /* If this OCR was run on a temporary file (e.g., selection), remove it now */
-    if (d->tmp_path) {
-        unlink(d->tmp_path);
-        g_free(d->tmp_path);
-    }
-
     g_free(text);
     g_free(d);
     g_object_unref(w);
@@ -1062,15 +1200,41 @@ delete_current_now(BrightEyesWindow *self)
     if (!current) return;
 
     GError *err = NULL;
-    if (!curator_trash_current(self->curator, &err)) {
-        g_warning("Failed to move to trash: %s", err ? err->message : "unknown");
+    if (!trash_queue_add(self->trash_queue, current, &err)) {
+        g_warning("Failed to move to trash: %s", err->message);
+        AdwToast *toast = adw_toast_new(err->message);
+        adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), toast);
         g_clear_error(&err);
         return;
     }
 
+    /* The deletion finishes in the background; the list and the thumbnail
+       bar (through items-changed) drop the file now */
+    g_free(curator_remove_current(self->curator));
     const char *next = curator_get_current(self->curator);
     load_image_path(self, next);
-    thumbnails_bar_refresh(self->thumbnails);
+}
+
+static void
+on_trash_failed(TrashQueue *queue, const char *path, guint n_pages, const char *message, char **items,
+                BrightEyesWindow *self)
+{
+    /* Dropped from the list when queued; they are still on disk */
+    gboolean was_empty = curator_get_current(self->curator) == NULL;
+    for (guint i = 0; items && items[i]; i++)
+        curator_restore(self->curator, items[i]);
+    if (was_empty && curator_get_current(self->curator))
+        load_image_path(self, curator_get_current(self->curator));
+
+    g_autofree char *name = g_path_get_basename(path);
+    g_autofree char *title = NULL;
+    if (n_pages > 0)
+        title = g_strdup_printf("Could not delete %u pages from %s: %s", n_pages, name, message);
+    else
+        title = g_strdup_printf("Could not move %s to trash: %s", name, message);
+
+    AdwToast *toast = adw_toast_new(title);
+    adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), toast);
 }
 
 static void
@@ -1176,6 +1340,10 @@ on_window_key_pressed(GtkEventControllerKey *controller, guint keyval, guint key
             toggle_metadata(self);
             return TRUE;
         }
+        case GDK_KEY_F12:
+            /* Debug: live metrics over the image */
+            g_action_group_activate_action(G_ACTION_GROUP(self->win_actions), "metrics-overlay", NULL);
+            return TRUE;
     }
     
     return FALSE;
@@ -1285,70 +1453,88 @@ on_open_editor_action(GSimpleAction *action, GVariant *parameter, gpointer user_
 }
 
 static void
-convert_cbz_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+on_cbz_batch_progress(CbzBatch *batch, guint converted, guint total, double fraction, BrightEyesWindow *self)
 {
-    char **paths = (char **)task_data;
-    const char *src = paths[0];
-    const char *dst = paths[1];
-    GError *error = NULL;
+    if (!self->cbz_batch_toast) return;
+    int percent = (int)(fraction * 100.0);
+    g_autofree char *title = total == 1
+        ? g_strdup_printf("Converting archive… %d%%", percent)
+        : g_strdup_printf("Converting: %u of %u archives (%d%%)", converted, total, percent);
+    adw_toast_set_title(self->cbz_batch_toast, title);
+}
 
-    if (archive_convert_to_cbz(src, dst, &error)) {
-        g_task_return_boolean(task, TRUE);
-    } else {
-        g_task_return_error(task, error);
+static void
+on_cbz_batch_finished(CbzBatch *batch, gboolean cancelled, BrightEyesWindow *self)
+{
+    if (self->cbz_batch_toast) {
+        adw_toast_dismiss(self->cbz_batch_toast);
+        g_clear_object(&self->cbz_batch_toast);
     }
+
+    guint failed = cbz_batch_get_n_failed(batch);
+    guint skipped = cbz_batch_get_n_skipped(batch);
+    const char *last_error = cbz_batch_get_last_error(batch);
+    g_autofree char *title = NULL;
+    if (cancelled)
+        title = g_strdup("Conversion stopped");
+    else if (failed == 1 && last_error)
+        title = g_strdup_printf("Conversion failed: %s", last_error);
+    else if (failed > 0 && skipped > 0)
+        title = g_strdup_printf("Conversion finished; %u archives could not be converted, %u already had a CBZ",
+                                failed, skipped);
+    else if (failed > 0)
+        title = g_strdup_printf("Conversion finished; %u archives could not be converted", failed);
+    else if (skipped > 0)
+        title = g_strdup_printf("Conversion finished; %u archives already had a CBZ and were left alone", skipped);
+    else
+        title = g_strdup("Archive converted to CBZ");
+
+    adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), adw_toast_new(title));
 }
 
+/* Convert sources in the background, showing progress in a toast. */
 static void
-on_convert_cbz_finished(GObject *source_object, GAsyncResult *res, gpointer user_data)
+start_cbz_batch(BrightEyesWindow *self, GPtrArray *sources)
 {
-    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(source_object);
-    GError *error = NULL;
+    if (self->cbz_batch && cbz_batch_is_running(self->cbz_batch)) {
+        adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay),
+                                    adw_toast_new("A conversion is already running"));
+        return;
+    }
 
-    if (g_task_propagate_boolean(G_TASK(res), &error)) {
-        adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), adw_toast_new("Archive converted to CBZ"));
-    } else {
-        g_warning("Conversion failed: %s", error->message);
-        g_autofree char *msg = g_strdup_printf("Conversion failed: %s", error->message);
-        adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), adw_toast_new(msg));
-        g_error_free(error);
+    if (self->cbz_batch) {
+        g_signal_handlers_disconnect_by_data(self->cbz_batch, self);
+        g_clear_object(&self->cbz_batch);
     }
+
+    self->cbz_batch = cbz_batch_new(sources);
+    g_signal_connect(self->cbz_batch, "progress", G_CALLBACK(on_cbz_batch_progress), self);
+    g_signal_connect(self->cbz_batch, "finished", G_CALLBACK(on_cbz_batch_finished), self);
+
+    AdwToast *toast = adw_toast_new("Converting archive…");
+    adw_toast_set_timeout(toast, 0); /* Persist until the conversion ends */
+    adw_toast_set_button_label(toast, "Stop");
+    adw_toast_set_action_name(toast, "win.convert-cancel");
+    self->cbz_batch_toast = g_object_ref(toast);
+    adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), toast);
+
+    cbz_batch_start(self->cbz_batch);
 }
 
 static void
 start_conversion_task(BrightEyesWindow *self, const char *path)
 {
-    /* Calculate destination */
-    char *dest_path = NULL;
-    
-    /* Determine if we are just replacing extension or appending */
-    const char *dot = strrchr(path, '.');
-    if (dot && g_ascii_strcasecmp(dot, ".cbr") == 0) {
-         char *tmp = g_strndup(path, dot - path);
-         dest_path = g_strdup_printf("%s.cbz", tmp);
-         g_free(tmp);
-    } else {
-         dest_path = g_strdup_printf("%s.cbz", path);
-    }
-
+    g_autofree char *dest_path = cbz_batch_destination_for(path);
     if (g_file_test(dest_path, G_FILE_TEST_EXISTS)) {
         g_autofree char *msg = g_strdup_printf("Destination already exists: %s", dest_path);
         adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), adw_toast_new(msg));
-        g_free(dest_path);
         return;
     }
 
-    adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay), adw_toast_new("Converting archive..."));
-    
-    GTask *task = g_task_new(self, NULL, on_convert_cbz_finished, NULL);
-    char **paths = g_new(char *, 3);
-    paths[0] = g_strdup(path);
-    paths[1] = dest_path;
-    paths[2] = NULL;
-    g_task_set_task_data(task, paths, (GDestroyNotify)g_strfreev);
-    
-    g_task_run_in_thread(task, convert_cbz_thread);
-    g_object_unref(task);
+    GPtrArray *sources = g_ptr_array_new();
+    g_ptr_array_add(sources, (gpointer)path);
+    start_cbz_batch(self, sources);
+    g_ptr_array_unref(sources);
 }
 
 static void
@@ -1385,6 +1571,24 @@ check_cbr_prompt(BrightEyesWindow *self, const char *path)
     }
 }
 
+/* Showing the overlay turns collection on; hiding it leaves that to the
+ * app.metrics action, which may have been enabled separately */
+static void
+on_metrics_overlay_changed(GSimpleAction *action, GVariant *value, gpointer user_data)
+{
+    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
+    gboolean show = g_variant_get_boolean(value);
+
+    if (show) {
+        metrics_set_enabled(TRUE);
+        /* Keep the application-level toggle in step */
+        GApplication *app = g_application_get_default();
+        if (app) g_action_group_change_action_state(G_ACTION_GROUP(app), "metrics", g_variant_new_boolean(TRUE));
+    }
+    viewer_set_metrics_overlay(self->viewer, show);
+    g_simple_action_set_state(action, value);
+}
+
 static void
 on_convert_to_cbz_action(GSimpleAction *action, GVariant *parameter, gpointer user_data)
 {
@@ -1411,6 +1615,46 @@ on_convert_to_cbz_action(GSimpleAction *action, GVariant *parameter, gpointer us
     g_free(archive_path);
 }
 
+/* Convert every CBR next to the current file that has no CBZ yet. */
+static void
+on_convert_folder_action(GSimpleAction *action, GVariant *parameter, gpointer user_data)
+{
+    (void)action;
+    (void)parameter;
+    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
+    const char *current_file = curator_get_current(self->curator);
+    if (!current_file) return;
+
+    /* Inside an archive the folder is the one holding the archive */
+    g_autofree char *dir = NULL;
+    if (g_str_has_prefix(current_file, "archive://")) {
+        const char *sep = strstr(current_file, "::");
+        if (!sep) return;
+        g_autofree char *archive_path = g_strndup(current_file + strlen("archive://"),
+                                                  sep - (current_file + strlen("archive://")));
+        dir = g_path_get_dirname(archive_path);
+    } else {
+        dir = g_path_get_dirname(current_file);
+    }
+
+    GPtrArray *sources = cbz_batch_find_sources(dir);
+    if (sources->len == 0)
+        adw_toast_overlay_add_toast(ADW_TOAST_OVERLAY(self->toast_overlay),
+                                    adw_toast_new("No CBR archives left to convert in this folder"));
+    else
+        start_cbz_batch(self, sources);
+    g_ptr_array_unref(sources);
+}
+
+static void
+on_convert_cancel_action(GSimpleAction *action, GVariant *parameter, gpointer user_data)
+{
+    (void)action;
+    (void)parameter;
+    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
+    if (self->cbz_batch) cbz_batch_cancel(self->cbz_batch);
+}
+
 static char *
 get_config_path(void)
 {
@@ -1431,6 +1675,7 @@ save_settings(BrightEyesWindow *self)
     g_key_file_set_boolean(key_file, "Settings", "viewer_dark_background", self->viewer_dark_background);
     g_key_file_set_boolean(key_file, "Settings", "confirm_delete", self->confirm_delete);
     g_key_file_set_boolean(key_file, "Settings", "default_fit_to_window", self->default_fit_to_window);
+    g_key_file_set_integer(key_file, "Settings", "prefetch_radius", self->prefetch_radius);
     if (self->ocr_language) {
         g_key_file_set_string(key_file, "Settings", "ocr_language", self->ocr_language);
     }
@@ -1474,6 +1719,9 @@ load_settings(BrightEyesWindow *self)
             apply_default_zoom_pref(self);
         }
 
+        if (g_key_file_has_key(key_file, "Settings", "prefetch_radius", NULL))
+            self->prefetch_radius = (guint)CLAMP(g_key_file_get_integer(key_file, "Settings", "prefetch_radius", NULL), 0, 8);
+
         if (g_key_file_has_key(key_file, "Settings", "ocr_language", NULL)) {
             g_free(self->ocr_language);
             self->ocr_language = g_key_file_get_string(key_file, "Settings", "ocr_language", NULL);
@@ -1536,6 +1784,16 @@ static void
 on_duration_changed(GtkAdjustment *adj, GParamSpec *pspec, BrightEyesWindow *self)
 {
     self->slideshow_duration = (guint)gtk_adjustment_get_value(adj);
+    if (self->slideshow) slideshow_set_interval(self->slideshow, self->slideshow_duration);
+    save_settings(self);
+}
+
+static void
+on_prefetch_radius_changed(GtkAdjustment *adj, GParamSpec *pspec, BrightEyesWindow *self)
+{
+    self->prefetch_radius = (guint)gtk_adjustment_get_value(adj);
+    prefetcher_set_radius(self->prefetcher, self->prefetch_radius);
+    prefetcher_update(self->prefetcher);
     save_settings(self);
 }
 
@@ -1677,6 +1935,15 @@ on_preferences_action(GSimpleAction *action, GVariant *parameter, gpointer user_
     GtkAdjustment *adj = adw_spin_row_get_adjustment(spin_row);
     g_signal_connect(adj, "notify::value", G_CALLBACK(on_duration_changed), self);
     adw_preferences_group_add(viewer_group, GTK_WIDGET(spin_row));
+
+    /* Read-ahead */
+    AdwSpinRow *prefetch_row = ADW_SPIN_ROW(adw_spin_row_new_with_range(0.0, 8.0, 1.0));
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(prefetch_row), "Preload Neighbouring Images");
+    adw_action_row_set_subtitle(ADW_ACTION_ROW(prefetch_row), "Images decoded ahead on each side of the current one");
+    adw_spin_row_set_value(prefetch_row, (double)self->prefetch_radius);
+    GtkAdjustment *prefetch_adj = adw_spin_row_get_adjustment(prefetch_row);
+    g_signal_connect(prefetch_adj, "notify::value", G_CALLBACK(on_prefetch_radius_changed), self);
+    adw_preferences_group_add(viewer_group, GTK_WIDGET(prefetch_row));
     
     adw_preferences_page_add(page_viewer, ADW_PREFERENCES_GROUP(viewer_group));
 
@@ -1796,6 +2063,12 @@ on_shortcuts_action(GSimpleAction *action, GVariant *parameter, gpointer user_da
     "                <property name='accelerator'>F9</property>"
     "              </object>"
     "            </child>"
+    "            <child>"
+    "              <object class='GtkShortcutsShortcut'>"
+    "                <property name='title'>Performance Overlay</property>"
+    "                <property name='accelerator'>F12</property>"
+    "              </object>"
+    "            </child>"
     "          </object>"
     "        </child>"
     "      </object>"
@@ -1862,11 +2135,7 @@ on_drop(GtkDropTarget *target,
         if (path) {
             /* Check if directory or file */
             if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
-                 curator_load_directory(self->curator, path);
-                 const char *current = curator_get_current(self->curator);
-                 load_image_path(self, current);
-                 thumbnails_bar_refresh(self->thumbnails);
-                 adw_overlay_split_view_set_show_sidebar(self->split_view, TRUE);
+                 open_directory(self, path);
             } else {
                  bright_eyes_window_open_file(self, path);
             }
@@ -1877,14 +2146,87 @@ on_drop(GtkDropTarget *target,
     return FALSE;
 }
 
+/* --- Startup --- */
+
+static void
+startup_disconnect(BrightEyesWindow *self)
+{
+    if (self->startup_clock) {
+        g_signal_handler_disconnect(self->startup_clock, self->after_paint_id);
+        self->after_paint_id = 0;
+        g_clear_object(&self->startup_clock);
+    }
+    if (self->startup_timeout_id) {
+        g_source_remove(self->startup_timeout_id);
+        self->startup_timeout_id = 0;
+    }
+}
+
+/* Release what was held back for the first frame. */
+static void
+finish_startup(BrightEyesWindow *self)
+{
+    if (!self->starting) return;
+
+    self->starting = FALSE;
+    self->first_image_pending = FALSE;
+    startup_disconnect(self);
+
+    curator_hold_scans(self->curator, FALSE);
+    prefetcher_update(self->prefetcher);
+    startup_trace_mark("deferred work started");
+}
+
+static void
+on_startup_after_paint(GdkFrameClock *clock, BrightEyesWindow *self)
+{
+    /* The viewer queues a redraw once the image is in */
+    if (self->first_image_pending) return;
+
+    startup_trace_mark("first frame");
+    finish_startup(self);
+}
+
+/* The first image may fail to decode or be a video; don't hold scans forever */
+static gboolean
+on_startup_timeout(gpointer user_data)
+{
+    BrightEyesWindow *self = BRIGHT_EYES_WINDOW(user_data);
+    self->startup_timeout_id = 0;
+    startup_trace_mark("first frame timed out");
+    finish_startup(self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+on_window_realize(GtkWidget *widget, BrightEyesWindow *self)
+{
+    if (!self->starting || self->startup_clock) return;
+
+    self->startup_clock = g_object_ref(gtk_widget_get_frame_clock(widget));
+    self->after_paint_id = g_signal_connect(self->startup_clock, "after-paint",
+                                            G_CALLBACK(on_startup_after_paint), self);
+    self->startup_timeout_id = g_timeout_add(STARTUP_TIMEOUT_MS, on_startup_timeout, self);
+}
+
 static void
 bright_eyes_window_dispose(GObject *object)
 {
     BrightEyesWindow *self = BRIGHT_EYES_WINDOW(object);
+
+    startup_disconnect(self);
     
-    if (self->slideshow_id > 0) {
-        g_source_remove(self->slideshow_id);
-        self->slideshow_id = 0;
+    if (self->slideshow) {
+        g_signal_handlers_disconnect_by_data(self->slideshow, self);
+        slideshow_stop(self->slideshow);
+        g_clear_object(&self->slideshow);
+    }
+
+    if (self->trash_queue) {
+        /* Pending rewrites keep the queue, and the application, alive */
+        g_signal_handlers_disconnect_by_data(self->trash_queue, self);
+        trash_queue_flush(self->trash_queue);
+        g_clear_object(&self->trash_queue);
     }
 
     /* Disconnect signals from child widgets before they are destroyed */
@@ -1903,6 +2245,19 @@ bright_eyes_window_dispose(GObject *object)
     }
 
     g_clear_pointer(&self->ocr_language, g_free);
+    if (self->ocr_batch) {
+        g_signal_handlers_disconnect_by_data(self->ocr_batch, self);
+        ocr_batch_cancel(self->ocr_batch);
+        g_clear_object(&self->ocr_batch);
+    }
+    g_clear_object(&self->ocr_batch_toast);
+    if (self->cbz_batch) {
+        g_signal_handlers_disconnect_by_data(self->cbz_batch, self);
+        cbz_batch_cancel(self->cbz_batch);
+        g_clear_object(&self->cbz_batch);
+    }
+    g_clear_object(&self->cbz_batch_toast);
+    g_clear_object(&self->prefetcher);
     g_clear_object(&self->curator);
 
     /* Chain up to destroy widgets */
@@ -1920,15 +2275,25 @@ static void
 bright_eyes_window_init(BrightEyesWindow *self)
 {
     self->curator = curator_new();
-    self->slideshow_id = 0;    self->slideshow_duration = 3;
+    g_signal_connect_object(self->curator, "load-progress", G_CALLBACK(on_curator_load_progress), self, 0);
+    self->starting = TRUE;
+    curator_hold_scans(self->curator, TRUE);
+    g_signal_connect(self, "realize", G_CALLBACK(on_window_realize), self);
+    self->slideshow_duration = 3;
+    self->trash_queue = trash_queue_new();
+    g_signal_connect(self->trash_queue, "failed", G_CALLBACK(on_trash_failed), self);
     self->ocr_language = g_strdup("eng");
     self->viewer_dark_background = TRUE;
     self->confirm_delete = TRUE;
     self->default_fit_to_window = TRUE;
+    self->prefetch_radius = 2;
 
     /* Load settings */
     load_settings(self);
 
+    self->prefetcher = prefetcher_new(self->curator);
+    prefetcher_set_radius(self->prefetcher, self->prefetch_radius);
+
     gtk_window_set_default_size(GTK_WINDOW(self), 1000, 700);
     gtk_window_set_title(GTK_WINDOW(self), "BrightEyes");
 
@@ -1950,6 +2315,11 @@ bright_eyes_window_init(BrightEyesWindow *self)
     self->viewer = viewer_new();
     viewer_set_dark_background(self->viewer, self->viewer_dark_background);
     viewer_set_default_fit(self->viewer, self->default_fit_to_window);
+
+    self->slideshow = slideshow_new(self->curator, GTK_WIDGET(self->viewer));
+    slideshow_set_interval(self->slideshow, self->slideshow_duration);
+    g_signal_connect(self->slideshow, "advance", G_CALLBACK(on_slideshow_advance), self);
+    g_signal_connect(self->slideshow, "stopped", G_CALLBACK(on_slideshow_stopped), self);
     
     GtkWidget *overlay = gtk_overlay_new();
     gtk_overlay_set_child(GTK_OVERLAY(overlay), GTK_WIDGET(self->viewer));
@@ -1989,6 +2359,7 @@ bright_eyes_window_init(BrightEyesWindow *self)
     g_signal_connect_swapped(self->viewer, "open-requested", G_CALLBACK(show_open_folder_dialog), self);
     /* Listen for playback state to gray out controls */
     g_signal_connect(self->viewer, "playback-changed", G_CALLBACK(on_playback_changed), self);
+    g_signal_connect(self->viewer, "image-loaded", G_CALLBACK(on_viewer_image_loaded), self);
     /* Initialize control state according to current playback */
     on_playback_changed(self->viewer, viewer_is_playing(self->viewer), self);
 
@@ -2085,9 +2456,13 @@ bright_eyes_window_init(BrightEyesWindow *self)
         { "about", on_about_action, NULL, NULL, NULL },
         { "open-editor", on_open_editor_action, NULL, NULL, NULL },
         { "convert-to-cbz", on_convert_to_cbz_action, NULL, NULL, NULL },
+        { "convert-folder-to-cbz", on_convert_folder_action, NULL, NULL, NULL },
+        { "convert-cancel", on_convert_cancel_action, NULL, NULL, NULL },
         { "ocr-whole", on_ocr_whole_action, NULL, NULL, NULL },
         { "ocr-selection", on_ocr_selection_action, NULL, NULL, NULL },
-        { "clear-selection", on_clear_selection_action, NULL, NULL, NULL }
+        { "ocr-batch", on_ocr_batch_action, NULL, NULL, NULL },
+        { "clear-selection", on_clear_selection_action, NULL, NULL, NULL },
+        { "metrics-overlay", NULL, NULL, "false", on_metrics_overlay_changed }
     };
     
     g_action_map_add_action_entries(G_ACTION_MAP(actions), action_entries, G_N_ELEMENTS(action_entries), self);
@@ -2096,6 +2471,7 @@ bright_eyes_window_init(BrightEyesWindow *self)
     
     GMenu *menu = g_menu_new();
     g_menu_append(menu, "Convert to CBZ", "win.convert-to-cbz");
+    g_menu_append(menu, "Convert Folder to CBZ", "win.convert-folder-to-cbz");
     g_menu_append(menu, "Preferences", "win.preferences");
     g_menu_append(menu, "Keyboard Shortcuts", "win.shortcuts");
     g_menu_append(menu, "About BrightEyes", "win.about");
@@ -2118,6 +2494,7 @@ bright_eyes_window_init(BrightEyesWindow *self)
     GMenu *ocr_menu = g_menu_new();
     g_menu_append(ocr_menu, "OCR Whole Image", "win.ocr-whole");
     g_menu_append(ocr_menu, "OCR Selection", "win.ocr-selection");
+    g_menu_append(ocr_menu, "OCR All Pages", "win.ocr-batch");
     g_menu_append(ocr_menu, "Clear Selection", "win.clear-selection");
 
     GtkWidget *ocr_btn = gtk_menu_button_new();
@@ -2171,8 +2548,8 @@ bright_eyes_window_open_file(BrightEyesWindow *self, const char *path)
         const char *resolved = curator_get_current(self->curator);
         load_image_path(self, resolved);
         
-        /* Refresh sidebar and ensure it is shown so thumbnails bind and load */
-        thumbnails_bar_refresh(self->thumbnails);
+        /* The sidebar fills in as the directory scan proceeds; show it so
+           thumbnails bind and load */
         adw_overlay_split_view_set_show_sidebar(self->split_view, TRUE);
     }
 }
@@ -0,0 +1,617 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <cairo.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef HAVE_LIBARCHIVE
+#include <archive.h>
+#include <archive_entry.h>
+#endif
+#include "archive.h"
+#include "archive_cache.h"
+#include "archive_index.h"
+#include "curator.h"
+#include "imageservice.h"
+#include "videothumb.h"
+#include "ocr.h"
+
+/* Benchmark harness (headless)
+ *
+ * Times the hot paths the UI depends on, without a display:
+ * - Archives: archive_list_image_entries (cold index and warm) and
+ *   archive_read_entry_bytes in page order and in a fixed random order, on
+ *   synthetic CBZ files with stored and with deflated pages. Those reads
+ *   empty the entry cache first, so they time decompression; the warm run
+ *   reports what the entry cache serves. --archive adds a real archive to
+ *   the same runs.
+ * - Thumbnails: image_service_request at thumbnail size on synthetic PNG
+ *   pages; video_thumbnail_capture on --video when given.
+ * - Curator: curator_load_directory on synthetic trees of empty .jpg files
+ *   (10k and 100k by default, see --trees).
+ * - OCR: ocr_recognize_file on a rendered text page; the first call, which
+ *   loads the models, is reported on its own.
+ *
+ * Fixtures live in a temporary directory that is also XDG_CACHE_HOME, so
+ * the archive entry cache and index start empty and the user's caches are
+ * left alone. Output is one JSON object per line on stdout:
+ *   {"name": "...", "unit": "ms", "n": 20, "min": .., "p50": .., "p90": ..,
+ *    "p99": .., "max": .., "mean": ..}
+ * or {"name": "...", "skipped": "reason"}. Progress goes to stderr.
+ *
+ * Sections: results, fixtures, benchmarks, main.
+ */
+
+#define PAGE_WIDTH 1200
+#define PAGE_HEIGHT 1800
+#define N_PAGES 16
+#define THUMB_SIZE 128
+
+static int opt_iterations = 20;
+static char *opt_archive = NULL;
+static char *opt_video = NULL;
+static char *opt_trees = NULL;
+static char *opt_ocr_lang = NULL;
+static char *opt_only = NULL;
+static gboolean opt_keep = FALSE;
+
+static GOptionEntry entries[] = {
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iterations, "Samples per benchmark (default 20)", "N" },
+    { "archive", 0, 0, G_OPTION_ARG_FILENAME, &opt_archive, "Also benchmark this archive", "FILE" },
+    { "video", 0, 0, G_OPTION_ARG_FILENAME, &opt_video, "Video for the video thumbnail benchmark", "FILE" },
+    { "trees", 0, 0, G_OPTION_ARG_STRING, &opt_trees, "Directory sizes for the curator (default 10000,100000)", "N,..." },
+    { "ocr-lang", 0, 0, G_OPTION_ARG_STRING, &opt_ocr_lang, "Tesseract language (default eng)", "LANG" },
+    { "only", 0, 0, G_OPTION_ARG_STRING, &opt_only, "Run benchmarks whose name starts with PREFIX", "PREFIX" },
+    { "keep", 0, 0, G_OPTION_ARG_NONE, &opt_keep, "Keep the fixture directory", NULL },
+    { NULL }
+};
+
+/* --- Results --- */
+
+static gboolean
+selected(const char *name)
+{
+    return !opt_only || g_str_has_prefix(name, opt_only);
+}
+
+static int
+compare_doubles(gconstpointer a, gconstpointer b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of a sorted array */
+static double
+percentile(GArray *sorted, double p)
+{
+    guint rank = (guint)(p / 100.0 * sorted->len + 0.999999);
+    rank = CLAMP(rank, 1, sorted->len);
+    return g_array_index(sorted, double, rank - 1);
+}
+
+static void
+report(const char *name, GArray *samples)
+{
+    if (samples->len == 0) {
+        g_print("{\"name\": \"%s\", \"skipped\": \"no samples\"}\n", name);
+        return;
+    }
+
+    g_array_sort(samples, compare_doubles);
+    double sum = 0;
+    for (guint i = 0; i < samples->len; i++) sum += g_array_index(samples, double, i);
+
+    g_print("{\"name\": \"%s\", \"unit\": \"ms\", \"n\": %u, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+            "\"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f}\n",
+            name, samples->len, g_array_index(samples, double, 0), percentile(samples, 50),
+            percentile(samples, 90), percentile(samples, 99),
+            g_array_index(samples, double, samples->len - 1), sum / samples->len);
+}
+
+static void
+report_skipped(const char *name, const char *reason)
+{
+    /* Reasons are our own messages or GError text; keep the JSON valid */
+    char *escaped = g_strescape(reason, NULL);
+    g_print("{\"name\": \"%s\", \"skipped\": \"%s\"}\n", name, escaped);
+    g_free(escaped);
+}
+
+static inline gint64
+now_us(void)
+{
+    return g_get_monotonic_time();
+}
+
+static inline void
+add_sample(GArray *samples, gint64 start)
+{
+    double ms = (double)(now_us() - start) / 1000.0;
+    g_array_append_val(samples, ms);
+}
+
+/* --- Fixtures --- */
+
+static GdkPixbuf *
+make_page(guint seed)
+{
+    GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, PAGE_WIDTH, PAGE_HEIGHT);
+    int stride = gdk_pixbuf_get_rowstride(pixbuf);
+    guint8 *pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+    /* Smooth shapes with some noise, so PNG has real work to do */
+    GRand *rand = g_rand_new_with_seed(seed);
+    for (int y = 0; y < PAGE_HEIGHT; y++) {
+        guint8 *p = pixels + (gsize)y * stride;
+        for (int x = 0; x < PAGE_WIDTH; x++, p += 3) {
+            guint8 n = (guint8)g_rand_int_range(rand, 0, 16);
+            p[0] = (guint8)((x ^ y) + seed * 11) + n;
+            p[1] = (guint8)(x / 5 + y / 7) + n;
+            p[2] = (guint8)(y / 3 + seed * 29);
+        }
+    }
+    g_rand_free(rand);
+    return pixbuf;
+}
+
+static GPtrArray *
+make_pages(const char *dir, GError **error)
+{
+    GPtrArray *pages = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < N_PAGES; i++) {
+        char *name = g_strdup_printf("page%03u.png", i + 1);
+        char *path = g_build_filename(dir, name, NULL);
+        GdkPixbuf *pixbuf = make_page(i);
+        gboolean ok = gdk_pixbuf_save(pixbuf, path, "png", error, NULL);
+        g_object_unref(pixbuf);
+        g_free(name);
+        if (!ok) {
+            g_free(path);
+            g_ptr_array_unref(pages);
+            return NULL;
+        }
+        g_ptr_array_add(pages, path);
+    }
+    return pages;
+}
+
+#ifdef HAVE_LIBARCHIVE
+static gboolean
+make_cbz(const char *path, GPtrArray *pages, const char *compression, GError **error)
+{
+    struct archive *out = archive_write_new();
+    archive_write_set_format_zip(out);
+    archive_write_set_format_option(out, "zip", "compression", compression);
+    if (archive_write_open_filename(out, path) != ARCHIVE_OK) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create %s: %s", path, archive_error_string(out));
+        archive_write_free(out);
+        return FALSE;
+    }
+
+    gboolean ok = TRUE;
+    for (guint i = 0; ok && i < pages->len; i++) {
+        const char *page = g_ptr_array_index(pages, i);
+        char *data = NULL;
+        gsize len = 0;
+        if (!g_file_get_contents(page, &data, &len, error)) {
+            ok = FALSE;
+            break;
+        }
+
+        char *name = g_path_get_basename(page);
+        struct archive_entry *entry = archive_entry_new();
+        archive_entry_set_pathname(entry, name);
+        archive_entry_set_size(entry, (la_int64_t)len);
+        archive_entry_set_filetype(entry, AE_IFREG);
+        archive_entry_set_perm(entry, 0644);
+        if (archive_write_header(out, entry) != ARCHIVE_OK ||
+            archive_write_data(out, data, len) != (la_ssize_t)len) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to write %s: %s", name, archive_error_string(out));
+            ok = FALSE;
+        }
+        archive_entry_free(entry);
+        g_free(name);
+        g_free(data);
+    }
+
+    if (archive_write_close(out) != ARCHIVE_OK && ok) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to finish %s: %s", path, archive_error_string(out));
+        ok = FALSE;
+    }
+    archive_write_free(out);
+    return ok;
+}
+#endif
+
+static gboolean
+make_tree(const char *dir, guint n_files, GError **error)
+{
+    if (g_mkdir_with_parents(dir, 0755) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to create %s", dir);
+        return FALSE;
+    }
+    for (guint i = 0; i < n_files; i++) {
+        char name[32];
+        g_snprintf(name, sizeof name, "img%07u.jpg", i);
+        char *path = g_build_filename(dir, name, NULL);
+        int fd = g_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        g_free(path);
+        if (fd < 0) {
+            g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Failed to create files in %s", dir);
+            return FALSE;
+        }
+        close(fd);
+    }
+    return TRUE;
+}
+
+static char *
+make_text_page(const char *dir)
+{
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, 1200, 900);
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+    cairo_set_source_rgb(cr, 0, 0, 0);
+    cairo_select_font_face(cr, "sans-serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 36);
+
+    static const char *lines[] = {
+        "The quick brown fox jumps over the lazy dog.",
+        "Pack my box with five dozen liquor jugs.",
+        "How vexingly quick daft zebras jump!",
+        "Sphinx of black quartz, judge my vow.",
+        "BrightEyes benchmark page 0123456789",
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(lines); i++) {
+        cairo_move_to(cr, 60, 120 + i * 140);
+        cairo_show_text(cr, lines[i]);
+    }
+    cairo_destroy(cr);
+
+    char *path = g_build_filename(dir, "text.png", NULL);
+    if (cairo_surface_write_to_png(surface, path) != CAIRO_STATUS_SUCCESS)
+        g_clear_pointer(&path, g_free);
+    cairo_surface_destroy(surface);
+    return path;
+}
+
+static void
+remove_tree(const char *path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const char *name;
+        while ((name = g_dir_read_name(dir))) {
+            char *child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+/* --- Benchmarks --- */
+
+static void
+bench_archive(const char *label, const char *archive_path)
+{
+    char *name;
+    GError *error = NULL;
+    GPtrArray *pages = g_ptr_array_new_with_free_func(g_free);
+
+    if (!archive_list_image_entries(archive_path, pages, &error)) {
+        name = g_strdup_printf("archive-list[%s]", label);
+        report_skipped(name, error->message);
+        g_free(name);
+        g_clear_error(&error);
+        g_ptr_array_unref(pages);
+        return;
+    }
+
+    name = g_strdup_printf("archive-list-cold[%s]", label);
+    if (selected(name)) {
+        GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+        for (int i = 0; i < opt_iterations; i++) {
+            GPtrArray *list = g_ptr_array_new_with_free_func(g_free);
+            archive_index_invalidate(archive_path);
+            gint64 start = now_us();
+            archive_list_image_entries(archive_path, list, NULL);
+            add_sample(samples, start);
+            g_ptr_array_unref(list);
+        }
+        report(name, samples);
+        g_array_unref(samples);
+    }
+    g_free(name);
+
+    name = g_strdup_printf("archive-list[%s]", label);
+    if (selected(name)) {
+        GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+        for (int i = 0; i < opt_iterations; i++) {
+            GPtrArray *list = g_ptr_array_new_with_free_func(g_free);
+            gint64 start = now_us();
+            archive_list_image_entries(archive_path, list, NULL);
+            add_sample(samples, start);
+            g_ptr_array_unref(list);
+        }
+        report(name, samples);
+        g_array_unref(samples);
+    }
+    g_free(name);
+
+    if (pages->len == 0) {
+        g_ptr_array_unref(pages);
+        return;
+    }
+
+    /* One sample per page read; enough passes to reach the iteration count.
+     * Cold reads drop the archive's cached entries first, outside the timing. */
+    guint n_reads = MAX((guint)opt_iterations, pages->len);
+
+    name = g_strdup_printf("archive-read-sequential[%s]", label);
+    if (selected(name)) {
+        GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+        for (guint i = 0; i < n_reads; i++) {
+            const char *entry = g_ptr_array_index(pages, i % pages->len);
+            archive_cache_invalidate(archive_path);
+            gint64 start = now_us();
+            GBytes *bytes = archive_read_entry_bytes(archive_path, entry, NULL);
+            add_sample(samples, start);
+            if (bytes) g_bytes_unref(bytes);
+        }
+        report(name, samples);
+        g_array_unref(samples);
+    }
+    g_free(name);
+
+    name = g_strdup_printf("archive-read-random[%s]", label);
+    if (selected(name)) {
+        GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+        GRand *rand = g_rand_new_with_seed(42);
+        for (guint i = 0; i < n_reads; i++) {
+            const char *entry = g_ptr_array_index(pages, g_rand_int_range(rand, 0, (gint32)pages->len));
+            archive_cache_invalidate(archive_path);
+            gint64 start = now_us();
+            GBytes *bytes = archive_read_entry_bytes(archive_path, entry, NULL);
+            add_sample(samples, start);
+            if (bytes) g_bytes_unref(bytes);
+        }
+        g_rand_free(rand);
+        report(name, samples);
+        g_array_unref(samples);
+    }
+    g_free(name);
+
+    /* Every page read once, untimed, so compressed ones come from the cache */
+    name = g_strdup_printf("archive-read-warm[%s]", label);
+    if (selected(name)) {
+        GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+        for (guint i = 0; i < pages->len; i++) {
+            GBytes *bytes = archive_read_entry_bytes(archive_path, g_ptr_array_index(pages, i), NULL);
+            if (bytes) g_bytes_unref(bytes);
+        }
+        for (guint i = 0; i < n_reads; i++) {
+            const char *entry = g_ptr_array_index(pages, i % pages->len);
+            gint64 start = now_us();
+            GBytes *bytes = archive_read_entry_bytes(archive_path, entry, NULL);
+            add_sample(samples, start);
+            if (bytes) g_bytes_unref(bytes);
+        }
+        report(name, samples);
+        g_array_unref(samples);
+    }
+    g_free(name);
+
+    g_ptr_array_unref(pages);
+}
+
+static void
+bench_image_thumbnails(GPtrArray *pages)
+{
+    if (!selected("thumbnail-image")) return;
+
+    /* Scaled requests are never cached, so every sample is a full decode */
+    GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+    for (int i = 0; i < opt_iterations; i++) {
+        const char *path = g_ptr_array_index(pages, i % pages->len);
+        gint64 start = now_us();
+        GdkPixbuf *thumb = image_service_request(path, THUMB_SIZE, NULL, NULL);
+        add_sample(samples, start);
+        g_clear_object(&thumb);
+    }
+    report("thumbnail-image", samples);
+    g_array_unref(samples);
+}
+
+static void
+bench_video_thumbnails(void)
+{
+    if (!selected("thumbnail-video")) return;
+    if (!opt_video) {
+        report_skipped("thumbnail-video", "no --video given");
+        return;
+    }
+
+    GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+    GError *error = NULL;
+    for (int i = 0; i < opt_iterations; i++) {
+        gint64 start = now_us();
+        GdkPixbuf *thumb = video_thumbnail_capture(opt_video, THUMB_SIZE, NULL, &error);
+        if (!thumb) break;
+        add_sample(samples, start);
+        g_object_unref(thumb);
+    }
+
+    if (error) {
+        report_skipped("thumbnail-video", error->message);
+        g_clear_error(&error);
+    } else {
+        report("thumbnail-video", samples);
+    }
+    g_array_unref(samples);
+    video_thumbnail_engines_release();
+}
+
+static void
+bench_curator(const char *root)
+{
+    char **sizes = g_strsplit(opt_trees ? opt_trees : "10000,100000", ",", -1);
+
+    for (guint s = 0; sizes[s]; s++) {
+        guint n_files = (guint)g_ascii_strtoull(sizes[s], NULL, 10);
+        if (n_files == 0) continue;
+
+        char *name = g_strdup_printf("curator-load[%u]", n_files);
+        if (!selected(name)) {
+            g_free(name);
+            continue;
+        }
+
+        char *dir_name = g_strdup_printf("tree-%u", n_files);
+        char *dir = g_build_filename(root, dir_name, NULL);
+        GError *error = NULL;
+        g_printerr("bench: creating %u files\n", n_files);
+        if (!make_tree(dir, n_files, &error)) {
+            report_skipped(name, error->message);
+            g_clear_error(&error);
+        } else {
+            /* Large trees take seconds each; a few samples are enough */
+            int iterations = n_files >= 50000 ? MIN(opt_iterations, 5) : opt_iterations;
+            GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+            for (int i = 0; i < iterations; i++) {
+                Curator *curator = curator_new();
+                gint64 start = now_us();
+                curator_load_directory(curator, dir);
+                add_sample(samples, start);
+                if (curator_get_files(curator)->len != n_files)
+                    g_printerr("bench: %s listed %u of %u files\n", name, curator_get_files(curator)->len, n_files);
+                g_object_unref(curator);
+            }
+            report(name, samples);
+            g_array_unref(samples);
+        }
+        if (!opt_keep) remove_tree(dir);
+        g_free(dir);
+        g_free(dir_name);
+        g_free(name);
+    }
+    g_strfreev(sizes);
+}
+
+static void
+bench_ocr(const char *root)
+{
+    if (!selected("ocr")) return;
+
+    char *page = make_text_page(root);
+    if (!page) {
+        report_skipped("ocr", "could not render the text page");
+        return;
+    }
+
+    const char *lang = opt_ocr_lang ? opt_ocr_lang : "eng";
+    GError *error = NULL;
+
+    /* The first recognition loads the models into a pooled engine */
+    GArray *init = g_array_new(FALSE, FALSE, sizeof(double));
+    gint64 start = now_us();
+    char *text = ocr_recognize_file(page, lang, NULL, NULL, &error);
+    add_sample(init, start);
+    if (!text) {
+        report_skipped("ocr", error ? error->message : "recognition failed");
+        g_clear_error(&error);
+        g_array_unref(init);
+        g_free(page);
+        return;
+    }
+    g_free(text);
+    report("ocr-first", init);
+    g_array_unref(init);
+
+    GArray *samples = g_array_new(FALSE, FALSE, sizeof(double));
+    for (int i = 0; i < opt_iterations; i++) {
+        start = now_us();
+        text = ocr_recognize_file(page, lang, NULL, NULL, NULL);
+        add_sample(samples, start);
+        g_free(text);
+    }
+    report("ocr", samples);
+    g_array_unref(samples);
+    g_free(page);
+}
+
+/* --- Main --- */
+
+int
+main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *context = g_option_context_new("- benchmark BrightEyes hot paths");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_clear_error(&error);
+        g_option_context_free(context);
+        return 2;
+    }
+    g_option_context_free(context);
+    opt_iterations = MAX(opt_iterations, 1);
+
+    char *root = g_dir_make_tmp("brighteyes-bench-XXXXXX", &error);
+    if (!root) {
+        g_printerr("Failed to create fixture directory: %s\n", error->message);
+        g_clear_error(&error);
+        return 1;
+    }
+    /* Before anything asks GLib for the cache directory */
+    char *cache = g_build_filename(root, "cache", NULL);
+    g_setenv("XDG_CACHE_HOME", cache, TRUE);
+    g_free(cache);
+
+    g_printerr("bench: fixtures in %s\n", root);
+    GPtrArray *pages = make_pages(root, &error);
+    if (!pages) {
+        g_printerr("Failed to create pages: %s\n", error->message);
+        g_clear_error(&error);
+        remove_tree(root);
+        g_free(root);
+        return 1;
+    }
+
+#ifdef HAVE_LIBARCHIVE
+    static const char *compressions[] = { "store", "deflate" };
+    for (guint i = 0; i < G_N_ELEMENTS(compressions); i++) {
+        char *file = g_strdup_printf("%s.cbz", compressions[i]);
+        char *path = g_build_filename(root, file, NULL);
+        if (make_cbz(path, pages, compressions[i], &error))
+            bench_archive(compressions[i], path);
+        else
+            report_skipped(file, error->message);
+        g_clear_error(&error);
+        g_free(path);
+        g_free(file);
+    }
+#else
+    report_skipped("archive", "built without libarchive");
+#endif
+    if (opt_archive) bench_archive("user", opt_archive);
+
+    bench_image_thumbnails(pages);
+    bench_video_thumbnails();
+    bench_curator(root);
+    bench_ocr(root);
+
+    g_ptr_array_unref(pages);
+    if (opt_keep)
+        g_printerr("bench: kept %s\n", root);
+    else
+        remove_tree(root);
+    g_free(root);
+    return 0;
+}
@@ -7,6 +7,7 @@ DUR=${2:-10}
 LOG=/tmp/brighteyes-smoke.log
 
 export BRIGHTEYES_THUMBNAILS_DEBUG=1
+export BRIGHTEYES_STARTUP_TRACE=1
 
 echo "Running BrightEyes (instrumentation enabled) against: $DIR for ${DUR}s" | tee $LOG
 
@@ -15,10 +16,16 @@ echo "Running BrightEyes (instrumentation enabled) against: $DIR for ${DUR}s" |
 PID=$!
 # Let the UI mount and populate thumbnails
 sleep $DUR
+# Counters are no longer printed per event; ask the running app for them
+gapplication action org.jeremy.BrightEyes dump-metrics 2>/dev/null || true
+sleep 1
 kill $PID 2>/dev/null || true
 sleep 1
 
 echo "--- Instrumentation summary from logs ---"
-grep 'THUMBS-INSTR' $LOG || echo "No instrumentation lines found in $LOG"
+grep 'THUMBS-INSTR\|METRICS:' $LOG || echo "No instrumentation lines found in $LOG"
+
+echo "--- Startup trace ---"
+grep 'STARTUP-TRACE' $LOG || echo "No startup trace lines found in $LOG"
 
 echo "Log: $LOG"